@@ -1,170 +1,1003 @@
-/*
-	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
-
-	Redistribution and use in source and binary forms, with or without
-	modification, are permitted provided that the following conditions are met:
-
-	* Redistributions of source code must retain the above copyright notice,
-	  this list of conditions and the following disclaimer.
-	* Redistributions in binary form must reproduce the above copyright notice,
-	  this list of conditions and the following disclaimer in the documentation
-	  and/or other materials provided with the distribution.
-	* Neither the name of CM256 nor the names of its contributors may be
-	  used to endorse or promote products derived from this software without
-	  specific prior written permission.
-
-	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
-	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
-	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
-	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
-	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
-	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
-	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
-	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
-	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
-	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
-	POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#ifndef CM256_H
-#define CM256_H
-
-#include "gf256.h"
-
-#include <assert.h>
-
-// Library version
-#define CM256_VERSION 2
-
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-/*
- * Verify binary compatibility with the API on startup.
- *
- * Example:
- * 	if (cm256_init()) exit(1);
- *
- * Returns 0 on success, and any other code indicates failure.
- */
-extern int cm256_init_(int version);
-#define cm256_init() cm256_init_(CM256_VERSION)
-
-
-// Encoder parameters
-typedef struct cm256_encoder_params_t {
-    // Original block count < 256
-    int OriginalCount;
-
-    // Recovery block count < 256
-    int RecoveryCount;
-
-    // Number of bytes per block (all blocks are the same size in bytes)
-    int BlockBytes;
-} cm256_encoder_params;
-
-// Descriptor for data block
-typedef struct cm256_block_t {
-    // Pointer to data received.
-    void* Block;
-
-    // Block index.
-    // For original data, it will be in the range
-    //    [0..(originalCount-1)] inclusive.
-    // For recovery data, the first one's Index must be originalCount,
-    //    and it will be in the range
-    //    [originalCount..(originalCount+recoveryCount-1)] inclusive.
-    unsigned char Index;
-    // Ignored during encoding, required during decoding.
-} cm256_block;
-
-
-// Compute the value to put in the Index member of cm256_block
-static inline unsigned char cm256_get_recovery_block_index(cm256_encoder_params params, int recoveryBlockIndex)
-{
-    assert(recoveryBlockIndex >= 0 && recoveryBlockIndex < params.RecoveryCount);
-    return (unsigned char)(params.OriginalCount + recoveryBlockIndex);
-}
-static inline unsigned char cm256_get_original_block_index(cm256_encoder_params params, int originalBlockIndex)
-{
-    assert(originalBlockIndex >= 0 && originalBlockIndex < params.OriginalCount);
-    return (unsigned char)(originalBlockIndex);
-}
-
-
-/*
- * Cauchy MDS GF(256) encode
- *
- * This produces a set of recovery blocks that should be transmitted after the
- * original data blocks.
- *
- * It takes in 'originalCount' equal-sized blocks and produces 'recoveryCount'
- * equally-sized recovery blocks.
- *
- * The input 'originals' array allows more natural usage of the library.
- * The output recovery blocks are stored end-to-end in 'recoveryBlocks'.
- * 'recoveryBlocks' should have recoveryCount * blockBytes bytes available.
- *
- * Precondition: originalCount + recoveryCount <= 256
- *
- * When transmitting the data, the block index of the data should be sent,
- * and the recovery block index is also needed.  The decoder should also
- * be provided with the values of originalCount, recoveryCount and blockBytes.
- *
- * Example wire format:
- * [originalCount(1 byte)] [recoveryCount(1 byte)]
- * [blockIndex(1 byte)] [blockData(blockBytes bytes)]
- *
- * Be careful not to mix blocks from different encoders.
- *
- * It is possible to support variable-length data by including the original
- * data length at the front of each message in 2 bytes, such that when it is
- * recovered after a loss the data length is available in the block data and
- * the remaining bytes of padding can be neglected.
- *
- * Returns 0 on success, and any other code indicates failure.
- */
-extern int cm256_encode(
-    cm256_encoder_params params, // Encoder parameters
-    cm256_block* originals,      // Array of pointers to original blocks
-    void* recoveryBlocks);       // Output recovery blocks end-to-end
-
-// Encode one block.
-// Note: This function does not validate input, use with care.
-extern void cm256_encode_block(
-    cm256_encoder_params params, // Encoder parameters
-    cm256_block* originals,      // Array of pointers to original blocks
-    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
-    void* recoveryBlock);        // Output recovery block
-
-/*
- * Cauchy MDS GF(256) decode
- *
- * This recovers the original data from the recovery data in the provided
- * blocks.  There should be 'originalCount' blocks in the provided array.
- * Recovery will always be possible if that many blocks are received.
- *
- * Provide the same values for 'originalCount', 'recoveryCount', and
- * 'blockBytes' used by the encoder.
- *
- * The block Index should be set to the block index of the original data,
- * as described in the cm256_block struct comments above.
- *
- * Recovery blocks will be replaced with original data and the Index
- * will be updated to indicate the original block that was recovered.
- *
- * Returns 0 on success, and any other code indicates failure.
- */
-extern int cm256_decode(
-    cm256_encoder_params params, // Encoder parameters
-    cm256_block* blocks);        // Array of 'originalCount' blocks as described above
-
-
-#ifdef __cplusplus
-}
-#endif
-
-
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_H
+#define CM256_H
+
+#include "gf256.h"
+
+#include <assert.h>
+
+// Library version.  The inline GF(256) math in gf256.h reads gf256_ctx, so
+// this carries the context layout bit of GF256_VERSION as well.
+#define CM256_VERSION (2 | (GF256_VERSION & GF256_VERSION_COMPACT))
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Verify binary compatibility with the API on startup.
+ *
+ * Example:
+ * 	if (cm256_init()) exit(1);
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_init_(int version);
+#define cm256_init() cm256_init_(CM256_VERSION)
+
+
+// Encoder parameters
+typedef struct cm256_encoder_params_t {
+    // Original block count < 256
+    int OriginalCount;
+
+    // Recovery block count < 256
+    int RecoveryCount;
+
+    // Number of bytes per block (all blocks are the same size in bytes)
+    int BlockBytes;
+} cm256_encoder_params;
+
+// Descriptor for data block
+typedef struct cm256_block_t {
+    // Pointer to data received.
+    void* Block;
+
+    // Block index.
+    // For original data, it will be in the range
+    //    [0..(originalCount-1)] inclusive.
+    // For recovery data, the first one's Index must be originalCount,
+    //    and it will be in the range
+    //    [originalCount..(originalCount+recoveryCount-1)] inclusive.
+    unsigned char Index;
+    // Ignored during encoding, required during decoding.
+} cm256_block;
+
+
+// Compute the value to put in the Index member of cm256_block
+static inline unsigned char cm256_get_recovery_block_index(cm256_encoder_params params, int recoveryBlockIndex)
+{
+    assert(recoveryBlockIndex >= 0 && recoveryBlockIndex < params.RecoveryCount);
+    return (unsigned char)(params.OriginalCount + recoveryBlockIndex);
+}
+static inline unsigned char cm256_get_original_block_index(cm256_encoder_params params, int originalBlockIndex)
+{
+    assert(originalBlockIndex >= 0 && originalBlockIndex < params.OriginalCount);
+    return (unsigned char)(originalBlockIndex);
+}
+
+
+/*
+ * Cauchy MDS GF(256) encode
+ *
+ * This produces a set of recovery blocks that should be transmitted after the
+ * original data blocks.
+ *
+ * It takes in 'originalCount' equal-sized blocks and produces 'recoveryCount'
+ * equally-sized recovery blocks.
+ *
+ * The input 'originals' array allows more natural usage of the library.
+ * The output recovery blocks are stored end-to-end in 'recoveryBlocks'.
+ * 'recoveryBlocks' should have recoveryCount * blockBytes bytes available.
+ *
+ * Precondition: originalCount + recoveryCount <= 256
+ *
+ * When transmitting the data, the block index of the data should be sent,
+ * and the recovery block index is also needed.  The decoder should also
+ * be provided with the values of originalCount, recoveryCount and blockBytes.
+ *
+ * Example wire format:
+ * [originalCount(1 byte)] [recoveryCount(1 byte)]
+ * [blockIndex(1 byte)] [blockData(blockBytes bytes)]
+ *
+ * Be careful not to mix blocks from different encoders.
+ *
+ * It is possible to support variable-length data by including the original
+ * data length at the front of each message in 2 bytes, such that when it is
+ * recovered after a loss the data length is available in the block data and
+ * the remaining bytes of padding can be neglected.  cm256_encode_sized()
+ * does this without coding the padding, see Variable-length blocks below.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_encode(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
+// Encode one block.
+// Note: This function does not validate input, use with care.
+extern void cm256_encode_block(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    void* recoveryBlock);        // Output recovery block
+
+/*
+ * Worker pool for the multithreaded entry points
+ *
+ * The pool owns a set of worker threads that are created once and then sleep
+ * between calls, so that each call only pays for a wake-up rather than for
+ * spawning threads.  The calling thread also does work during a call.
+ *
+ * 'workerCount' is the number of threads to create in addition to the
+ * calling thread.  Pass -1 to use one less than the number of hardware
+ * threads.
+ *
+ * A pool may be shared between threads; calls made through it at the same
+ * time take turns.  A call that is made on a thread while that thread is
+ * working for the same pool does not wait for its turn, which would never
+ * come; it runs on that thread alone.
+ *
+ * Returns null on failure.
+ */
+typedef struct cm256_pool_t cm256_pool;
+
+extern cm256_pool* cm256_pool_create(int workerCount);
+extern void cm256_pool_destroy(cm256_pool* pool);
+
+/*
+ * Multithreaded Cauchy MDS GF(256) encode
+ *
+ * Same as cm256_encode(), except that the byte range of the blocks is split
+ * into stripes that are encoded in parallel on the threads of 'pool'.
+ * The output is identical to cm256_encode().
+ *
+ * Blocks that are too small to split into stripes of at least
+ * CM256_MT_MIN_STRIPE_BYTES are encoded on the calling thread alone, as are
+ * all blocks when 'pool' is null.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+#define CM256_MT_MIN_STRIPE_BYTES (32 * 1024)
+
+extern int cm256_encode_mt(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks,        // Output recovery blocks end-to-end
+    cm256_pool* pool);           // Worker pool from cm256_pool_create()
+
+/*
+ * Encoder handle
+ *
+ * For applications that encode many times with the same parameters, the
+ * handle precomputes the recovery matrix and the multiply tables for each
+ * of its coefficients, so that each encode only does the bulk math.  This
+ * matters most for small blocks, where looking up coefficients is a
+ * noticeable share of the work.
+ *
+ * The handle is read-only after creation and may be used from several
+ * threads at once.  The BlockBytes given at creation applies to every call.
+ *
+ * Returns null if the parameters are invalid or on allocation failure.
+ */
+typedef struct cm256_encoder_t cm256_encoder;
+
+extern cm256_encoder* cm256_encoder_create(cm256_encoder_params params);
+extern void cm256_encoder_destroy(cm256_encoder* encoder);
+
+// Same as cm256_encode() using the parameters of the handle
+extern int cm256_encoder_encode(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
+// Same as cm256_encode_mt() using the parameters of the handle
+extern int cm256_encoder_encode_mt(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks,        // Output recovery blocks end-to-end
+    cm256_pool* pool);           // Worker pool from cm256_pool_create()
+
+// Same as cm256_encode_block() using the parameters of the handle
+// Note: This function does not validate input, use with care.
+extern void cm256_encoder_encode_block(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    void* recoveryBlock);        // Output recovery block
+
+/*
+ * Matrix points
+ *
+ * The recovery matrix is built from a set of Cauchy points: recovery row i
+ * uses X[i], original column j uses Y[j], and each element is
+ *
+ *     a_ij = RowScale[i] * (Y[j] + X[0]) / (X[i] + Y[j])
+ *
+ * so that row 0 is all ones.  The points must all be distinct, RowScale must
+ * be non-zero and RowScale[0] must be 1.  cm256_encode() and cm256_decode()
+ * use the default points X[i] = originalCount + i, Y[j] = j, RowScale[i] = 1.
+ *
+ * cm256_optimize_points() searches for points whose matrix has fewer ones in
+ * its 8x8 bit matrix expansion.  That is the XOR count of the bitmatrix mode,
+ * and each extra one left in a row of the byte codec is a plain XOR.  Within
+ * a row other than row 0 the elements are all distinct, so row scaling can
+ * make at most one of them 1.
+ *
+ * The decoder must use the same points as the encoder, so an application
+ * that optimizes them stores or sends the first recoveryCount entries of X
+ * and RowScale and the first originalCount entries of Y with the data.
+ */
+typedef struct cm256_matrix_points_t {
+    unsigned char X[256];        // Point for each recovery row
+    unsigned char Y[256];        // Point for each original column
+    unsigned char RowScale[256]; // Scale for each recovery row
+} cm256_matrix_points;
+
+// Fill in the default points used by cm256_encode()
+extern void cm256_default_points(cm256_encoder_params params, cm256_matrix_points* points);
+
+// Starting from the default points, run 'iterations' steps of local search.
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_optimize_points(
+    cm256_encoder_params params,  // Encoder parameters
+    int iterations,               // Search effort, e.g. 1000
+    cm256_matrix_points* points); // Output points
+
+// Returns the number of ones in the bit matrix expansion of rows 1..m-1,
+// or a negative code if the points are invalid
+extern int cm256_points_cost(cm256_encoder_params params, const cm256_matrix_points* points);
+
+// Same as cm256_encoder_create() with the given points
+extern cm256_encoder* cm256_encoder_create_with_points(
+    cm256_encoder_params params,        // Encoder parameters
+    const cm256_matrix_points* points); // Points the recovery data is encoded with
+
+// Same as cm256_decode_mt() for data encoded with the given points.
+// 'pool' may be null to decode on the calling thread.
+extern int cm256_decode_with_points(
+    cm256_encoder_params params,       // Encoder parameters
+    const cm256_matrix_points* points, // Points the recovery data was encoded with
+    cm256_block* blocks,               // Array of 'originalCount' blocks as described above
+    cm256_pool* pool);                 // Optional worker pool
+
+/*
+ * Streaming encoder
+ *
+ * For applications that produce the original blocks one at a time, the
+ * streaming encoder owns the recovery blocks and folds each original into
+ * all of them as soon as it is pushed.  This spreads the encoding work out
+ * as the data arrives, and the caller does not need to keep the originals
+ * once they are pushed.
+ *
+ * Originals may be pushed in any order, each exactly once.  After all of
+ * them are pushed, flush copies out the recovery blocks and resets the
+ * encoder for the next group.  Reset discards a partial group.
+ *
+ * The encoder is not thread-safe.
+ *
+ * Returns null if the parameters are invalid or on allocation failure.
+ */
+typedef struct cm256_stream_encoder_t cm256_stream_encoder;
+
+extern cm256_stream_encoder* cm256_stream_encoder_create(cm256_encoder_params params);
+extern void cm256_stream_encoder_destroy(cm256_stream_encoder* encoder);
+extern void cm256_stream_encoder_reset(cm256_stream_encoder* encoder);
+
+// Fold one original block into the recovery blocks.
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_stream_encoder_push(
+    cm256_stream_encoder* encoder, // Encoder from cm256_stream_encoder_create()
+    int originalIndex,             // Return value from cm256_get_original_block_index()
+    const void* originalBlock);    // Original block data
+
+// Produce the same output as cm256_encode() once every original is pushed.
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_stream_encoder_flush(
+    cm256_stream_encoder* encoder, // Encoder from cm256_stream_encoder_create()
+    void* recoveryBlocks);         // Output recovery blocks end-to-end
+
+/*
+ * Parity update
+ *
+ * For applications that store the recovery blocks, a write to one original
+ * block does not need the other originals to bring the recovery blocks up
+ * to date.  Each recovery block is linear in the originals, so the change
+ * (old + new) is multiplied by that original's coefficient in each row and
+ * added in place.  This reads the one original instead of all k of them.
+ *
+ * If the application already has the change, it passes that as 'newBlock'
+ * with a null 'oldBlock'.  Recovery blocks are updated in place, and a null
+ * entry in 'recoveryBlocks' skips that row.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_update(
+    cm256_encoder_params params, // Encoder parameters
+    int originalIndex,           // Return value from cm256_get_original_block_index()
+    const void* oldBlock,        // Original block data before the write, or null
+    const void* newBlock,        // Original block data after the write, or the change
+    void* const* recoveryBlocks);// Array of 'recoveryCount' recovery blocks to update
+
+// Same as cm256_update() using the parameters and points of the handle
+extern int cm256_encoder_update(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    int originalIndex,           // Return value from cm256_get_original_block_index()
+    const void* oldBlock,        // Original block data before the write, or null
+    const void* newBlock,        // Original block data after the write, or the change
+    void* const* recoveryBlocks);// Array of 'recoveryCount' recovery blocks to update
+
+/*
+ * Cauchy MDS GF(256) decode
+ *
+ * This recovers the original data from the recovery data in the provided
+ * blocks.  There should be 'originalCount' blocks in the provided array.
+ * Recovery will always be possible if that many blocks are received.
+ *
+ * Provide the same values for 'originalCount', 'recoveryCount', and
+ * 'blockBytes' used by the encoder.
+ *
+ * The block Index should be set to the block index of the original data,
+ * as described in the cm256_block struct comments above.
+ *
+ * Recovery blocks will be replaced with original data and the Index
+ * will be updated to indicate the original block that was recovered.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decode(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks);        // Array of 'originalCount' blocks as described above
+
+/*
+ * Streaming decoder
+ *
+ * For applications that receive blocks one at a time, the streaming decoder
+ * does most of the decoding work as the blocks arrive rather than after the
+ * last one.  Each original is eliminated from the recovery blocks received
+ * so far, and each recovery block has the originals received so far
+ * eliminated from it.  When the k-th block is pushed only the small solve
+ * for the erased originals remains, and it is done during that push.
+ *
+ * The decoder keeps the pushed cm256_block pointers, so the blocks and
+ * their data must stay valid until the decode is complete.  As with
+ * cm256_decode(), recovery blocks are replaced with original data and their
+ * Index is updated to the original that was recovered.  Blocks pushed after
+ * the decode is complete are ignored.  Reset starts a new group.
+ *
+ * The decoder is not thread-safe.
+ *
+ * Returns null if the parameters are invalid or on allocation failure.
+ */
+typedef struct cm256_stream_decoder_t cm256_stream_decoder;
+
+extern cm256_stream_decoder* cm256_stream_decoder_create(cm256_encoder_params params);
+extern void cm256_stream_decoder_destroy(cm256_stream_decoder* decoder);
+extern void cm256_stream_decoder_reset(cm256_stream_decoder* decoder);
+
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_stream_decoder_push(
+    cm256_stream_decoder* decoder, // Decoder from cm256_stream_decoder_create()
+    cm256_block* block);           // Received block as described above
+
+// Returns non-zero once all of the original data is available
+extern int cm256_stream_decoder_complete(const cm256_stream_decoder* decoder);
+
+/*
+ * Multithreaded Cauchy MDS GF(256) decode
+ *
+ * Same as cm256_decode(), except that the elimination passes are run over
+ * stripes of the blocks in parallel on the threads of 'pool'.  The matrix
+ * decomposition only depends on the block indices, so it is computed once
+ * up front on the calling thread.
+ *
+ * As with cm256_encode_mt(), small blocks or a null 'pool' are decoded on
+ * the calling thread alone.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decode_mt(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    cm256_pool* pool);           // Worker pool from cm256_pool_create()
+
+
+/*
+ * Cauchy MDS GF(256) decode into separate outputs
+ *
+ * Same as cm256_decode_mt(), except that the blocks are not modified.  Each
+ * erased original i is written to outputs[i] instead of over a recovery
+ * block, so the received data may be read-only and needs no copy first.
+ *
+ * 'outputs' has 'originalCount' entries indexed by original block index.
+ * The entries for erased originals must be non-null, and the others are
+ * ignored.  Outputs must not overlap the blocks.
+ *
+ * 'pool' may be null to decode on the calling thread.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decode_into(
+    cm256_encoder_params params, // Encoder parameters
+    const cm256_block* blocks,   // Array of 'originalCount' blocks as described above
+    void* const* outputs,        // Array of 'originalCount' output pointers
+    cm256_pool* pool);           // Optional worker pool
+
+/*
+ * Partial decode
+ *
+ * Same as cm256_decode_into(), except that only the erased originals with a
+ * non-null entry in 'outputs' are recovered.  Each one is computed directly
+ * as a combination of the k received blocks, so recovering a few originals
+ * costs about k multiply-adds over the data per original rather than a full
+ * decode.  This suits degraded reads that need one or two missing blocks.
+ *
+ * 'pool' may be null to decode on the calling thread.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decode_partial(
+    cm256_encoder_params params, // Encoder parameters
+    const cm256_block* blocks,   // Array of 'originalCount' blocks as described above
+    void* const* outputs,        // Array of 'originalCount' output pointers, null to skip
+    cm256_pool* pool);           // Optional worker pool
+
+/*
+ * Variable-length blocks
+ *
+ * Same as cm256_encode() and cm256_decode(), for originals of different
+ * lengths.  Each original holds 'Bytes' bytes, from 0 to BlockBytes, and is
+ * treated as zeros past them, so the codec neither reads nor multiplies
+ * the padding and a short block costs only its own length.
+ *
+ * Each recovery block holds as many bytes of data as the longest original,
+ * followed by CM256_SIZED_TRAILER_BYTES bytes that carry the lengths of the
+ * originals through the code.  cm256_encode_sized() stores the recovery
+ * blocks end-to-end, cm256_sized_recovery_bytes(BlockBytes) apart, and sets
+ * 'recoveryBytes' to the number of bytes to send from the start of each.
+ *
+ * When decoding, Bytes is the number of bytes received in each block, so
+ * every recovery block has the same Bytes.  As with cm256_decode(), the
+ * recovery blocks are overwritten with the erased originals, and their
+ * Index and Bytes are set to the index and true length of the original.
+ *
+ * Returns 0 on success, and any other code indicates failure.  Returns -1
+ * if a length is out of range or the recovered lengths are inconsistent.
+ */
+#define CM256_SIZED_TRAILER_BYTES 4
+
+// Room needed for a recovery block of a code with 'blockBytes' bytes per block
+static inline int cm256_sized_recovery_bytes(int blockBytes)
+{
+    return blockBytes + CM256_SIZED_TRAILER_BYTES;
+}
+
+typedef struct cm256_sized_block_t {
+    // Pointer to the block data
+    void* Block;
+
+    // Number of bytes of data in the block
+    int Bytes;
+
+    // Block index, as in cm256_block
+    unsigned char Index;
+} cm256_sized_block;
+
+extern int cm256_encode_sized(
+    cm256_encoder_params params,         // Encoder parameters, BlockBytes the longest allowed
+    const cm256_sized_block* originals,  // Array of original blocks
+    void* recoveryBlocks,                // Output recovery blocks end-to-end
+    int* recoveryBytes);                 // Set to the length of each recovery block
+
+extern int cm256_decode_sized(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_sized_block* blocks);  // Array of 'originalCount' blocks as described above
+
+/*
+ * Scatter-gather blocks
+ *
+ * For applications whose blocks are split over several buffers, such as a
+ * packet header and payload in different network buffers, these take each
+ * block as a list of segments instead of one pointer.  The segments of a
+ * block are read in order as one block of BlockBytes bytes, so the data
+ * does not need to be gathered into a contiguous copy first.
+ *
+ * Only blocks that the codec reads may be scattered.  Recovery blocks are
+ * written end-to-end as by cm256_encode(), and cm256_decode_sg() writes the
+ * erased originals to separate outputs as cm256_decode_partial() does.  The
+ * streaming decoder decodes recovery blocks in place, so only originals
+ * may be pushed with cm256_stream_decoder_push_sg(); it keeps the block and
+ * segment pointers, which must stay valid until the decode is complete.
+ *
+ * 'pool' may be null to run on the calling thread.
+ *
+ * Returns 0 on success, and any other code indicates failure.  Returns -1
+ * if the segments of a block do not add up to BlockBytes.
+ */
+typedef struct cm256_iovec_t {
+    const void* Base; // Start of the segment
+    int Bytes;        // Number of bytes in the segment
+} cm256_iovec;
+
+typedef struct cm256_sg_block_t {
+    const cm256_iovec* Segments; // Array of segments, in block order
+    int SegmentCount;            // Number of segments
+    unsigned char Index;         // Block index, as in cm256_block
+} cm256_sg_block;
+
+extern int cm256_encode_sg(
+    cm256_encoder_params params,     // Encoder parameters
+    const cm256_sg_block* originals, // Array of original blocks
+    void* recoveryBlocks,            // Output recovery blocks end-to-end
+    cm256_pool* pool);               // Optional worker pool
+
+typedef struct cm256_sg_encode_stripe_t {
+    const cm256_sg_block* Originals; // Array of original blocks
+    void* RecoveryBlocks;            // Output recovery blocks end-to-end
+} cm256_sg_encode_stripe;
+
+// Same as cm256_encode_batch() for scatter-gather originals
+extern int cm256_encode_sg_batch(
+    cm256_encoder_params params,           // Encoder parameters
+    const cm256_sg_encode_stripe* stripes, // Array of stripes to encode
+    int stripeCount,                       // Number of stripes
+    cm256_pool* pool);                     // Optional worker pool
+
+// Same as cm256_decode_partial() for scatter-gather blocks
+extern int cm256_decode_sg(
+    cm256_encoder_params params,  // Encoder parameters
+    const cm256_sg_block* blocks, // Array of 'originalCount' received blocks
+    void* const* outputs,         // Array of 'originalCount' output pointers, null to skip
+    cm256_pool* pool);            // Optional worker pool
+
+typedef struct cm256_sg_decode_stripe_t {
+    const cm256_sg_block* Blocks; // Array of 'originalCount' received blocks
+    void* const* Outputs;         // Array of 'originalCount' output pointers, null to skip
+} cm256_sg_decode_stripe;
+
+// Same as cm256_decode_sg() for a batch of stripes.  The blocks of every
+// stripe are checked before any output is written.
+extern int cm256_decode_sg_batch(
+    cm256_encoder_params params,           // Encoder parameters
+    const cm256_sg_decode_stripe* stripes, // Array of stripes to decode
+    int stripeCount,                       // Number of stripes
+    cm256_pool* pool);                     // Optional worker pool
+
+// Same as cm256_stream_encoder_push() for a scatter-gather original
+extern int cm256_stream_encoder_push_sg(
+    cm256_stream_encoder* encoder, // Encoder from cm256_stream_encoder_create()
+    int originalIndex,             // Return value from cm256_get_original_block_index()
+    const cm256_iovec* segments,   // Array of segments of the original block
+    int segmentCount);             // Number of segments
+
+// Same as cm256_stream_decoder_push() for a scatter-gather original.
+// Returns -1 for a recovery block.
+extern int cm256_stream_decoder_push_sg(
+    cm256_stream_decoder* decoder, // Decoder from cm256_stream_decoder_create()
+    const cm256_sg_block* block);  // Received original block
+
+/*
+ * Checksums
+ *
+ * cm256_crc32c() returns the CRC32C (Castagnoli) of the data, continuing
+ * from 'crc', which is 0 for the start of the data.  The CRC of a buffer
+ * in pieces is the CRC of each piece passed to the next.
+ *
+ * The _crc variants also return the CRC32C of every block they read or
+ * write, taken from each tile right after the coding pass over it while it
+ * is still in cache, rather than in another trip through memory afterwards.
+ * They run on the calling thread.
+ *
+ * cm256_encode_crc() fills in 'crcs' by block index: the originals, then
+ * the recovery blocks it produced.  cm256_decode_crc() fills in 'crcs' by
+ * original index, for the received and the recovered originals.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern uint32_t cm256_crc32c(uint32_t crc, const void* data, int bytes);
+
+extern int cm256_encode_crc(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks,        // Output recovery blocks end-to-end
+    uint32_t* crcs);             // Output 'originalCount' + 'recoveryCount' CRCs
+
+extern int cm256_decode_crc(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    uint32_t* crcs);             // Output 'originalCount' CRCs
+
+/*
+ * Decode plan
+ *
+ * The decoder's matrix math only depends on which block indices were
+ * received, not on the block data.  When the same set of blocks is lost
+ * across many stripes of data, a plan computes that math once so that each
+ * decode only runs the bulk elimination, with no allocation.
+ *
+ * 'indices' holds the 'originalCount' block indices that will be present,
+ * in any order.  The BlockBytes given at creation applies to every call.
+ *
+ * The plan is read-only after creation and may be used from several threads
+ * at once.
+ *
+ * Returns null if the parameters or indices are invalid or on allocation
+ * failure.
+ */
+typedef struct cm256_decode_plan_t cm256_decode_plan;
+
+extern cm256_decode_plan* cm256_decode_plan_create(
+    cm256_encoder_params params,   // Encoder parameters
+    const unsigned char* indices); // Array of 'originalCount' block indices
+extern void cm256_decode_plan_destroy(cm256_decode_plan* plan);
+
+// Same as cm256_decode_mt() using a plan.  The blocks may be in any order,
+// but their indices must be the ones the plan was created with.
+// 'pool' may be null to decode on the calling thread.
+extern int cm256_decode_plan_apply(
+    const cm256_decode_plan* plan, // Plan from cm256_decode_plan_create()
+    cm256_block* blocks,           // Array of 'originalCount' blocks as described above
+    cm256_pool* pool);             // Optional worker pool
+
+/*
+ * Decode plan cache
+ *
+ * Keeps up to 'capacity' decode plans keyed by the parameters and the set
+ * of received block indices, evicting the least recently used plan when
+ * full.  This suits applications that see a few loss patterns repeat
+ * without knowing them ahead of time.
+ *
+ * The cache may be shared between threads.
+ *
+ * Returns null on failure.
+ */
+typedef struct cm256_plan_cache_t cm256_plan_cache;
+
+extern cm256_plan_cache* cm256_plan_cache_create(int capacity);
+extern void cm256_plan_cache_destroy(cm256_plan_cache* cache);
+
+// Same as cm256_decode_mt(), using a cached plan for the received indices
+// or creating one on a miss.  'pool' may be null.
+extern int cm256_decode_cached(
+    cm256_plan_cache* cache,     // Cache from cm256_plan_cache_create()
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    cm256_pool* pool);           // Optional worker pool
+
+
+/*
+ * Batch encode and decode
+ *
+ * For applications that code many small independent stripes with the same
+ * parameters, these process a whole array of stripes in one call.  The
+ * parameters are validated and the coefficients computed once per batch
+ * rather than per stripe, and with a pool the stripes are spread over its
+ * threads.
+ *
+ * Each encode stripe is the 'originals' and 'recoveryBlocks' arguments of
+ * one cm256_encode() call.  Each decode stripe is the 'blocks' argument of
+ * one cm256_decode() call; stripes that received the same block indices
+ * share one decode plan.
+ *
+ * 'pool' may be null to run on the calling thread.
+ *
+ * Returns 0 on success, and any other code indicates failure.  If some of
+ * the decode stripes are invalid, the others are still decoded.
+ */
+typedef struct cm256_encode_stripe_t {
+    cm256_block* Originals;      // Array of pointers to original blocks
+    void* RecoveryBlocks;        // Output recovery blocks end-to-end
+} cm256_encode_stripe;
+
+extern int cm256_encode_batch(
+    cm256_encoder_params params,         // Encoder parameters
+    const cm256_encode_stripe* stripes,  // Array of stripes to encode
+    int stripeCount,                     // Number of stripes
+    cm256_pool* pool);                   // Optional worker pool
+
+// Same as cm256_encode_batch() using the parameters of the handle
+extern int cm256_encoder_encode_batch(
+    cm256_encoder* encoder,              // Encoder from cm256_encoder_create()
+    const cm256_encode_stripe* stripes,  // Array of stripes to encode
+    int stripeCount,                     // Number of stripes
+    cm256_pool* pool);                   // Optional worker pool
+
+extern int cm256_decode_batch(
+    cm256_encoder_params params,   // Encoder parameters
+    cm256_block* const* stripes,   // Array of stripes, each 'originalCount' blocks
+    int stripeCount,               // Number of stripes
+    cm256_pool* pool);             // Optional worker pool
+
+
+/*
+ * Large-block mode
+ *
+ * When all of the blocks of one encode or decode call add up to more than
+ * the threshold, the codec builds each tile of output in a small scratch
+ * buffer and writes it out with non-temporal stores, and prefetches the
+ * next tile of input while it works on the current one.  The outputs then
+ * do not push the inputs that are still needed out of the cache.  This
+ * suits archival encodes whose blocks are much bigger than the last-level
+ * cache, where the outputs are not read again before they are sent on.
+ *
+ * The mode is off by default, because cm256_bench did not find it faster
+ * than the default path at any size it measured, up to three times the
+ * size of the last-level cache.  cm256_set_large_block_threshold() turns it
+ * on for calls over that many bytes, and a negative value turns it off
+ * again.  Compare the encode_large and encode_cached cases of cm256_bench
+ * on a host first.
+ */
+extern long long cm256_get_large_block_threshold();
+extern void cm256_set_large_block_threshold(long long bytes);
+
+
+/*
+ * Aligned block arena
+ *
+ * For applications that code at a high rate, the arena hands out block
+ * buffers of one size from a single allocation that is reused, so that no
+ * call allocates.  Each block starts on a CM256_BLOCK_ALIGN byte boundary
+ * and has cm256_padded_bytes(blockBytes) bytes of room.  On Linux, arenas
+ * of 2 MiB or more are backed by transparent huge pages when available.
+ *
+ * cm256_arena_alloc() returns a block with the padding past 'blockBytes'
+ * zeroed, or null once all 'blockCount' blocks are in use.  Blocks go back
+ * to the arena with cm256_arena_free(), and all of them are released when
+ * the arena is destroyed.
+ *
+ * The arena may be shared between threads.
+ *
+ * Returns null on failure.
+ */
+#define CM256_BLOCK_ALIGN 64
+
+// Bytes of room in an aligned and padded block of 'blockBytes' bytes
+static inline int cm256_padded_bytes(int blockBytes)
+{
+    return (blockBytes + CM256_BLOCK_ALIGN - 1) & ~(CM256_BLOCK_ALIGN - 1);
+}
+
+typedef struct cm256_arena_t cm256_arena;
+
+extern cm256_arena* cm256_arena_create(int blockBytes, int blockCount);
+extern void cm256_arena_destroy(cm256_arena* arena);
+
+extern void* cm256_arena_alloc(cm256_arena* arena);
+extern void cm256_arena_free(cm256_arena* arena, void* block);
+
+/*
+ * Aligned and padded encode and decode
+ *
+ * Same as cm256_encode() and cm256_decode(), for blocks that the caller
+ * declares aligned and padded:
+ *
+ * + Every block starts on a CM256_BLOCK_ALIGN byte boundary, and so does
+ *   'recoveryBlocks'.
+ * + Every block has cm256_padded_bytes(BlockBytes) bytes of room, and the
+ *   recovery blocks are stored end-to-end at that stride.
+ * + The padding past BlockBytes is zero in the original blocks, and in the
+ *   received recovery blocks when decoding.
+ *
+ * Blocks from cm256_arena_alloc() meet all three.  The codec then works on
+ * whole padded blocks, so no kernel call has a tail to finish.  The code is
+ * linear, so zero padding in gives zero padding out: only BlockBytes of each
+ * block need be sent, and the receiver zero-pads what it receives.
+ *
+ * Returns -1 if a block is misaligned, and otherwise the same codes as
+ * cm256_encode() and cm256_decode().
+ */
+extern int cm256_encode_aligned(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end, padded
+
+extern int cm256_decode_aligned(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks);        // Array of 'originalCount' blocks as described above
+
+
+/*
+ * FFT mode encode and decode
+ *
+ * An alternative Reed-Solomon codec built on the additive FFT of Lin, Chung
+ * and Han, which costs O(n log n) in the number of blocks instead of the
+ * O(k * m) of the Cauchy matrix.  It is faster for large codes with many
+ * recovery blocks and slower for small ones; cm256_fft_preferred() picks
+ * between them using the crossover measured by cm256_bench.
+ *
+ * The recovery data differs from the Cauchy codec, so blocks encoded with
+ * cm256_fft_encode() must be decoded with cm256_fft_decode().  The block
+ * indices, the layout of the arguments and the error codes are otherwise
+ * the same as cm256_encode() and cm256_decode().
+ *
+ * Precondition: NextPow2(recoveryCount) + originalCount <= 256
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_fft_encode(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
+extern int cm256_fft_decode(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks);        // Array of 'originalCount' blocks as described above
+
+/*
+ * FFT mode is preferred when the Cauchy cost of about k * m block operations
+ * is at least CM256_FFT_CROSSOVER_PERCENT percent of the FFT cost of about
+ * n * log2(n), where n = NextPow2(NextPow2(m) + k), as measured by
+ * cm256_bench.
+ */
+#define CM256_FFT_CROSSOVER_PERCENT 180
+
+// Returns non-zero if FFT mode supports the parameters and is expected to
+// be faster than the Cauchy codec for them
+extern int cm256_fft_preferred(cm256_encoder_params params);
+
+/*
+ * XOR bitmatrix mode
+ *
+ * For hosts where table-based multiplies are slow, this mode expands each
+ * Cauchy coefficient into an 8x8 bit matrix and splits each block into 8
+ * packets, so that encoding and decoding are only XORs of packets.  The XOR
+ * schedule is optimized when the codec is created, and decode schedules are
+ * built on first use for each set of received block indices and kept in a
+ * least recently used cache of 'decodeCacheCapacity' entries.
+ *
+ * The recovery data differs from cm256_encode(), so blocks encoded with
+ * cm256_xor_encode() must be decoded with cm256_xor_decode().  The block
+ * indices, the layout of the arguments and the error codes are otherwise
+ * the same as cm256_encode() and cm256_decode().
+ *
+ * Precondition: BlockBytes is a multiple of 8
+ *
+ * The codec may be used from several threads at once.
+ *
+ * Returns null if the parameters are invalid or on allocation failure.
+ */
+typedef struct cm256_xor_codec_t cm256_xor_codec;
+
+extern cm256_xor_codec* cm256_xor_codec_create(cm256_encoder_params params, int decodeCacheCapacity);
+extern void cm256_xor_codec_destroy(cm256_xor_codec* codec);
+
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_xor_encode(
+    const cm256_xor_codec* codec, // Codec from cm256_xor_codec_create()
+    cm256_block* originals,       // Array of pointers to original blocks
+    void* recoveryBlocks);        // Output recovery blocks end-to-end
+
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_xor_decode(
+    cm256_xor_codec* codec,       // Codec from cm256_xor_codec_create()
+    cm256_block* blocks);         // Array of 'originalCount' blocks as described above
+
+// Same as cm256_xor_codec_create() with the given points
+extern cm256_xor_codec* cm256_xor_codec_create_with_points(
+    cm256_encoder_params params,       // Encoder parameters
+    const cm256_matrix_points* points, // Points the recovery data is encoded with
+    int decodeCacheCapacity);          // Number of decode schedules to keep
+
+// Returns the number of packet XORs in the encode schedule
+extern int cm256_xor_encode_cost(const cm256_xor_codec* codec);
+
+/*
+ * Statistics
+ *
+ * When the library is built with CM256_ENABLE_STATS defined, every thread
+ * counts the calls and the timer ticks spent in each phase of encoding and
+ * decoding, and the calls, bytes and ticks of each bulk memory kernel for
+ * the instruction set that ran it.  Without it these functions still exist,
+ * the hot paths contain no counting code, and the stats read as all zero.
+ *
+ * Phases nest: Coefficients includes LDU, and Decode includes everything
+ * below it.  Work done on pool threads is counted on those threads.  Kernel
+ * bytes count bytes read from each source, so a multi-source call over N
+ * sources counts N times its length.
+ *
+ * Ticks come from the TSC on x86 and are nanoseconds elsewhere.
+ * TicksPerSecond converts them.
+ */
+enum
+{
+    CM256_PHASE_ENCODE,               // EncodeBlockRange: one recovery row over one tile
+    CM256_PHASE_DECODE,               // cm256_decode() and the other full decoders
+    CM256_PHASE_DECODE_M1,            // The m=1 XOR decoder
+    CM256_PHASE_COEFFICIENTS,         // Decode matrix setup
+    CM256_PHASE_LDU,                  // GenerateLDUDecomposition
+    CM256_PHASE_ELIMINATE_ORIGINALS,  // Subtracting the received originals
+    CM256_PHASE_ELIMINATE_L,          // Forward substitution
+    CM256_PHASE_ELIMINATE_D,          // Diagonal
+    CM256_PHASE_ELIMINATE_U,          // Back substitution
+    CM256_PHASE_COUNT
+};
+
+enum
+{
+    CM256_KERNEL_ADD,                 // gf256_add_mem
+    CM256_KERNEL_ADD2,                // gf256_add2_mem
+    CM256_KERNEL_ADDSET,              // gf256_addset_mem
+    CM256_KERNEL_MUL,                 // gf256_mul_mem
+    CM256_KERNEL_MULADD,              // gf256_muladd_mem
+    CM256_KERNEL_MULADD_MULTI,        // The multi-source kernels
+    CM256_KERNEL_COUNT
+};
+
+enum
+{
+    CM256_ISA_PORTABLE,               // The scalar 64-bit kernels
+    CM256_ISA_SSSE3,
+    CM256_ISA_AVX2,
+    CM256_ISA_AVX512BW,
+    CM256_ISA_GFNI,
+    CM256_ISA_NEON,
+    CM256_ISA_SVE2,
+    CM256_ISA_COUNT
+};
+
+typedef struct cm256_phase_stats_t
+{
+    uint64_t Calls;
+    uint64_t Ticks;
+} cm256_phase_stats;
+
+typedef struct cm256_kernel_stats_t
+{
+    uint64_t Calls;
+    uint64_t Bytes;
+    uint64_t Ticks;
+} cm256_kernel_stats;
+
+typedef struct cm256_stats_t
+{
+    // Nonzero if the library was built with CM256_ENABLE_STATS
+    int Enabled;
+
+    // Instruction set picked by gf256_init(), one of CM256_ISA_*
+    int SelectedIsa;
+
+    // Rate of the timer ticks, or 0 if it is not known yet
+    double TicksPerSecond;
+
+    cm256_phase_stats Phases[CM256_PHASE_COUNT];
+    cm256_kernel_stats Kernels[CM256_ISA_COUNT][CM256_KERNEL_COUNT];
+} cm256_stats;
+
+// Sums the counters of every thread since the last reset.
+// Returns 0 on success, and any other code indicates failure.
+extern int cm256_get_stats(cm256_stats* stats);
+
+// Starts counting from zero again.  Threads are never stopped, so work in
+// flight on other threads may be split across the reset.
+extern void cm256_reset_stats();
+
+// Names for metrics, such as "eliminate_l", "muladd" and "AVX2"
+extern const char* cm256_stats_phase_name(int phase);
+extern const char* cm256_stats_kernel_name(int kernel);
+extern const char* cm256_stats_isa_name(int isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+
 #endif // CM256_H
\ No newline at end of file
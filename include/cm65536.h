@@ -0,0 +1,144 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef CM65536_H
+#define CM65536_H
+
+#include "gf65536.h"
+
+#include <assert.h>
+
+// Library version
+#define CM65536_VERSION 1
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cauchy MDS GF(65536) codec
+ *
+ * The same Cauchy code as cm256, over GF(2^16) so that a code may have up
+ * to 65536 original and recovery blocks in total.  The API mirrors cm256.h.
+ *
+ * Each GF(2^16) symbol is a little-endian 16-bit word, so BlockBytes must
+ * be even.  Multiplies cost a little more than in GF(256), so cm256 is
+ * still the better choice for codes that fit in 256 blocks.
+ *
+ * Decoding N lost blocks takes O(N^2) memory for the matrix decomposition.
+ */
+
+/*
+ * Verify binary compatibility with the API on startup.
+ *
+ * Example:
+ * 	if (cm65536_init()) exit(1);
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm65536_init_(int version);
+#define cm65536_init() cm65536_init_(CM65536_VERSION)
+
+
+// Encoder parameters
+typedef struct cm65536_encoder_params_t {
+    // Original block count
+    int OriginalCount;
+
+    // Recovery block count, with OriginalCount + RecoveryCount <= 65536
+    int RecoveryCount;
+
+    // Number of bytes per block (all blocks are the same size in bytes).
+    // Must be even.
+    int BlockBytes;
+} cm65536_encoder_params;
+
+// Descriptor for data block
+typedef struct cm65536_block_t {
+    // Pointer to data received.
+    void* Block;
+
+    // Block index, numbered the same way as cm256_block.
+    // Ignored during encoding, required during decoding.
+    unsigned short Index;
+} cm65536_block;
+
+
+// Compute the value to put in the Index member of cm65536_block
+static inline unsigned short cm65536_get_recovery_block_index(cm65536_encoder_params params, int recoveryBlockIndex)
+{
+    assert(recoveryBlockIndex >= 0 && recoveryBlockIndex < params.RecoveryCount);
+    return (unsigned short)(params.OriginalCount + recoveryBlockIndex);
+}
+static inline unsigned short cm65536_get_original_block_index(cm65536_encoder_params params, int originalBlockIndex)
+{
+    assert(originalBlockIndex >= 0 && originalBlockIndex < params.OriginalCount);
+    return (unsigned short)(originalBlockIndex);
+}
+
+
+/*
+ * Cauchy MDS GF(65536) encode
+ *
+ * Same as cm256_encode().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm65536_encode(
+    cm65536_encoder_params params, // Encoder parameters
+    cm65536_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);         // Output recovery blocks end-to-end
+
+// Encode one block.
+// Note: This function does not validate input, use with care.
+extern void cm65536_encode_block(
+    cm65536_encoder_params params, // Encoder parameters
+    cm65536_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,        // Return value from cm65536_get_recovery_block_index()
+    void* recoveryBlock);          // Output recovery block
+
+/*
+ * Cauchy MDS GF(65536) decode
+ *
+ * Same as cm256_decode().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm65536_decode(
+    cm65536_encoder_params params, // Encoder parameters
+    cm65536_block* blocks);        // Array of 'originalCount' blocks as described above
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM65536_H
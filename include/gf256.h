@@ -1,277 +1,401 @@
-/** \file
-    \brief GF(256) Main C API Header
-    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
-
-    Redistribution and use in source and binary forms, with or without
-    modification, are permitted provided that the following conditions are met:
-
-    * Redistributions of source code must retain the above copyright notice,
-      this list of conditions and the following disclaimer.
-    * Redistributions in binary form must reproduce the above copyright notice,
-      this list of conditions and the following disclaimer in the documentation
-      and/or other materials provided with the distribution.
-    * Neither the name of GF256 nor the names of its contributors may be
-      used to endorse or promote products derived from this software without
-      specific prior written permission.
-
-    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
-    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
-    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
-    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
-    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
-    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
-    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
-    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
-    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
-    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
-    POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#ifndef CAT_GF256_H
-#define CAT_GF256_H
-
-/** \page GF256 GF(256) Math Module
-
-    This module provides efficient implementations of bulk
-    GF(2^^8) math operations over memory buffers.
-
-    Addition is done over the base field in GF(2) meaning
-    that addition is XOR between memory buffers.
-
-    Multiplication is performed using table lookups via
-    SIMD instructions.  This is somewhat slower than XOR,
-    but fast enough to not become a major bottleneck when
-    used sparingly.
-*/
-
-#include <stdint.h> // uint32_t etc
-#include <cstring> // memcpy, memset
-
-/// Library header version
-#define GF256_VERSION 2
-
-//------------------------------------------------------------------------------
-// Platform/Architecture
-
-#if defined(__ARM_ARCH) || defined(__ARM_NEON) || defined(__ARM_NEON__)
-    #if !defined IOS
-        #define LINUX_ARM
-    #endif
-#endif
-
-#if defined(ANDROID) || defined(IOS) || defined(LINUX_ARM) || defined(__powerpc__) || defined(__s390__)
-    #define GF256_TARGET_MOBILE
-#endif // ANDROID
-
-#if defined(__AVX2__) && (!defined (_MSC_VER) || _MSC_VER >= 1900)
-    #define GF256_TRY_AVX2 /* 256-bit */
-    #include <immintrin.h>
-    #define GF256_ALIGN_BYTES 32
-#else // __AVX2__
-    #define GF256_ALIGN_BYTES 16
-#endif // __AVX2__
-
-#if !defined(GF256_TARGET_MOBILE)
-    #include <tmmintrin.h> // SSSE3: _mm_shuffle_epi8
-    #include <emmintrin.h> // SSE2
-#endif // GF256_TARGET_MOBILE
-
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    #include <arm_neon.h>
-    #define GF256_TRY_NEON
-#endif
-
-// Compiler-specific 128-bit SIMD register keyword
-#if defined(GF256_TARGET_MOBILE)
-#if defined(GF256_TRY_NEON)
-    #define GF256_M128 uint8x16_t
-#else
-    #define GF256_M128 uint64_t
-#endif // GF256_TRY_NEON
-#else // GF256_TARGET_MOBILE
-    #define GF256_M128 __m128i
-#endif // GF256_TARGET_MOBILE
-
-// Compiler-specific 256-bit SIMD register keyword
-#ifdef GF256_TRY_AVX2
-    #define GF256_M256 __m256i
-#endif
-
-// Compiler-specific C++11 restrict keyword
-#define GF256_RESTRICT __restrict
-
-// Compiler-specific force inline keyword
-#ifdef _MSC_VER
-    #define GF256_FORCE_INLINE inline __forceinline
-#else
-    #define GF256_FORCE_INLINE inline __attribute__((always_inline))
-#endif
-
-// Compiler-specific alignment keyword
-// Note: Alignment only matters for ARM NEON where it should be 16
-#ifdef _MSC_VER
-    #define GF256_ALIGNED __declspec(align(GF256_ALIGN_BYTES))
-#else // _MSC_VER
-    #define GF256_ALIGNED __attribute__((aligned(GF256_ALIGN_BYTES)))
-#endif // _MSC_VER
-
-#ifdef __cplusplus
-extern "C" {
-#endif // __cplusplus
-
-
-//------------------------------------------------------------------------------
-// Portability
-
-/// Swap two memory buffers in-place
-extern void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes);
-
-
-//------------------------------------------------------------------------------
-// GF(256) Context
-
-#ifdef _MSC_VER
-    #pragma warning(push)
-    #pragma warning(disable: 4324) // warning C4324: 'gf256_ctx' : structure was padded due to __declspec(align())
-#endif // _MSC_VER
-
-/// The context object stores tables required to perform library calculations
-struct gf256_ctx
-{
-    /// We require memory to be aligned since the SIMD instructions benefit from
-    /// or require aligned accesses to the table data.
-    struct
-    {
-        GF256_ALIGNED GF256_M128 TABLE_LO_Y[256];
-        GF256_ALIGNED GF256_M128 TABLE_HI_Y[256];
-    } MM128;
-#ifdef GF256_TRY_AVX2
-    struct
-    {
-        GF256_ALIGNED GF256_M256 TABLE_LO_Y[256];
-        GF256_ALIGNED GF256_M256 TABLE_HI_Y[256];
-    } MM256;
-#endif // GF256_TRY_AVX2
-
-    /// Mul/Div/Inv/Sqr tables
-    uint8_t GF256_MUL_TABLE[256 * 256];
-    uint8_t GF256_DIV_TABLE[256 * 256];
-    uint8_t GF256_INV_TABLE[256];
-    uint8_t GF256_SQR_TABLE[256];
-
-    /// Log/Exp tables
-    uint16_t GF256_LOG_TABLE[256];
-    uint8_t GF256_EXP_TABLE[512 * 2 + 1];
-
-    /// Polynomial used
-    unsigned Polynomial;
-};
-
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif // _MSC_VER
-
-extern gf256_ctx GF256Ctx;
-
-
-//------------------------------------------------------------------------------
-// Initialization
-
-/**
-    Initialize a context, filling in the tables.
-    
-    Thread-safety / Usage Notes:
-    
-    It is perfectly safe and encouraged to use a gf256_ctx object from multiple
-    threads.  The gf256_init() is relatively expensive and should only be done
-    once, though it will take less than a millisecond.
-    
-    The gf256_ctx object must be aligned to 16 byte boundary.
-    Simply tag the object with GF256_ALIGNED to achieve this.
-    
-    Example:
-       static GF256_ALIGNED gf256_ctx TheGF256Context;
-       gf256_init(&TheGF256Context, 0);
-    
-    Returns 0 on success and other values on failure.
-*/
-extern int gf256_init_(int version);
-#define gf256_init() gf256_init_(GF256_VERSION)
-
-
-//------------------------------------------------------------------------------
-// Math Operations
-
-/// return x + y
-static GF256_FORCE_INLINE uint8_t gf256_add(uint8_t x, uint8_t y)
-{
-    return (uint8_t)(x ^ y);
-}
-
-/// return x * y
-/// For repeated multiplication by a constant, it is faster to put the constant in y.
-static GF256_FORCE_INLINE uint8_t gf256_mul(uint8_t x, uint8_t y)
-{
-    return GF256Ctx.GF256_MUL_TABLE[((unsigned)y << 8) + x];
-}
-
-/// return x / y
-/// Memory-access optimized for constant divisors in y.
-static GF256_FORCE_INLINE uint8_t gf256_div(uint8_t x, uint8_t y)
-{
-    return GF256Ctx.GF256_DIV_TABLE[((unsigned)y << 8) + x];
-}
-
-/// return 1 / x
-static GF256_FORCE_INLINE uint8_t gf256_inv(uint8_t x)
-{
-    return GF256Ctx.GF256_INV_TABLE[x];
-}
-
-/// return x * x
-static GF256_FORCE_INLINE uint8_t gf256_sqr(uint8_t x)
-{
-    return GF256Ctx.GF256_SQR_TABLE[x];
-}
-
-
-//------------------------------------------------------------------------------
-// Bulk Memory Math Operations
-
-/// Performs "x[] += y[]" bulk memory XOR operation
-extern void gf256_add_mem(void * GF256_RESTRICT vx,
-                          const void * GF256_RESTRICT vy, int bytes);
-
-/// Performs "z[] += x[] + y[]" bulk memory operation
-extern void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                           const void * GF256_RESTRICT vy, int bytes);
-
-/// Performs "z[] = x[] + y[]" bulk memory operation
-extern void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                             const void * GF256_RESTRICT vy, int bytes);
-
-/// Performs "z[] = x[] * y" bulk memory operation
-extern void gf256_mul_mem(void * GF256_RESTRICT vz,
-                          const void * GF256_RESTRICT vx, uint8_t y, int bytes);
-
-/// Performs "z[] += x[] * y" bulk memory operation
-extern void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
-                             const void * GF256_RESTRICT vx, int bytes);
-
-/// Performs "x[] /= y" bulk memory operation
-static GF256_FORCE_INLINE void gf256_div_mem(void * GF256_RESTRICT vz,
-                                             const void * GF256_RESTRICT vx, uint8_t y, int bytes)
-{
-    // Multiply by inverse
-    gf256_mul_mem(vz, vx, y == 1 ? (uint8_t)1 : GF256Ctx.GF256_INV_TABLE[y], bytes);
-}
-
-
-//------------------------------------------------------------------------------
-// Misc Operations
-
-#ifdef __cplusplus
-}
-#endif // __cplusplus
-
+/** \file
+    \brief GF(256) Main C API Header
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAT_GF256_H
+#define CAT_GF256_H
+
+/** \page GF256 GF(256) Math Module
+
+    This module provides efficient implementations of bulk
+    GF(2^^8) math operations over memory buffers.
+
+    Addition is done over the base field in GF(2) meaning
+    that addition is XOR between memory buffers.
+
+    Multiplication is performed using table lookups via
+    SIMD instructions.  This is somewhat slower than XOR,
+    but fast enough to not become a major bottleneck when
+    used sparingly.
+*/
+
+#include <stdint.h> // uint32_t etc
+#include <cstring> // memcpy, memset
+
+/// Library header version.  GF256_COMPACT_CONTEXT changes the layout of
+/// gf256_ctx, so it sets GF256_VERSION_COMPACT in the version, and
+/// gf256_init() fails if the header and the library disagree on it.
+#define GF256_VERSION_COMPACT 0x100
+#ifdef GF256_COMPACT_CONTEXT
+    #define GF256_VERSION (2 | GF256_VERSION_COMPACT)
+#else
+    #define GF256_VERSION 2
+#endif
+
+//------------------------------------------------------------------------------
+// Platform/Architecture
+
+#if defined(__ARM_ARCH) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #if !defined IOS
+        #define LINUX_ARM
+    #endif
+#endif
+
+#if defined(ANDROID) || defined(IOS) || defined(LINUX_ARM) || defined(__powerpc__) || defined(__s390__)
+    #define GF256_TARGET_MOBILE
+#endif // ANDROID
+
+// The SIMD kernels are compiled once per instruction set in their own
+// translation units and selected at runtime, so the AVX2 tables must be
+// present regardless of the flags used to compile the including file.
+#if !defined(GF256_TARGET_MOBILE) && (!defined (_MSC_VER) || _MSC_VER >= 1900)
+    #define GF256_TRY_AVX2 /* 256-bit */
+    #include <immintrin.h>
+    #define GF256_ALIGN_BYTES 32
+#else // GF256_TARGET_MOBILE
+    #define GF256_ALIGN_BYTES 16
+#endif // GF256_TARGET_MOBILE
+
+#if !defined(GF256_TARGET_MOBILE)
+    #include <tmmintrin.h> // SSSE3: _mm_shuffle_epi8
+    #include <emmintrin.h> // SSE2
+#endif // GF256_TARGET_MOBILE
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define GF256_TRY_NEON
+#endif
+
+// Compiler-specific 128-bit SIMD register keyword
+#if defined(GF256_TARGET_MOBILE)
+#if defined(GF256_TRY_NEON)
+    #define GF256_M128 uint8x16_t
+#else
+    #define GF256_M128 uint64_t
+#endif // GF256_TRY_NEON
+#else // GF256_TARGET_MOBILE
+    #define GF256_M128 __m128i
+#endif // GF256_TARGET_MOBILE
+
+// Compiler-specific 256-bit SIMD register keyword
+#ifdef GF256_TRY_AVX2
+    #define GF256_M256 __m256i
+#endif
+
+// Compiler-specific C++11 restrict keyword
+#define GF256_RESTRICT __restrict
+
+// Compiler-specific force inline keyword
+#ifdef _MSC_VER
+    #define GF256_FORCE_INLINE inline __forceinline
+#else
+    #define GF256_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// Compiler-specific alignment keyword
+// Note: Alignment only matters for ARM NEON where it should be 16
+#ifdef _MSC_VER
+    #define GF256_ALIGNED __declspec(align(GF256_ALIGN_BYTES))
+#else // _MSC_VER
+    #define GF256_ALIGNED __attribute__((aligned(GF256_ALIGN_BYTES)))
+#endif // _MSC_VER
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+
+//------------------------------------------------------------------------------
+// Portability
+
+/// Swap two memory buffers in-place
+extern void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes);
+
+/// Copy x[] to z[] with non-temporal stores where the CPU has them, so that
+/// output that is not read again soon does not evict data still in use.
+/// The stores are weakly ordered: call gf256_stream_fence() before the data
+/// is read by another thread or handed to a device.
+extern void gf256_stream_copy_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, int bytes);
+
+/// Orders the stores of gf256_stream_copy_mem() before any later stores
+extern void gf256_stream_fence();
+
+/// Hint that x[] will be read soon, fetching it into the L2 cache
+extern void gf256_prefetch_mem(const void * vx, int bytes);
+
+
+//------------------------------------------------------------------------------
+// GF(256) Context
+
+#ifdef _MSC_VER
+    #pragma warning(push)
+    #pragma warning(disable: 4324) // warning C4324: 'gf256_ctx' : structure was padded due to __declspec(align())
+#endif // _MSC_VER
+
+/// The context object stores tables required to perform library calculations
+/// The tables are generated at build time by gf256_tablegen.cpp and the
+/// context is read-only data, so processes share its pages.
+///
+/// Building with GF256_COMPACT_CONTEXT defined leaves out the 64 KiB
+/// multiply and divide tables and the 256-bit nibble tables.  Scalar math then
+/// goes through the log/exp tables and the SIMD kernels load only the 32
+/// bytes of nibble tables for each coefficient in use, so the working set
+/// stays in L1 next to the data being streamed.  The define must be the same
+/// for the library and every file that includes this header.
+struct gf256_ctx
+{
+    /// We require memory to be aligned since the SIMD instructions benefit from
+    /// or require aligned accesses to the table data.  The nibble tables are
+    /// stored as bytes so they can be initialized the same way on every
+    /// compiler; each row is loaded as one GF256_M128 or GF256_M256.
+    struct
+    {
+        GF256_ALIGNED uint8_t TABLE_LO_Y[256][16];
+        GF256_ALIGNED uint8_t TABLE_HI_Y[256][16];
+    } MM128;
+#if defined(GF256_TRY_AVX2) && !defined(GF256_COMPACT_CONTEXT)
+    struct
+    {
+        GF256_ALIGNED uint8_t TABLE_LO_Y[256][32];
+        GF256_ALIGNED uint8_t TABLE_HI_Y[256][32];
+    } MM256;
+#endif // GF256_TRY_AVX2
+
+    /// Mul/Div/Inv/Sqr tables
+#ifndef GF256_COMPACT_CONTEXT
+    uint8_t GF256_MUL_TABLE[256 * 256];
+    uint8_t GF256_DIV_TABLE[256 * 256];
+#endif // GF256_COMPACT_CONTEXT
+    uint8_t GF256_INV_TABLE[256];
+    uint8_t GF256_SQR_TABLE[256];
+
+    /// Bit matrix for multiplying by each y, in the 8x8 layout expected by
+    /// the GF2P8AFFINEQB instruction.  Byte (7 - i) holds row i: bit j is
+    /// set when bit i of (y * 2^j) is set.
+    uint64_t GF256_AFFINE_TABLE[256];
+
+    /// Log/Exp tables.  The log of 0 is 512, which lands every product or
+    /// quotient of 0 in the zero tail of the exp table.
+    uint16_t GF256_LOG_TABLE[256];
+    uint8_t GF256_EXP_TABLE[512 * 2 + 1];
+
+    /// Polynomial used
+    unsigned Polynomial;
+};
+
+#ifdef _MSC_VER
+    #pragma warning(pop)
+#endif // _MSC_VER
+
+extern const gf256_ctx GF256Ctx;
+
+
+//------------------------------------------------------------------------------
+// Initialization
+
+/**
+    Initialize a context, filling in the tables.
+    
+    Thread-safety / Usage Notes:
+    
+    It is perfectly safe and encouraged to use a gf256_ctx object from multiple
+    threads.  The tables are generated at build time, so gf256_init() only
+    detects the CPU and picks the kernels, and later calls return at once.
+    Builds with GF256_INIT_SELF_TEST or DEBUG defined also check the kernels.
+    
+    The gf256_ctx object must be aligned to 16 byte boundary.
+    Simply tag the object with GF256_ALIGNED to achieve this.
+    
+    Example:
+       static GF256_ALIGNED gf256_ctx TheGF256Context;
+       gf256_init(&TheGF256Context, 0);
+    
+    Returns 0 on success and other values on failure.
+*/
+extern int gf256_init_(int version);
+#define gf256_init() gf256_init_(GF256_VERSION)
+
+/// Returns the name of the SIMD kernels selected by gf256_init() for this CPU:
+/// "GFNI", "AVX512BW", "AVX2", "SSSE3", "SVE2", "NEON" or "Portable"
+extern const char* gf256_kernels_name();
+
+
+//------------------------------------------------------------------------------
+// Math Operations
+
+/// return x + y
+static GF256_FORCE_INLINE uint8_t gf256_add(uint8_t x, uint8_t y)
+{
+    return (uint8_t)(x ^ y);
+}
+
+/// return x * y
+/// For repeated multiplication by a constant, it is faster to put the constant in y.
+static GF256_FORCE_INLINE uint8_t gf256_mul(uint8_t x, uint8_t y)
+{
+#ifdef GF256_COMPACT_CONTEXT
+    return GF256Ctx.GF256_EXP_TABLE[GF256Ctx.GF256_LOG_TABLE[x] + GF256Ctx.GF256_LOG_TABLE[y]];
+#else
+    return GF256Ctx.GF256_MUL_TABLE[((unsigned)y << 8) + x];
+#endif
+}
+
+/// return x / y
+/// Memory-access optimized for constant divisors in y.
+static GF256_FORCE_INLINE uint8_t gf256_div(uint8_t x, uint8_t y)
+{
+#ifdef GF256_COMPACT_CONTEXT
+    // The low byte of the log of 0 is 0, which keeps the index in range, and
+    // the mask returns 0 for y = 0 like the full table
+    const unsigned log_yn = 255 - (uint8_t)GF256Ctx.GF256_LOG_TABLE[y];
+    return GF256Ctx.GF256_EXP_TABLE[GF256Ctx.GF256_LOG_TABLE[x] + log_yn] & (uint8_t)-(y != 0);
+#else
+    return GF256Ctx.GF256_DIV_TABLE[((unsigned)y << 8) + x];
+#endif
+}
+
+/// return 1 / x
+static GF256_FORCE_INLINE uint8_t gf256_inv(uint8_t x)
+{
+    return GF256Ctx.GF256_INV_TABLE[x];
+}
+
+/// return x * x
+static GF256_FORCE_INLINE uint8_t gf256_sqr(uint8_t x)
+{
+    return GF256Ctx.GF256_SQR_TABLE[x];
+}
+
+
+//------------------------------------------------------------------------------
+// Bulk Memory Math Operations
+
+/// Performs "x[] += y[]" bulk memory XOR operation
+extern void gf256_add_mem(void * GF256_RESTRICT vx,
+                          const void * GF256_RESTRICT vy, int bytes);
+
+/// Performs "z[] += x[] + y[]" bulk memory operation
+extern void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                           const void * GF256_RESTRICT vy, int bytes);
+
+/// Performs "z[] = x[] + y[]" bulk memory operation
+extern void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                             const void * GF256_RESTRICT vy, int bytes);
+
+/// Performs "z[] = x[] * y" bulk memory operation
+extern void gf256_mul_mem(void * GF256_RESTRICT vz,
+                          const void * GF256_RESTRICT vx, uint8_t y, int bytes);
+
+/// Performs "z[] += x[] * y" bulk memory operation
+extern void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                             const void * GF256_RESTRICT vx, int bytes);
+
+/**
+    Performs "z[] += x_0[] * y_0 + x_1[] * y_1 + ..." bulk memory operation
+    over `count` source buffers, given as arrays of coefficients and pointers.
+
+    Sources are accumulated 8, 4 or 2 at a time while the destination is held
+    in registers, so the destination is read and written once per group of
+    sources rather than once per source.  Sources with a zero coefficient are
+    skipped.
+*/
+extern void gf256_muladd_multi_mem(void * GF256_RESTRICT vz, const uint8_t * y,
+                                   const void * const * vx, int count, int bytes);
+
+/// Performs "z[] = x_0[] * y_0 + x_1[] * y_1 + ..." bulk memory operation.
+/// Same as gf256_muladd_multi_mem() except that the destination is not read.
+extern void gf256_mul_multi_mem(void * GF256_RESTRICT vz, const uint8_t * y,
+                                const void * const * vx, int count, int bytes);
+
+/**
+    Precomputed tables for multiplying by one coefficient y.
+
+    Callers that apply the same coefficients many times can fill these in
+    once with gf256_mul_tables_init() and pass an array of them to
+    gf256_muladd_multi_tables_mem(), which then reads its tables from one
+    contiguous array instead of looking them up in the context per call.
+
+    The bulk kernels only read Lo, Hi and Affine, so the tables can describe
+    any GF(2)-linear map on bytes, such as multiplication in a different
+    field representation.
+*/
+typedef struct gf256_mul_tables_t
+{
+    /// Lo[x] = x * y, Hi[x] = (x << 4) * y, for x = 0..15
+    uint8_t Lo[16];
+    uint8_t Hi[16];
+
+    /// Bit matrix for y in the layout of GF256_AFFINE_TABLE
+    uint64_t Affine;
+
+    /// The coefficient itself
+    uint8_t Y;
+} gf256_mul_tables;
+
+/// Fill in the tables for multiplying by y
+extern void gf256_mul_tables_init(gf256_mul_tables * tables, uint8_t y);
+
+/// Performs "z[] += x_0[] * y_0 + x_1[] * y_1 + ..." bulk memory operation,
+/// where the coefficients are given as an array of precomputed tables.
+extern void gf256_muladd_multi_tables_mem(void * GF256_RESTRICT vz, const gf256_mul_tables * tables,
+                                          const void * const * vx, int count, int bytes);
+
+/// Performs "z[] = x_0[] * y_0 + x_1[] * y_1 + ..." bulk memory operation,
+/// where the coefficients are given as an array of precomputed tables.
+extern void gf256_mul_multi_tables_mem(void * GF256_RESTRICT vz, const gf256_mul_tables * tables,
+                                       const void * const * vx, int count, int bytes);
+
+/**
+    Performs "z_i[] += x[] * y_i" bulk memory operation for each of `count`
+    destination buffers, given as arrays of coefficients and pointers.
+
+    This is the transpose of gf256_muladd_multi_mem(): the source is read once
+    per group of 8, 4 or 2 destinations rather than once per destination.
+    Destinations with a zero coefficient are skipped.  The destinations must
+    not overlap the source or each other.
+*/
+extern void gf256_muladd_spread_mem(void * const * vz, const uint8_t * y,
+                                    const void * GF256_RESTRICT vx, int count, int bytes);
+
+/// Performs "x[] /= y" bulk memory operation
+static GF256_FORCE_INLINE void gf256_div_mem(void * GF256_RESTRICT vz,
+                                             const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    // Multiply by inverse
+    gf256_mul_mem(vz, vx, y == 1 ? (uint8_t)1 : GF256Ctx.GF256_INV_TABLE[y], bytes);
+}
+
+
+//------------------------------------------------------------------------------
+// Misc Operations
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
 #endif // CAT_GF256_H
\ No newline at end of file
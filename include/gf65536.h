@@ -0,0 +1,158 @@
+/** \file
+    \brief GF(2^^16) Math Module
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef CAT_GF65536_H
+#define CAT_GF65536_H
+
+/** \page GF65536 GF(65536) Math Module
+
+    This module provides GF(2^^16) math over memory buffers, for codes with
+    more than 256 symbols.  Buffers are arrays of little-endian 16-bit words,
+    so every buffer length in bytes must be even.
+
+    Addition is XOR, the same as in GF(256).
+
+    Multiplication by a constant y splits each word into four nibbles, and
+    looks up the product of y with each nibble in a 16-entry table.  The low
+    and high bytes of those products are kept in separate tables so that the
+    SIMD kernels can do each lookup with a byte shuffle, eight shuffles per
+    vector of words.
+*/
+
+#include "gf256.h"
+
+/// Library header version
+#define GF65536_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+
+//------------------------------------------------------------------------------
+// GF(65536) Context
+
+/// The context object stores the log/exp tables needed for fast math
+typedef struct gf65536_ctx_t
+{
+    /// Log[x] = log of x to the generator, for x != 0
+    uint16_t Log[65536];
+
+    /// Exp[i] = generator^i, doubled in length to skip a modulo in mul
+    uint16_t Exp[65536 * 2];
+} gf65536_ctx;
+
+extern gf65536_ctx GF65536Ctx;
+
+
+//------------------------------------------------------------------------------
+// Initialization
+
+/**
+    Fill in the tables and select the SIMD kernels for this CPU.
+
+    This also initializes the GF(256) module, whose CPU detection it shares.
+    As with gf256_init() it is safe to call more than once.
+
+    Returns 0 on success and other values on failure.
+*/
+extern int gf65536_init_(int version);
+#define gf65536_init() gf65536_init_(GF65536_VERSION)
+
+/// Returns the name of the SIMD kernels selected by gf65536_init() for this CPU:
+/// "AVX2", "SSSE3" or "Portable"
+extern const char* gf65536_kernels_name();
+
+
+//------------------------------------------------------------------------------
+// Math Operations
+
+/// return x + y
+static GF256_FORCE_INLINE uint16_t gf65536_add(uint16_t x, uint16_t y)
+{
+    return (uint16_t)(x ^ y);
+}
+
+/// return x * y
+static GF256_FORCE_INLINE uint16_t gf65536_mul(uint16_t x, uint16_t y)
+{
+    if (x == 0 || y == 0)
+        return 0;
+    return GF65536Ctx.Exp[(unsigned)GF65536Ctx.Log[x] + GF65536Ctx.Log[y]];
+}
+
+/// return x / y, where y != 0
+static GF256_FORCE_INLINE uint16_t gf65536_div(uint16_t x, uint16_t y)
+{
+    if (x == 0)
+        return 0;
+    return GF65536Ctx.Exp[(unsigned)GF65536Ctx.Log[x] + 65535 - GF65536Ctx.Log[y]];
+}
+
+/// return 1 / x, where x != 0
+static GF256_FORCE_INLINE uint16_t gf65536_inv(uint16_t x)
+{
+    return GF65536Ctx.Exp[65535 - GF65536Ctx.Log[x]];
+}
+
+
+//------------------------------------------------------------------------------
+// Bulk Memory Math Operations
+
+/// Performs "x[] += y[]" bulk memory XOR operation
+extern void gf65536_add_mem(void * GF256_RESTRICT vx,
+                            const void * GF256_RESTRICT vy, int bytes);
+
+/// Performs "z[] = x[] + y[]" bulk memory operation
+extern void gf65536_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes);
+
+/// Performs "z[] += x[] * y" bulk memory operation
+extern void gf65536_muladd_mem(void * GF256_RESTRICT vz, uint16_t y,
+                               const void * GF256_RESTRICT vx, int bytes);
+
+/// Performs "z[] = x[] * y" bulk memory operation
+extern void gf65536_mul_mem(void * GF256_RESTRICT vz,
+                            const void * GF256_RESTRICT vx, uint16_t y, int bytes);
+
+/// Performs "x[] /= y" bulk memory operation
+static GF256_FORCE_INLINE void gf65536_div_mem(void * GF256_RESTRICT vz,
+                                               const void * GF256_RESTRICT vx, uint16_t y, int bytes)
+{
+    // Multiply by inverse
+    gf65536_mul_mem(vz, vx, y == 1 ? (uint16_t)1 : gf65536_inv(y), bytes);
+}
+
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // CAT_GF65536_H
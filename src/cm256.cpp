@@ -1,603 +1,2283 @@
-/*
-	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
-
-	Redistribution and use in source and binary forms, with or without
-	modification, are permitted provided that the following conditions are met:
-
-	* Redistributions of source code must retain the above copyright notice,
-	  this list of conditions and the following disclaimer.
-	* Redistributions in binary form must reproduce the above copyright notice,
-	  this list of conditions and the following disclaimer in the documentation
-	  and/or other materials provided with the distribution.
-	* Neither the name of CM256 nor the names of its contributors may be
-	  used to endorse or promote products derived from this software without
-	  specific prior written permission.
-
-	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
-	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
-	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
-	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
-	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
-	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
-	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
-	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
-	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
-	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
-	POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#include "cm256.h"
-
-
-/*
-    GF(256) Cauchy Matrix Overview
-
-    As described on Wikipedia, each element of a normal Cauchy matrix is defined as:
-
-        a_ij = 1 / (x_i - y_j)
-        The arrays x_i and y_j are vector parameters of the matrix.
-        The values in x_i cannot be reused in y_j.
-
-    Moving beyond the Wikipedia...
-
-    (1) Number of rows (R) is the range of i, and number of columns (C) is the range of j.
-
-    (2) Being able to select x_i and y_j makes Cauchy matrices more flexible in practice
-        than Vandermonde matrices, which only have one parameter per row.
-
-    (3) Cauchy matrices are always invertible, AKA always full rank, AKA when treated as
-        as linear system y = M*x, the linear system has a single solution.
-
-    (4) A Cauchy matrix concatenated below a square CxC identity matrix always has rank C,
-        Meaning that any R rows can be eliminated from the concatenated matrix and the
-        matrix will still be invertible.  This is how Reed-Solomon erasure codes work.
-
-    (5) Any row or column can be multiplied by non-zero values, and the resulting matrix
-        is still full rank.  This is true for any matrix, since it is effectively the same
-        as pre and post multiplying by diagonal matrices, which are always invertible.
-
-    (6) Matrix elements with a value of 1 are much faster to operate on than other values.
-        For instance a matrix of [1, 1, 1, 1, 1] is invertible and much faster for various
-        purposes than [2, 2, 2, 2, 2].
-
-    (7) For GF(256) matrices, the symbols in x_i and y_j are selected from the numbers
-        0...255, and so the number of rows + number of columns may not exceed 256.
-        Note that values in x_i and y_j may not be reused as stated above.
-
-    In summary, Cauchy matrices
-        are preferred over Vandermonde matrices.  (2)
-        are great for MDS erasure codes.  (3) and (4)
-        should be optimized to include more 1 elements.  (5) and (6)
-        have a limited size in GF(256), rows+cols <= 256.  (7)
-*/
-
-
-//-----------------------------------------------------------------------------
-// Initialization
-
-extern "C" int cm256_init_(int version)
-{
-    if (version != CM256_VERSION)
-    {
-        // User's header does not match library version
-        return -10;
-    }
-
-    // Return error code from GF(256) init if required
-    return gf256_init();
-}
-
-
-/*
-    Selected Cauchy Matrix Form
-
-    The matrix consists of elements a_ij, where i = row, j = column.
-    a_ij = 1 / (x_i - y_j), where x_i and y_j are sets of GF(256) values
-    that do not intersect.
-
-    We select x_i and y_j to just be incrementing numbers for the
-    purposes of this library.  Further optimizations may yield matrices
-    with more 1 elements, but the benefit seems relatively small.
-
-    The x_i values range from 0...(originalCount - 1).
-    The y_j values range from originalCount...(originalCount + recoveryCount - 1).
-
-    We then improve the Cauchy matrix by dividing each column by the
-    first row element of that column.  The result is an invertible
-    matrix that has all 1 elements in the first row.  This is equivalent
-    to a rotated Vandermonde matrix, so we could have used one of those.
-
-    The advantage of doing this is that operations involving the first
-    row will be extremely fast (just memory XOR), so the decoder can
-    be optimized to take advantage of the shortcut when the first
-    recovery row can be used.
-
-    First row element of Cauchy matrix for each column:
-    a_0j = 1 / (x_0 - y_j) = 1 / (x_0 - y_j)
-
-    Our Cauchy matrix sets first row to ones, so:
-    a_ij = (1 / (x_i - y_j)) / a_0j
-    a_ij = (y_j - x_0) / (x_i - y_j)
-    a_ij = (y_j + x_0) div (x_i + y_j) in GF(256)
-*/
-
-// This function generates each matrix element based on x_i, x_0, y_j
-// Note that for x_i == x_0, this will return 1, so it is better to unroll out the first row.
-static GF256_FORCE_INLINE unsigned char GetMatrixElement(unsigned char x_i, unsigned char x_0, unsigned char y_j)
-{
-    return gf256_div(gf256_add(y_j, x_0), gf256_add(x_i, y_j));
-}
-
-
-//-----------------------------------------------------------------------------
-// Encoding
-
-extern "C" void cm256_encode_block(
-    cm256_encoder_params params, // Encoder parameters
-    cm256_block* originals,      // Array of pointers to original blocks
-    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
-    void* recoveryBlock)         // Output recovery block
-{
-    // If only one block of input data,
-    if (params.OriginalCount == 1)
-    {
-        // No meaningful operation here, degenerate to outputting the same data each time.
-
-        memcpy(recoveryBlock, originals[0].Block, params.BlockBytes);
-        return;
-    }
-    // else OriginalCount >= 2:
-
-    // Unroll first row of recovery matrix:
-    // The matrix we generate for the first row is all ones,
-    // so it is merely a parity of the original data.
-    if (recoveryBlockIndex == params.OriginalCount)
-    {
-        gf256_addset_mem(recoveryBlock, originals[0].Block, originals[1].Block, params.BlockBytes);
-        for (int j = 2; j < params.OriginalCount; ++j)
-        {
-            gf256_add_mem(recoveryBlock, originals[j].Block, params.BlockBytes);
-        }
-        return;
-    }
-
-    // TBD: Faster algorithms seem to exist for computing this matrix-vector product.
-
-    // Start the x_0 values arbitrarily from the original count.
-    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
-
-    // For other rows:
-    {
-        const uint8_t x_i = static_cast<uint8_t>(recoveryBlockIndex);
-
-        // Unroll first operation for speed
-        {
-            const uint8_t y_0 = 0;
-            const uint8_t matrixElement = GetMatrixElement(x_i, x_0, y_0);
-
-            gf256_mul_mem(recoveryBlock, originals[0].Block, matrixElement, params.BlockBytes);
-        }
-
-        // For each original data column,
-        for (int j = 1; j < params.OriginalCount; ++j)
-        {
-            const uint8_t y_j = static_cast<uint8_t>(j);
-            const uint8_t matrixElement = GetMatrixElement(x_i, x_0, y_j);
-
-            gf256_muladd_mem(recoveryBlock, matrixElement, originals[j].Block, params.BlockBytes);
-        }
-    }
-}
-
-extern "C" int cm256_encode(
-    cm256_encoder_params params, // Encoder params
-    cm256_block* originals,      // Array of pointers to original blocks
-    void* recoveryBlocks)        // Output recovery blocks end-to-end
-{
-    // Validate input:
-    if (params.OriginalCount <= 0 ||
-        params.RecoveryCount <= 0 ||
-        params.BlockBytes <= 0)
-    {
-        return -1;
-    }
-    if (params.OriginalCount + params.RecoveryCount > 256)
-    {
-        return -2;
-    }
-    if (!originals || !recoveryBlocks)
-    {
-        return -3;
-    }
-
-    uint8_t* recoveryBlock = static_cast<uint8_t*>(recoveryBlocks);
-
-    for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += params.BlockBytes)
-    {
-        cm256_encode_block(params, originals, (params.OriginalCount + block), recoveryBlock);
-    }
-
-    return 0;
-}
-
-
-//-----------------------------------------------------------------------------
-// Decoding
-
-struct CM256Decoder
-{
-    // Encode parameters
-    cm256_encoder_params Params;
-
-    // Recovery blocks
-    cm256_block* Recovery[256];
-    int RecoveryCount;
-
-    // Original blocks
-    cm256_block* Original[256];
-    int OriginalCount;
-
-    // Row indices that were erased
-    uint8_t ErasuresIndices[256];
-
-    // Initialize the decoder
-    bool Initialize(cm256_encoder_params& params, cm256_block* blocks);
-
-    // Decode m=1 case
-    void DecodeM1();
-
-    // Decode for m>1 case
-    void Decode();
-
-    // Generate the LU decomposition of the matrix
-    void GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D, uint8_t* matrix_U);
-};
-
-bool CM256Decoder::Initialize(cm256_encoder_params& params, cm256_block* blocks)
-{
-    Params = params;
-
-    cm256_block* block = blocks;
-    OriginalCount = 0;
-    RecoveryCount = 0;
-
-    // Initialize erasures to zeros
-    for (int ii = 0; ii < params.OriginalCount; ++ii)
-    {
-        ErasuresIndices[ii] = 0;
-    }
-
-    // For each input block,
-    for (int ii = 0; ii < params.OriginalCount; ++ii, ++block)
-    {
-        int row = block->Index;
-
-        // If it is an original block,
-        if (row < params.OriginalCount)
-        {
-            Original[OriginalCount++] = block;
-
-            if (ErasuresIndices[row] != 0)
-            {
-                // Error out if two row indices repeat
-                return false;
-            }
-
-            ErasuresIndices[row] = 1;
-        }
-        else
-        {
-            Recovery[RecoveryCount++] = block;
-        }
-    }
-
-    // Identify erasures
-    for (int ii = 0, indexCount = 0; ii < 256; ++ii)
-    {
-        if (!ErasuresIndices[ii])
-        {
-            ErasuresIndices[indexCount] = static_cast<uint8_t>( ii );
-
-            if (++indexCount >= RecoveryCount)
-            {
-                break;
-            }
-        }
-    }
-
-    return true;
-}
-
-void CM256Decoder::DecodeM1()
-{
-    // XOR all other blocks into the recovery block
-    uint8_t* outBlock = static_cast<uint8_t*>(Recovery[0]->Block);
-    const uint8_t* inBlock = nullptr;
-
-    // For each block,
-    for (int ii = 0; ii < OriginalCount; ++ii)
-    {
-        const uint8_t* inBlock2 = static_cast<const uint8_t*>(Original[ii]->Block);
-
-        if (!inBlock)
-        {
-            inBlock = inBlock2;
-        }
-        else
-        {
-            // outBlock ^= inBlock ^ inBlock2
-            gf256_add2_mem(outBlock, inBlock, inBlock2, Params.BlockBytes);
-            inBlock = nullptr;
-        }
-    }
-
-    // Complete XORs
-    if (inBlock)
-    {
-        gf256_add_mem(outBlock, inBlock, Params.BlockBytes);
-    }
-
-    // Recover the index it corresponds to
-    Recovery[0]->Index = ErasuresIndices[0];
-}
-
-// Generate the LU decomposition of the matrix
-void CM256Decoder::GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D, uint8_t* matrix_U)
-{
-    // Schur-type-direct-Cauchy algorithm 2.5 from
-    // "Pivoting and Backward Stability of Fast Algorithms for Solving Cauchy Linear Equations"
-    // T. Boros, T. Kailath, V. Olshevsky
-    // Modified for practical use.  I folded the diagonal parts of U/L matrices into the
-    // diagonal one to reduce the number of multiplications to perform against the input data,
-    // and organized the triangle matrices in memory to allow for faster SSE3 GF multiplications.
-
-    // Matrix size NxN
-    const int N = RecoveryCount;
-
-    // Generators
-    uint8_t g[256], b[256];
-    for (int i = 0; i < N; ++i)
-    {
-        g[i] = 1;
-        b[i] = 1;
-    }
-
-    // Temporary buffer for rotated row of U matrix
-    // This allows for faster GF bulk multiplication
-    uint8_t rotated_row_U[256];
-    uint8_t* last_U = matrix_U + ((N - 1) * N) / 2 - 1;
-    int firstOffset_U = 0;
-
-    // Start the x_0 values arbitrarily from the original count.
-    const uint8_t x_0 = static_cast<uint8_t>(Params.OriginalCount);
-
-    // Unrolling k = 0 just makes it slower for some reason.
-    for (int k = 0; k < N - 1; ++k)
-    {
-        const uint8_t x_k = Recovery[k]->Index;
-        const uint8_t y_k = ErasuresIndices[k];
-
-        // D_kk = (x_k + y_k)
-        // L_kk = g[k] / (x_k + y_k)
-        // U_kk = b[k] * (x_0 + y_k) / (x_k + y_k)
-        const uint8_t D_kk = gf256_add(x_k, y_k);
-        const uint8_t L_kk = gf256_div(g[k], D_kk);
-        const uint8_t U_kk = gf256_mul(gf256_div(b[k], D_kk), gf256_add(x_0, y_k));
-
-        // diag_D[k] = D_kk * L_kk * U_kk
-        diag_D[k] = gf256_mul(D_kk, gf256_mul(L_kk, U_kk));
-
-        // Computing the k-th row of L and U
-        uint8_t* row_L = matrix_L;
-        uint8_t* row_U = rotated_row_U;
-        for (int j = k + 1; j < N; ++j)
-        {
-            const uint8_t x_j = Recovery[j]->Index;
-            const uint8_t y_j = ErasuresIndices[j];
-
-            // L_jk = g[j] / (x_j + y_k)
-            // U_kj = b[j] / (x_k + y_j)
-            const uint8_t L_jk = gf256_div(g[j], gf256_add(x_j, y_k));
-            const uint8_t U_kj = gf256_div(b[j], gf256_add(x_k, y_j));
-
-            *matrix_L++ = L_jk;
-            *row_U++ = U_kj;
-
-            // g[j] = g[j] * (x_j + x_k) / (x_j + y_k)
-            // b[j] = b[j] * (y_j + y_k) / (y_j + x_k)
-            g[j] = gf256_mul(g[j], gf256_div(gf256_add(x_j, x_k), gf256_add(x_j, y_k)));
-            b[j] = gf256_mul(b[j], gf256_div(gf256_add(y_j, y_k), gf256_add(y_j, x_k)));
-        }
-
-        // Do these row/column divisions in bulk for speed.
-        // L_jk /= L_kk
-        // U_kj /= U_kk
-        const int count = N - (k + 1);
-        gf256_div_mem(row_L, row_L, L_kk, count);
-        gf256_div_mem(rotated_row_U, rotated_row_U, U_kk, count);
-
-        // Copy U matrix row into place in memory.
-        uint8_t* output_U = last_U + firstOffset_U;
-        row_U = rotated_row_U;
-        for (int j = k + 1; j < N; ++j)
-        {
-            *output_U = *row_U++;
-            output_U -= j;
-        }
-        firstOffset_U -= k + 2;
-    }
-
-    // Multiply diagonal matrix into U
-    uint8_t* row_U = matrix_U;
-    for (int j = N - 1; j > 0; --j)
-    {
-        const uint8_t y_j = ErasuresIndices[j];
-        const int count = j;
-
-        gf256_mul_mem(row_U, row_U, gf256_add(x_0, y_j), count);
-        row_U += count;
-    }
-
-    const uint8_t x_n = Recovery[N - 1]->Index;
-    const uint8_t y_n = ErasuresIndices[N - 1];
-
-    // D_nn = 1 / (x_n + y_n)
-    // L_nn = g[N-1]
-    // U_nn = b[N-1] * (x_0 + y_n)
-    const uint8_t L_nn = g[N - 1];
-    const uint8_t U_nn = gf256_mul(b[N - 1], gf256_add(x_0, y_n));
-
-    // diag_D[N-1] = L_nn * D_nn * U_nn
-    diag_D[N - 1] = gf256_div(gf256_mul(L_nn, U_nn), gf256_add(x_n, y_n));
-}
-
-void CM256Decoder::Decode()
-{
-    // Matrix size is NxN, where N is the number of recovery blocks used.
-    const int N = RecoveryCount;
-
-    // Start the x_0 values arbitrarily from the original count.
-    const uint8_t x_0 = static_cast<uint8_t>(Params.OriginalCount);
-
-    // Eliminate original data from the the recovery rows
-    for (int originalIndex = 0; originalIndex < OriginalCount; ++originalIndex)
-    {
-        const uint8_t* inBlock = static_cast<const uint8_t*>(Original[originalIndex]->Block);
-        const uint8_t inRow = Original[originalIndex]->Index;
-
-        for (int recoveryIndex = 0; recoveryIndex < N; ++recoveryIndex)
-        {
-            uint8_t* outBlock = static_cast<uint8_t*>(Recovery[recoveryIndex]->Block);
-            const uint8_t x_i = Recovery[recoveryIndex]->Index;
-            const uint8_t y_j = inRow;
-            const uint8_t matrixElement = GetMatrixElement(x_i, x_0, y_j);
-
-            gf256_muladd_mem(outBlock, matrixElement, inBlock, Params.BlockBytes);
-        }
-    }
-
-    // Allocate matrix
-    static const int StackAllocSize = 2048;
-    uint8_t stackMatrix[StackAllocSize];
-    uint8_t* dynamicMatrix = nullptr;
-    uint8_t* matrix = stackMatrix;
-    const int requiredSpace = N * N;
-    if (requiredSpace > StackAllocSize)
-    {
-        dynamicMatrix = new uint8_t[requiredSpace];
-        matrix = dynamicMatrix;
-    }
-
-    /*
-        Compute matrix decomposition:
-
-            G = L * D * U
-
-        L is lower-triangular, diagonal is all ones.
-        D is a diagonal matrix.
-        U is upper-triangular, diagonal is all ones.
-    */
-    uint8_t* matrix_U = matrix;
-    uint8_t* diag_D = matrix_U + (N - 1) * N / 2;
-    uint8_t* matrix_L = diag_D + N;
-    GenerateLDUDecomposition(matrix_L, diag_D, matrix_U);
-
-    /*
-        Eliminate lower left triangle.
-    */
-    // For each column,
-    for (int j = 0; j < N - 1; ++j)
-    {
-        const void* block_j = Recovery[j]->Block;
-
-        // For each row,
-        for (int i = j + 1; i < N; ++i)
-        {
-            void* block_i = Recovery[i]->Block;
-            const uint8_t c_ij = *matrix_L++; // Matrix elements are stored column-first, top-down.
-
-            gf256_muladd_mem(block_i, c_ij, block_j, Params.BlockBytes);
-        }
-    }
-
-    /*
-        Eliminate diagonal.
-    */
-    for (int i = 0; i < N; ++i)
-    {
-        void* block = Recovery[i]->Block;
-
-        Recovery[i]->Index = ErasuresIndices[i];
-
-        gf256_div_mem(block, block, diag_D[i], Params.BlockBytes);
-    }
-
-    /*
-        Eliminate upper right triangle.
-    */
-    for (int j = N - 1; j >= 1; --j)
-    {
-        const void* block_j = Recovery[j]->Block;
-
-        for (int i = j - 1; i >= 0; --i)
-        {
-            void* block_i = Recovery[i]->Block;
-            const uint8_t c_ij = *matrix_U++; // Matrix elements are stored column-first, bottom-up.
-
-            gf256_muladd_mem(block_i, c_ij, block_j, Params.BlockBytes);
-        }
-    }
-
-    delete[] dynamicMatrix;
-}
-
-extern "C" int cm256_decode(
-    cm256_encoder_params params, // Encoder params
-    cm256_block* blocks)         // Array of 'originalCount' blocks as described above
-{
-    if (params.OriginalCount <= 0 ||
-        params.RecoveryCount <= 0 ||
-        params.BlockBytes <= 0)
-    {
-        return -1;
-    }
-    if (params.OriginalCount + params.RecoveryCount > 256)
-    {
-        return -2;
-    }
-    if (!blocks)
-    {
-        return -3;
-    }
-
-    // If there is only one block,
-    if (params.OriginalCount == 1)
-    {
-        // It is the same block repeated
-        blocks[0].Index = 0;
-        return 0;
-    }
-
-    CM256Decoder state;
-    if (!state.Initialize(params, blocks))
-    {
-        return -5;
-    }
-
-    // If nothing is erased,
-    if (state.RecoveryCount <= 0)
-    {
-        return 0;
-    }
-
-    // If m=1,
-    if (params.RecoveryCount == 1)
-    {
-        state.DecodeM1();
-        return 0;
-    }
-
-    // Decode for m>1
-    state.Decode();
-    return 0;
-}
\ No newline at end of file
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+#include "cm256_codec.h"
+#include "cm256_pool.h"
+#include "cm256_stats.h"
+
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
+
+/*
+    GF(256) Cauchy Matrix Overview
+
+    As described on Wikipedia, each element of a normal Cauchy matrix is defined as:
+
+        a_ij = 1 / (x_i - y_j)
+        The arrays x_i and y_j are vector parameters of the matrix.
+        The values in x_i cannot be reused in y_j.
+
+    Moving beyond the Wikipedia...
+
+    (1) Number of rows (R) is the range of i, and number of columns (C) is the range of j.
+
+    (2) Being able to select x_i and y_j makes Cauchy matrices more flexible in practice
+        than Vandermonde matrices, which only have one parameter per row.
+
+    (3) Cauchy matrices are always invertible, AKA always full rank, AKA when treated as
+        as linear system y = M*x, the linear system has a single solution.
+
+    (4) A Cauchy matrix concatenated below a square CxC identity matrix always has rank C,
+        Meaning that any R rows can be eliminated from the concatenated matrix and the
+        matrix will still be invertible.  This is how Reed-Solomon erasure codes work.
+
+    (5) Any row or column can be multiplied by non-zero values, and the resulting matrix
+        is still full rank.  This is true for any matrix, since it is effectively the same
+        as pre and post multiplying by diagonal matrices, which are always invertible.
+
+    (6) Matrix elements with a value of 1 are much faster to operate on than other values.
+        For instance a matrix of [1, 1, 1, 1, 1] is invertible and much faster for various
+        purposes than [2, 2, 2, 2, 2].
+
+    (7) For GF(256) matrices, the symbols in x_i and y_j are selected from the numbers
+        0...255, and so the number of rows + number of columns may not exceed 256.
+        Note that values in x_i and y_j may not be reused as stated above.
+
+    In summary, Cauchy matrices
+        are preferred over Vandermonde matrices.  (2)
+        are great for MDS erasure codes.  (3) and (4)
+        should be optimized to include more 1 elements.  (5) and (6)
+        have a limited size in GF(256), rows+cols <= 256.  (7)
+*/
+
+
+//-----------------------------------------------------------------------------
+// Scratch Buffers
+
+// High-rate callers code many times per second, so each thread keeps its
+// scratch buffers and only grows them rather than allocating on every call
+uint8_t* GetThreadScratch(ScratchSlot slot, int bytes)
+{
+    static thread_local std::vector<uint8_t> scratch[kScratchSlotCount];
+    if ((int)scratch[slot].size() < bytes)
+    {
+        scratch[slot].resize(bytes);
+    }
+    return scratch[slot].data();
+}
+
+
+//-----------------------------------------------------------------------------
+// Large-Block Mode
+
+/*
+    When the blocks of one call are bigger than the last-level cache, the
+    recovery blocks and recovered originals are written once and not read
+    again before the caller sends them on.  Normal stores first read every
+    output line into the cache and then leave it there, evicting the input
+    that the next recovery rows still need.
+
+    In large-block mode each output tile is computed in a per-thread scratch
+    tile that stays in cache, and is then written out with non-temporal
+    stores, which skip the cache and the read for ownership.  While a tile is
+    being coded, the start of the tile after it is prefetched a few blocks at
+    a time between rows, so the hardware prefetcher is already following each
+    input stream when the first row of that tile needs it.
+
+    The mode is used when all of the blocks of a call add up to more than
+    the threshold set with cm256_set_large_block_threshold(), and is off by
+    default.  The encode_large and decode_large cases of cm256_bench compare
+    it with the cached path for 40 blocks of 2.5 MiB to 320 MiB in total.
+    On a CPU with a 105 MiB last-level cache it was never consistently
+    faster: up to the cache size the two were within run-to-run noise, and
+    at three times the cache size it was 10% to 20% slower.  So there is no
+    size at which cm256_init() could turn it on safely, and it is left for
+    hosts where the bench shows a gain.
+*/
+
+// Off unless set: no call has more bytes than this
+static const long long kLargeBlockThresholdOff = LLONG_MAX;
+
+static std::atomic<long long> LargeBlockThreshold(kLargeBlockThresholdOff);
+
+extern "C" long long cm256_get_large_block_threshold()
+{
+    return LargeBlockThreshold;
+}
+
+extern "C" void cm256_set_large_block_threshold(long long bytes)
+{
+    LargeBlockThreshold = bytes < 0 ? kLargeBlockThresholdOff : bytes;
+}
+
+// Returns true if a call over blockCount blocks should use large-block mode
+bool UseLargeBlocks(int blockCount, int blockBytes)
+{
+    return (long long)blockCount * blockBytes > cm256_get_large_block_threshold();
+}
+
+
+//-----------------------------------------------------------------------------
+// Initialization
+
+extern "C" int cm256_init_(int version)
+{
+    if (version != CM256_VERSION)
+    {
+        // User's header does not match library version
+        return -10;
+    }
+
+    // Return error code from GF(256) init if required
+    return gf256_init();
+}
+
+
+//-----------------------------------------------------------------------------
+// Matrix Points
+
+/*
+    The encoder handle and the decoder can take a set of points in place of
+    the defaults in cm256_codec.h.  GetMatrixElement() works for any distinct
+    points, and so does the LDU decomposition in the decoder.  Scaling
+    recovery row i by RowScale[i] gives the matrix S * G, which the decoder
+    factors as
+
+        S * G = (S * L * S^-1) * (S * D) * U
+
+    so the scales only change the L and D coefficients and cost no extra
+    passes over the data.
+*/
+
+extern "C" void cm256_default_points(cm256_encoder_params params, cm256_matrix_points* points)
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        points->X[i] = static_cast<uint8_t>(params.OriginalCount + i);
+        points->Y[i] = static_cast<uint8_t>(i);
+        points->RowScale[i] = 1;
+    }
+}
+
+static bool ValidatePoints(cm256_encoder_params params, const cm256_matrix_points* points)
+{
+    if (!points || points->RowScale[0] != 1 ||
+        params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return false;
+    }
+
+    bool used[256] = {};
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        if (used[points->X[i]] || points->RowScale[i] == 0)
+        {
+            return false;
+        }
+        used[points->X[i]] = true;
+    }
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        if (used[points->Y[j]])
+        {
+            return false;
+        }
+        used[points->Y[j]] = true;
+    }
+    return true;
+}
+
+// Element a_ij for recovery row i and original column j with the given points
+static GF256_FORCE_INLINE uint8_t GetPointsMatrixElement(const cm256_matrix_points& points, int row, int column)
+{
+    return gf256_mul(points.RowScale[row], GetMatrixElement(points.X[row], points.X[0], points.Y[column]));
+}
+
+// Number of ones in the 8x8 bit matrix of multiplying by each value
+static void GetBitMatrixWeights(uint8_t* weights)
+{
+    for (int y = 0; y < 256; ++y)
+    {
+        int ones = 0;
+        for (int b = 0; b < 8; ++b)
+        {
+            for (uint8_t column = gf256_mul(static_cast<uint8_t>(y), static_cast<uint8_t>(1 << b)); column; column &= column - 1)
+            {
+                ++ones;
+            }
+        }
+        weights[y] = static_cast<uint8_t>(ones);
+    }
+}
+
+// Returns the cost of rows 1..m-1 with each row at its cheapest scale, and
+// stores those scales in points->RowScale
+static int ScalePointRows(cm256_encoder_params params, cm256_matrix_points* points, const uint8_t* weights)
+{
+    int total = 0;
+
+    for (int row = 1; row < params.RecoveryCount; ++row)
+    {
+        uint8_t elements[256];
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            elements[j] = GetMatrixElement(points->X[row], points->X[0], points->Y[j]);
+        }
+
+        int bestCost = -1;
+        for (int scale = 1; scale < 256; ++scale)
+        {
+            int cost = 0;
+            for (int j = 0; j < params.OriginalCount; ++j)
+            {
+                cost += weights[gf256_mul(elements[j], static_cast<uint8_t>(scale))];
+            }
+
+            if (bestCost < 0 || cost < bestCost)
+            {
+                bestCost = cost;
+                points->RowScale[row] = static_cast<uint8_t>(scale);
+            }
+        }
+
+        total += bestCost;
+    }
+
+    return total;
+}
+
+extern "C" int cm256_optimize_points(
+    cm256_encoder_params params,  // Encoder parameters
+    int iterations,               // Search effort, e.g. 1000
+    cm256_matrix_points* points)  // Output points
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        iterations < 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!points)
+    {
+        return -3;
+    }
+
+    cm256_default_points(params, points);
+
+    uint8_t weights[256];
+    GetBitMatrixWeights(weights);
+
+    int bestCost = ScalePointRows(params, points, weights);
+
+    // Owner of each field value: X[i] is i, Y[j] is 256 + j, unused is -1
+    int owner[256];
+    for (int v = 0; v < 256; ++v)
+    {
+        owner[v] = -1;
+    }
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        owner[points->X[i]] = i;
+    }
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        owner[points->Y[j]] = 256 + j;
+    }
+
+    auto pointOf = [points](int who) -> unsigned char& {
+        return who < 256 ? points->X[who] : points->Y[who - 256];
+    };
+
+    // Deterministic, so the same search gives the same points everywhere
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    auto next = [&state]() -> unsigned {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<unsigned>(state >> 32);
+    };
+
+    cm256_matrix_points candidate = *points;
+
+    // Local search: move one point to another value, swapping with the point
+    // that holds it if any, and keep the change if it is no worse
+    for (int step = 0; step < iterations; ++step)
+    {
+        const unsigned pick = next() % (unsigned)(params.RecoveryCount + params.OriginalCount);
+        const int who = pick < (unsigned)params.RecoveryCount ? (int)pick : 256 + (int)(pick - params.RecoveryCount);
+        const uint8_t value = static_cast<uint8_t>(next());
+        const uint8_t old = pointOf(who);
+        const int other = owner[value];
+        if (other == who)
+        {
+            continue;
+        }
+
+        pointOf(who) = value;
+        if (other >= 0)
+        {
+            pointOf(other) = old;
+        }
+
+        memcpy(&candidate, points, sizeof(candidate));
+        const int cost = ScalePointRows(params, &candidate, weights);
+
+        if (cost <= bestCost)
+        {
+            bestCost = cost;
+            memcpy(points->RowScale, candidate.RowScale, sizeof(points->RowScale));
+            owner[value] = who;
+            owner[old] = other;
+        }
+        else
+        {
+            pointOf(who) = old;
+            if (other >= 0)
+            {
+                pointOf(other) = value;
+            }
+        }
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_points_cost(cm256_encoder_params params, const cm256_matrix_points* points)
+{
+    if (!ValidatePoints(params, points))
+    {
+        return -1;
+    }
+
+    uint8_t weights[256];
+    GetBitMatrixWeights(weights);
+
+    int total = 0;
+    for (int row = 1; row < params.RecoveryCount; ++row)
+    {
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            total += weights[GetPointsMatrixElement(*points, row, j)];
+        }
+    }
+    return total;
+}
+
+
+//-----------------------------------------------------------------------------
+// Encoding
+
+// Encode the byte range [offset, offset + bytes) of one recovery block
+void EncodeBlockRange(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    uint8_t* recoveryBlock,      // Output recovery block (start of the range)
+    int offset,                  // Offset of the range into each original block
+    int bytes,                   // Number of bytes in the range
+    const gf256_mul_tables* rowTables) // Precomputed row of the matrix, or null
+{
+    CM256_STATS_PHASE(CM256_PHASE_ENCODE);
+
+    // If only one block of input data,
+    if (params.OriginalCount == 1)
+    {
+        // No meaningful operation here, degenerate to outputting the same data each time.
+
+        memcpy(recoveryBlock, static_cast<const uint8_t*>(originals[0].Block) + offset, bytes);
+        return;
+    }
+    // else OriginalCount >= 2:
+
+    // Unroll first row of recovery matrix:
+    // The matrix we generate for the first row is all ones,
+    // so it is merely a parity of the original data.
+    if (recoveryBlockIndex == params.OriginalCount)
+    {
+        gf256_addset_mem(recoveryBlock,
+            static_cast<const uint8_t*>(originals[0].Block) + offset,
+            static_cast<const uint8_t*>(originals[1].Block) + offset, bytes);
+        for (int j = 2; j < params.OriginalCount; ++j)
+        {
+            gf256_add_mem(recoveryBlock, static_cast<const uint8_t*>(originals[j].Block) + offset, bytes);
+        }
+        return;
+    }
+
+    // TBD: Faster algorithms seem to exist for computing this matrix-vector product.
+
+    const void* inBlocks[256];
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        inBlocks[j] = static_cast<const uint8_t*>(originals[j].Block) + offset;
+    }
+
+    // If the encoder handle has the coefficients ready,
+    if (rowTables)
+    {
+        gf256_mul_multi_tables_mem(recoveryBlock, rowTables, inBlocks, params.OriginalCount, bytes);
+        return;
+    }
+
+    // Start the x_0 values arbitrarily from the original count.
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+
+    // For other rows:
+    {
+        const uint8_t x_i = static_cast<uint8_t>(recoveryBlockIndex);
+
+        // For each original data column,
+        uint8_t matrixElements[256];
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            const uint8_t y_j = static_cast<uint8_t>(j);
+            matrixElements[j] = GetMatrixElement(x_i, x_0, y_j);
+        }
+
+        // Accumulate all of the columns in one pass over the recovery block
+        gf256_mul_multi_mem(recoveryBlock, matrixElements, inBlocks, params.OriginalCount, bytes);
+    }
+}
+
+extern "C" void cm256_encode_block(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    void* recoveryBlock)         // Output recovery block
+{
+    EncodeBlockRange(params, originals, recoveryBlockIndex,
+        static_cast<uint8_t*>(recoveryBlock), 0, params.BlockBytes, nullptr);
+}
+
+/*
+    Cache Tiling
+
+    Producing recovery blocks one at a time reads every original block once
+    per recovery row.  When the original data does not fit in cache, every
+    one of those passes comes from DRAM and the encoder is limited by memory
+    bandwidth rather than by the GF(256) math.
+
+    Instead the blocks are split into tiles of a few KB, and all of the
+    recovery rows are produced for one tile before moving on to the next.
+    The tile size is picked so that the tile of every original block and
+    every recovery block stays resident in a typical L2 cache, so each
+    original byte is loaded from memory only once per stripe.
+
+    The math is applied byte-wise, so the output is identical to encoding
+    each recovery block in one piece.
+*/
+
+// Cache budget for the original + recovery tiles being worked on
+static const int kEncodeTileCacheBytes = 512 * 1024;
+
+// Smallest tile that keeps the SIMD loops efficient
+static const int kEncodeMinTileBytes = 1024;
+
+// Tiles are a multiple of this so that the wide SIMD paths are not split
+static const int kEncodeTileAlignBytes = 64;
+
+// Returns the number of bytes to encode at a time for each block
+int GetEncodeTileBytes(const cm256_encoder_params& params)
+{
+    int tileBytes = kEncodeTileCacheBytes / (params.OriginalCount + params.RecoveryCount);
+    tileBytes -= tileBytes % kEncodeTileAlignBytes;
+    if (tileBytes < kEncodeMinTileBytes)
+    {
+        tileBytes = kEncodeMinTileBytes;
+    }
+    return tileBytes;
+}
+
+// Encode the byte range [begin, end) of every recovery block one tile at a time
+static void EncodeStripe(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    uint8_t* recoveryData,       // Output recovery blocks end-to-end
+    int begin,                   // Offset of the stripe into each block
+    int end,                     // Offset of the end of the stripe
+    const gf256_mul_tables* tables, // Precomputed rows 1..m-1 of the matrix, or null
+    uint32_t* crcs = nullptr,    // CRCs of the originals then the recovery blocks, or null
+    const cm256_block* nextOriginals = nullptr) // Originals of the next stripe of a batch, or null
+{
+    const int tileBytes = GetEncodeTileBytes(params);
+
+    // In large-block mode each row of a tile is produced in scratch and then
+    // streamed out, see Large-Block Mode
+    uint8_t* scratchTile = nullptr;
+    if (UseLargeBlocks(params.OriginalCount + params.RecoveryCount, params.BlockBytes))
+    {
+        scratchTile = GetThreadScratch(kScratchTile, tileBytes);
+    }
+
+    // For each tile of the stripe,
+    for (int offset = begin; offset < end; offset += tileBytes)
+    {
+        int bytes = end - offset;
+        if (bytes > tileBytes)
+        {
+            bytes = tileBytes;
+        }
+        const int nextOffset = offset + bytes;
+        const int nextBytes = std::min(tileBytes, end - nextOffset);
+
+        // Produce this tile of every recovery block while the originals are in cache
+        uint8_t* recoveryBlock = recoveryData + offset;
+        for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += params.BlockBytes)
+        {
+            const gf256_mul_tables* rowTables = nullptr;
+            if (tables && block > 0)
+            {
+                rowTables = tables + (block - 1) * params.OriginalCount;
+            }
+
+            uint32_t* crc = crcs ? crcs + params.OriginalCount + block : nullptr;
+
+            // During the first tile, fetch a share of the next stripe's originals
+            // per row, see Batches
+            if (nextOriginals && offset == begin)
+            {
+                const int first = block * params.OriginalCount / params.RecoveryCount;
+                const int last = (block + 1) * params.OriginalCount / params.RecoveryCount;
+                for (int i = first; i < last; ++i)
+                {
+                    gf256_prefetch_mem(nextOriginals[i].Block, params.BlockBytes);
+                }
+            }
+
+            if (!scratchTile)
+            {
+                EncodeBlockRange(params, originals, (params.OriginalCount + block), recoveryBlock, offset, bytes, rowTables);
+                if (crc)
+                {
+                    *crc = cm256_crc32c(*crc, recoveryBlock, bytes);
+                }
+                continue;
+            }
+
+            PrefetchSlice(params.OriginalCount, nextOffset, nextBytes, block, params.RecoveryCount,
+                [originals](int i) { return originals[i].Block; });
+
+            EncodeBlockRange(params, originals, (params.OriginalCount + block), scratchTile, offset, bytes, rowTables);
+            if (crc)
+            {
+                *crc = cm256_crc32c(*crc, scratchTile, bytes);
+            }
+            gf256_stream_copy_mem(recoveryBlock, scratchTile, bytes);
+        }
+
+        // The originals of this tile are still in cache
+        for (int j = 0; crcs && j < params.OriginalCount; ++j)
+        {
+            crcs[j] = cm256_crc32c(crcs[j], static_cast<const uint8_t*>(originals[j].Block) + offset, bytes);
+        }
+    }
+
+    if (scratchTile)
+    {
+        gf256_stream_fence();
+    }
+}
+
+static int ValidateEncodeParams(
+    const cm256_encoder_params& params,
+    cm256_block* originals,
+    void* recoveryBlocks)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+    return 0;
+}
+
+extern "C" int cm256_encode(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    // Validate input:
+    const int result = ValidateEncodeParams(params, originals, recoveryBlocks);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    EncodeStripe(params, originals, static_cast<uint8_t*>(recoveryBlocks), 0, params.BlockBytes, nullptr);
+
+    return 0;
+}
+
+extern "C" int cm256_encode_crc(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks,        // Output recovery blocks end-to-end
+    uint32_t* crcs)              // Output 'originalCount' + 'recoveryCount' CRCs
+{
+    // Validate input:
+    const int result = ValidateEncodeParams(params, originals, recoveryBlocks);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!crcs)
+    {
+        return -3;
+    }
+
+    // The tiles are visited in order, so each CRC is continued tile by tile
+    memset(crcs, 0, (params.OriginalCount + params.RecoveryCount) * sizeof(uint32_t));
+
+    EncodeStripe(params, originals, static_cast<uint8_t*>(recoveryBlocks), 0, params.BlockBytes, nullptr, crcs);
+
+    return 0;
+}
+
+/*
+    Stripe Parallelism
+
+    Every byte offset of the recovery blocks depends only on the same byte
+    offset of the original blocks, so the blocks can be cut into stripes
+    along the byte range and each stripe encoded independently with no
+    synchronization.  Each worker then walks its own stripe with the same
+    cache tiling as the single-threaded encoder.
+
+    Stripes are a multiple of the tile alignment so that no SIMD register is
+    split between threads, and no smaller than CM256_MT_MIN_STRIPE_BYTES so
+    that waking a worker costs much less than the work handed to it.
+*/
+
+struct EncodeStripeTask
+{
+    cm256_encoder_params Params;
+    cm256_block* Originals;
+    uint8_t* RecoveryData;
+    const gf256_mul_tables* Tables;
+    int StripeBytes;
+
+    static void Run(void* context, int task)
+    {
+        const EncodeStripeTask* self = static_cast<const EncodeStripeTask*>(context);
+
+        const int begin = task * self->StripeBytes;
+        int end = begin + self->StripeBytes;
+        if (end > self->Params.BlockBytes)
+        {
+            end = self->Params.BlockBytes;
+        }
+
+        EncodeStripe(self->Params, self->Originals, self->RecoveryData, begin, end, self->Tables);
+    }
+};
+
+// Returns the number of stripes to split each block into for the pool
+int GetStripeCount(int blockBytes, cm256_pool* pool)
+{
+    int stripeCount = cm256_pool_concurrency(pool);
+    const int maxStripes = blockBytes / CM256_MT_MIN_STRIPE_BYTES;
+    if (stripeCount > maxStripes)
+    {
+        stripeCount = maxStripes;
+    }
+    return stripeCount;
+}
+
+// Returns the stripe size for splitting each block into stripeCount stripes
+int GetStripeBytes(int blockBytes, int stripeCount)
+{
+    int stripeBytes = (blockBytes + stripeCount - 1) / stripeCount;
+    stripeBytes += kEncodeTileAlignBytes - 1;
+    stripeBytes -= stripeBytes % kEncodeTileAlignBytes;
+    return stripeBytes;
+}
+
+// Encode on the pool, or on the calling thread for small blocks
+static void EncodeWithPool(
+    cm256_encoder_params params,
+    cm256_block* originals,
+    void* recoveryBlocks,
+    const gf256_mul_tables* tables,
+    cm256_pool* pool)
+{
+    const int stripeCount = GetStripeCount(params.BlockBytes, pool);
+
+    // Small blocks are not worth waking the workers for
+    if (stripeCount < 2)
+    {
+        EncodeStripe(params, originals, static_cast<uint8_t*>(recoveryBlocks), 0, params.BlockBytes, tables);
+        return;
+    }
+
+    EncodeStripeTask task;
+    task.Params = params;
+    task.Originals = originals;
+    task.RecoveryData = static_cast<uint8_t*>(recoveryBlocks);
+    task.Tables = tables;
+    task.StripeBytes = GetStripeBytes(params.BlockBytes, stripeCount);
+
+    // Rounding the stripes up may leave fewer stripes than requested
+    const int taskCount = (params.BlockBytes + task.StripeBytes - 1) / task.StripeBytes;
+
+    cm256_pool_run(pool, &EncodeStripeTask::Run, &task, taskCount);
+}
+
+extern "C" int cm256_encode_mt(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks,        // Output recovery blocks end-to-end
+    cm256_pool* pool)            // Worker pool from cm256_pool_create()
+{
+    // Validate input:
+    const int result = ValidateEncodeParams(params, originals, recoveryBlocks);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    EncodeWithPool(params, originals, recoveryBlocks, nullptr, pool);
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Encoder Handle
+
+/*
+    For fixed parameters the coefficients of the recovery matrix never
+    change, so the handle computes them once along with their multiply
+    tables.  The tables for rows 1..m-1 are stored row by row in one array,
+    so encoding a block streams through k consecutive entries.  Row 0 is all
+    ones and is still done with XOR.
+*/
+
+static cm256_encoder* CreateEncoder(cm256_encoder_params params, const cm256_matrix_points* points)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return nullptr;
+    }
+
+    cm256_encoder* encoder = new (std::nothrow) cm256_encoder;
+    if (!encoder)
+    {
+        return nullptr;
+    }
+    encoder->Params = params;
+    encoder->Tables = nullptr;
+
+    // One original block is just copied, and row 0 needs no tables
+    if (params.OriginalCount >= 2 && params.RecoveryCount >= 2)
+    {
+        const int rows = params.RecoveryCount - 1;
+        encoder->Tables = new (std::nothrow) gf256_mul_tables[rows * params.OriginalCount];
+        if (!encoder->Tables)
+        {
+            delete encoder;
+            return nullptr;
+        }
+
+        const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+
+        gf256_mul_tables* tables = encoder->Tables;
+        for (int row = 1; row <= rows; ++row)
+        {
+            const uint8_t x_i = static_cast<uint8_t>(params.OriginalCount + row);
+            for (int j = 0; j < params.OriginalCount; ++j)
+            {
+                gf256_mul_tables_init(tables++, points ? GetPointsMatrixElement(*points, row, j)
+                                                       : GetMatrixElement(x_i, x_0, static_cast<uint8_t>(j)));
+            }
+        }
+    }
+
+    return encoder;
+}
+
+extern "C" cm256_encoder* cm256_encoder_create(cm256_encoder_params params)
+{
+    return CreateEncoder(params, nullptr);
+}
+
+extern "C" cm256_encoder* cm256_encoder_create_with_points(
+    cm256_encoder_params params,        // Encoder parameters
+    const cm256_matrix_points* points)  // Points the recovery data is encoded with
+{
+    if (!ValidatePoints(params, points))
+    {
+        return nullptr;
+    }
+
+    return CreateEncoder(params, points);
+}
+
+extern "C" void cm256_encoder_destroy(cm256_encoder* encoder)
+{
+    if (encoder)
+    {
+        delete[] encoder->Tables;
+        delete encoder;
+    }
+}
+
+extern "C" int cm256_encoder_encode(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    if (!encoder || !originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    EncodeStripe(encoder->Params, originals, static_cast<uint8_t*>(recoveryBlocks),
+        0, encoder->Params.BlockBytes, encoder->Tables);
+
+    return 0;
+}
+
+extern "C" int cm256_encoder_encode_mt(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks,        // Output recovery blocks end-to-end
+    cm256_pool* pool)            // Worker pool from cm256_pool_create()
+{
+    if (!encoder || !originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    EncodeWithPool(encoder->Params, originals, recoveryBlocks, encoder->Tables, pool);
+
+    return 0;
+}
+
+extern "C" void cm256_encoder_encode_block(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    void* recoveryBlock)         // Output recovery block
+{
+    const cm256_encoder_params& params = encoder->Params;
+
+    const gf256_mul_tables* rowTables = nullptr;
+    const int row = recoveryBlockIndex - params.OriginalCount;
+    if (encoder->Tables && row > 0)
+    {
+        rowTables = encoder->Tables + (row - 1) * params.OriginalCount;
+    }
+
+    EncodeBlockRange(params, originals, recoveryBlockIndex,
+        static_cast<uint8_t*>(recoveryBlock), 0, params.BlockBytes, rowTables);
+}
+
+
+//-----------------------------------------------------------------------------
+// Batches
+
+/*
+    Batches of small stripes are spread over the pool a run of whole stripes
+    at a time, rather than by cutting each block into byte ranges.  Each run
+    holds enough data to be worth waking a worker for.  Stripes with large
+    blocks are still split by byte range one stripe at a time.
+
+    The blocks of a batch usually come from separate I/O requests, so the
+    next stripe's originals are scattered and the hardware prefetcher cannot
+    find them.  While the first tile of a stripe is coded, a share of the
+    next stripe's originals is prefetched between recovery rows, so their
+    loads overlap the math instead of stalling the start of the next stripe.
+    The encode_batch and encode_each cases of cm256_bench compare this with
+    one encode call per stripe.
+*/
+
+// Returns the number of stripes in each task of a batch, at least 1
+int GetBatchTaskStripes(
+    cm256_encoder_params params,
+    int stripeCount,
+    cm256_pool* pool)
+{
+    // One task for the whole batch, which an empty batch still counts as
+    if (cm256_pool_concurrency(pool) < 2)
+    {
+        return stripeCount > 1 ? stripeCount : 1;
+    }
+
+    const int stripeBytes = params.BlockBytes * (params.OriginalCount + params.RecoveryCount);
+    int taskStripes = CM256_MT_MIN_STRIPE_BYTES / stripeBytes;
+    if (taskStripes < 1)
+    {
+        taskStripes = 1;
+    }
+    return taskStripes;
+}
+
+struct EncodeBatchTask
+{
+    cm256_encoder_params Params;
+    const gf256_mul_tables* Tables;
+    const cm256_encode_stripe* Stripes;
+    int StripeCount;
+    int TaskStripes;
+
+    // Encode stripes [begin, end) on this thread
+    void RunRange(int begin, int end) const
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const cm256_block* nextOriginals = (i + 1 < end) ? Stripes[i + 1].Originals : nullptr;
+            EncodeStripe(Params, Stripes[i].Originals, static_cast<uint8_t*>(Stripes[i].RecoveryBlocks),
+                0, Params.BlockBytes, Tables, nullptr, nextOriginals);
+        }
+    }
+
+    static void Run(void* context, int task)
+    {
+        const EncodeBatchTask* self = static_cast<const EncodeBatchTask*>(context);
+
+        const int begin = task * self->TaskStripes;
+        int end = begin + self->TaskStripes;
+        if (end > self->StripeCount)
+        {
+            end = self->StripeCount;
+        }
+
+        self->RunRange(begin, end);
+    }
+};
+
+extern "C" int cm256_encoder_encode_batch(
+    cm256_encoder* encoder,              // Encoder from cm256_encoder_create()
+    const cm256_encode_stripe* stripes,  // Array of stripes to encode
+    int stripeCount,                     // Number of stripes
+    cm256_pool* pool)                    // Optional worker pool
+{
+    if (!encoder || (!stripes && stripeCount > 0) || stripeCount < 0)
+    {
+        return -3;
+    }
+    for (int i = 0; i < stripeCount; ++i)
+    {
+        if (!stripes[i].Originals || !stripes[i].RecoveryBlocks)
+        {
+            return -3;
+        }
+    }
+
+    if (stripeCount == 0)
+    {
+        return 0;
+    }
+
+    const cm256_encoder_params& params = encoder->Params;
+
+    // Large blocks are split by byte range instead
+    if (GetStripeCount(params.BlockBytes, pool) >= 2)
+    {
+        for (int i = 0; i < stripeCount; ++i)
+        {
+            EncodeWithPool(params, stripes[i].Originals, stripes[i].RecoveryBlocks, encoder->Tables, pool);
+        }
+        return 0;
+    }
+
+    EncodeBatchTask task;
+    task.Params = params;
+    task.Tables = encoder->Tables;
+    task.Stripes = stripes;
+    task.StripeCount = stripeCount;
+    task.TaskStripes = GetBatchTaskStripes(params, stripeCount, pool);
+
+    const int taskCount = (stripeCount + task.TaskStripes - 1) / task.TaskStripes;
+    if (taskCount < 2)
+    {
+        task.RunRange(0, stripeCount);
+        return 0;
+    }
+
+    cm256_pool_run(pool, &EncodeBatchTask::Run, &task, taskCount);
+    return 0;
+}
+
+extern "C" int cm256_encode_batch(
+    cm256_encoder_params params,         // Encoder parameters
+    const cm256_encode_stripe* stripes,  // Array of stripes to encode
+    int stripeCount,                     // Number of stripes
+    cm256_pool* pool)                    // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+
+    // Share one set of coefficient tables between all the stripes
+    cm256_encoder* encoder = cm256_encoder_create(params);
+    if (!encoder)
+    {
+        return -4;
+    }
+
+    const int batchResult = cm256_encoder_encode_batch(encoder, stripes, stripeCount, pool);
+
+    cm256_encoder_destroy(encoder);
+    return batchResult;
+}
+
+//-----------------------------------------------------------------------------
+// Decoding
+
+bool CM256Decoder::Initialize(cm256_encoder_params& params, cm256_block* blocks)
+{
+    Params = params;
+    OriginalsEliminated = false;
+    Outputs = nullptr;
+    Points = nullptr;
+    Crcs = nullptr;
+
+    cm256_block* block = blocks;
+    OriginalCount = 0;
+    RecoveryCount = 0;
+
+    // Initialize erasures to zeros
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        ErasuresIndices[ii] = 0;
+    }
+
+    // For each input block,
+    for (int ii = 0; ii < params.OriginalCount; ++ii, ++block)
+    {
+        int row = block->Index;
+
+        // If it is an original block,
+        if (row < params.OriginalCount)
+        {
+            Original[OriginalCount++] = block;
+
+            if (ErasuresIndices[row] != 0)
+            {
+                // Error out if two row indices repeat
+                return false;
+            }
+
+            ErasuresIndices[row] = 1;
+        }
+        else
+        {
+            Recovery[RecoveryCount++] = block;
+        }
+    }
+
+    // Identify erasures
+    for (int ii = 0, indexCount = 0; ii < 256; ++ii)
+    {
+        if (!ErasuresIndices[ii])
+        {
+            ErasuresIndices[indexCount] = static_cast<uint8_t>( ii );
+
+            if (++indexCount >= RecoveryCount)
+            {
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void CM256Decoder::DecodeM1(cm256_pool* pool)
+{
+    RunStripes(pool, true);
+
+    // Recover the index it corresponds to
+    if (!Outputs)
+    {
+        Recovery[0]->Index = ErasuresIndices[0];
+    }
+}
+
+void CM256Decoder::DecodeM1Range(int offset, int bytes, uint8_t* scratchTile, int nextBytes)
+{
+    CM256_STATS_PHASE(CM256_PHASE_DECODE_M1);
+
+    // XOR all other blocks into the recovery block
+    uint8_t* outBlock = scratchTile ? scratchTile : GetOutput(0) + offset;
+    const uint8_t* inBlock = nullptr;
+    int ii = 0;
+
+    // Writing elsewhere, the first pass sets the output from the recovery block
+    if (Outputs || scratchTile)
+    {
+        const uint8_t* recoveryBlock = static_cast<const uint8_t*>(Recovery[0]->Block) + offset;
+        const uint8_t* inBlock2 = static_cast<const uint8_t*>(Original[0]->Block) + offset;
+
+        gf256_addset_mem(outBlock, recoveryBlock, inBlock2, bytes);
+        ii = 1;
+    }
+
+    // For each block,
+    for (; ii < OriginalCount; ++ii)
+    {
+        const uint8_t* inBlock2 = static_cast<const uint8_t*>(Original[ii]->Block) + offset;
+
+        if (scratchTile)
+        {
+            PrefetchTile(offset + bytes, nextBytes, ii, OriginalCount);
+        }
+
+        if (!inBlock)
+        {
+            inBlock = inBlock2;
+        }
+        else
+        {
+            // outBlock ^= inBlock ^ inBlock2
+            gf256_add2_mem(outBlock, inBlock, inBlock2, bytes);
+            inBlock = nullptr;
+        }
+    }
+
+    // Complete XORs
+    if (inBlock)
+    {
+        gf256_add_mem(outBlock, inBlock, bytes);
+    }
+
+    if (Crcs)
+    {
+        const void* decoded[1] = { outBlock };
+        UpdateTileCrcs(offset, bytes, decoded);
+    }
+
+    if (scratchTile)
+    {
+        gf256_stream_copy_mem(GetOutput(0) + offset, scratchTile, bytes);
+    }
+}
+
+// Generate the LU decomposition of the matrix
+void CM256Decoder::GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D, uint8_t* matrix_U)
+{
+    CM256_STATS_PHASE(CM256_PHASE_LDU);
+
+    // Schur-type-direct-Cauchy algorithm 2.5 from
+    // "Pivoting and Backward Stability of Fast Algorithms for Solving Cauchy Linear Equations"
+    // T. Boros, T. Kailath, V. Olshevsky
+    // Modified for practical use.  I folded the diagonal parts of U/L matrices into the
+    // diagonal one to reduce the number of multiplications to perform against the input data,
+    // and organized the triangle matrices in memory to allow for faster SSE3 GF multiplications.
+
+    // Matrix size NxN
+    const int N = RecoveryCount;
+
+    // Generators
+    uint8_t g[256], b[256];
+    for (int i = 0; i < N; ++i)
+    {
+        g[i] = 1;
+        b[i] = 1;
+    }
+
+    // Temporary buffer for rotated row of U matrix
+    // This allows for faster GF bulk multiplication
+    uint8_t rotated_row_U[256];
+    uint8_t* last_U = matrix_U + ((N - 1) * N) / 2 - 1;
+    int firstOffset_U = 0;
+
+    // Start the x_0 values arbitrarily from the original count.
+    const uint8_t x_0 = GetX0();
+
+    // Unrolling k = 0 just makes it slower for some reason.
+    for (int k = 0; k < N - 1; ++k)
+    {
+        const uint8_t x_k = GetRecoveryX(k);
+        const uint8_t y_k = GetOriginalY(ErasuresIndices[k]);
+
+        // D_kk = (x_k + y_k)
+        // L_kk = g[k] / (x_k + y_k)
+        // U_kk = b[k] * (x_0 + y_k) / (x_k + y_k)
+        const uint8_t D_kk = gf256_add(x_k, y_k);
+        const uint8_t L_kk = gf256_div(g[k], D_kk);
+        const uint8_t U_kk = gf256_mul(gf256_div(b[k], D_kk), gf256_add(x_0, y_k));
+
+        // diag_D[k] = D_kk * L_kk * U_kk
+        diag_D[k] = gf256_mul(D_kk, gf256_mul(L_kk, U_kk));
+
+        // Computing the k-th row of L and U
+        uint8_t* row_L = matrix_L;
+        uint8_t* row_U = rotated_row_U;
+        for (int j = k + 1; j < N; ++j)
+        {
+            const uint8_t x_j = GetRecoveryX(j);
+            const uint8_t y_j = GetOriginalY(ErasuresIndices[j]);
+
+            // L_jk = g[j] / (x_j + y_k)
+            // U_kj = b[j] / (x_k + y_j)
+            const uint8_t L_jk = gf256_div(g[j], gf256_add(x_j, y_k));
+            const uint8_t U_kj = gf256_div(b[j], gf256_add(x_k, y_j));
+
+            *matrix_L++ = L_jk;
+            *row_U++ = U_kj;
+
+            // g[j] = g[j] * (x_j + x_k) / (x_j + y_k)
+            // b[j] = b[j] * (y_j + y_k) / (y_j + x_k)
+            g[j] = gf256_mul(g[j], gf256_div(gf256_add(x_j, x_k), gf256_add(x_j, y_k)));
+            b[j] = gf256_mul(b[j], gf256_div(gf256_add(y_j, y_k), gf256_add(y_j, x_k)));
+        }
+
+        // Do these row/column divisions in bulk for speed.
+        // L_jk /= L_kk
+        // U_kj /= U_kk
+        const int count = N - (k + 1);
+        gf256_div_mem(row_L, row_L, L_kk, count);
+        gf256_div_mem(rotated_row_U, rotated_row_U, U_kk, count);
+
+        // Copy U matrix row into place in memory.
+        uint8_t* output_U = last_U + firstOffset_U;
+        row_U = rotated_row_U;
+        for (int j = k + 1; j < N; ++j)
+        {
+            *output_U = *row_U++;
+            output_U -= j;
+        }
+        firstOffset_U -= k + 2;
+    }
+
+    // Multiply diagonal matrix into U
+    uint8_t* row_U = matrix_U;
+    for (int j = N - 1; j > 0; --j)
+    {
+        const uint8_t y_j = GetOriginalY(ErasuresIndices[j]);
+        const int count = j;
+
+        gf256_mul_mem(row_U, row_U, gf256_add(x_0, y_j), count);
+        row_U += count;
+    }
+
+    const uint8_t x_n = GetRecoveryX(N - 1);
+    const uint8_t y_n = GetOriginalY(ErasuresIndices[N - 1]);
+
+    // D_nn = 1 / (x_n + y_n)
+    // L_nn = g[N-1]
+    // U_nn = b[N-1] * (x_0 + y_n)
+    const uint8_t L_nn = g[N - 1];
+    const uint8_t U_nn = gf256_mul(b[N - 1], gf256_add(x_0, y_n));
+
+    // diag_D[N-1] = L_nn * D_nn * U_nn
+    diag_D[N - 1] = gf256_div(gf256_mul(L_nn, U_nn), gf256_add(x_n, y_n));
+}
+
+void CM256Decoder::Decode(cm256_pool* pool)
+{
+    // Allocate matrix and coefficients
+    static const int StackAllocSize = 2048;
+    uint8_t stackMatrix[StackAllocSize];
+    uint8_t* matrix = stackMatrix;
+    const int requiredSpace = GetCoefficientBytes();
+    if (requiredSpace > StackAllocSize)
+    {
+        matrix = GetThreadScratch(kScratchCoefficients, requiredSpace);
+    }
+
+    ComputeCoefficients(matrix);
+    Eliminate(pool);
+}
+
+int CM256Decoder::GetCoefficientBytes() const
+{
+    // Matrix size is NxN, where N is the number of recovery blocks used.
+    const int N = RecoveryCount;
+
+    return N * N * 2 + N * OriginalCount;
+}
+
+void CM256Decoder::ComputeCoefficients(uint8_t* matrix)
+{
+    CM256_STATS_PHASE(CM256_PHASE_COEFFICIENTS);
+
+    // Matrix size is NxN, where N is the number of recovery blocks used.
+    const int N = RecoveryCount;
+
+    // Start the x_0 values arbitrarily from the original count.
+    const uint8_t x_0 = GetX0();
+
+    /*
+        Compute matrix decomposition:
+
+            G = L * D * U
+
+        L is lower-triangular, diagonal is all ones.
+        D is a diagonal matrix.
+        U is upper-triangular, diagonal is all ones.
+
+        The decomposition only depends on the block indices, so it is done
+        once here.  The elimination coefficients are then laid out row by row
+        so that each byte range of the blocks can be eliminated independently.
+    */
+    uint8_t* matrix_U = matrix;
+    uint8_t* diag_D = matrix_U + (N - 1) * N / 2;
+    uint8_t* matrix_L = diag_D + N;
+    GenerateLDUDecomposition(matrix_L, diag_D, matrix_U);
+
+    uint8_t* originalMatrix = matrix_L + (N - 1) * N / 2;
+    uint8_t* rowsL = originalMatrix + N * OriginalCount;
+    uint8_t* rowsU = rowsL + (N - 1) * N / 2;
+
+    // Coefficients for eliminating original data from the recovery rows
+    uint8_t* row = originalMatrix;
+    for (int recoveryIndex = 0; recoveryIndex < N && !OriginalsEliminated; ++recoveryIndex)
+    {
+        const uint8_t x_i = GetRecoveryX(recoveryIndex);
+        const uint8_t scale = GetRowScale(recoveryIndex);
+
+        for (int originalIndex = 0; originalIndex < OriginalCount; ++originalIndex)
+        {
+            const uint8_t y_j = GetOriginalY(Original[originalIndex]->Index);
+            *row++ = gf256_mul(scale, GetMatrixElement(x_i, x_0, y_j));
+        }
+    }
+
+    // Fold the row scales into L and D, see Matrix Points
+    if (Points)
+    {
+        uint8_t* column_L = matrix_L;
+        for (int j = 0; j < N - 1; ++j)
+        {
+            const uint8_t scale_j = GetRowScale(j);
+            for (int i = j + 1; i < N; ++i)
+            {
+                *column_L = gf256_mul(*column_L, gf256_div(GetRowScale(i), scale_j));
+                ++column_L;
+            }
+        }
+        for (int i = 0; i < N; ++i)
+        {
+            diag_D[i] = gf256_mul(diag_D[i], GetRowScale(i));
+        }
+    }
+
+    // Rows of L: matrix elements are stored column-first, top-down.
+    row = rowsL;
+    for (int i = 1; i < N; ++i)
+    {
+        const uint8_t* column_L = matrix_L;
+        for (int j = 0; j < i; ++j)
+        {
+            *row++ = column_L[i - j - 1];
+            column_L += N - j - 1;
+        }
+    }
+
+    // Rows of U: matrix elements are stored column-first, bottom-up.
+    // Column j holds j elements and ends where column j-1 begins.
+    row = rowsU;
+    for (int i = 0; i < N - 1; ++i)
+    {
+        const uint8_t* column_U = matrix_U + (N - 1) * N / 2 - i * (i + 1) / 2;
+        for (int j = i + 1; j < N; ++j)
+        {
+            column_U -= j;
+            *row++ = column_U[j - 1 - i];
+        }
+    }
+
+    OriginalMatrix = originalMatrix;
+    RowsL = rowsL;
+    DiagD = diag_D;
+    RowsU = rowsU;
+}
+
+void CM256Decoder::Eliminate(cm256_pool* pool)
+{
+    RunStripes(pool, false);
+
+    for (int i = 0; i < RecoveryCount && !Outputs; ++i)
+    {
+        Recovery[i]->Index = ErasuresIndices[i];
+    }
+}
+
+void CM256Decoder::EliminateRange(int offset, int bytes, uint8_t* scratchTile, int nextBytes)
+{
+    const int N = RecoveryCount;
+
+    // One extra source for the recovery block when writing elsewhere
+    const void* inBlocks[257];
+    for (int originalIndex = 0; originalIndex < OriginalCount; ++originalIndex)
+    {
+        inBlocks[originalIndex] = static_cast<const uint8_t*>(Original[originalIndex]->Block) + offset;
+    }
+
+    // With a scratch tile every row is worked on there, and only streamed
+    // out to its output at the end
+    const void* recoveryBlocks[256];
+    for (int i = 0; i < N; ++i)
+    {
+        recoveryBlocks[i] = scratchTile ? scratchTile + i * bytes : GetOutput(i) + offset;
+    }
+
+    if (scratchTile && OriginalsEliminated)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            memcpy(const_cast<void*>(recoveryBlocks[i]), static_cast<const uint8_t*>(Recovery[i]->Block) + offset, bytes);
+        }
+    }
+
+    // Eliminate original data from the the recovery rows
+    const uint8_t* row = OriginalMatrix;
+    for (int recoveryIndex = 0; recoveryIndex < N && !OriginalsEliminated; ++recoveryIndex, row += OriginalCount)
+    {
+        CM256_STATS_PHASE(CM256_PHASE_ELIMINATE_ORIGINALS);
+
+        void* recoveryBlock = const_cast<void*>(recoveryBlocks[recoveryIndex]);
+
+        if (scratchTile)
+        {
+            PrefetchTile(offset + bytes, nextBytes, recoveryIndex, N);
+        }
+
+        if (!Outputs && !scratchTile)
+        {
+            gf256_muladd_multi_mem(recoveryBlock, row, inBlocks, OriginalCount, bytes);
+            continue;
+        }
+
+        // output = recovery + sum of original * coefficient, in one pass
+        uint8_t coefficients[257];
+        memcpy(coefficients, row, OriginalCount);
+        coefficients[OriginalCount] = 1;
+        inBlocks[OriginalCount] = static_cast<const uint8_t*>(Recovery[recoveryIndex]->Block) + offset;
+
+        gf256_mul_multi_mem(recoveryBlock, coefficients, inBlocks, OriginalCount + 1, bytes);
+    }
+
+    /*
+        Eliminate lower left triangle.
+
+        This is forward substitution, done one row at a time so that each
+        row is updated in a single pass over its block.
+    */
+    row = RowsL;
+    for (int i = 1; i < N; ++i)
+    {
+        CM256_STATS_PHASE(CM256_PHASE_ELIMINATE_L);
+        gf256_muladd_multi_mem(const_cast<void*>(recoveryBlocks[i]), row, recoveryBlocks, i, bytes);
+        row += i;
+    }
+
+    /*
+        Eliminate diagonal.
+    */
+    for (int i = 0; i < N; ++i)
+    {
+        CM256_STATS_PHASE(CM256_PHASE_ELIMINATE_D);
+        void* block = const_cast<void*>(recoveryBlocks[i]);
+
+        gf256_div_mem(block, block, DiagD[i], bytes);
+    }
+
+    /*
+        Eliminate upper right triangle.
+
+        This is back substitution, again done one row at a time.
+    */
+    row = RowsU + (N - 1) * N / 2;
+    for (int i = N - 2; i >= 0; --i)
+    {
+        CM256_STATS_PHASE(CM256_PHASE_ELIMINATE_U);
+        row -= N - 1 - i;
+        gf256_muladd_multi_mem(const_cast<void*>(recoveryBlocks[i]), row, recoveryBlocks + i + 1, N - 1 - i, bytes);
+    }
+
+    if (Crcs)
+    {
+        UpdateTileCrcs(offset, bytes, recoveryBlocks);
+    }
+
+    if (scratchTile)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            gf256_stream_copy_mem(GetOutput(i) + offset, recoveryBlocks[i], bytes);
+        }
+    }
+}
+
+/*
+    Decoder Tiling and Stripes
+
+    Like encoding, every elimination pass works on each byte offset of the
+    blocks independently.  So the decoder walks the blocks in cache-sized
+    tiles, running every pass on one tile before moving on, and with a pool
+    it splits the blocks into stripes that are decoded on separate threads.
+*/
+
+struct DecodeStripeTask
+{
+    CM256Decoder* Decoder;
+    bool M1;
+    int StripeBytes;
+
+    // Decode the byte range [begin, end) one tile at a time
+    void RunRange(int begin, int end) const
+    {
+        const int tileBytes = GetEncodeTileBytes(Decoder->Params);
+
+        // In large-block mode the outputs of a tile are built in scratch and
+        // then streamed out, see Large-Block Mode
+        const int N = Decoder->RecoveryCount;
+        uint8_t* scratchTile = nullptr;
+        if (UseLargeBlocks(Decoder->OriginalCount + N, Decoder->Params.BlockBytes))
+        {
+            scratchTile = GetThreadScratch(kScratchTile, N * tileBytes);
+        }
+
+        for (int offset = begin; offset < end; offset += tileBytes)
+        {
+            int bytes = end - offset;
+            if (bytes > tileBytes)
+            {
+                bytes = tileBytes;
+            }
+            const int nextBytes = std::min(tileBytes, end - offset - bytes);
+
+            if (M1)
+            {
+                Decoder->DecodeM1Range(offset, bytes, scratchTile, nextBytes);
+            }
+            else
+            {
+                Decoder->EliminateRange(offset, bytes, scratchTile, nextBytes);
+            }
+        }
+
+        if (scratchTile)
+        {
+            gf256_stream_fence();
+        }
+    }
+
+    static void Run(void* context, int task)
+    {
+        const DecodeStripeTask* self = static_cast<const DecodeStripeTask*>(context);
+
+        const int blockBytes = self->Decoder->Params.BlockBytes;
+        const int begin = task * self->StripeBytes;
+        int end = begin + self->StripeBytes;
+        if (end > blockBytes)
+        {
+            end = blockBytes;
+        }
+
+        self->RunRange(begin, end);
+    }
+};
+
+void CM256Decoder::RunStripes(cm256_pool* pool, bool m1)
+{
+    DecodeStripeTask task;
+    task.Decoder = this;
+    task.M1 = m1;
+
+    const int blockBytes = Params.BlockBytes;
+    const int stripeCount = GetStripeCount(blockBytes, pool);
+
+    // Small blocks are not worth waking the workers for
+    if (stripeCount < 2)
+    {
+        task.RunRange(0, blockBytes);
+        return;
+    }
+
+    task.StripeBytes = GetStripeBytes(blockBytes, stripeCount);
+    const int taskCount = (blockBytes + task.StripeBytes - 1) / task.StripeBytes;
+
+    cm256_pool_run(pool, &DecodeStripeTask::Run, &task, taskCount);
+}
+
+static int DecodeWithPool(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    void* const* outputs,        // Outputs for erased originals, or null to decode in place
+    cm256_pool* pool,            // Optional worker pool
+    const cm256_matrix_points* points = nullptr, // Matrix points, or null for the defaults
+    uint32_t* crcs = nullptr)    // CRCs of the originals by index, or null
+{
+    CM256_STATS_PHASE(CM256_PHASE_DECODE);
+
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+
+    // If there is only one block,
+    if (params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        if (!outputs)
+        {
+            blocks[0].Index = 0;
+        }
+        else if (blocks[0].Index != 0)
+        {
+            if (!outputs[0])
+            {
+                return -3;
+            }
+            memcpy(outputs[0], blocks[0].Block, params.BlockBytes);
+        }
+        if (crcs)
+        {
+            crcs[0] = cm256_crc32c(0, blocks[0].Block, params.BlockBytes);
+        }
+        return 0;
+    }
+
+    CM256Decoder state;
+    if (!state.Initialize(params, blocks))
+    {
+        return -5;
+    }
+    state.Points = points;
+
+    // If nothing is erased,
+    if (state.RecoveryCount <= 0)
+    {
+        // There is no pass over the data to take the CRCs in
+        for (int i = 0; crcs && i < params.OriginalCount; ++i)
+        {
+            crcs[blocks[i].Index] = cm256_crc32c(0, blocks[i].Block, params.BlockBytes);
+        }
+        return 0;
+    }
+
+    // The CRCs are continued over the tiles in order, so they are taken on
+    // the calling thread
+    if (crcs)
+    {
+        memset(crcs, 0, params.OriginalCount * sizeof(uint32_t));
+        state.Crcs = crcs;
+        pool = nullptr;
+    }
+
+    if (outputs)
+    {
+        for (int i = 0; i < state.RecoveryCount; ++i)
+        {
+            if (!outputs[state.ErasuresIndices[i]])
+            {
+                return -3;
+            }
+        }
+        state.Outputs = outputs;
+    }
+
+    // If m=1,
+    if (params.RecoveryCount == 1)
+    {
+        state.DecodeM1(pool);
+        return 0;
+    }
+
+    // Decode for m>1
+    state.Decode(pool);
+    return 0;
+}
+
+extern "C" int cm256_decode(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* blocks)         // Array of 'originalCount' blocks as described above
+{
+    return DecodeWithPool(params, blocks, nullptr, nullptr);
+}
+
+extern "C" int cm256_decode_crc(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    uint32_t* crcs)              // Output 'originalCount' CRCs
+{
+    if (!crcs)
+    {
+        return -3;
+    }
+
+    return DecodeWithPool(params, blocks, nullptr, nullptr, nullptr, crcs);
+}
+
+extern "C" int cm256_decode_mt(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    cm256_pool* pool)            // Worker pool from cm256_pool_create()
+{
+    return DecodeWithPool(params, blocks, nullptr, pool);
+}
+
+extern "C" int cm256_decode_into(
+    cm256_encoder_params params, // Encoder params
+    const cm256_block* blocks,   // Array of 'originalCount' blocks as described above
+    void* const* outputs,        // Array of 'originalCount' output pointers
+    cm256_pool* pool)            // Optional worker pool
+{
+    if (!outputs)
+    {
+        return -3;
+    }
+
+    // The blocks are only read when writing to separate outputs
+    return DecodeWithPool(params, const_cast<cm256_block*>(blocks), outputs, pool);
+}
+
+extern "C" int cm256_decode_with_points(
+    cm256_encoder_params params,       // Encoder params
+    const cm256_matrix_points* points, // Points the recovery data was encoded with
+    cm256_block* blocks,               // Array of 'originalCount' blocks as described above
+    cm256_pool* pool)                  // Optional worker pool
+{
+    if (!points)
+    {
+        return -3;
+    }
+    if (!ValidatePoints(params, points))
+    {
+        return -1;
+    }
+
+    return DecodeWithPool(params, blocks, nullptr, pool, points);
+}
+
+
+//-----------------------------------------------------------------------------
+// Partial Decode
+
+/*
+    After the received originals are eliminated, the recovery rows hold
+
+        R'_i = sum_t C_it * E_t,    C_it = (y_t + x_0) / (x_i + y_t)
+
+    for the erased originals E_t at indices y_t.  C is a Cauchy matrix with
+    its columns scaled by (y_t + x_0), so each row of its inverse has the
+    closed form below and costs O(N) to evaluate after O(N^2) setup.
+
+    Folding the elimination of the received originals into that row turns
+    each wanted original into a single combination of the k received blocks,
+    which is one pass over the data rather than the full N x N solve.
+*/
+
+// Computes the products over the recovery rows shared by every inverse row
+void GetPartialDecodeProducts(const CM256Decoder& state, uint8_t* P, uint8_t* Dx)
+{
+    const int N = state.RecoveryCount;
+    for (int i = 0; i < N; ++i)
+    {
+        const uint8_t x_i = state.Recovery[i]->Index;
+
+        uint8_t p = 1, dx = 1;
+        for (int s = 0; s < N; ++s)
+        {
+            p = gf256_mul(p, gf256_add(x_i, state.ErasuresIndices[s]));
+            if (s != i)
+            {
+                dx = gf256_mul(dx, gf256_add(x_i, state.Recovery[s]->Index));
+            }
+        }
+        P[i] = p;
+        Dx[i] = dx;
+    }
+}
+
+// Computes the k source coefficients that produce erased original t.
+// Sources are the originals in Original[] order followed by Recovery[].
+// P[i] = prod_s (x_i + y_s) and Dx[i] = prod_{s != i} (x_i + x_s).
+void GetPartialDecodeRow(
+    const CM256Decoder& state,
+    const uint8_t* P,
+    const uint8_t* Dx,
+    int t,
+    uint8_t* coefficients)
+{
+    const int N = state.RecoveryCount;
+    const uint8_t x_0 = static_cast<uint8_t>(state.Params.OriginalCount);
+    const uint8_t y_t = state.ErasuresIndices[t];
+
+    // Q = prod_s (x_s + y_t) and Dy = (y_t + x_0) * prod_{s != t} (y_t + y_s)
+    uint8_t Q = 1, Dy = gf256_add(y_t, x_0);
+    for (int s = 0; s < N; ++s)
+    {
+        Q = gf256_mul(Q, gf256_add(state.Recovery[s]->Index, y_t));
+        if (s != t)
+        {
+            Dy = gf256_mul(Dy, gf256_add(y_t, state.ErasuresIndices[s]));
+        }
+    }
+
+    // Row t of the inverse: w_i = P_i * Q / ((x_i + y_t) * Dx_i * Dy)
+    uint8_t* w = coefficients + state.OriginalCount;
+    for (int i = 0; i < N; ++i)
+    {
+        const uint8_t x_i = state.Recovery[i]->Index;
+        const uint8_t denominator = gf256_mul(gf256_mul(gf256_add(x_i, y_t), Dx[i]), Dy);
+        w[i] = gf256_div(gf256_mul(P[i], Q), denominator);
+    }
+
+    // Received originals: v_j = sum_i w_i * (y_j + x_0) / (x_i + y_j)
+    for (int j = 0; j < state.OriginalCount; ++j)
+    {
+        const uint8_t y_j = state.Original[j]->Index;
+
+        uint8_t v = 0;
+        for (int i = 0; i < N; ++i)
+        {
+            v = gf256_add(v, gf256_mul(w[i], GetMatrixElement(state.Recovery[i]->Index, x_0, y_j)));
+        }
+        coefficients[j] = v;
+    }
+}
+
+struct PartialDecodeTask
+{
+    cm256_encoder_params Params; // OriginalCount sources, RecoveryCount outputs
+    const void* const* Sources;
+    const cm256_sg_block* const* SgSources; // Read instead of Sources when not null
+    uint8_t* const* Outputs;
+    const uint8_t* Coefficients; // One row of OriginalCount per output
+    int StripeBytes;
+
+    // Produce the byte range [begin, end) of every output one tile at a time
+    void RunRange(int begin, int end) const
+    {
+        const int tileBytes = GetEncodeTileBytes(Params);
+        const int sourceCount = Params.OriginalCount;
+
+        SgRuns runs;
+        if (SgSources)
+        {
+            runs.Reset(SgSources, sourceCount);
+        }
+
+        int bytes;
+        for (int offset = begin; offset < end; offset += bytes)
+        {
+            bytes = end - offset;
+            if (bytes > tileBytes)
+            {
+                bytes = tileBytes;
+            }
+
+            // Scatter-gather runs may be shorter than a tile
+            const void* sources[256];
+            if (SgSources)
+            {
+                bytes = runs.Next(offset, bytes, sources);
+            }
+            else
+            {
+                for (int j = 0; j < sourceCount; ++j)
+                {
+                    sources[j] = static_cast<const uint8_t*>(Sources[j]) + offset;
+                }
+            }
+
+            for (int o = 0; o < Params.RecoveryCount; ++o)
+            {
+                gf256_mul_multi_mem(Outputs[o] + offset, Coefficients + o * sourceCount, sources, sourceCount, bytes);
+            }
+        }
+    }
+
+    static void Run(void* context, int task)
+    {
+        const PartialDecodeTask* self = static_cast<const PartialDecodeTask*>(context);
+
+        const int begin = task * self->StripeBytes;
+        int end = begin + self->StripeBytes;
+        if (end > self->Params.BlockBytes)
+        {
+            end = self->Params.BlockBytes;
+        }
+
+        self->RunRange(begin, end);
+    }
+};
+
+// Decode the wanted erased originals.  With sgBlocks the data is read from
+// there, and 'blocks' only gives the index of each one.
+int DecodePartial(
+    cm256_encoder_params params,
+    const cm256_block* blocks,
+    const cm256_sg_block* sgBlocks,
+    void* const* outputs,
+    cm256_pool* pool)
+{
+    // If there is only one block,
+    if (params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        if (blocks[0].Index != 0 && outputs[0])
+        {
+            if (sgBlocks)
+            {
+                GatherSgBlock(sgBlocks[0], params.BlockBytes, outputs[0]);
+            }
+            else
+            {
+                memcpy(outputs[0], blocks[0].Block, params.BlockBytes);
+            }
+        }
+        return 0;
+    }
+
+    // The blocks are only read
+    CM256Decoder state;
+    if (!state.Initialize(params, const_cast<cm256_block*>(blocks)))
+    {
+        return -5;
+    }
+
+    const int N = state.RecoveryCount;
+
+    // Find the erased originals that were asked for
+    int wanted[256];
+    int wantedCount = 0;
+    for (int t = 0; t < N; ++t)
+    {
+        if (outputs[state.ErasuresIndices[t]])
+        {
+            wanted[wantedCount++] = t;
+        }
+    }
+    if (wantedCount <= 0)
+    {
+        return 0;
+    }
+
+    uint8_t P[256], Dx[256];
+    GetPartialDecodeProducts(state, P, Dx);
+
+    // Allocate coefficients
+    static const int StackAllocSize = 2048;
+    uint8_t stackCoefficients[StackAllocSize];
+    uint8_t* coefficients = stackCoefficients;
+    const int requiredSpace = wantedCount * params.OriginalCount;
+    if (requiredSpace > StackAllocSize)
+    {
+        coefficients = GetThreadScratch(kScratchCoefficients, requiredSpace);
+    }
+
+    const void* sources[256];
+    for (int j = 0; j < state.OriginalCount; ++j)
+    {
+        sources[j] = state.Original[j]->Block;
+    }
+    for (int i = 0; i < N; ++i)
+    {
+        sources[state.OriginalCount + i] = state.Recovery[i]->Block;
+    }
+
+    // The sources in the same order, by their position in the blocks array
+    const cm256_sg_block* sgSources[256];
+    if (sgBlocks)
+    {
+        for (int j = 0; j < state.OriginalCount; ++j)
+        {
+            sgSources[j] = sgBlocks + (state.Original[j] - blocks);
+        }
+        for (int i = 0; i < N; ++i)
+        {
+            sgSources[state.OriginalCount + i] = sgBlocks + (state.Recovery[i] - blocks);
+        }
+    }
+
+    uint8_t* outputBlocks[256];
+    for (int o = 0; o < wantedCount; ++o)
+    {
+        GetPartialDecodeRow(state, P, Dx, wanted[o], coefficients + o * params.OriginalCount);
+        outputBlocks[o] = static_cast<uint8_t*>(outputs[state.ErasuresIndices[wanted[o]]]);
+    }
+
+    PartialDecodeTask task;
+    task.Params.OriginalCount = params.OriginalCount;
+    task.Params.RecoveryCount = wantedCount;
+    task.Params.BlockBytes = params.BlockBytes;
+    task.Sources = sources;
+    task.SgSources = sgBlocks ? sgSources : nullptr;
+    task.Outputs = outputBlocks;
+    task.Coefficients = coefficients;
+
+    const int stripeCount = GetStripeCount(params.BlockBytes, pool);
+
+    // Small blocks are not worth waking the workers for
+    if (stripeCount < 2)
+    {
+        task.RunRange(0, params.BlockBytes);
+    }
+    else
+    {
+        task.StripeBytes = GetStripeBytes(params.BlockBytes, stripeCount);
+        const int taskCount = (params.BlockBytes + task.StripeBytes - 1) / task.StripeBytes;
+
+        cm256_pool_run(pool, &PartialDecodeTask::Run, &task, taskCount);
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_decode_partial(
+    cm256_encoder_params params, // Encoder params
+    const cm256_block* blocks,   // Array of 'originalCount' blocks as described above
+    void* const* outputs,        // Array of 'originalCount' output pointers
+    cm256_pool* pool)            // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!blocks || !outputs)
+    {
+        return -3;
+    }
+
+    return DecodePartial(params, blocks, nullptr, outputs, pool);
+}
+
+//-----------------------------------------------------------------------------
+// Batch Decode
+
+/*
+    The stripes of a batch are grouped by the set of block indices they
+    received, so that each group shares one decode plan.
+*/
+
+struct DecodeBatchTask
+{
+    const cm256_decode_plan* Plan;
+    cm256_block* const* Stripes;
+    const int* Order; // Stripe numbers of the group
+    int StripeCount;  // Number of stripes in the group
+    int TaskStripes;
+
+    // Decode stripes [begin, end) of the group on this thread
+    void RunRange(int begin, int end) const
+    {
+        // The group was built so that every stripe matches the plan
+        for (int i = begin; i < end; ++i)
+        {
+            cm256_decode_plan_apply(Plan, Stripes[Order[i]], nullptr);
+        }
+    }
+
+    static void Run(void* context, int task)
+    {
+        const DecodeBatchTask* self = static_cast<const DecodeBatchTask*>(context);
+
+        const int begin = task * self->TaskStripes;
+        int end = begin + self->TaskStripes;
+        if (end > self->StripeCount)
+        {
+            end = self->StripeCount;
+        }
+
+        self->RunRange(begin, end);
+    }
+};
+
+// Bitmap of the block indices received for one stripe of a batch
+struct BatchStripeKey
+{
+    uint64_t Present[4];
+
+    bool operator<(const BatchStripeKey& other) const
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            if (Present[i] != other.Present[i])
+            {
+                return Present[i] < other.Present[i];
+            }
+        }
+        return false;
+    }
+    bool operator==(const BatchStripeKey& other) const
+    {
+        return !(*this < other) && !(other < *this);
+    }
+};
+
+extern "C" int cm256_decode_batch(
+    cm256_encoder_params params,   // Encoder parameters
+    cm256_block* const* stripes,   // Array of stripes, each 'originalCount' blocks
+    int stripeCount,               // Number of stripes
+    cm256_pool* pool)              // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if ((!stripes && stripeCount > 0) || stripeCount < 0)
+    {
+        return -3;
+    }
+    for (int i = 0; i < stripeCount; ++i)
+    {
+        if (!stripes[i])
+        {
+            return -3;
+        }
+    }
+
+    std::vector<BatchStripeKey> keys(stripeCount);
+    std::vector<int> order(stripeCount);
+    for (int i = 0; i < stripeCount; ++i)
+    {
+        BatchStripeKey& key = keys[i];
+        key.Present[0] = key.Present[1] = key.Present[2] = key.Present[3] = 0;
+
+        for (int ii = 0; ii < params.OriginalCount; ++ii)
+        {
+            const unsigned index = stripes[i][ii].Index;
+            key.Present[index / 64] |= (uint64_t)1 << (index % 64);
+        }
+
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&keys](int a, int b) {
+        return keys[a] < keys[b];
+    });
+
+    const bool splitBlocks = GetStripeCount(params.BlockBytes, pool) >= 2;
+    const int taskStripes = GetBatchTaskStripes(params, stripeCount, pool);
+
+    int result = 0;
+
+    // For each group of stripes with the same received indices,
+    for (int first = 0, last; first < stripeCount; first = last)
+    {
+        const BatchStripeKey& key = keys[order[first]];
+        for (last = first + 1; last < stripeCount && keys[order[last]] == key; ++last)
+        {
+        }
+
+        cm256_block* const blocks = stripes[order[first]];
+        unsigned char indices[256];
+        for (int ii = 0; ii < params.OriginalCount; ++ii)
+        {
+            indices[ii] = blocks[ii].Index;
+        }
+
+        // Continue with the other groups if this one is invalid
+        cm256_decode_plan* plan = cm256_decode_plan_create(params, indices);
+        if (!plan)
+        {
+            result = -5;
+            continue;
+        }
+
+        if (splitBlocks)
+        {
+            // Large blocks are split by byte range instead
+            for (int i = first; i < last; ++i)
+            {
+                cm256_decode_plan_apply(plan, stripes[order[i]], pool);
+            }
+        }
+        else
+        {
+            DecodeBatchTask task;
+            task.Plan = plan;
+            task.Stripes = stripes;
+            task.Order = &order[first];
+            task.StripeCount = last - first;
+            task.TaskStripes = taskStripes;
+
+            const int taskCount = (task.StripeCount + taskStripes - 1) / taskStripes;
+            if (taskCount < 2)
+            {
+                task.RunRange(0, task.StripeCount);
+            }
+            else
+            {
+                cm256_pool_run(pool, &DecodeBatchTask::Run, &task, taskCount);
+            }
+        }
+
+        cm256_decode_plan_destroy(plan);
+    }
+
+    return result;
+}
@@ -0,0 +1,300 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+
+#include <mutex>
+#include <new>
+#include <cstring>
+#include <cstdint>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Aligned Block Arena
+
+/*
+    All blocks come from one allocation, carved at a stride of the padded
+    block size.  Blocks that have never been handed out are taken from the
+    end of the carved region, so creating an arena does not touch its memory,
+    and freed blocks are kept on a list threaded through their first bytes.
+
+    On Linux the memory is mapped rather than allocated.  Arenas of at least
+    one huge page are aligned to a huge page and advised with MADV_HUGEPAGE,
+    so that streaming through many blocks does not walk the TLB one 4 KiB
+    page at a time.  Nothing is required of the system: without transparent
+    huge pages the advice is ignored and the arena uses normal pages.
+*/
+
+static const size_t kHugePageBytes = 2 * 1024 * 1024;
+
+struct ArenaFreeBlock
+{
+    ArenaFreeBlock* Next;
+};
+
+struct cm256_arena_t
+{
+    int BlockBytes;
+    int PaddedBytes;
+    int BlockCount;
+
+    // Start of the first block, and the allocation it is carved from
+    uint8_t* Blocks;
+    void* Allocation;
+    size_t AllocationBytes;
+    bool Mapped;
+
+    // Protects the fields below
+    std::mutex Lock;
+
+    ArenaFreeBlock* FreeList;
+
+    // Number of blocks carved from the start of the region so far
+    int CarvedCount;
+};
+
+static bool AllocateArenaMemory(cm256_arena* arena, size_t bytes)
+{
+#ifdef __linux__
+    const bool huge = bytes >= kHugePageBytes;
+
+    // Map an extra huge page so that the blocks can start on a huge page
+    const size_t mapBytes = huge ? bytes + kHugePageBytes : bytes;
+    void* mapped = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped != MAP_FAILED)
+    {
+        arena->Allocation = mapped;
+        arena->AllocationBytes = mapBytes;
+        arena->Mapped = true;
+
+        uintptr_t start = reinterpret_cast<uintptr_t>(mapped);
+        if (huge)
+        {
+            start = (start + kHugePageBytes - 1) & ~(uintptr_t)(kHugePageBytes - 1);
+#ifdef MADV_HUGEPAGE
+            madvise(reinterpret_cast<void*>(start), bytes, MADV_HUGEPAGE);
+#endif
+        }
+        arena->Blocks = reinterpret_cast<uint8_t*>(start);
+        return true;
+    }
+#endif // __linux__
+
+    uint8_t* allocation = new (std::nothrow) uint8_t[bytes + CM256_BLOCK_ALIGN - 1];
+    if (!allocation)
+    {
+        return false;
+    }
+    arena->Allocation = allocation;
+    arena->AllocationBytes = bytes + CM256_BLOCK_ALIGN - 1;
+    arena->Mapped = false;
+
+    const uintptr_t start = (reinterpret_cast<uintptr_t>(allocation) + CM256_BLOCK_ALIGN - 1) &
+        ~(uintptr_t)(CM256_BLOCK_ALIGN - 1);
+    arena->Blocks = reinterpret_cast<uint8_t*>(start);
+    return true;
+}
+
+static void FreeArenaMemory(cm256_arena* arena)
+{
+#ifdef __linux__
+    if (arena->Mapped)
+    {
+        munmap(arena->Allocation, arena->AllocationBytes);
+        return;
+    }
+#endif // __linux__
+
+    delete[] static_cast<uint8_t*>(arena->Allocation);
+}
+
+extern "C" cm256_arena* cm256_arena_create(int blockBytes, int blockCount)
+{
+    if (blockBytes <= 0 || blockCount <= 0 ||
+        blockBytes > INT32_MAX - CM256_BLOCK_ALIGN)
+    {
+        return nullptr;
+    }
+
+    const int paddedBytes = cm256_padded_bytes(blockBytes);
+    const uint64_t bytes = (uint64_t)paddedBytes * (uint64_t)blockCount;
+    if (bytes > (uint64_t)SIZE_MAX - kHugePageBytes)
+    {
+        return nullptr;
+    }
+
+    cm256_arena* arena = new (std::nothrow) cm256_arena;
+    if (!arena)
+    {
+        return nullptr;
+    }
+
+    arena->BlockBytes = blockBytes;
+    arena->PaddedBytes = paddedBytes;
+    arena->BlockCount = blockCount;
+    arena->FreeList = nullptr;
+    arena->CarvedCount = 0;
+
+    if (!AllocateArenaMemory(arena, (size_t)bytes))
+    {
+        delete arena;
+        return nullptr;
+    }
+
+    return arena;
+}
+
+extern "C" void cm256_arena_destroy(cm256_arena* arena)
+{
+    if (arena)
+    {
+        FreeArenaMemory(arena);
+        delete arena;
+    }
+}
+
+extern "C" void* cm256_arena_alloc(cm256_arena* arena)
+{
+    if (!arena)
+    {
+        return nullptr;
+    }
+
+    uint8_t* block;
+    {
+        std::lock_guard<std::mutex> locker(arena->Lock);
+
+        if (arena->FreeList)
+        {
+            block = reinterpret_cast<uint8_t*>(arena->FreeList);
+            arena->FreeList = arena->FreeList->Next;
+        }
+        else if (arena->CarvedCount < arena->BlockCount)
+        {
+            block = arena->Blocks + (size_t)arena->CarvedCount * arena->PaddedBytes;
+            ++arena->CarvedCount;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    // The aligned entry points require zero padding, see cm256_encode_aligned()
+    memset(block + arena->BlockBytes, 0, arena->PaddedBytes - arena->BlockBytes);
+    return block;
+}
+
+extern "C" void cm256_arena_free(cm256_arena* arena, void* block)
+{
+    if (!arena || !block)
+    {
+        return;
+    }
+
+    ArenaFreeBlock* freeBlock = static_cast<ArenaFreeBlock*>(block);
+
+    std::lock_guard<std::mutex> locker(arena->Lock);
+    freeBlock->Next = arena->FreeList;
+    arena->FreeList = freeBlock;
+}
+
+
+//-----------------------------------------------------------------------------
+// Aligned and Padded Encode and Decode
+
+// Checks the parameters in the same order as cm256_encode(), then that every
+// block is aligned.  'recoveryBlocks' is null when decoding.
+static int ValidateAlignedParams(
+    const cm256_encoder_params& params,
+    const cm256_block* blocks,
+    const void* recoveryBlocks,
+    bool encode)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.BlockBytes > INT32_MAX - CM256_BLOCK_ALIGN)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!blocks || (encode && !recoveryBlocks))
+    {
+        return -3;
+    }
+
+    uintptr_t misaligned = reinterpret_cast<uintptr_t>(recoveryBlocks);
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        misaligned |= reinterpret_cast<uintptr_t>(blocks[i].Block);
+    }
+    if ((misaligned & (CM256_BLOCK_ALIGN - 1)) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int cm256_encode_aligned(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    const int result = ValidateAlignedParams(params, originals, recoveryBlocks, true);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    // Code whole padded blocks, so every kernel call covers a multiple of
+    // the widest register and none of them has a tail
+    params.BlockBytes = cm256_padded_bytes(params.BlockBytes);
+    return cm256_encode(params, originals, recoveryBlocks);
+}
+
+extern "C" int cm256_decode_aligned(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks)         // Array of 'originalCount' blocks as described above
+{
+    const int result = ValidateAlignedParams(params, blocks, nullptr, false);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    params.BlockBytes = cm256_padded_bytes(params.BlockBytes);
+    return cm256_decode(params, blocks);
+}
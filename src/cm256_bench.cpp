@@ -0,0 +1,1066 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Microbenchmarks
+
+        cm256_bench [--json] [--quick] [--samples N] [--filter text]
+
+    Times the bulk memory kernels of every instruction set the CPU supports
+    over a range of sizes and alignments, then full encode and decode over a
+    grid of (k, m, BlockBytes) on each instruction set.
+
+    Each case is run for a warmup period first.  Then the number of
+    repetitions per sample is doubled until one sample takes at least
+    kMinSampleNsec, so that clock overhead stays out of the numbers, and
+    samples are taken until the sample count or the time budget of the case
+    runs out.  The median, 99th percentile and minimum time per call are
+    reported along with the median throughput.  All times come from
+    steady_clock.
+
+    FFT mode, XOR bitmatrix mode, the GF(65536) codec, large-block mode and
+    batches are timed on the default instruction set only.  The FFT crossover cases time both codecs
+    at a 2:1 code rate and count the sizes where cm256_fft_preferred() picks
+    the slower one; CM256_FFT_CROSSOVER_PERCENT is tuned from the range of
+    crossovers they report as best.
+
+    --json prints one JSON document for scripts that track regressions
+    between releases, and --filter keeps only the cases whose name or
+    instruction set contains the text.
+
+    To see the effect of the compact GF(256) context, build once with and
+    once without GF256_COMPACT_CONTEXT and compare the small-block decodes.
+    The JSON document records which context was built.
+*/
+
+#include "cm256.h"
+#include "cm65536.h"
+#include "gf256_kernels.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+
+//-----------------------------------------------------------------------------
+// Measurement
+
+// Shortest sample, well above the cost of reading the clock
+static const double kMinSampleNsec = 50000.;
+
+// Time a case runs before it is measured
+static const double kWarmupNsec = 20000000.;
+
+struct BenchOptions
+{
+    bool Json = false;
+
+    // Samples per case, and the time budget after which fewer are taken
+    int Samples = 101;
+    double BudgetNsec = 500000000.;
+
+    // Only cases whose name or instruction set contain this are run
+    std::string Filter;
+};
+
+struct BenchResult
+{
+    std::string Name;
+    std::string Isa;
+
+    // Parameters of the case, or 0 where they do not apply
+    int Bytes = 0;
+    int Offset = 0;
+    int OriginalCount = 0;
+    int RecoveryCount = 0;
+
+    // Bytes counted towards throughput per call
+    double ProcessedBytes = 0.;
+
+    int Samples = 0;
+    int Repetitions = 0;
+
+    // Nanoseconds per call
+    double MedianNsec = 0.;
+    double P99Nsec = 0.;
+    double MinNsec = 0.;
+};
+
+typedef std::chrono::steady_clock BenchClock;
+
+template<typename Op>
+static double TimeRepetitions(Op& op, int repetitions)
+{
+    const auto t0 = BenchClock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        op();
+    }
+    const auto t1 = BenchClock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count();
+}
+
+template<typename Op>
+static void Measure(Op op, const BenchOptions& options, BenchResult& result)
+{
+    // Warm the caches, the branch predictors and the CPU clock
+    const auto warmupEnd = BenchClock::now() +
+        std::chrono::nanoseconds((long long)kWarmupNsec);
+    do
+    {
+        op();
+    } while (BenchClock::now() < warmupEnd);
+
+    int repetitions = 1;
+    while (repetitions < (1 << 24) && TimeRepetitions(op, repetitions) < kMinSampleNsec)
+    {
+        repetitions *= 2;
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.Samples);
+    double elapsed = 0.;
+
+    // At least 11 samples, so the percentiles mean something
+    while ((int)samples.size() < options.Samples &&
+           (samples.size() < 11 || elapsed < options.BudgetNsec))
+    {
+        const double nsec = TimeRepetitions(op, repetitions);
+        elapsed += nsec;
+        samples.push_back(nsec / repetitions);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const size_t count = samples.size();
+
+    result.Samples = (int)count;
+    result.Repetitions = repetitions;
+    result.MinNsec = samples[0];
+    result.MedianNsec = (count % 2) ? samples[count / 2]
+                                    : (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+
+    // Nearest-rank percentile
+    size_t rank = (size_t)((count * 99 + 99) / 100);
+    result.P99Nsec = samples[rank - 1];
+}
+
+// Outcome of the FFT crossover cases
+struct CrossoverResult
+{
+    // Sizes timed, and how many cm256_fft_preferred() picked the slower codec for
+    int Sizes = 0;
+    int Mispredicted = 0;
+
+    // First range of crossover percents that mispredict the fewest sizes
+    int BestPercentMin = 0;
+    int BestPercentMax = 0;
+    int BestMispredicted = 0;
+};
+
+static double GetGBps(const BenchResult& result)
+{
+    return result.MedianNsec > 0. ? result.ProcessedBytes / result.MedianNsec : 0.;
+}
+
+
+//-----------------------------------------------------------------------------
+// Reporting
+
+#ifdef GF256_COMPACT_CONTEXT
+static const bool kCompactContext = true;
+#else
+static const bool kCompactContext = false;
+#endif
+
+class BenchReport
+{
+public:
+    explicit BenchReport(const BenchOptions& options)
+        : Options(options)
+    {
+    }
+
+    bool Wanted(const std::string& name, const std::string& isa) const
+    {
+        return Options.Filter.empty() ||
+            name.find(Options.Filter) != std::string::npos ||
+            isa.find(Options.Filter) != std::string::npos;
+    }
+
+    void Add(const BenchResult& result)
+    {
+        Results.push_back(result);
+
+        if (!Options.Json)
+        {
+            char params[64];
+            if (result.OriginalCount > 0)
+            {
+                snprintf(params, sizeof(params), "k=%d m=%d bytes=%d",
+                    result.OriginalCount, result.RecoveryCount, result.Bytes);
+            }
+            else
+            {
+                snprintf(params, sizeof(params), "bytes=%d offset=%d", result.Bytes, result.Offset);
+            }
+
+            printf("%-16s %-9s %-26s median %11.1f ns  p99 %11.1f ns  %8.3f GB/s\n",
+                result.Name.c_str(), result.Isa.c_str(), params,
+                result.MedianNsec, result.P99Nsec, GetGBps(result));
+            fflush(stdout);
+        }
+    }
+
+    void SetCrossover(const CrossoverResult& crossover)
+    {
+        Crossover = crossover;
+        HasCrossover = true;
+
+        if (!Options.Json)
+        {
+            printf("fft crossover at %d%% mispredicted %d of %d sizes, best %d%%-%d%% mispredicted %d\n",
+                CM256_FFT_CROSSOVER_PERCENT, crossover.Mispredicted, crossover.Sizes,
+                crossover.BestPercentMin, crossover.BestPercentMax, crossover.BestMispredicted);
+            fflush(stdout);
+        }
+    }
+
+    void Finish() const
+    {
+        if (!Options.Json)
+        {
+            return;
+        }
+
+        printf("{\n  \"version\": 1,\n  \"default_isa\": \"%s\",\n  \"compact_context\": %s,\n"
+            "  \"samples\": %d,\n",
+            gf256_kernels_name(), kCompactContext ? "true" : "false", Options.Samples);
+
+        if (HasCrossover)
+        {
+            printf("  \"fft_crossover\": {\"percent\": %d, \"sizes\": %d, \"mispredicted\": %d, "
+                "\"best_percent_min\": %d, \"best_percent_max\": %d, \"best_mispredicted\": %d},\n",
+                CM256_FFT_CROSSOVER_PERCENT, Crossover.Sizes, Crossover.Mispredicted,
+                Crossover.BestPercentMin, Crossover.BestPercentMax, Crossover.BestMispredicted);
+        }
+
+        printf("  \"results\": [");
+
+        for (size_t i = 0; i < Results.size(); ++i)
+        {
+            const BenchResult& r = Results[i];
+            printf("%s\n    {\"name\": \"%s\", \"isa\": \"%s\", \"bytes\": %d, \"offset\": %d, "
+                "\"k\": %d, \"m\": %d, \"samples\": %d, \"repetitions\": %d, "
+                "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"min_ns\": %.1f, \"gbps\": %.4f}",
+                i ? "," : "", r.Name.c_str(), r.Isa.c_str(), r.Bytes, r.Offset,
+                r.OriginalCount, r.RecoveryCount, r.Samples, r.Repetitions,
+                r.MedianNsec, r.P99Nsec, r.MinNsec, GetGBps(r));
+        }
+
+        printf("\n  ]\n}\n");
+    }
+
+private:
+    const BenchOptions& Options;
+    std::vector<BenchResult> Results;
+
+    CrossoverResult Crossover;
+    bool HasCrossover = false;
+};
+
+
+//-----------------------------------------------------------------------------
+// Buffers
+
+// Buffer aligned to a cache line, with room to offset into it
+class BenchBuffer
+{
+public:
+    explicit BenchBuffer(size_t bytes)
+        : Storage(bytes + 128)
+    {
+        uintptr_t p = reinterpret_cast<uintptr_t>(Storage.data());
+        Aligned = reinterpret_cast<uint8_t*>((p + 63) & ~(uintptr_t)63);
+
+        // Nonzero data so nothing takes a shortcut
+        uint32_t x = 0x2545f491u;
+        for (size_t i = 0; i < bytes + 64; ++i)
+        {
+            x = x * 1664525u + 1013904223u;
+            Aligned[i] = static_cast<uint8_t>(x >> 24);
+        }
+    }
+
+    uint8_t* Get(int offset = 0)
+    {
+        return Aligned + offset;
+    }
+
+private:
+    std::vector<uint8_t> Storage;
+    uint8_t* Aligned;
+};
+
+
+//-----------------------------------------------------------------------------
+// Instruction Sets
+
+static std::vector<const gf256_kernels*> GetSupportedKernels()
+{
+    const gf256_cpu_features features = gf256_get_cpu_features();
+
+    std::vector<const gf256_kernels*> supported;
+    supported.push_back(gf256_kernels_scalar());
+
+    const gf256_kernels* candidates[] = {
+        features.SSSE3 ? gf256_kernels_ssse3() : nullptr,
+        features.AVX2 ? gf256_kernels_avx2() : nullptr,
+        features.AVX512BW ? gf256_kernels_avx512() : nullptr,
+        features.GFNI ? gf256_kernels_gfni() : nullptr,
+        features.Neon ? gf256_kernels_neon() : nullptr,
+        features.SVE2 ? gf256_kernels_sve2() : nullptr,
+    };
+    for (const gf256_kernels* kernels : candidates)
+    {
+        // Null when the kernels were not built for this target
+        if (kernels)
+        {
+            supported.push_back(kernels);
+        }
+    }
+
+    return supported;
+}
+
+
+//-----------------------------------------------------------------------------
+// Kernel Benchmarks
+
+static void BenchKernels(const BenchOptions& options, BenchReport& report, bool quick)
+{
+    static const int kSizes[] = { 64, 512, 4096, 32768, 262144, 2097152 };
+    static const int kOffsets[] = { 0, 1, 16 };
+    static const char* kNames[] = { "add_mem", "mul_mem", "muladd_mem" };
+
+    const int sizeCount = quick ? 3 : (int)(sizeof(kSizes) / sizeof(kSizes[0]));
+    const int offsetCount = quick ? 2 : (int)(sizeof(kOffsets) / sizeof(kOffsets[0]));
+
+    BenchBuffer x(kSizes[sizeCount - 1]), z(kSizes[sizeCount - 1]);
+    const uint8_t y = 0x8e;
+
+    for (const gf256_kernels* kernels : GetSupportedKernels())
+    {
+        for (int op = 0; op < 3; ++op)
+        {
+            if (!report.Wanted(kNames[op], kernels->Name))
+            {
+                continue;
+            }
+
+            for (int s = 0; s < sizeCount; ++s)
+            {
+                for (int o = 0; o < offsetCount; ++o)
+                {
+                    const int bytes = kSizes[s];
+                    uint8_t* zp = z.Get(kOffsets[o]);
+                    const uint8_t* xp = x.Get(kOffsets[o]);
+
+                    BenchResult result;
+                    result.Name = kNames[op];
+                    result.Isa = kernels->Name;
+                    result.Bytes = bytes;
+                    result.Offset = kOffsets[o];
+                    result.ProcessedBytes = bytes;
+
+                    switch (op)
+                    {
+                    case 0: Measure([&]() { kernels->AddMem(zp, xp, bytes); }, options, result); break;
+                    case 1: Measure([&]() { kernels->MulMem(zp, xp, y, bytes); }, options, result); break;
+                    default: Measure([&]() { kernels->MulAddMem(zp, y, xp, bytes); }, options, result); break;
+                    }
+
+                    report.Add(result);
+                }
+            }
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Codec Benchmarks
+
+// Resets 'blocks' to the originals with as many of them as there are
+// recovery blocks replaced by recovery data
+static void LoseOriginals(cm256_encoder_params params, const cm256_block* originals,
+                          uint8_t* recoveryData, cm256_block* blocks)
+{
+    const int lost = std::min(params.OriginalCount, params.RecoveryCount);
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i] = originals[i];
+    }
+    for (int i = 0; i < lost; ++i)
+    {
+        blocks[i].Block = recoveryData + (size_t)i * params.BlockBytes;
+        blocks[i].Index = cm256_get_recovery_block_index(params, i);
+    }
+}
+
+static bool BenchCodec(const BenchOptions& options, BenchReport& report, bool quick)
+{
+    static const int kShapes[][2] = { { 10, 4 }, { 32, 8 }, { 100, 30 }, { 200, 56 } };
+    // Small blocks with many originals are bound by the scalar matrix math and
+    // its table lookups rather than by the bulk kernels
+    static const int kBlockBytes[] = { 64, 1296, 4096, 65536 };
+
+    const int shapeCount = quick ? 2 : (int)(sizeof(kShapes) / sizeof(kShapes[0]));
+    const int blockCount = quick ? 2 : (int)(sizeof(kBlockBytes) / sizeof(kBlockBytes[0]));
+
+    bool success = true;
+
+    for (const gf256_kernels* kernels : GetSupportedKernels())
+    {
+        const bool wantEncode = report.Wanted("encode", kernels->Name);
+        const bool wantDecode = report.Wanted("decode", kernels->Name);
+        if (!wantEncode && !wantDecode)
+        {
+            continue;
+        }
+
+        gf256_set_kernels(kernels);
+
+        for (int s = 0; s < shapeCount; ++s)
+        {
+            for (int b = 0; b < blockCount; ++b)
+            {
+                cm256_encoder_params params;
+                params.OriginalCount = kShapes[s][0];
+                params.RecoveryCount = kShapes[s][1];
+                params.BlockBytes = kBlockBytes[b];
+
+                const int k = params.OriginalCount;
+                const int m = params.RecoveryCount;
+                BenchBuffer originalData((size_t)k * params.BlockBytes);
+                BenchBuffer recoveryData((size_t)m * params.BlockBytes);
+
+                cm256_block originals[256], blocks[256];
+                for (int i = 0; i < k; ++i)
+                {
+                    originals[i].Block = originalData.Get() + (size_t)i * params.BlockBytes;
+                    originals[i].Index = cm256_get_original_block_index(params, i);
+                }
+
+                BenchResult result;
+                result.Isa = kernels->Name;
+                result.Bytes = params.BlockBytes;
+                result.OriginalCount = k;
+                result.RecoveryCount = m;
+                result.ProcessedBytes = (double)k * params.BlockBytes;
+
+                int status = 0;
+
+                if (wantEncode)
+                {
+                    result.Name = "encode";
+                    Measure([&]() {
+                        status |= cm256_encode(params, originals, recoveryData.Get());
+                    }, options, result);
+                    report.Add(result);
+                }
+
+                if (!wantDecode)
+                {
+                    success = success && status == 0;
+                    continue;
+                }
+
+                // Lose as many originals as there are recovery blocks.  The
+                // decoder works the same whatever the data is, so decoding
+                // over its own output each time only costs resetting the
+                // blocks.
+                result.Name = "decode";
+                Measure([&]() {
+                    LoseOriginals(params, originals, recoveryData.Get(), blocks);
+                    status |= cm256_decode(params, blocks);
+                }, options, result);
+                report.Add(result);
+
+                success = success && status == 0;
+            }
+        }
+    }
+
+    gf256_set_kernels(nullptr);
+    return success;
+}
+
+
+//-----------------------------------------------------------------------------
+// Codec Variant Benchmarks
+
+/*
+    FFT mode and XOR bitmatrix mode do their own bulk work through the
+    kernels that cm256_init() picked, and the GF(65536) codec has kernels of
+    its own, so these run once on the default instruction set.
+*/
+
+static bool BenchCodecVariants(const BenchOptions& options, BenchReport& report, bool quick)
+{
+    // NextPow2(m) + k <= 256 for FFT mode
+    static const int kShapes[][2] = { { 10, 4 }, { 32, 8 }, { 100, 30 }, { 128, 64 } };
+    // Multiples of 8 for XOR bitmatrix mode
+    static const int kBlockBytes[] = { 1296, 65536 };
+
+    const int shapeCount = quick ? 2 : (int)(sizeof(kShapes) / sizeof(kShapes[0]));
+    const int blockCount = quick ? 1 : (int)(sizeof(kBlockBytes) / sizeof(kBlockBytes[0]));
+    const char* isa = gf256_kernels_name();
+
+    int status = 0;
+
+    for (int s = 0; s < shapeCount; ++s)
+    {
+        for (int b = 0; b < blockCount; ++b)
+        {
+            cm256_encoder_params params;
+            params.OriginalCount = kShapes[s][0];
+            params.RecoveryCount = kShapes[s][1];
+            params.BlockBytes = kBlockBytes[b];
+
+            const int k = params.OriginalCount;
+            const int m = params.RecoveryCount;
+            BenchBuffer originalData((size_t)k * params.BlockBytes);
+            BenchBuffer recoveryData((size_t)m * params.BlockBytes);
+
+            cm256_block originals[256], blocks[256];
+            for (int i = 0; i < k; ++i)
+            {
+                originals[i].Block = originalData.Get() + (size_t)i * params.BlockBytes;
+                originals[i].Index = cm256_get_original_block_index(params, i);
+            }
+
+            BenchResult result;
+            result.Isa = isa;
+            result.Bytes = params.BlockBytes;
+            result.OriginalCount = k;
+            result.RecoveryCount = m;
+            result.ProcessedBytes = (double)k * params.BlockBytes;
+
+            if (report.Wanted("fft_encode", isa) || report.Wanted("fft_decode", isa))
+            {
+                result.Name = "fft_encode";
+                Measure([&]() {
+                    status |= cm256_fft_encode(params, originals, recoveryData.Get());
+                }, options, result);
+                report.Add(result);
+
+                result.Name = "fft_decode";
+                Measure([&]() {
+                    LoseOriginals(params, originals, recoveryData.Get(), blocks);
+                    status |= cm256_fft_decode(params, blocks);
+                }, options, result);
+                report.Add(result);
+            }
+
+            if (report.Wanted("xor_encode", isa) || report.Wanted("xor_decode", isa))
+            {
+                cm256_xor_codec* codec = cm256_xor_codec_create(params, 4);
+                if (!codec)
+                {
+                    return false;
+                }
+
+                result.Name = "xor_encode";
+                Measure([&]() {
+                    status |= cm256_xor_encode(codec, originals, recoveryData.Get());
+                }, options, result);
+                report.Add(result);
+
+                // One loss pattern, so the decode schedule comes from the cache
+                result.Name = "xor_decode";
+                Measure([&]() {
+                    LoseOriginals(params, originals, recoveryData.Get(), blocks);
+                    status |= cm256_xor_decode(codec, blocks);
+                }, options, result);
+                report.Add(result);
+
+                cm256_xor_codec_destroy(codec);
+            }
+        }
+    }
+
+    // Codes past 256 blocks, and one that cm256 could also run for comparison
+    static const int kWideShapes[][2] = { { 100, 30 }, { 300, 50 } };
+    static const int kWideBlockBytes = 4096;
+
+    if (report.Wanted("cm65536_encode", isa) || report.Wanted("cm65536_decode", isa))
+    {
+        for (const auto& shape : kWideShapes)
+        {
+            cm65536_encoder_params params;
+            params.OriginalCount = shape[0];
+            params.RecoveryCount = shape[1];
+            params.BlockBytes = kWideBlockBytes;
+
+            const int k = params.OriginalCount;
+            const int m = params.RecoveryCount;
+            BenchBuffer originalData((size_t)k * params.BlockBytes);
+            BenchBuffer recoveryData((size_t)m * params.BlockBytes);
+
+            std::vector<cm65536_block> originals(k), blocks(k);
+            for (int i = 0; i < k; ++i)
+            {
+                originals[i].Block = originalData.Get() + (size_t)i * params.BlockBytes;
+                originals[i].Index = cm65536_get_original_block_index(params, i);
+            }
+
+            BenchResult result;
+            result.Isa = isa;
+            result.Bytes = params.BlockBytes;
+            result.OriginalCount = k;
+            result.RecoveryCount = m;
+            result.ProcessedBytes = (double)k * params.BlockBytes;
+
+            result.Name = "cm65536_encode";
+            Measure([&]() {
+                status |= cm65536_encode(params, &originals[0], recoveryData.Get());
+            }, options, result);
+            report.Add(result);
+
+            result.Name = "cm65536_decode";
+            Measure([&]() {
+                blocks = originals;
+                for (int i = 0; i < m; ++i)
+                {
+                    blocks[i].Block = recoveryData.Get() + (size_t)i * params.BlockBytes;
+                    blocks[i].Index = cm65536_get_recovery_block_index(params, i);
+                }
+                status |= cm65536_decode(params, &blocks[0]);
+            }, options, result);
+            report.Add(result);
+        }
+    }
+
+    return status == 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Large-Block Mode
+
+/*
+    Times encode and decode with large-block mode off and forced on, over
+    totals of all blocks from well inside the last-level cache to well past
+    it.  The mode is off by default, and is only worth turning on with
+    cm256_set_large_block_threshold() from the size where the large cases
+    start to win on the host.
+*/
+
+static bool BenchLargeBlocks(const BenchOptions& options, BenchReport& report, bool quick)
+{
+    static const int kOriginalCount = 32;
+    static const int kRecoveryCount = 8;
+    // 40 blocks of these add up to 2.5 MiB through 320 MiB
+    static const int kBlockBytes[] = { 65536, 262144, 1048576, 4194304, 8388608 };
+
+    const int blockCount = quick ? 3 : (int)(sizeof(kBlockBytes) / sizeof(kBlockBytes[0]));
+    const char* isa = gf256_kernels_name();
+
+    int status = 0;
+
+    for (int b = 0; b < blockCount; ++b)
+    {
+        cm256_encoder_params params;
+        params.OriginalCount = kOriginalCount;
+        params.RecoveryCount = kRecoveryCount;
+        params.BlockBytes = kBlockBytes[b];
+
+        const int k = params.OriginalCount;
+        const int m = params.RecoveryCount;
+        BenchBuffer originalData((size_t)k * params.BlockBytes);
+        BenchBuffer recoveryData((size_t)m * params.BlockBytes);
+
+        cm256_block originals[256], blocks[256];
+        for (int i = 0; i < k; ++i)
+        {
+            originals[i].Block = originalData.Get() + (size_t)i * params.BlockBytes;
+            originals[i].Index = cm256_get_original_block_index(params, i);
+        }
+
+        for (int large = 0; large < 2; ++large)
+        {
+            BenchResult result;
+            result.Isa = isa;
+            result.Bytes = params.BlockBytes;
+            result.OriginalCount = k;
+            result.RecoveryCount = m;
+            result.ProcessedBytes = (double)k * params.BlockBytes;
+
+            cm256_set_large_block_threshold(large ? 0 : -1);
+
+            result.Name = large ? "encode_large" : "encode_cached";
+            if (report.Wanted(result.Name, isa))
+            {
+                Measure([&]() {
+                    status |= cm256_encode(params, originals, recoveryData.Get());
+                }, options, result);
+                report.Add(result);
+            }
+
+            result.Name = large ? "decode_large" : "decode_cached";
+            if (report.Wanted(result.Name, isa))
+            {
+                Measure([&]() {
+                    LoseOriginals(params, originals, recoveryData.Get(), blocks);
+                    status |= cm256_decode(params, blocks);
+                }, options, result);
+                report.Add(result);
+            }
+        }
+    }
+
+    cm256_set_large_block_threshold(-1);
+    return status == 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Batches
+
+/*
+    Times a batch of small stripes whose originals add up to well past the
+    last-level cache, so each stripe's originals come from memory.
+    encode_batch is cm256_encoder_encode_batch() on the calling thread, and
+    encode_each is one cm256_encoder_encode() call per stripe.  The gap
+    between the two is what the batch gains from running ahead to the next
+    stripe's originals.
+*/
+
+static bool BenchBatches(const BenchOptions& options, BenchReport& report, bool quick)
+{
+    static const int kShapes[][3] = { { 10, 4, 1296 }, { 32, 8, 4096 } };
+    const size_t totalBytes = (size_t)(quick ? 16 : 256) << 20;
+    const char* isa = gf256_kernels_name();
+
+    int status = 0;
+
+    for (const auto& shape : kShapes)
+    {
+        cm256_encoder_params params;
+        params.OriginalCount = shape[0];
+        params.RecoveryCount = shape[1];
+        params.BlockBytes = shape[2];
+
+        const int k = params.OriginalCount;
+        const size_t originalBytes = (size_t)k * params.BlockBytes;
+        const size_t recoveryBytes = (size_t)params.RecoveryCount * params.BlockBytes;
+        const int stripeCount = (int)(totalBytes / originalBytes);
+
+        BenchBuffer originalData(originalBytes * stripeCount);
+        BenchBuffer recoveryData(recoveryBytes * stripeCount);
+
+        // Blocks are scattered over the buffer, as they would be coming from
+        // separate I/O requests, so the hardware prefetcher cannot run ahead
+        std::vector<int> slots((size_t)k * stripeCount);
+        uint32_t seed = 0x2545f491u;
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            slots[i] = (int)i;
+        }
+        for (size_t i = slots.size() - 1; i > 0; --i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(slots[i], slots[seed % (i + 1)]);
+        }
+
+        std::vector<cm256_block> originals((size_t)k * stripeCount);
+        std::vector<cm256_encode_stripe> stripes(stripeCount);
+        for (int s = 0; s < stripeCount; ++s)
+        {
+            for (int i = 0; i < k; ++i)
+            {
+                cm256_block& block = originals[(size_t)s * k + i];
+                block.Block = originalData.Get() + (size_t)slots[(size_t)s * k + i] * params.BlockBytes;
+                block.Index = cm256_get_original_block_index(params, i);
+            }
+            stripes[s].Originals = &originals[(size_t)s * k];
+            stripes[s].RecoveryBlocks = recoveryData.Get() + recoveryBytes * s;
+        }
+
+        cm256_encoder* encoder = cm256_encoder_create(params);
+        if (!encoder)
+        {
+            return false;
+        }
+
+        BenchResult result;
+        result.Isa = isa;
+        result.Bytes = params.BlockBytes;
+        result.OriginalCount = k;
+        result.RecoveryCount = params.RecoveryCount;
+        result.ProcessedBytes = (double)originalBytes * stripeCount;
+
+        result.Name = "encode_batch";
+        if (report.Wanted(result.Name, isa))
+        {
+            Measure([&]() {
+                status |= cm256_encoder_encode_batch(encoder, &stripes[0], stripeCount, nullptr);
+            }, options, result);
+            report.Add(result);
+        }
+
+        result.Name = "encode_each";
+        if (report.Wanted(result.Name, isa))
+        {
+            Measure([&]() {
+                for (int s = 0; s < stripeCount; ++s)
+                {
+                    status |= cm256_encoder_encode(encoder, stripes[s].Originals, stripes[s].RecoveryBlocks);
+                }
+            }, options, result);
+            report.Add(result);
+        }
+
+        cm256_encoder_destroy(encoder);
+    }
+
+    return status == 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// FFT Crossover
+
+/*
+    Times a full encode and decode with each codec at a 2:1 code rate, from
+    k = 8 up to k = 128, the largest that FFT mode supports at this rate.
+    The same cost model as cm256_fft_preferred() is then evaluated for a
+    range of crossover percents to find the ones that agree with the most
+    measurements.
+
+    With 4 KB blocks on a CPU with AVX-512 and GFNI, the shipped value of
+    180 picked the slower codec for 0 to 2 of the 16 sizes over ten runs,
+    where 160 picked it for 1 to 3.  The sizes it gets wrong are near
+    k = 56 and k = 88, where the two codecs are within about 10% of each
+    other and the faster one changes from run to run.
+*/
+
+static const int kCrossoverBlockBytes = 4096;
+
+// Cauchy cost over FFT cost in percent, as cm256_fft_preferred() models it
+static int GetCrossoverPercent(cm256_encoder_params params)
+{
+    unsigned recoveryPow2 = 1;
+    while (recoveryPow2 < (unsigned)params.RecoveryCount)
+    {
+        recoveryPow2 *= 2;
+    }
+    unsigned n = 1, logN = 0;
+    while (n < recoveryPow2 + params.OriginalCount)
+    {
+        n *= 2;
+        ++logN;
+    }
+    return (int)((unsigned)params.OriginalCount * params.RecoveryCount * 100 / (n * logN));
+}
+
+static bool BenchFftCrossover(const BenchOptions& options, BenchReport& report, bool quick)
+{
+    const char* isa = gf256_kernels_name();
+    if (!report.Wanted("crossover", isa))
+    {
+        return true;
+    }
+
+    struct Size
+    {
+        int Percent;
+        bool FftFaster;
+        bool Preferred;
+    };
+    std::vector<Size> sizes;
+
+    int status = 0;
+
+    for (int k = 8; k <= 128; k += quick ? 24 : 8)
+    {
+        cm256_encoder_params params;
+        params.OriginalCount = k;
+        params.RecoveryCount = k / 2;
+        params.BlockBytes = kCrossoverBlockBytes;
+
+        const int m = params.RecoveryCount;
+        BenchBuffer originalData((size_t)k * params.BlockBytes);
+        BenchBuffer recoveryData((size_t)m * params.BlockBytes);
+
+        cm256_block originals[256], blocks[256];
+        for (int i = 0; i < k; ++i)
+        {
+            originals[i].Block = originalData.Get() + (size_t)i * params.BlockBytes;
+            originals[i].Index = cm256_get_original_block_index(params, i);
+        }
+
+        BenchResult cauchy;
+        cauchy.Name = "crossover_cauchy";
+        cauchy.Isa = isa;
+        cauchy.Bytes = params.BlockBytes;
+        cauchy.OriginalCount = k;
+        cauchy.RecoveryCount = m;
+        cauchy.ProcessedBytes = (double)k * params.BlockBytes;
+
+        BenchResult fft = cauchy;
+        fft.Name = "crossover_fft";
+
+        Measure([&]() {
+            status |= cm256_encode(params, originals, recoveryData.Get());
+            LoseOriginals(params, originals, recoveryData.Get(), blocks);
+            status |= cm256_decode(params, blocks);
+        }, options, cauchy);
+        report.Add(cauchy);
+
+        Measure([&]() {
+            status |= cm256_fft_encode(params, originals, recoveryData.Get());
+            LoseOriginals(params, originals, recoveryData.Get(), blocks);
+            status |= cm256_fft_decode(params, blocks);
+        }, options, fft);
+        report.Add(fft);
+
+        Size size;
+        size.Percent = GetCrossoverPercent(params);
+        size.FftFaster = fft.MedianNsec < cauchy.MedianNsec;
+        size.Preferred = cm256_fft_preferred(params) != 0;
+        sizes.push_back(size);
+    }
+
+    CrossoverResult crossover;
+    crossover.Sizes = (int)sizes.size();
+    crossover.BestMispredicted = crossover.Sizes + 1;
+
+    for (const Size& size : sizes)
+    {
+        crossover.Mispredicted += size.Preferred != size.FftFaster;
+    }
+
+    // Noise can make the count dip more than once, so keep the first range
+    bool inBestRange = false;
+    for (int percent = 50; percent <= 400; percent += 5)
+    {
+        int mispredicted = 0;
+        for (const Size& size : sizes)
+        {
+            mispredicted += (size.Percent >= percent) != size.FftFaster;
+        }
+
+        if (mispredicted < crossover.BestMispredicted)
+        {
+            crossover.BestMispredicted = mispredicted;
+            crossover.BestPercentMin = percent;
+            inBestRange = true;
+        }
+        else if (mispredicted > crossover.BestMispredicted)
+        {
+            inBestRange = false;
+        }
+
+        if (inBestRange)
+        {
+            crossover.BestPercentMax = percent;
+        }
+    }
+
+    report.SetCrossover(crossover);
+    return status == 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Entrypoint
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--json")
+        {
+            options.Json = true;
+        }
+        else if (arg == "--quick")
+        {
+            quick = true;
+            options.Samples = 21;
+            options.BudgetNsec = 50000000.;
+        }
+        else if (arg == "--samples" && i + 1 < argc)
+        {
+            options.Samples = std::max(atoi(argv[++i]), 1);
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            options.Filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: cm256_bench [--json] [--quick] [--samples N] [--filter text]\n");
+            return 1;
+        }
+    }
+
+    if (cm256_init() || cm65536_init())
+    {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+
+    BenchReport report(options);
+
+    BenchKernels(options, report, quick);
+
+    if (!BenchCodec(options, report, quick))
+    {
+        fprintf(stderr, "codec failed\n");
+        return 1;
+    }
+
+    if (!BenchCodecVariants(options, report, quick) || !BenchLargeBlocks(options, report, quick) ||
+        !BenchBatches(options, report, quick) || !BenchFftCrossover(options, report, quick))
+    {
+        fprintf(stderr, "codec failed\n");
+        return 1;
+    }
+
+    report.Finish();
+    return 0;
+}
@@ -0,0 +1,467 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_CODEC_H
+#define CM256_CODEC_H
+
+#include "cm256.h"
+#include "cm256_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+/*
+    Codec State (internal)
+
+    The decoder state and the helpers of cm256.cpp that the other codec
+    modules build on.
+*/
+
+
+//-----------------------------------------------------------------------------
+// Scratch Buffers
+
+enum ScratchSlot
+{
+    kScratchCoefficients, // Decode coefficients that do not fit on the stack
+    kScratchTile,         // Output tiles of large-block mode, parity update changes
+    kScratchSizedTails,   // Zero-padded tails of variable-length blocks
+    kScratchGather,       // Short spans gathered from scatter-gather blocks
+    kScratchSlotCount
+};
+
+// High-rate callers code many times per second, so each thread keeps its
+// scratch buffers and only grows them rather than allocating on every call
+extern uint8_t* GetThreadScratch(ScratchSlot slot, int bytes);
+
+
+//-----------------------------------------------------------------------------
+// Large-Block Mode
+
+// Returns true if a call over blockCount blocks should use large-block mode
+extern bool UseLargeBlocks(int blockCount, int blockBytes);
+
+// Bytes prefetched from the start of each block's next tile.  The hardware
+// prefetcher follows each stream once it has started, so only the start is
+// fetched in software; fetching whole tiles fills the line-fill buffers and
+// stalls the math.
+static const int kLargeBlockPrefetchBytes = 1024;
+
+// Prefetch the start of slice 'part' of 'parts' of the blocks at 'offset'
+template<typename GetBlock>
+inline void PrefetchSlice(int blockCount, int offset, int bytes, int part, int parts, GetBlock getBlock)
+{
+    if (bytes <= 0)
+    {
+        return;
+    }
+
+    bytes = std::min(bytes, kLargeBlockPrefetchBytes);
+
+    const int first = part * blockCount / parts;
+    const int last = (part + 1) * blockCount / parts;
+    for (int i = first; i < last; ++i)
+    {
+        gf256_prefetch_mem(static_cast<const uint8_t*>(getBlock(i)) + offset, bytes);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Matrix
+
+/*
+    Selected Cauchy Matrix Form
+
+    The matrix consists of elements a_ij, where i = row, j = column.
+    a_ij = 1 / (x_i - y_j), where x_i and y_j are sets of GF(256) values
+    that do not intersect.
+
+    We select x_i and y_j to just be incrementing numbers for the
+    purposes of this library.  Further optimizations may yield matrices
+    with more 1 elements, but the benefit seems relatively small.
+
+    The x_i values range from 0...(originalCount - 1).
+    The y_j values range from originalCount...(originalCount + recoveryCount - 1).
+
+    We then improve the Cauchy matrix by dividing each column by the
+    first row element of that column.  The result is an invertible
+    matrix that has all 1 elements in the first row.  This is equivalent
+    to a rotated Vandermonde matrix, so we could have used one of those.
+
+    The advantage of doing this is that operations involving the first
+    row will be extremely fast (just memory XOR), so the decoder can
+    be optimized to take advantage of the shortcut when the first
+    recovery row can be used.
+
+    First row element of Cauchy matrix for each column:
+    a_0j = 1 / (x_0 - y_j) = 1 / (x_0 - y_j)
+
+    Our Cauchy matrix sets first row to ones, so:
+    a_ij = (1 / (x_i - y_j)) / a_0j
+    a_ij = (y_j - x_0) / (x_i - y_j)
+    a_ij = (y_j + x_0) div (x_i + y_j) in GF(256)
+*/
+
+// This function generates each matrix element based on x_i, x_0, y_j
+// Note that for x_i == x_0, this will return 1, so it is better to unroll out the first row.
+static GF256_FORCE_INLINE unsigned char GetMatrixElement(unsigned char x_i, unsigned char x_0, unsigned char y_j)
+{
+    return gf256_div(gf256_add(y_j, x_0), gf256_add(x_i, y_j));
+}
+
+
+//-----------------------------------------------------------------------------
+// Scatter-Gather Blocks
+
+/*
+    A scatter-gather block is read as its segments end-to-end.  The kernels
+    are handed runs of the byte range over which every block being read is
+    contiguous, so most of the data is read where it lies.
+
+    Segment boundaries in different blocks would cut the runs short where
+    they fall close together, as with headers of different lengths.  A block
+    that is contiguous for less than kSgGatherBytes past the current offset
+    has just that span gathered into scratch instead, so apart from the end
+    of the range no run is shorter than that.
+*/
+
+// Shortest run handed to the kernels, apart from the end of the range
+static const int kSgGatherBytes = 256;
+
+// Returns 0 if the segments of the block add up to blockBytes
+extern int ValidateSgBlock(const cm256_sg_block& block, int blockBytes);
+
+// Copy a whole scatter-gather block to one buffer
+extern void GatherSgBlock(const cm256_sg_block& block, int blockBytes, void* dest);
+
+// Position in the segments of one block, which only moves forward
+struct SgCursor
+{
+    const cm256_iovec* Segment;
+    int SegmentOffset; // Offset of Segment into the block
+
+    void Reset(const cm256_sg_block& block)
+    {
+        Segment = block.Segments;
+        SegmentOffset = 0;
+    }
+
+    // Move to the segment holding 'offset', which must be inside the block
+    void Seek(int offset)
+    {
+        while (offset >= SegmentOffset + Segment->Bytes)
+        {
+            SegmentOffset += Segment->Bytes;
+            ++Segment;
+        }
+    }
+
+    // After Seek(offset): the data at 'offset'
+    const uint8_t* At(int offset) const
+    {
+        return static_cast<const uint8_t*>(Segment->Base) + (offset - SegmentOffset);
+    }
+
+    // After Seek(offset): the number of bytes contiguous from 'offset'
+    int Contiguous(int offset) const
+    {
+        return SegmentOffset + Segment->Bytes - offset;
+    }
+
+    // After Seek(offset): copy [offset, offset + bytes) across segments
+    void Gather(int offset, int bytes, uint8_t* dest) const
+    {
+        const cm256_iovec* segment = Segment;
+        int skip = offset - SegmentOffset;
+        for (; bytes > 0; ++segment, skip = 0)
+        {
+            const int copyBytes = std::min(bytes, segment->Bytes - skip);
+            if (copyBytes > 0)
+            {
+                memcpy(dest, static_cast<const uint8_t*>(segment->Base) + skip, copyBytes);
+                dest += copyBytes;
+                bytes -= copyBytes;
+            }
+        }
+    }
+};
+
+// Cursors over several blocks that are read in step
+struct SgRuns
+{
+    SgCursor Cursors[256];
+    int Count;
+
+    // Gathered spans, kSgGatherBytes per block
+    uint8_t* Staging;
+
+    void Reset(const cm256_sg_block* const* blocks, int count)
+    {
+        Count = count;
+        for (int i = 0; i < count; ++i)
+        {
+            Cursors[i].Reset(*blocks[i]);
+        }
+        Staging = GetThreadScratch(kScratchGather, count * kSgGatherBytes);
+    }
+
+    // Returns the length of the run at 'offset', at most maxBytes, and sets
+    // data[i] to the run in block i.  The data stays valid until the next
+    // call, and offsets must not go backwards.
+    int Next(int offset, int maxBytes, const void** data)
+    {
+        int bytes = maxBytes;
+        bool gather = false;
+        for (int i = 0; i < Count; ++i)
+        {
+            Cursors[i].Seek(offset);
+            const int contiguous = Cursors[i].Contiguous(offset);
+            if (contiguous >= kSgGatherBytes)
+            {
+                bytes = std::min(bytes, contiguous);
+            }
+            else if (contiguous < maxBytes)
+            {
+                gather = true;
+            }
+        }
+        if (gather)
+        {
+            bytes = std::min(bytes, kSgGatherBytes);
+        }
+
+        for (int i = 0; i < Count; ++i)
+        {
+            if (Cursors[i].Contiguous(offset) >= bytes)
+            {
+                data[i] = Cursors[i].At(offset);
+            }
+            else
+            {
+                uint8_t* staging = Staging + i * kSgGatherBytes;
+                Cursors[i].Gather(offset, bytes, staging);
+                data[i] = staging;
+            }
+        }
+        return bytes;
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+// Encoding
+
+// Encode the byte range [offset, offset + bytes) of one recovery block
+extern void EncodeBlockRange(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    uint8_t* recoveryBlock,      // Output recovery block (start of the range)
+    int offset,                  // Offset of the range into each original block
+    int bytes,                   // Number of bytes in the range
+    const gf256_mul_tables* rowTables); // Precomputed row of the matrix, or null
+
+// Returns the number of bytes to encode at a time for each block
+extern int GetEncodeTileBytes(const cm256_encoder_params& params);
+
+// Returns the number of stripes to split each block into for the pool
+extern int GetStripeCount(int blockBytes, cm256_pool* pool);
+
+// Returns the stripe size for splitting each block into stripeCount stripes
+extern int GetStripeBytes(int blockBytes, int stripeCount);
+
+// Returns the number of stripes in each task of a batch, at least 1
+extern int GetBatchTaskStripes(
+    cm256_encoder_params params,
+    int stripeCount,
+    cm256_pool* pool);
+
+
+//-----------------------------------------------------------------------------
+// Encoder Handle
+
+struct cm256_encoder_t
+{
+    cm256_encoder_params Params;
+
+    // (RecoveryCount - 1) rows of OriginalCount tables, or null
+    gf256_mul_tables* Tables;
+};
+
+
+//-----------------------------------------------------------------------------
+// Decoding
+
+struct CM256Decoder
+{
+    // Encode parameters
+    cm256_encoder_params Params;
+
+    // Recovery blocks
+    cm256_block* Recovery[256];
+    int RecoveryCount;
+
+    // Original blocks
+    cm256_block* Original[256];
+    int OriginalCount;
+
+    // Row indices that were erased
+    uint8_t ErasuresIndices[256];
+
+    // Elimination coefficients for m>1, filled in by Decode()
+    const uint8_t* OriginalMatrix; // N x OriginalCount, row-major
+    const uint8_t* RowsL;          // Row i of L holds i elements
+    const uint8_t* DiagD;          // N diagonal elements
+    const uint8_t* RowsU;          // Row i of U holds N-1-i elements
+
+    // Set when the originals were already eliminated from the recovery
+    // blocks, so only the NxN solve remains
+    bool OriginalsEliminated;
+
+    // CRCs of the originals by index, continued over each tile, or null
+    uint32_t* Crcs;
+
+    // Indexed by original block index: where each erased original is written,
+    // leaving the recovery blocks untouched.  Null to decode in place.
+    void* const* Outputs;
+
+    // Matrix points the data was encoded with, or null for the defaults
+    const cm256_matrix_points* Points;
+
+    // Points of the matrix rows and columns for the received blocks
+    uint8_t GetX0() const
+    {
+        return Points ? Points->X[0] : static_cast<uint8_t>(Params.OriginalCount);
+    }
+    uint8_t GetRecoveryX(int i) const
+    {
+        const uint8_t index = Recovery[i]->Index;
+        return Points ? Points->X[index - Params.OriginalCount] : index;
+    }
+    uint8_t GetOriginalY(uint8_t originalIndex) const
+    {
+        return Points ? Points->Y[originalIndex] : originalIndex;
+    }
+    uint8_t GetRowScale(int i) const
+    {
+        return Points ? Points->RowScale[Recovery[i]->Index - Params.OriginalCount] : 1;
+    }
+
+    // Returns the block that recovery row i is decoded into
+    uint8_t* GetOutput(int i) const
+    {
+        return static_cast<uint8_t*>(Outputs ? Outputs[ErasuresIndices[i]] : Recovery[i]->Block);
+    }
+
+    // Continue the CRCs over a tile at 'offset', where 'decoded' holds the
+    // tile of each erased original
+    void UpdateTileCrcs(int offset, int bytes, const void* const* decoded) const
+    {
+        for (int j = 0; j < OriginalCount; ++j)
+        {
+            uint32_t& crc = Crcs[Original[j]->Index];
+            crc = cm256_crc32c(crc, static_cast<const uint8_t*>(Original[j]->Block) + offset, bytes);
+        }
+        for (int i = 0; i < RecoveryCount; ++i)
+        {
+            uint32_t& crc = Crcs[ErasuresIndices[i]];
+            crc = cm256_crc32c(crc, decoded[i], bytes);
+        }
+    }
+
+    // Prefetch slice 'part' of 'parts' of the received blocks for the next tile
+    void PrefetchTile(int offset, int bytes, int part, int parts) const
+    {
+        PrefetchSlice(OriginalCount + RecoveryCount, offset, bytes, part, parts, [this](int i) {
+            return i < OriginalCount ? Original[i]->Block : Recovery[i - OriginalCount]->Block;
+        });
+    }
+
+    // Initialize the decoder
+    bool Initialize(cm256_encoder_params& params, cm256_block* blocks);
+
+    // Decode m=1 case
+    void DecodeM1(cm256_pool* pool);
+
+    // Decode m=1 case for the byte range [offset, offset + bytes).
+    // With a scratch tile the output is built there and then streamed out,
+    // and the next 'nextBytes' of the blocks are prefetched.
+    void DecodeM1Range(int offset, int bytes, uint8_t* scratchTile, int nextBytes);
+
+    // Decode for m>1 case
+    void Decode(cm256_pool* pool);
+
+    // Bytes of scratch and coefficients needed by ComputeCoefficients()
+    int GetCoefficientBytes() const;
+
+    // Fill in the m>1 elimination coefficients, stored in 'matrix'
+    void ComputeCoefficients(uint8_t* matrix);
+
+    // Run the m>1 elimination with the coefficients from ComputeCoefficients()
+    void Eliminate(cm256_pool* pool);
+
+    // Run the m>1 elimination passes over the byte range [offset, offset + bytes),
+    // using a scratch tile of RecoveryCount * bytes like DecodeM1Range()
+    void EliminateRange(int offset, int bytes, uint8_t* scratchTile, int nextBytes);
+
+    // Run DecodeM1Range() or EliminateRange() over the whole block,
+    // in tiles and in stripes on the pool
+    void RunStripes(cm256_pool* pool, bool m1);
+
+    // Generate the LU decomposition of the matrix
+    void GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D, uint8_t* matrix_U);
+};
+
+
+//-----------------------------------------------------------------------------
+// Partial Decode
+
+// Computes the products over the recovery rows shared by every inverse row
+extern void GetPartialDecodeProducts(const CM256Decoder& state, uint8_t* P, uint8_t* Dx);
+
+// Computes the k source coefficients that produce erased original t.
+// Sources are the originals in Original[] order followed by Recovery[].
+// P[i] = prod_s (x_i + y_s) and Dx[i] = prod_{s != i} (x_i + x_s).
+extern void GetPartialDecodeRow(
+    const CM256Decoder& state,
+    const uint8_t* P,
+    const uint8_t* Dx,
+    int t,
+    uint8_t* coefficients);
+
+// Decode the wanted erased originals.  With sgBlocks the data is read from
+// there, and 'blocks' only gives the index of each one.
+extern int DecodePartial(
+    cm256_encoder_params params,
+    const cm256_block* blocks,
+    const cm256_sg_block* sgBlocks,
+    void* const* outputs,
+    cm256_pool* pool);
+
+#endif // CM256_CODEC_H
@@ -0,0 +1,191 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256_crc32c.h"
+#include "gf256_kernels.h"
+
+#include <mutex>
+
+
+/*
+    Portable CRC32C
+
+    Slicing-by-8: table k holds the register change from a byte followed by
+    k zero bytes, so eight bytes are folded in with eight independent table
+    lookups instead of a chain of eight.
+*/
+
+static uint32_t Crc32cTables[8][256];
+
+static void InitializeCrc32cTables()
+{
+    for (unsigned n = 0; n < 256; ++n)
+    {
+        uint32_t crc = n;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc >> 1) ^ (kCrc32cPolynomial & (0U - (crc & 1)));
+        }
+        Crc32cTables[0][n] = crc;
+    }
+    for (unsigned n = 0; n < 256; ++n)
+    {
+        uint32_t crc = Crc32cTables[0][n];
+        for (int k = 1; k < 8; ++k)
+        {
+            crc = Crc32cTables[0][crc & 0xff] ^ (crc >> 8);
+            Crc32cTables[k][n] = crc;
+        }
+    }
+}
+
+static uint32_t Crc32cPortable(uint32_t crc, const uint8_t* data, int bytes)
+{
+    for (; bytes >= 8; bytes -= 8, data += 8)
+    {
+        // Read little-endian so this also works on big-endian hosts
+        const uint32_t lo = crc ^ (data[0] | ((uint32_t)data[1] << 8) |
+            ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+        crc = Crc32cTables[7][lo & 0xff] ^
+              Crc32cTables[6][(lo >> 8) & 0xff] ^
+              Crc32cTables[5][(lo >> 16) & 0xff] ^
+              Crc32cTables[4][lo >> 24] ^
+              Crc32cTables[3][data[4]] ^
+              Crc32cTables[2][data[5]] ^
+              Crc32cTables[1][data[6]] ^
+              Crc32cTables[0][data[7]];
+    }
+    for (; bytes > 0; --bytes, ++data)
+    {
+        crc = Crc32cTables[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+
+//------------------------------------------------------------------------------
+// Lane Shift Tables
+
+/*
+    Running the register through n zero bytes is a linear map, a 32x32 bit
+    matrix over GF(2).  The matrix for one zero bit is squared up to one
+    zero byte and then to the lane length, and applied to each byte value
+    of each byte of the register to fill in the tables the SSE4.2 kernel
+    uses to combine its lanes.
+*/
+
+cm256_crc32c_shifts Crc32cShifts;
+
+// Multiply the 32x32 bit matrix 'mat' by 'vec' over GF(2)
+static uint32_t MatrixTimes(const uint32_t* mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    for (; vec; vec >>= 1, ++mat)
+    {
+        if (vec & 1)
+        {
+            sum ^= *mat;
+        }
+    }
+    return sum;
+}
+
+static void MatrixSquare(uint32_t* square, const uint32_t* mat)
+{
+    for (int n = 0; n < 32; ++n)
+    {
+        square[n] = MatrixTimes(mat, mat[n]);
+    }
+}
+
+// Fill in the tables for running through 'bytes' zero bytes, a power of two
+static void InitializeShift(uint32_t shift[4][256], int bytes)
+{
+    // Operator for one zero bit, then squared up to one zero byte
+    uint32_t op[32], square[32];
+    op[0] = kCrc32cPolynomial;
+    for (int n = 1; n < 32; ++n)
+    {
+        op[n] = 1U << (n - 1);
+    }
+    MatrixSquare(square, op);     // 2 bits
+    MatrixSquare(op, square);     // 4 bits
+    MatrixSquare(square, op);     // 8 bits
+    memcpy(op, square, sizeof(op));
+
+    for (; bytes > 1; bytes >>= 1)
+    {
+        MatrixSquare(square, op);
+        memcpy(op, square, sizeof(op));
+    }
+
+    for (unsigned n = 0; n < 256; ++n)
+    {
+        shift[0][n] = MatrixTimes(op, n);
+        shift[1][n] = MatrixTimes(op, n << 8);
+        shift[2][n] = MatrixTimes(op, n << 16);
+        shift[3][n] = MatrixTimes(op, n << 24);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Dispatch
+
+static std::once_flag Crc32cOnce;
+static cm256_crc32c_kernel Crc32cKernel = nullptr;
+
+// gf256_get_cpu_features() detects the CPU on first use, so this picks the
+// right kernel even when it runs before gf256_init()
+static void SelectCrc32cKernel()
+{
+    InitializeCrc32cTables();
+    Crc32cKernel = Crc32cPortable;
+
+    if (gf256_get_cpu_features().SSE42)
+    {
+        const cm256_crc32c_kernel kernel = cm256_crc32c_kernel_sse42();
+        if (kernel)
+        {
+            InitializeShift(Crc32cShifts.Long, kCrc32cLongLaneBytes);
+            InitializeShift(Crc32cShifts.Short, kCrc32cShortLaneBytes);
+            Crc32cKernel = kernel;
+        }
+    }
+}
+
+extern "C" uint32_t cm256_crc32c(uint32_t crc, const void* data, int bytes)
+{
+    std::call_once(Crc32cOnce, SelectCrc32cKernel);
+
+    if (bytes <= 0)
+    {
+        return crc;
+    }
+    return ~Crc32cKernel(~crc, static_cast<const uint8_t*>(data), bytes);
+}
@@ -0,0 +1,69 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_CRC32C_H
+#define CM256_CRC32C_H
+
+#include "cm256.h"
+
+/*
+    CRC32C Kernels (internal)
+
+    cm256_crc32c() forwards to the fastest kernel for the CPU, picked on
+    first use.  The kernels work on the CRC register itself, so they do not
+    invert it before and after the data.
+*/
+
+// Kernel: returns the register after running 'bytes' of 'data' through it
+typedef uint32_t (*cm256_crc32c_kernel)(uint32_t crc, const uint8_t* data, int bytes);
+
+// CRC32C polynomial 0x1EDC6F41, bit-reversed
+static const uint32_t kCrc32cPolynomial = 0x82f63b78;
+
+// Lane lengths of the SSE4.2 kernel; see cm256_crc32c_sse42.cpp
+static const int kCrc32cLongLaneBytes = 8192;
+static const int kCrc32cShortLaneBytes = 256;
+
+// Register change from running through each lane length of zero bytes,
+// one table for each byte of the register
+struct cm256_crc32c_shifts
+{
+    uint32_t Long[4][256];
+    uint32_t Short[4][256];
+};
+
+// Filled in by the dispatch in cm256_crc32c.cpp before a kernel that reads
+// it is selected.  It is set up there rather than with the kernel so that
+// nothing shared is compiled with the instruction set flags.
+extern cm256_crc32c_shifts Crc32cShifts;
+
+// Returns the kernel using the SSE4.2 crc32 instruction, or nullptr if it
+// was not built for this target.  Only call it if the CPU has SSE4.2.
+extern cm256_crc32c_kernel cm256_crc32c_kernel_sse42();
+
+#endif // CM256_CRC32C_H
@@ -0,0 +1,132 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256_crc32c.h"
+
+// Built with -msse4.2.  MSVC does not define __SSE4_2__ but always allows
+// the intrinsics on x86.
+#if !defined(GF256_TARGET_MOBILE) && (defined(__SSE4_2__) || defined(_MSC_VER))
+
+#include <nmmintrin.h> // SSE4.2: _mm_crc32_u64, _mm_crc32_u32
+
+/*
+    SSE4.2 CRC32C
+
+    The crc32 instruction takes about three cycles but can start one every
+    cycle, so one chain of them runs at a third of the possible rate.  Long
+    inputs are split into three lanes that run side by side, each starting
+    from a zero register.  Running a register through n zero bytes is
+    linear, so each lane result is moved past the lanes after it with a
+    precomputed table and added to the next (Mark Adler, crc32c.c).
+
+    The lanes are kCrc32cLongLaneBytes long where the input allows it and
+    kCrc32cShortLaneBytes long for the remainder, which covers the short
+    tiles of the encoder and decoder.  The shift tables are built by the
+    portable dispatch, which is compiled without -msse4.2.
+
+    The 64-bit form of the instruction only exists in 64-bit mode, so 32-bit
+    builds run each 8 bytes through two 32-bit steps, which give the same
+    register.
+*/
+
+static inline uint32_t Shift(const uint32_t shift[4][256], uint32_t crc)
+{
+    return shift[0][crc & 0xff] ^ shift[1][(crc >> 8) & 0xff] ^
+           shift[2][(crc >> 16) & 0xff] ^ shift[3][crc >> 24];
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+static inline uint32_t Crc32cStep8(uint32_t crc, const uint8_t* data)
+{
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    return static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+}
+
+#else // __x86_64__
+
+static inline uint32_t Crc32cStep8(uint32_t crc, const uint8_t* data)
+{
+    uint32_t lo, hi;
+    memcpy(&lo, data, sizeof(lo));
+    memcpy(&hi, data + 4, sizeof(hi));
+    return _mm_crc32_u32(_mm_crc32_u32(crc, lo), hi);
+}
+
+#endif // __x86_64__
+
+// Run three lanes of 'lane' bytes through the register
+static inline uint32_t Crc32cLanes(uint32_t crc0, const uint8_t* data, int lane, const uint32_t shift[4][256])
+{
+    uint32_t crc1 = 0, crc2 = 0;
+    for (int offset = 0; offset < lane; offset += 8)
+    {
+        crc0 = Crc32cStep8(crc0, data + offset);
+        crc1 = Crc32cStep8(crc1, data + lane + offset);
+        crc2 = Crc32cStep8(crc2, data + 2 * lane + offset);
+    }
+    crc0 = Shift(shift, crc0) ^ crc1;
+    return Shift(shift, crc0) ^ crc2;
+}
+
+static uint32_t Crc32cSSE42(uint32_t crc, const uint8_t* data, int bytes)
+{
+    for (; bytes >= 3 * kCrc32cLongLaneBytes; bytes -= 3 * kCrc32cLongLaneBytes, data += 3 * kCrc32cLongLaneBytes)
+    {
+        crc = Crc32cLanes(crc, data, kCrc32cLongLaneBytes, Crc32cShifts.Long);
+    }
+    for (; bytes >= 3 * kCrc32cShortLaneBytes; bytes -= 3 * kCrc32cShortLaneBytes, data += 3 * kCrc32cShortLaneBytes)
+    {
+        crc = Crc32cLanes(crc, data, kCrc32cShortLaneBytes, Crc32cShifts.Short);
+    }
+
+    for (; bytes >= 8; bytes -= 8, data += 8)
+    {
+        crc = Crc32cStep8(crc, data);
+    }
+    for (; bytes > 0; --bytes, ++data)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+
+cm256_crc32c_kernel cm256_crc32c_kernel_sse42()
+{
+    return Crc32cSSE42;
+}
+
+#else // __SSE4_2__
+
+cm256_crc32c_kernel cm256_crc32c_kernel_sse42()
+{
+    return nullptr;
+}
+
+#endif // __SSE4_2__
@@ -0,0 +1,609 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+
+#include <new>
+#include <cstring>
+
+
+/*
+    FFT Mode
+
+    The Cauchy codec costs O(k * m) multiply-adds over the data.  This mode
+    implements the additive FFT Reed-Solomon construction of Lin, Chung and
+    Han ("Novel Polynomial Basis and Its Application to Reed-Solomon Erasure
+    Codes"), following the layout of Leopard-RS, which costs O(n log n) for
+    a code of n blocks.
+
+    The field is GF(256) with polynomial 0x11D, with its elements written in
+    a Cantor basis so that the subspace vanishing polynomials the FFT is
+    built on have simple evaluations.  This is a different representation
+    than GF256Ctx uses, so the byte values of the recovery blocks differ from
+    the Cauchy codec and the two must not be mixed.
+
+    Multiplying by a constant is still a GF(2)-linear map on bytes, so the
+    bulk multiplies go through gf256_mul_tables filled in for this field and
+    run on the same SIMD kernels as the Cauchy codec.
+
+    With m = NextPow2(recoveryCount), the recovery blocks are the first
+    recoveryCount evaluations of the length-m FFT of the sum of the IFFTs of
+    each group of m originals.  Decoding evaluates an error locator
+    polynomial over all n = NextPow2(m + originalCount) positions, takes its
+    formal derivative in the transformed domain, and reads the erased
+    originals out of the result.
+*/
+
+
+//-----------------------------------------------------------------------------
+// Field Tables
+
+static const unsigned kFFTModulus = 255;
+static const unsigned kFFTPolynomial = 0x11D;
+
+// Cantor basis: each element b_i satisfies b_i^2 + b_i = b_(i-1)
+static const uint8_t kFFTCantorBasis[8] = {
+    1, 214, 152, 146, 86, 200, 88, 230
+};
+
+struct CM256FFTTables
+{
+    // Log[0] = kFFTModulus stands for zero
+    uint8_t Log[256];
+
+    // Exp[kFFTModulus] = Exp[0] handles the wrap around of AddMod()
+    uint8_t Exp[256];
+
+    // Logs of the FFT twiddle factors, where kFFTModulus means zero
+    uint8_t Skew[kFFTModulus];
+
+    // Walsh-Hadamard transform of Log[], used to evaluate the error locator
+    uint8_t LogWalsh[256];
+
+    // Multiply by Exp[log] for log = 0..254
+    gf256_mul_tables Mul[kFFTModulus];
+
+    CM256FFTTables();
+};
+
+// Returns (a + b) mod 255, where 255 is also a representation of 0
+static GF256_FORCE_INLINE unsigned FFTAddMod(unsigned a, unsigned b)
+{
+    const unsigned sum = a + b;
+    return (sum + (sum >> 8)) & 0xff;
+}
+
+// Returns (a - b) mod 255, where 255 is also a representation of 0
+static GF256_FORCE_INLINE unsigned FFTSubMod(unsigned a, unsigned b)
+{
+    const unsigned dif = a + kFFTModulus - b;
+    return (dif + (dif >> 8)) & 0xff;
+}
+
+// In-place Walsh-Hadamard transform over the logarithms, mod 255
+static void FFTWalshHadamard(uint8_t* data, unsigned m, unsigned mTruncated)
+{
+    for (unsigned width = 1; width < m; width <<= 1)
+    {
+        for (unsigned i = 0; i < mTruncated; i += width * 2)
+        {
+            for (unsigned j = i; j < i + width; ++j)
+            {
+                const unsigned a = data[j], b = data[j + width];
+                data[j] = static_cast<uint8_t>(FFTAddMod(a, b));
+                data[j + width] = static_cast<uint8_t>(FFTSubMod(a, b));
+            }
+        }
+    }
+}
+
+CM256FFTTables::CM256FFTTables()
+{
+    // Logarithms of the polynomial basis elements, from an LFSR
+    uint8_t polyLog[256];
+    unsigned state = 1;
+    for (unsigned i = 0; i < kFFTModulus; ++i)
+    {
+        polyLog[state] = static_cast<uint8_t>(i);
+        state <<= 1;
+        if (state >= 256)
+        {
+            state ^= kFFTPolynomial;
+        }
+    }
+    polyLog[0] = kFFTModulus;
+
+    // Element i in the Cantor basis is the sum of basis vectors for its bits
+    Log[0] = 0;
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        const unsigned width = 1u << i;
+        for (unsigned j = 0; j < width; ++j)
+        {
+            Log[j + width] = Log[j] ^ kFFTCantorBasis[i];
+        }
+    }
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        Log[i] = polyLog[Log[i]];
+    }
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        Exp[Log[i]] = static_cast<uint8_t>(i);
+    }
+    Exp[kFFTModulus] = Exp[0];
+
+    // Returns a * Exp[logB]
+    auto multiplyLog = [this](unsigned a, unsigned logB) -> unsigned {
+        return a == 0 ? 0 : Exp[FFTAddMod(Log[a], logB)];
+    };
+
+    // Skew factors: evaluations of the normalized subspace polynomials
+    uint8_t temp[7];
+    for (unsigned i = 1; i < 8; ++i)
+    {
+        temp[i - 1] = static_cast<uint8_t>(1u << i);
+    }
+    for (unsigned m = 0; m < 7; ++m)
+    {
+        const unsigned step = 1u << (m + 1);
+
+        Skew[(1u << m) - 1] = 0;
+
+        for (unsigned i = m; i < 7; ++i)
+        {
+            const unsigned s = 1u << (i + 1);
+            for (unsigned j = (1u << m) - 1; j < s; j += step)
+            {
+                Skew[j + s] = Skew[j] ^ temp[i];
+            }
+        }
+
+        temp[m] = static_cast<uint8_t>(kFFTModulus - Log[multiplyLog(temp[m], Log[temp[m] ^ 1])]);
+
+        for (unsigned i = m + 1; i < 7; ++i)
+        {
+            const unsigned sum = FFTAddMod(Log[temp[i] ^ 1], temp[m]);
+            temp[i] = static_cast<uint8_t>(multiplyLog(temp[i], sum));
+        }
+    }
+    for (unsigned i = 0; i < kFFTModulus; ++i)
+    {
+        Skew[i] = Log[Skew[i]];
+    }
+
+    memcpy(LogWalsh, Log, sizeof(LogWalsh));
+    LogWalsh[0] = 0;
+    FFTWalshHadamard(LogWalsh, 256, 256);
+
+    // Bulk multiply tables in the layout of gf256_mul_tables_init()
+    for (unsigned log = 0; log < kFFTModulus; ++log)
+    {
+        gf256_mul_tables& tables = Mul[log];
+
+        for (unsigned x = 0; x < 16; ++x)
+        {
+            tables.Lo[x] = static_cast<uint8_t>(multiplyLog(x, log));
+            tables.Hi[x] = static_cast<uint8_t>(multiplyLog(x << 4, log));
+        }
+
+        uint64_t matrix = 0;
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            const unsigned column = multiplyLog(1u << j, log);
+            for (unsigned i = 0; i < 8; ++i)
+            {
+                if (column & (1u << i))
+                {
+                    matrix |= (uint64_t)1 << ((7 - i) * 8 + j);
+                }
+            }
+        }
+        tables.Affine = matrix;
+
+        // Not a GF256Ctx coefficient
+        tables.Y = 0;
+    }
+}
+
+static const CM256FFTTables& GetFFTTables()
+{
+    static const CM256FFTTables tables;
+    return tables;
+}
+
+
+//-----------------------------------------------------------------------------
+// Bulk Operations
+
+// z[] = x[] * Exp[log], where log 255 is the same as log 0
+static void FFTMulMem(const CM256FFTTables& T, uint8_t* z, const uint8_t* x, unsigned log, int bytes)
+{
+    log %= kFFTModulus;
+    if (log == 0)
+    {
+        memcpy(z, x, bytes);
+        return;
+    }
+    const void* source = x;
+    gf256_mul_multi_tables_mem(z, &T.Mul[log], &source, 1, bytes);
+}
+
+// x[] += y[] * Exp[log]; y[] += x[], where log 255 means a zero twiddle
+static GF256_FORCE_INLINE void FFTButterfly(const CM256FFTTables& T, uint8_t* x, uint8_t* y, unsigned log, int bytes)
+{
+    if (log != kFFTModulus)
+    {
+        const void* source = y;
+        gf256_muladd_multi_tables_mem(x, &T.Mul[log], &source, 1, bytes);
+    }
+    gf256_add_mem(y, x, bytes);
+}
+
+// y[] += x[]; x[] += y[] * Exp[log], where log 255 means a zero twiddle
+static GF256_FORCE_INLINE void IFFTButterfly(const CM256FFTTables& T, uint8_t* x, uint8_t* y, unsigned log, int bytes)
+{
+    gf256_add_mem(y, x, bytes);
+    if (log != kFFTModulus)
+    {
+        const void* source = y;
+        gf256_muladd_multi_tables_mem(x, &T.Mul[log], &source, 1, bytes);
+    }
+}
+
+/*
+    Decimation in time over m = 2^L buffers.  Layer `dist` pairs buffer i
+    with i + dist inside each group of 2 * dist, and the whole group shares
+    the twiddle Skew[skewBase + r + dist] where r is the start of the group.
+
+    Only groups starting below mTruncated are processed: for the IFFT the
+    inputs past it are zero, and for the FFT the outputs past it are unused.
+*/
+
+static void IFFT_DIT(const CM256FFTTables& T, uint8_t** work, unsigned mTruncated, unsigned m,
+                     int skewBase, int bytes)
+{
+    for (unsigned dist = 1; dist < m; dist <<= 1)
+    {
+        for (unsigned r = 0; r < mTruncated; r += dist * 2)
+        {
+            const unsigned log = T.Skew[skewBase + r + dist];
+            for (unsigned i = r; i < r + dist; ++i)
+            {
+                IFFTButterfly(T, work[i], work[i + dist], log, bytes);
+            }
+        }
+    }
+}
+
+static void FFT_DIT(const CM256FFTTables& T, uint8_t** work, unsigned mTruncated, unsigned m,
+                    int skewBase, int bytes)
+{
+    for (unsigned dist = m >> 1; dist > 0; dist >>= 1)
+    {
+        for (unsigned r = 0; r < mTruncated; r += dist * 2)
+        {
+            const unsigned log = T.Skew[skewBase + r + dist];
+            for (unsigned i = r; i < r + dist; ++i)
+            {
+                FFTButterfly(T, work[i], work[i + dist], log, bytes);
+            }
+        }
+    }
+}
+
+static unsigned NextPow2(unsigned n)
+{
+    unsigned p = 1;
+    while (p < n)
+    {
+        p <<= 1;
+    }
+    return p;
+}
+
+static int ValidateFFTParams(cm256_encoder_params params)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (NextPow2(params.RecoveryCount) + params.OriginalCount > 256)
+    {
+        return -2;
+    }
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Encoder
+
+extern "C" int cm256_fft_encode(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    const int result = ValidateFFTParams(params);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const CM256FFTTables& T = GetFFTTables();
+    const unsigned k = params.OriginalCount;
+    const unsigned m = NextPow2(params.RecoveryCount);
+    const int bytes = params.BlockBytes;
+
+    // Work space for the sum and for the IFFT of each further group
+    const unsigned workCount = k > m ? m * 2 : m;
+    uint8_t* workData = new (std::nothrow) uint8_t[(size_t)workCount * bytes];
+    if (!workData)
+    {
+        return -4;
+    }
+    uint8_t* work[512];
+    for (unsigned i = 0; i < workCount; ++i)
+    {
+        work[i] = workData + (size_t)i * bytes;
+    }
+
+    // For each group of m originals, IFFT it with the twiddles for its
+    // position and add it into the sum
+    for (unsigned first = 0; first < k; first += m)
+    {
+        uint8_t** groupWork = first == 0 ? work : work + m;
+        const unsigned groupCount = k - first < m ? k - first : m;
+
+        for (unsigned i = 0; i < groupCount; ++i)
+        {
+            memcpy(groupWork[i], originals[first + i].Block, bytes);
+        }
+        for (unsigned i = groupCount; i < m; ++i)
+        {
+            memset(groupWork[i], 0, bytes);
+        }
+
+        IFFT_DIT(T, groupWork, groupCount, m, (int)(m - 1 + first), bytes);
+
+        if (first != 0)
+        {
+            for (unsigned i = 0; i < m; ++i)
+            {
+                gf256_add_mem(work[i], groupWork[i], bytes);
+            }
+        }
+    }
+
+    FFT_DIT(T, work, params.RecoveryCount, m, -1, bytes);
+
+    uint8_t* recovery = static_cast<uint8_t*>(recoveryBlocks);
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        memcpy(recovery + (size_t)i * bytes, work[i], bytes);
+    }
+
+    delete[] workData;
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Decoder
+
+extern "C" int cm256_fft_decode(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* blocks)         // Array of 'originalCount' blocks as described above
+{
+    const int result = ValidateFFTParams(params);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+
+    const unsigned k = params.OriginalCount;
+    const unsigned recoveryCount = params.RecoveryCount;
+    const unsigned m = NextPow2(recoveryCount);
+    const unsigned n = NextPow2(m + k);
+    const int bytes = params.BlockBytes;
+
+    // Sort the blocks by index
+    const uint8_t* original[256] = {};
+    const uint8_t* recovery[256] = {};
+    cm256_block* recoveryBlocks[256];
+    unsigned erasureCount = 0;
+
+    for (unsigned i = 0; i < k; ++i)
+    {
+        const unsigned index = blocks[i].Index;
+        const uint8_t* data = static_cast<const uint8_t*>(blocks[i].Block);
+        if (!data)
+        {
+            return -3;
+        }
+
+        if (index < k)
+        {
+            if (original[index])
+            {
+                return -5;
+            }
+            original[index] = data;
+        }
+        else if (index < k + recoveryCount)
+        {
+            if (recovery[index - k])
+            {
+                return -5;
+            }
+            recovery[index - k] = data;
+            recoveryBlocks[erasureCount++] = &blocks[i];
+        }
+        else
+        {
+            return -5;
+        }
+    }
+
+    // Nothing to do if all of the originals arrived
+    if (erasureCount == 0)
+    {
+        return 0;
+    }
+
+    const CM256FFTTables& T = GetFFTTables();
+
+    // Evaluate the error locator polynomial at each position.  Recovery
+    // positions past recoveryCount are never received.
+    uint8_t locations[256] = {};
+    for (unsigned i = 0; i < m; ++i)
+    {
+        if (i >= recoveryCount || !recovery[i])
+        {
+            locations[i] = 1;
+        }
+    }
+    for (unsigned i = 0; i < k; ++i)
+    {
+        if (!original[i])
+        {
+            locations[m + i] = 1;
+        }
+    }
+
+    FFTWalshHadamard(locations, 256, m + k);
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        locations[i] = static_cast<uint8_t>(((unsigned)locations[i] * T.LogWalsh[i]) % kFFTModulus);
+    }
+    FFTWalshHadamard(locations, 256, 256);
+
+    uint8_t* workData = new (std::nothrow) uint8_t[(size_t)n * bytes];
+    if (!workData)
+    {
+        return -4;
+    }
+    uint8_t* work[256];
+    for (unsigned i = 0; i < n; ++i)
+    {
+        work[i] = workData + (size_t)i * bytes;
+    }
+
+    // Scale the received data by the error locator, with zeros for erasures
+    for (unsigned i = 0; i < m; ++i)
+    {
+        const uint8_t* data = i < recoveryCount ? recovery[i] : nullptr;
+        if (data)
+        {
+            FFTMulMem(T, work[i], data, locations[i], bytes);
+        }
+        else
+        {
+            memset(work[i], 0, bytes);
+        }
+    }
+    for (unsigned i = 0; i < k; ++i)
+    {
+        if (original[i])
+        {
+            FFTMulMem(T, work[m + i], original[i], locations[m + i], bytes);
+        }
+        else
+        {
+            memset(work[m + i], 0, bytes);
+        }
+    }
+    for (unsigned i = m + k; i < n; ++i)
+    {
+        memset(work[i], 0, bytes);
+    }
+
+    IFFT_DIT(T, work, m + k, n, -1, bytes);
+
+    // Formal derivative in the novel polynomial basis
+    for (unsigned i = 1; i < n; ++i)
+    {
+        const unsigned width = ((i ^ (i - 1)) + 1) >> 1;
+        for (unsigned j = 0; j < width; ++j)
+        {
+            gf256_add_mem(work[i - width + j], work[i + j], bytes);
+        }
+    }
+
+    FFT_DIT(T, work, m + k, n, -1, bytes);
+
+    // The received recovery data has been read, so the erased originals are
+    // written over it in order
+    unsigned next = 0;
+    for (unsigned i = 0; i < k; ++i)
+    {
+        if (!original[i])
+        {
+            cm256_block* block = recoveryBlocks[next++];
+            FFTMulMem(T, static_cast<uint8_t*>(block->Block), work[m + i],
+                      kFFTModulus - locations[m + i], bytes);
+            block->Index = static_cast<unsigned char>(i);
+        }
+    }
+
+    delete[] workData;
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Selection
+
+extern "C" int cm256_fft_preferred(cm256_encoder_params params)
+{
+    if (ValidateFFTParams(params) != 0)
+    {
+        return 0;
+    }
+
+    const unsigned n = NextPow2(NextPow2(params.RecoveryCount) + params.OriginalCount);
+    unsigned logN = 0;
+    while ((1u << logN) < n)
+    {
+        ++logN;
+    }
+
+    const unsigned cauchyCost = (unsigned)params.OriginalCount * params.RecoveryCount;
+    const unsigned fftCost = n * logN;
+    return cauchyCost * 100 >= fftCost * CM256_FFT_CROSSOVER_PERCENT;
+}
@@ -0,0 +1,376 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+#include "cm256_codec.h"
+
+#include <mutex>
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <new>
+#include <cstring>
+
+
+//-----------------------------------------------------------------------------
+// Decode Plan
+
+/*
+    The coefficients only depend on which block indices are present, so a
+    plan builds them once from the indices alone.  The plan keeps a decoder
+    whose blocks hold just those indices, and each apply copies it and points
+    it at the caller's blocks.
+*/
+
+struct cm256_decode_plan_t
+{
+    // Decoder state, with Original[] and Recovery[] pointing into Blocks
+    CM256Decoder Decoder;
+
+    // Index-only blocks the plan was built from
+    cm256_block Blocks[256];
+
+    // Storage for the Decoder coefficients, or null for m=1
+    uint8_t* Coefficients;
+};
+
+extern "C" cm256_decode_plan* cm256_decode_plan_create(
+    cm256_encoder_params params,   // Encoder parameters
+    const unsigned char* indices)  // Array of 'originalCount' block indices
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.OriginalCount + params.RecoveryCount > 256 ||
+        !indices)
+    {
+        return nullptr;
+    }
+
+    // Reject out of range or repeated indices
+    const int blockCount = params.OriginalCount + params.RecoveryCount;
+    bool present[256] = {};
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        const int index = indices[ii];
+        if (index >= blockCount || present[index])
+        {
+            return nullptr;
+        }
+        present[index] = true;
+    }
+
+    cm256_decode_plan* plan = new (std::nothrow) cm256_decode_plan;
+    if (!plan)
+    {
+        return nullptr;
+    }
+    plan->Coefficients = nullptr;
+
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        plan->Blocks[ii].Block = nullptr;
+        plan->Blocks[ii].Index = indices[ii];
+    }
+
+    CM256Decoder& decoder = plan->Decoder;
+    if (!decoder.Initialize(params, plan->Blocks))
+    {
+        delete plan;
+        return nullptr;
+    }
+
+    // With m=1 or nothing erased there are no coefficients to precompute
+    if (params.OriginalCount > 1 &&
+        params.RecoveryCount > 1 &&
+        decoder.RecoveryCount > 0)
+    {
+        plan->Coefficients = new (std::nothrow) uint8_t[decoder.GetCoefficientBytes()];
+        if (!plan->Coefficients)
+        {
+            delete plan;
+            return nullptr;
+        }
+
+        decoder.ComputeCoefficients(plan->Coefficients);
+    }
+
+    return plan;
+}
+
+extern "C" void cm256_decode_plan_destroy(cm256_decode_plan* plan)
+{
+    if (plan)
+    {
+        delete[] plan->Coefficients;
+        delete plan;
+    }
+}
+
+extern "C" int cm256_decode_plan_apply(
+    const cm256_decode_plan* plan, // Plan from cm256_decode_plan_create()
+    cm256_block* blocks,           // Array of 'originalCount' blocks as described above
+    cm256_pool* pool)              // Optional worker pool
+{
+    if (!plan || !blocks)
+    {
+        return -3;
+    }
+
+    const CM256Decoder& planned = plan->Decoder;
+    const cm256_encoder_params& params = planned.Params;
+
+    // If there is only one block,
+    if (params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        blocks[0].Index = 0;
+        return 0;
+    }
+
+    // Look up the caller's blocks by index
+    const int blockCount = params.OriginalCount + params.RecoveryCount;
+    cm256_block* byIndex[256] = {};
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        const int index = blocks[ii].Index;
+        if (index >= blockCount || byIndex[index])
+        {
+            return -5;
+        }
+        byIndex[index] = blocks + ii;
+    }
+
+    // Point a copy of the planned decoder at them.  Every planned index must
+    // be present, so the two sets of indices are the same.
+    CM256Decoder state = planned;
+    for (int ii = 0; ii < state.OriginalCount; ++ii)
+    {
+        state.Original[ii] = byIndex[planned.Original[ii]->Index];
+        if (!state.Original[ii])
+        {
+            return -5;
+        }
+    }
+    for (int ii = 0; ii < state.RecoveryCount; ++ii)
+    {
+        state.Recovery[ii] = byIndex[planned.Recovery[ii]->Index];
+        if (!state.Recovery[ii])
+        {
+            return -5;
+        }
+    }
+
+    // If nothing is erased,
+    if (state.RecoveryCount <= 0)
+    {
+        return 0;
+    }
+
+    // If m=1,
+    if (params.RecoveryCount == 1)
+    {
+        state.DecodeM1(pool);
+        return 0;
+    }
+
+    // Decode for m>1
+    state.Eliminate(pool);
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Decode Plan Cache
+
+// Identifies the plan for a set of received block indices
+struct PlanKey
+{
+    int OriginalCount;
+    int RecoveryCount;
+    int BlockBytes;
+
+    // Bit i is set if block index i was received
+    uint64_t Present[4];
+
+    bool operator==(const PlanKey& other) const
+    {
+        return OriginalCount == other.OriginalCount &&
+               RecoveryCount == other.RecoveryCount &&
+               BlockBytes == other.BlockBytes &&
+               0 == memcmp(Present, other.Present, sizeof(Present));
+    }
+};
+
+struct PlanKeyHash
+{
+    size_t operator()(const PlanKey& key) const
+    {
+        uint64_t h = (uint64_t)key.OriginalCount;
+        h = h * 0x9E3779B97F4A7C15ULL ^ (uint64_t)key.RecoveryCount;
+        h = h * 0x9E3779B97F4A7C15ULL ^ (uint64_t)key.BlockBytes;
+        for (int i = 0; i < 4; ++i)
+        {
+            h = h * 0x9E3779B97F4A7C15ULL ^ key.Present[i];
+        }
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+// Plans are shared so that an evicted plan stays alive until the decodes
+// still using it have finished
+typedef std::shared_ptr<cm256_decode_plan> PlanPtr;
+
+struct cm256_plan_cache_t
+{
+    int Capacity;
+
+    // Protects the fields below
+    std::mutex Lock;
+
+    // Most recently used first
+    typedef std::list<std::pair<PlanKey, PlanPtr> > EntryList;
+    EntryList Entries;
+
+    std::unordered_map<PlanKey, EntryList::iterator, PlanKeyHash> Index;
+
+    // Returns the cached plan and marks it most recently used, or null
+    PlanPtr Find(const PlanKey& key);
+
+    // Adds a plan, evicting the least recently used one if full.
+    // Returns the plan that is cached for the key afterwards.
+    PlanPtr Insert(const PlanKey& key, const PlanPtr& plan);
+};
+
+PlanPtr cm256_plan_cache_t::Find(const PlanKey& key)
+{
+    std::lock_guard<std::mutex> locker(Lock);
+
+    auto found = Index.find(key);
+    if (found == Index.end())
+    {
+        return PlanPtr();
+    }
+
+    Entries.splice(Entries.begin(), Entries, found->second);
+    return found->second->second;
+}
+
+PlanPtr cm256_plan_cache_t::Insert(const PlanKey& key, const PlanPtr& plan)
+{
+    std::lock_guard<std::mutex> locker(Lock);
+
+    // Another thread may have added the same plan in the meantime
+    auto found = Index.find(key);
+    if (found != Index.end())
+    {
+        Entries.splice(Entries.begin(), Entries, found->second);
+        return found->second->second;
+    }
+
+    if ((int)Entries.size() >= Capacity)
+    {
+        Index.erase(Entries.back().first);
+        Entries.pop_back();
+    }
+
+    Entries.emplace_front(key, plan);
+    Index[key] = Entries.begin();
+    return plan;
+}
+
+extern "C" cm256_plan_cache* cm256_plan_cache_create(int capacity)
+{
+    if (capacity <= 0)
+    {
+        return nullptr;
+    }
+
+    cm256_plan_cache* cache = new (std::nothrow) cm256_plan_cache;
+    if (cache)
+    {
+        cache->Capacity = capacity;
+    }
+    return cache;
+}
+
+extern "C" void cm256_plan_cache_destroy(cm256_plan_cache* cache)
+{
+    delete cache;
+}
+
+extern "C" int cm256_decode_cached(
+    cm256_plan_cache* cache,     // Cache from cm256_plan_cache_create()
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks,         // Array of 'originalCount' blocks as described above
+    cm256_pool* pool)            // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!blocks || !cache)
+    {
+        return -3;
+    }
+
+    PlanKey key;
+    key.OriginalCount = params.OriginalCount;
+    key.RecoveryCount = params.RecoveryCount;
+    key.BlockBytes = params.BlockBytes;
+    memset(key.Present, 0, sizeof(key.Present));
+
+    unsigned char indices[256];
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        const unsigned index = blocks[ii].Index;
+        indices[ii] = blocks[ii].Index;
+        key.Present[index / 64] |= (uint64_t)1 << (index % 64);
+    }
+
+    PlanPtr plan = cache->Find(key);
+    if (!plan)
+    {
+        // Build the plan outside the lock, since it is the slow part
+        plan.reset(cm256_decode_plan_create(params, indices), cm256_decode_plan_destroy);
+        if (!plan)
+        {
+            return -5;
+        }
+
+        plan = cache->Insert(key, plan);
+    }
+
+    return cm256_decode_plan_apply(plan.get(), blocks, pool);
+}
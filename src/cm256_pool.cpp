@@ -0,0 +1,211 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256_pool.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <new>
+
+
+//-----------------------------------------------------------------------------
+// Worker Pool
+
+/*
+    A task may itself call an entry point that runs on the same pool.  The
+    job it belongs to holds RunLock until all of its tasks are done, so the
+    nested job could never start.  Each thread notes the pool whose tasks it
+    is running, and a nested call on that pool runs its tasks inline.
+*/
+
+// Pool whose job this thread is working on, or null
+static thread_local const cm256_pool* RunningPool = nullptr;
+
+struct cm256_pool_t
+{
+    std::vector<std::thread> Workers;
+
+    // Serializes callers of cm256_pool_run()
+    std::mutex RunLock;
+
+    // Protects the fields below
+    std::mutex Lock;
+    std::condition_variable WorkAvailable;
+    std::condition_variable WorkDone;
+
+    // Incremented for each job so sleeping workers notice a new one
+    unsigned JobSerial = 0;
+    bool Terminated = false;
+
+    // Current job
+    cm256_pool_task Task = nullptr;
+    void* Context = nullptr;
+    int TaskCount = 0;
+    std::atomic<int> NextTask;
+
+    // Number of workers that have not yet finished the current job
+    int WorkersBusy = 0;
+
+    // Claim and run tasks until the job is exhausted
+    void Work()
+    {
+        for (;;)
+        {
+            const int task = NextTask.fetch_add(1);
+            if (task >= TaskCount)
+            {
+                break;
+            }
+            Task(Context, task);
+        }
+    }
+
+    void WorkerLoop()
+    {
+        // Workers only ever run tasks of this pool
+        RunningPool = this;
+
+        unsigned seenSerial = 0;
+
+        std::unique_lock<std::mutex> locker(Lock);
+        for (;;)
+        {
+            WorkAvailable.wait(locker, [&] { return Terminated || JobSerial != seenSerial; });
+            if (Terminated)
+            {
+                return;
+            }
+            seenSerial = JobSerial;
+
+            locker.unlock();
+            Work();
+            locker.lock();
+
+            if (--WorkersBusy == 0)
+            {
+                WorkDone.notify_one();
+            }
+        }
+    }
+};
+
+extern "C" cm256_pool* cm256_pool_create(int workerCount)
+{
+    if (workerCount < 0)
+    {
+        const int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    cm256_pool* pool = new (std::nothrow) cm256_pool;
+    if (!pool)
+    {
+        return nullptr;
+    }
+    pool->NextTask = 0;
+
+    try
+    {
+        for (int ii = 0; ii < workerCount; ++ii)
+        {
+            pool->Workers.emplace_back(&cm256_pool_t::WorkerLoop, pool);
+        }
+    }
+    catch (...)
+    {
+        cm256_pool_destroy(pool);
+        return nullptr;
+    }
+
+    return pool;
+}
+
+extern "C" void cm256_pool_destroy(cm256_pool* pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(pool->Lock);
+        pool->Terminated = true;
+    }
+    pool->WorkAvailable.notify_all();
+
+    for (std::thread& worker : pool->Workers)
+    {
+        worker.join();
+    }
+
+    delete pool;
+}
+
+int cm256_pool_concurrency(cm256_pool* pool)
+{
+    return pool ? static_cast<int>(pool->Workers.size()) + 1 : 1;
+}
+
+void cm256_pool_run(cm256_pool* pool, cm256_pool_task task, void* context, int taskCount)
+{
+    // Skip the handoff when there is nobody to hand work to, or when this
+    // thread is already running a task of the pool, see above
+    if (!pool || pool->Workers.empty() || taskCount <= 1 || RunningPool == pool)
+    {
+        for (int ii = 0; ii < taskCount; ++ii)
+        {
+            task(context, ii);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLocker(pool->RunLock);
+
+    {
+        std::lock_guard<std::mutex> locker(pool->Lock);
+        pool->Task = task;
+        pool->Context = context;
+        pool->TaskCount = taskCount;
+        pool->NextTask = 0;
+        pool->WorkersBusy = static_cast<int>(pool->Workers.size());
+        ++pool->JobSerial;
+    }
+    pool->WorkAvailable.notify_all();
+
+    const cm256_pool* outerPool = RunningPool;
+    RunningPool = pool;
+    pool->Work();
+    RunningPool = outerPool;
+
+    // Wait for the workers to finish the tasks they claimed
+    std::unique_lock<std::mutex> locker(pool->Lock);
+    pool->WorkDone.wait(locker, [pool] { return pool->WorkersBusy == 0; });
+}
@@ -0,0 +1,53 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_POOL_H
+#define CM256_POOL_H
+
+#include "cm256.h"
+
+/*
+    Worker Pool (internal)
+
+    A cm256_pool owns a fixed set of worker threads that sleep on a condition
+    variable between jobs.  A job is a task function and a count of tasks.
+    The calling thread works on the job too, and returns once every task has
+    finished.  Only one job runs at a time; concurrent callers take turns.
+    A task that runs a job on its own pool has that job's tasks run inline.
+*/
+
+// Task callback: runs task number `task` of a job
+typedef void (*cm256_pool_task)(void* context, int task);
+
+// Returns the number of threads that work on a job, including the caller
+extern int cm256_pool_concurrency(cm256_pool* pool);
+
+// Run tasks [0, taskCount) on the pool and the calling thread, then return
+extern void cm256_pool_run(cm256_pool* pool, cm256_pool_task task, void* context, int taskCount);
+
+#endif // CM256_POOL_H
@@ -0,0 +1,540 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+#include "cm256_codec.h"
+
+#include <algorithm>
+#include <atomic>
+
+
+//-----------------------------------------------------------------------------
+// Scatter-Gather Blocks
+
+/*
+    The cursors that read scatter-gather blocks are in cm256_codec.h, since
+    the partial and streaming decoders read them too.
+*/
+
+// Returns 0 if the segments of the block add up to blockBytes
+int ValidateSgBlock(const cm256_sg_block& block, int blockBytes)
+{
+    if (!block.Segments || block.SegmentCount <= 0)
+    {
+        return -3;
+    }
+
+    long long total = 0;
+    for (int s = 0; s < block.SegmentCount; ++s)
+    {
+        const cm256_iovec& segment = block.Segments[s];
+        if (segment.Bytes < 0)
+        {
+            return -1;
+        }
+        if (!segment.Base && segment.Bytes > 0)
+        {
+            return -3;
+        }
+        total += segment.Bytes;
+    }
+    return total == blockBytes ? 0 : -1;
+}
+
+// Copy a whole scatter-gather block to one buffer
+void GatherSgBlock(const cm256_sg_block& block, int blockBytes, void* dest)
+{
+    SgCursor cursor;
+    cursor.Reset(block);
+    cursor.Seek(0);
+    cursor.Gather(0, blockBytes, static_cast<uint8_t*>(dest));
+}
+
+
+//-----------------------------------------------------------------------------
+// Scatter-Gather Encode
+
+// Encode the byte range [begin, end) of every recovery block from
+// scatter-gather originals, one run at a time, see SgRuns in cm256_codec.h
+static void EncodeSgStripe(
+    cm256_encoder_params params,            // Encoder parameters
+    const cm256_sg_block* const* originals, // Array of pointers to original blocks
+    uint8_t* recoveryData,                  // Output recovery blocks end-to-end
+    int begin,                              // Offset of the stripe into each block
+    int end,                                // Offset of the end of the stripe
+    const gf256_mul_tables* tables)         // Precomputed rows 1..m-1 of the matrix, or null
+{
+    const int tileBytes = GetEncodeTileBytes(params);
+
+    SgRuns runs;
+    runs.Reset(originals, params.OriginalCount);
+
+    // For each run of the stripe,
+    for (int offset = begin; offset < end;)
+    {
+        const void* data[256];
+        const int bytes = runs.Next(offset, std::min(tileBytes, end - offset), data);
+
+        cm256_block runBlocks[256];
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            runBlocks[j].Block = const_cast<void*>(data[j]);
+        }
+
+        // Produce this run of every recovery block while the originals are in cache
+        uint8_t* recoveryBlock = recoveryData + offset;
+        for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += params.BlockBytes)
+        {
+            const gf256_mul_tables* rowTables = nullptr;
+            if (tables && block > 0)
+            {
+                rowTables = tables + (block - 1) * params.OriginalCount;
+            }
+
+            EncodeBlockRange(params, runBlocks, (params.OriginalCount + block), recoveryBlock, 0, bytes, rowTables);
+        }
+
+        offset += bytes;
+    }
+}
+
+struct EncodeSgStripeTask
+{
+    cm256_encoder_params Params;
+    const cm256_sg_block* const* Originals;
+    uint8_t* RecoveryData;
+    const gf256_mul_tables* Tables;
+    int StripeBytes;
+
+    static void Run(void* context, int task)
+    {
+        const EncodeSgStripeTask* self = static_cast<const EncodeSgStripeTask*>(context);
+
+        const int begin = task * self->StripeBytes;
+        int end = begin + self->StripeBytes;
+        if (end > self->Params.BlockBytes)
+        {
+            end = self->Params.BlockBytes;
+        }
+
+        EncodeSgStripe(self->Params, self->Originals, self->RecoveryData, begin, end, self->Tables);
+    }
+};
+
+// Same as EncodeWithPool() for scatter-gather originals
+static void EncodeSgWithPool(
+    cm256_encoder_params params,
+    const cm256_sg_block* const* originals,
+    void* recoveryBlocks,
+    const gf256_mul_tables* tables,
+    cm256_pool* pool)
+{
+    const int stripeCount = GetStripeCount(params.BlockBytes, pool);
+
+    // Small blocks are not worth waking the workers for
+    if (stripeCount < 2)
+    {
+        EncodeSgStripe(params, originals, static_cast<uint8_t*>(recoveryBlocks), 0, params.BlockBytes, tables);
+        return;
+    }
+
+    EncodeSgStripeTask task;
+    task.Params = params;
+    task.Originals = originals;
+    task.RecoveryData = static_cast<uint8_t*>(recoveryBlocks);
+    task.Tables = tables;
+    task.StripeBytes = GetStripeBytes(params.BlockBytes, stripeCount);
+
+    // Rounding the stripes up may leave fewer stripes than requested
+    const int taskCount = (params.BlockBytes + task.StripeBytes - 1) / task.StripeBytes;
+
+    cm256_pool_run(pool, &EncodeSgStripeTask::Run, &task, taskCount);
+}
+
+// Checks the originals of a scatter-gather encode and points to each one
+static int GetSgOriginals(
+    const cm256_encoder_params& params,
+    const cm256_sg_block* originals,
+    const cm256_sg_block** pointers)
+{
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        const int result = ValidateSgBlock(originals[j], params.BlockBytes);
+        if (result != 0)
+        {
+            return result;
+        }
+        pointers[j] = originals + j;
+    }
+    return 0;
+}
+
+extern "C" int cm256_encode_sg(
+    cm256_encoder_params params,     // Encoder parameters
+    const cm256_sg_block* originals, // Array of original blocks
+    void* recoveryBlocks,            // Output recovery blocks end-to-end
+    cm256_pool* pool)                // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const cm256_sg_block* pointers[256];
+    const int result = GetSgOriginals(params, originals, pointers);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    EncodeSgWithPool(params, pointers, recoveryBlocks, nullptr, pool);
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Scatter-Gather Batches
+
+struct EncodeSgBatchTask
+{
+    cm256_encoder_params Params;
+    const gf256_mul_tables* Tables;
+    const cm256_sg_encode_stripe* Stripes;
+    int StripeCount;
+    int TaskStripes;
+
+    // Encode stripes [begin, end) on this thread
+    void RunRange(int begin, int end) const
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const cm256_sg_block* originals[256];
+            for (int j = 0; j < Params.OriginalCount; ++j)
+            {
+                originals[j] = Stripes[i].Originals + j;
+            }
+
+            EncodeSgStripe(Params, originals, static_cast<uint8_t*>(Stripes[i].RecoveryBlocks),
+                0, Params.BlockBytes, Tables);
+        }
+    }
+
+    static void Run(void* context, int task)
+    {
+        const EncodeSgBatchTask* self = static_cast<const EncodeSgBatchTask*>(context);
+
+        const int begin = task * self->TaskStripes;
+        int end = begin + self->TaskStripes;
+        if (end > self->StripeCount)
+        {
+            end = self->StripeCount;
+        }
+
+        self->RunRange(begin, end);
+    }
+};
+
+extern "C" int cm256_encode_sg_batch(
+    cm256_encoder_params params,           // Encoder parameters
+    const cm256_sg_encode_stripe* stripes, // Array of stripes to encode
+    int stripeCount,                       // Number of stripes
+    cm256_pool* pool)                      // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if ((!stripes && stripeCount > 0) || stripeCount < 0)
+    {
+        return -3;
+    }
+
+    // Check every stripe before writing any of them
+    for (int i = 0; i < stripeCount; ++i)
+    {
+        if (!stripes[i].Originals || !stripes[i].RecoveryBlocks)
+        {
+            return -3;
+        }
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            const int result = ValidateSgBlock(stripes[i].Originals[j], params.BlockBytes);
+            if (result != 0)
+            {
+                return result;
+            }
+        }
+    }
+
+    if (stripeCount == 0)
+    {
+        return 0;
+    }
+
+    // Share one set of coefficient tables between all the stripes
+    cm256_encoder* encoder = cm256_encoder_create(params);
+    if (!encoder)
+    {
+        return -4;
+    }
+
+    // Large blocks are split by byte range instead
+    if (GetStripeCount(params.BlockBytes, pool) >= 2)
+    {
+        for (int i = 0; i < stripeCount; ++i)
+        {
+            const cm256_sg_block* originals[256];
+            GetSgOriginals(params, stripes[i].Originals, originals);
+
+            EncodeSgWithPool(params, originals, stripes[i].RecoveryBlocks, encoder->Tables, pool);
+        }
+        cm256_encoder_destroy(encoder);
+        return 0;
+    }
+
+    EncodeSgBatchTask task;
+    task.Params = params;
+    task.Tables = encoder->Tables;
+    task.Stripes = stripes;
+    task.StripeCount = stripeCount;
+    task.TaskStripes = GetBatchTaskStripes(params, stripeCount, pool);
+
+    const int taskCount = (stripeCount + task.TaskStripes - 1) / task.TaskStripes;
+    if (taskCount < 2)
+    {
+        task.RunRange(0, stripeCount);
+    }
+    else
+    {
+        cm256_pool_run(pool, &EncodeSgBatchTask::Run, &task, taskCount);
+    }
+
+    cm256_encoder_destroy(encoder);
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Scatter-Gather Decode
+
+// Decode one stripe whose blocks have been validated
+static int DecodeSgStripe(
+    const cm256_encoder_params& params,
+    const cm256_sg_decode_stripe& stripe,
+    cm256_pool* pool)
+{
+    // The decoder state only needs the indices
+    cm256_block indexBlocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        indexBlocks[i].Block = nullptr;
+        indexBlocks[i].Index = stripe.Blocks[i].Index;
+    }
+
+    return DecodePartial(params, indexBlocks, stripe.Blocks, stripe.Outputs, pool);
+}
+
+extern "C" int cm256_decode_sg(
+    cm256_encoder_params params,  // Encoder parameters
+    const cm256_sg_block* blocks, // Array of 'originalCount' received blocks
+    void* const* outputs,         // Array of 'originalCount' output pointers, null to skip
+    cm256_pool* pool)             // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!blocks || !outputs)
+    {
+        return -3;
+    }
+
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        const int result = ValidateSgBlock(blocks[i], params.BlockBytes);
+        if (result != 0)
+        {
+            return result;
+        }
+    }
+
+    cm256_sg_decode_stripe stripe;
+    stripe.Blocks = blocks;
+    stripe.Outputs = outputs;
+    return DecodeSgStripe(params, stripe, pool);
+}
+
+
+//-----------------------------------------------------------------------------
+// Scatter-Gather Batch Decode
+
+/*
+    Each stripe is a partial decode of its own, as in cm256_decode_sg().
+    Stripes with the same erasures do not share any work, because the
+    coefficients of a partial decode cost O(k * N) and the data costs
+    O(k * N * BlockBytes), so a plan would save little.
+*/
+
+struct DecodeSgBatchTask
+{
+    cm256_encoder_params Params;
+    const cm256_sg_decode_stripe* Stripes;
+    int StripeCount;
+    int TaskStripes;
+
+    // Set by any stripe whose indices are invalid
+    std::atomic<int> Result;
+
+    // Decode stripes [begin, end) on this thread
+    void RunRange(int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const int result = DecodeSgStripe(Params, Stripes[i], nullptr);
+            if (result != 0)
+            {
+                Result = result;
+            }
+        }
+    }
+
+    static void Run(void* context, int task)
+    {
+        DecodeSgBatchTask* self = static_cast<DecodeSgBatchTask*>(context);
+
+        const int begin = task * self->TaskStripes;
+        int end = begin + self->TaskStripes;
+        if (end > self->StripeCount)
+        {
+            end = self->StripeCount;
+        }
+
+        self->RunRange(begin, end);
+    }
+};
+
+extern "C" int cm256_decode_sg_batch(
+    cm256_encoder_params params,           // Encoder parameters
+    const cm256_sg_decode_stripe* stripes, // Array of stripes to decode
+    int stripeCount,                       // Number of stripes
+    cm256_pool* pool)                      // Optional worker pool
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if ((!stripes && stripeCount > 0) || stripeCount < 0)
+    {
+        return -3;
+    }
+
+    // Check every stripe before writing any of them
+    for (int i = 0; i < stripeCount; ++i)
+    {
+        if (!stripes[i].Blocks || !stripes[i].Outputs)
+        {
+            return -3;
+        }
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            const int result = ValidateSgBlock(stripes[i].Blocks[j], params.BlockBytes);
+            if (result != 0)
+            {
+                return result;
+            }
+        }
+    }
+
+    if (stripeCount == 0)
+    {
+        return 0;
+    }
+
+    // Large blocks are split by byte range instead
+    if (GetStripeCount(params.BlockBytes, pool) >= 2)
+    {
+        int result = 0;
+        for (int i = 0; i < stripeCount; ++i)
+        {
+            const int stripeResult = DecodeSgStripe(params, stripes[i], pool);
+            if (stripeResult != 0)
+            {
+                result = stripeResult;
+            }
+        }
+        return result;
+    }
+
+    DecodeSgBatchTask task;
+    task.Params = params;
+    task.Stripes = stripes;
+    task.StripeCount = stripeCount;
+    task.TaskStripes = GetBatchTaskStripes(params, stripeCount, pool);
+    task.Result = 0;
+
+    const int taskCount = (stripeCount + task.TaskStripes - 1) / task.TaskStripes;
+    if (taskCount < 2)
+    {
+        task.RunRange(0, stripeCount);
+    }
+    else
+    {
+        cm256_pool_run(pool, &DecodeSgBatchTask::Run, &task, taskCount);
+    }
+
+    return task.Result;
+}
@@ -0,0 +1,1277 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    File sharding tool
+
+    Splits a file into 'originalCount' data shards and 'recoveryCount' parity
+    shards, and rebuilds any shards that go missing afterwards:
+
+        cm256_shard encode <input> <prefix> <originalCount> <recoveryCount> [blockBytes]
+        cm256_shard repair <prefix>
+        cm256_shard repair-async <prefix> [stripesInFlight] [workerThreads]
+        cm256_shard join   <prefix> <output>
+
+    The input is treated as consecutive stripes of originalCount * blockBytes
+    bytes.  Block i of every stripe goes to data shard i, so shard file j holds
+    block j of stripe s at offset s * blockBytes.  The shards are written to
+    <prefix>.000, <prefix>.001, ... with the data shards first, and the
+    parameters go to <prefix>.manifest.
+
+    Files are never read into heap buffers.  The input and every shard are
+    mapped one window of stripes at a time, the encoder reads the original
+    blocks straight from the mapped input pages, and each recovery block is
+    written straight into the mapped page of its parity shard.  Repair decodes
+    from the mapped pages of the surviving shards into the mapped pages of the
+    rebuilt ones.  Unmapping each window before the next keeps the resident
+    set at about one window per file no matter how large the input is.
+
+    repair-async does the same repair with overlapped reads, decoding and
+    writes, see Asynchronous Repair below.
+*/
+
+#include "cm256.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Shard Layout
+
+// Default bytes per block
+static const int kDefaultBlockBytes = 64 * 1024;
+
+// Input bytes mapped per window
+static const uint64_t kWindowBytes = 64 * 1024 * 1024;
+
+struct ShardLayout
+{
+    cm256_encoder_params Params;
+
+    // Size of the original file
+    uint64_t FileBytes;
+
+    // Number of stripes, the last of which may be padded with zeroes
+    uint64_t StripeCount;
+
+    // Stripes mapped at a time
+    uint64_t WindowStripes;
+
+    uint64_t StripeBytes() const
+    {
+        return (uint64_t)Params.OriginalCount * Params.BlockBytes;
+    }
+    uint64_t ShardBytes() const
+    {
+        return StripeCount * Params.BlockBytes;
+    }
+    int ShardCount() const
+    {
+        return Params.OriginalCount + Params.RecoveryCount;
+    }
+};
+
+static void InitializeLayout(ShardLayout& layout)
+{
+    const uint64_t stripeBytes = layout.StripeBytes();
+    layout.StripeCount = (layout.FileBytes + stripeBytes - 1) / stripeBytes;
+    layout.WindowStripes = kWindowBytes / stripeBytes;
+    if (layout.WindowStripes < 1)
+    {
+        layout.WindowStripes = 1;
+    }
+}
+
+static std::string GetShardPath(const std::string& prefix, int shardIndex)
+{
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%03d", shardIndex);
+    return prefix + suffix;
+}
+
+static std::string GetManifestPath(const std::string& prefix)
+{
+    return prefix + ".manifest";
+}
+
+static bool WriteManifest(const std::string& prefix, const ShardLayout& layout)
+{
+    const std::string path = GetManifestPath(prefix);
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    fprintf(file, "cm256_shard 1\n%d %d %d %" PRIu64 "\n",
+        layout.Params.OriginalCount, layout.Params.RecoveryCount,
+        layout.Params.BlockBytes, layout.FileBytes);
+
+    return fclose(file) == 0;
+}
+
+static bool ReadManifest(const std::string& prefix, ShardLayout& layout)
+{
+    const std::string path = GetManifestPath(prefix);
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file)
+    {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    int version = 0;
+    const int fields = fscanf(file, "cm256_shard %d %d %d %d %" SCNu64, &version,
+        &layout.Params.OriginalCount, &layout.Params.RecoveryCount,
+        &layout.Params.BlockBytes, &layout.FileBytes);
+    fclose(file);
+
+    if (fields != 5 || version != 1 ||
+        layout.Params.OriginalCount <= 0 || layout.Params.RecoveryCount <= 0 ||
+        layout.Params.OriginalCount + layout.Params.RecoveryCount > 256 ||
+        layout.Params.BlockBytes <= 0)
+    {
+        fprintf(stderr, "%s: not a valid manifest\n", path.c_str());
+        return false;
+    }
+
+    InitializeLayout(layout);
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Mapped Files
+
+struct MappedFile
+{
+    int Fd = -1;
+    bool Writable = false;
+
+    // Current window, or null
+    uint8_t* Data = nullptr;
+    void* MapBase = nullptr;
+    size_t MapBytes = 0;
+};
+
+static bool OpenMapped(MappedFile& file, const std::string& path, bool create, uint64_t bytes)
+{
+    file.Writable = create;
+    file.Fd = create ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+                     : open(path.c_str(), O_RDONLY);
+    if (file.Fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (create && ftruncate(file.Fd, (off_t)bytes) != 0)
+    {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+// Maps bytes [offset, offset + bytes) of the file
+static bool MapWindow(MappedFile& file, uint64_t offset, size_t bytes)
+{
+    static const uint64_t pageBytes = (uint64_t)sysconf(_SC_PAGESIZE);
+
+    // mmap() offsets must be page aligned
+    const uint64_t skip = offset % pageBytes;
+
+    file.MapBytes = (size_t)(bytes + skip);
+    file.MapBase = mmap(nullptr, file.MapBytes,
+        file.Writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+        MAP_SHARED, file.Fd, (off_t)(offset - skip));
+    if (file.MapBase == MAP_FAILED)
+    {
+        file.MapBase = nullptr;
+        file.Data = nullptr;
+        fprintf(stderr, "mmap: %s\n", strerror(errno));
+        return false;
+    }
+
+    // Every window is walked front to back once
+    madvise(file.MapBase, file.MapBytes, MADV_SEQUENTIAL);
+
+    file.Data = static_cast<uint8_t*>(file.MapBase) + skip;
+    return true;
+}
+
+// Dirty pages of a shared mapping stay in the page cache after munmap(), so
+// the kernel writes them back without holding them in our resident set
+static void UnmapWindow(MappedFile& file)
+{
+    if (file.MapBase)
+    {
+        munmap(file.MapBase, file.MapBytes);
+    }
+    file.MapBase = nullptr;
+    file.Data = nullptr;
+}
+
+static bool CloseMapped(MappedFile& file)
+{
+    UnmapWindow(file);
+    bool success = true;
+    if (file.Fd >= 0)
+    {
+        success = close(file.Fd) == 0;
+    }
+    file.Fd = -1;
+    return success;
+}
+
+static bool CloseAll(std::vector<MappedFile>& files)
+{
+    bool success = true;
+    for (MappedFile& file : files)
+    {
+        if (!CloseMapped(file))
+        {
+            success = false;
+        }
+    }
+    return success;
+}
+
+static void PrintThroughput(const char* what, uint64_t bytes,
+    std::chrono::steady_clock::time_point t0)
+{
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+    printf("%s %" PRIu64 " bytes in %.3f s (%.1f MB/s)\n", what, bytes, seconds,
+        seconds > 0. ? bytes / seconds / 1000000. : 0.);
+}
+
+
+//-----------------------------------------------------------------------------
+// Commands
+
+static int EncodeCommand(const std::string& inputPath, const std::string& prefix,
+    int originalCount, int recoveryCount, int blockBytes)
+{
+    ShardLayout layout;
+    layout.Params.OriginalCount = originalCount;
+    layout.Params.RecoveryCount = recoveryCount;
+    layout.Params.BlockBytes = blockBytes;
+
+    cm256_encoder* encoder = cm256_encoder_create(layout.Params);
+    if (!encoder)
+    {
+        fprintf(stderr, "encode: invalid parameters\n");
+        return 1;
+    }
+
+    MappedFile input;
+    if (!OpenMapped(input, inputPath, false, 0))
+    {
+        cm256_encoder_destroy(encoder);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(input.Fd, &st) != 0)
+    {
+        fprintf(stderr, "%s: %s\n", inputPath.c_str(), strerror(errno));
+        CloseMapped(input);
+        cm256_encoder_destroy(encoder);
+        return 1;
+    }
+    layout.FileBytes = (uint64_t)st.st_size;
+    InitializeLayout(layout);
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    bool success = true;
+    std::vector<MappedFile> shards(layout.ShardCount());
+    for (int i = 0; i < layout.ShardCount() && success; ++i)
+    {
+        success = OpenMapped(shards[i], GetShardPath(prefix, i), true, layout.ShardBytes());
+    }
+
+    const uint64_t stripeBytes = layout.StripeBytes();
+    const int k = originalCount;
+    cm256_block originals[256];
+    std::vector<uint8_t> tailStripe;
+
+    for (uint64_t first = 0; first < layout.StripeCount && success; first += layout.WindowStripes)
+    {
+        uint64_t stripes = layout.StripeCount - first;
+        if (stripes > layout.WindowStripes)
+        {
+            stripes = layout.WindowStripes;
+        }
+
+        const uint64_t inputOffset = first * stripeBytes;
+        uint64_t inputBytes = layout.FileBytes - inputOffset;
+        if (inputBytes > stripes * stripeBytes)
+        {
+            inputBytes = stripes * stripeBytes;
+        }
+
+        success = MapWindow(input, inputOffset, (size_t)inputBytes);
+        for (int i = 0; i < layout.ShardCount() && success; ++i)
+        {
+            success = MapWindow(shards[i], first * blockBytes, (size_t)(stripes * blockBytes));
+        }
+
+        for (uint64_t s = 0; s < stripes && success; ++s)
+        {
+            const uint64_t stripeOffset = s * stripeBytes;
+            const uint8_t* stripe = input.Data + stripeOffset;
+
+            // Only the last stripe can run past the end of the file, and
+            // reading past the end of a mapping faults, so it is padded
+            if (stripeOffset + stripeBytes > inputBytes)
+            {
+                tailStripe.assign((size_t)stripeBytes, 0);
+                memcpy(tailStripe.data(), stripe, (size_t)(inputBytes - stripeOffset));
+                stripe = tailStripe.data();
+            }
+
+            for (int i = 0; i < k; ++i)
+            {
+                originals[i].Block = const_cast<uint8_t*>(stripe) + (size_t)i * blockBytes;
+                originals[i].Index = cm256_get_original_block_index(layout.Params, i);
+
+                memcpy(shards[i].Data + s * blockBytes, originals[i].Block, blockBytes);
+            }
+
+            for (int r = 0; r < recoveryCount; ++r)
+            {
+                cm256_encoder_encode_block(encoder, originals,
+                    cm256_get_recovery_block_index(layout.Params, r),
+                    shards[k + r].Data + s * blockBytes);
+            }
+        }
+
+        UnmapWindow(input);
+        for (MappedFile& shard : shards)
+        {
+            UnmapWindow(shard);
+        }
+    }
+
+    if (!CloseAll(shards))
+    {
+        success = false;
+    }
+    CloseMapped(input);
+    cm256_encoder_destroy(encoder);
+
+    if (!success || !WriteManifest(prefix, layout))
+    {
+        fprintf(stderr, "encode: failed\n");
+        return 1;
+    }
+
+    PrintThroughput("encoded", layout.FileBytes, t0);
+    return 0;
+}
+
+// Sorts the shards into usable and missing ones, and leaves the first k
+// usable shards in 'present'.  Returns false if too many are missing.
+static bool FindShards(const std::string& prefix, const ShardLayout& layout,
+    std::vector<int>& present, std::vector<int>& missing)
+{
+    // A shard is usable if it is there at its full size
+    for (int i = 0; i < layout.ShardCount(); ++i)
+    {
+        struct stat st;
+        if (stat(GetShardPath(prefix, i).c_str(), &st) == 0 &&
+            (uint64_t)st.st_size == layout.ShardBytes())
+        {
+            present.push_back(i);
+        }
+        else
+        {
+            missing.push_back(i);
+        }
+    }
+
+    if (missing.empty())
+    {
+        printf("repair: all %d shards are present\n", layout.ShardCount());
+        return true;
+    }
+    if ((int)present.size() < layout.Params.OriginalCount)
+    {
+        fprintf(stderr, "repair: %d shards missing, at most %d can be rebuilt\n",
+            (int)missing.size(), layout.Params.RecoveryCount);
+        return false;
+    }
+
+    // Data shards come first, so every surviving data shard is used
+    present.resize(layout.Params.OriginalCount);
+    return true;
+}
+
+static int RepairCommand(const std::string& prefix)
+{
+    ShardLayout layout;
+    std::vector<int> present, missing;
+    if (!ReadManifest(prefix, layout) ||
+        !FindShards(prefix, layout, present, missing))
+    {
+        return 1;
+    }
+    if (missing.empty())
+    {
+        return 0;
+    }
+
+    const cm256_encoder_params& params = layout.Params;
+    const int k = params.OriginalCount;
+    const int blockBytes = params.BlockBytes;
+
+    cm256_encoder* encoder = cm256_encoder_create(params);
+    if (!encoder)
+    {
+        return 1;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    bool success = true;
+    std::vector<MappedFile> sources(k), rebuilt(missing.size());
+    for (int i = 0; i < k && success; ++i)
+    {
+        success = OpenMapped(sources[i], GetShardPath(prefix, present[i]), false, 0);
+    }
+    for (size_t i = 0; i < missing.size() && success; ++i)
+    {
+        success = OpenMapped(rebuilt[i], GetShardPath(prefix, missing[i]), true, layout.ShardBytes());
+    }
+
+    bool dataMissing = false;
+    for (int index : missing)
+    {
+        if (index < k)
+        {
+            dataMissing = true;
+        }
+    }
+
+    cm256_block blocks[256], originals[256];
+    void* outputs[256];
+
+    for (uint64_t first = 0; first < layout.StripeCount && success; first += layout.WindowStripes)
+    {
+        uint64_t stripes = layout.StripeCount - first;
+        if (stripes > layout.WindowStripes)
+        {
+            stripes = layout.WindowStripes;
+        }
+
+        for (MappedFile& file : sources)
+        {
+            success = success && MapWindow(file, first * blockBytes, (size_t)(stripes * blockBytes));
+        }
+        for (MappedFile& file : rebuilt)
+        {
+            success = success && MapWindow(file, first * blockBytes, (size_t)(stripes * blockBytes));
+        }
+
+        for (uint64_t s = 0; s < stripes && success; ++s)
+        {
+            const size_t offset = (size_t)(s * blockBytes);
+
+            for (int i = 0; i < k; ++i)
+            {
+                blocks[i].Block = sources[i].Data + offset;
+                blocks[i].Index = static_cast<unsigned char>(present[i]);
+                if (present[i] < k)
+                {
+                    originals[present[i]] = blocks[i];
+                }
+            }
+            for (size_t i = 0; i < missing.size(); ++i)
+            {
+                const int index = missing[i];
+                if (index < k)
+                {
+                    outputs[index] = rebuilt[i].Data + offset;
+                    originals[index].Block = outputs[index];
+                    originals[index].Index = static_cast<unsigned char>(index);
+                }
+            }
+
+            if (dataMissing && cm256_decode_into(params, blocks, outputs, nullptr) != 0)
+            {
+                fprintf(stderr, "repair: decode failed\n");
+                success = false;
+                break;
+            }
+
+            for (size_t i = 0; i < missing.size(); ++i)
+            {
+                if (missing[i] >= k)
+                {
+                    cm256_encoder_encode_block(encoder, originals, missing[i], rebuilt[i].Data + offset);
+                }
+            }
+        }
+
+        for (MappedFile& file : sources)
+        {
+            UnmapWindow(file);
+        }
+        for (MappedFile& file : rebuilt)
+        {
+            UnmapWindow(file);
+        }
+    }
+
+    CloseAll(sources);
+    if (!CloseAll(rebuilt))
+    {
+        success = false;
+    }
+    cm256_encoder_destroy(encoder);
+
+    if (!success)
+    {
+        fprintf(stderr, "repair: failed\n");
+        return 1;
+    }
+
+    for (int index : missing)
+    {
+        printf("rebuilt %s\n", GetShardPath(prefix, index).c_str());
+    }
+    PrintThroughput("repaired", layout.ShardBytes() * missing.size(), t0);
+    return 0;
+}
+
+static int JoinCommand(const std::string& prefix, const std::string& outputPath)
+{
+    ShardLayout layout;
+    if (!ReadManifest(prefix, layout))
+    {
+        return 1;
+    }
+
+    const int k = layout.Params.OriginalCount;
+    const int blockBytes = layout.Params.BlockBytes;
+    const uint64_t stripeBytes = layout.StripeBytes();
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    bool success = true;
+    std::vector<MappedFile> shards(k);
+    for (int i = 0; i < k && success; ++i)
+    {
+        success = OpenMapped(shards[i], GetShardPath(prefix, i), false, 0);
+    }
+    MappedFile output;
+    success = success && OpenMapped(output, outputPath, true, layout.FileBytes);
+
+    for (uint64_t first = 0; first < layout.StripeCount && success; first += layout.WindowStripes)
+    {
+        uint64_t stripes = layout.StripeCount - first;
+        if (stripes > layout.WindowStripes)
+        {
+            stripes = layout.WindowStripes;
+        }
+
+        const uint64_t outputOffset = first * stripeBytes;
+        uint64_t outputBytes = layout.FileBytes - outputOffset;
+        if (outputBytes > stripes * stripeBytes)
+        {
+            outputBytes = stripes * stripeBytes;
+        }
+
+        success = MapWindow(output, outputOffset, (size_t)outputBytes);
+        for (MappedFile& shard : shards)
+        {
+            success = success && MapWindow(shard, first * blockBytes, (size_t)(stripes * blockBytes));
+        }
+
+        // Copy each block up to the end of the file, dropping the padding
+        for (uint64_t offset = 0; offset < outputBytes && success; offset += blockBytes)
+        {
+            const uint64_t block = offset / blockBytes;
+            uint64_t bytes = outputBytes - offset;
+            if (bytes > (uint64_t)blockBytes)
+            {
+                bytes = blockBytes;
+            }
+
+            memcpy(output.Data + offset,
+                shards[block % k].Data + (block / k) * blockBytes, (size_t)bytes);
+        }
+
+        UnmapWindow(output);
+        for (MappedFile& shard : shards)
+        {
+            UnmapWindow(shard);
+        }
+    }
+
+    CloseAll(shards);
+    if (!CloseMapped(output))
+    {
+        success = false;
+    }
+
+    if (!success)
+    {
+        fprintf(stderr, "join: failed\n");
+        return 1;
+    }
+
+    PrintThroughput("joined", layout.FileBytes, t0);
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Asynchronous Repair
+
+/*
+    The mmap repair leaves reads to page faults, so the thread alternates
+    between waiting on the disks and decoding.  On Linux the repair-async
+    command keeps a bounded number of stripes in flight through io_uring
+    instead, each going through three stages:
+
+        read the k surviving blocks -> decode -> write the rebuilt blocks
+
+    Every stripe in flight owns a slot of (k + missing) blocks in one page
+    aligned buffer pool, and a slot goes back to the pool once its writes
+    complete.  The slots are registered with the ring, so the requests use
+    the fixed-buffer opcodes and the kernel does not map and pin the pages
+    on every request.  While the calling thread decodes one slot, the reads
+    and writes queued for the other slots proceed in the kernel.
+
+    The shards are opened with O_DIRECT when the block size is a multiple
+    of kDirectAlignment and the filesystem allows it, so rebuilds do not
+    push everything else out of the page cache.
+
+    Decoding uses cm256_decode_into(), and a worker pool when requested.
+    If io_uring is not available, the command falls back to the mmap
+    repair.
+*/
+
+#if defined(__linux__)
+
+// Default number of stripes in flight
+static const int kDefaultStripesInFlight = 8;
+
+// Offsets and sizes required by O_DIRECT on common devices
+static const int kDirectAlignment = 4096;
+
+// Submission queue entries are capped, which caps the stripes in flight
+static const int kMaxRingEntries = 4096;
+
+struct IoRing
+{
+    int Fd = -1;
+
+    // Submission queue
+    void* SqRing = nullptr;
+    size_t SqRingBytes = 0;
+    unsigned* SqHead = nullptr;
+    unsigned* SqTail = nullptr;
+    unsigned* SqArray = nullptr;
+    unsigned SqMask = 0;
+    unsigned SqEntries = 0;
+    io_uring_sqe* Sqes = nullptr;
+    size_t SqesBytes = 0;
+
+    // Entries filled in, and entries handed to the kernel
+    unsigned LocalTail = 0;
+    unsigned SubmittedTail = 0;
+
+    // Completion queue, which may share the submission queue mapping
+    void* CqRing = nullptr;
+    size_t CqRingBytes = 0;
+    unsigned* CqHead = nullptr;
+    unsigned* CqTail = nullptr;
+    unsigned CqMask = 0;
+    io_uring_cqe* Cqes = nullptr;
+};
+
+static void IoRingDestroy(IoRing& ring)
+{
+    if (ring.Sqes)
+    {
+        munmap(ring.Sqes, ring.SqesBytes);
+    }
+    if (ring.CqRing && ring.CqRing != ring.SqRing)
+    {
+        munmap(ring.CqRing, ring.CqRingBytes);
+    }
+    if (ring.SqRing)
+    {
+        munmap(ring.SqRing, ring.SqRingBytes);
+    }
+    if (ring.Fd >= 0)
+    {
+        close(ring.Fd);
+    }
+    ring = IoRing();
+}
+
+static void* MapRing(const IoRing& ring, size_t bytes, off_t offset)
+{
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.Fd, offset);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// Returns false with errno set on failure
+static bool IoRingCreate(IoRing& ring, unsigned entries)
+{
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    ring.Fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (ring.Fd < 0)
+    {
+        return false;
+    }
+
+    ring.SqRingBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring.CqRingBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    ring.SqesBytes = p.sq_entries * sizeof(io_uring_sqe);
+
+    // Newer kernels map both queues with one call
+    const bool singleMap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+    {
+        if (ring.SqRingBytes < ring.CqRingBytes)
+        {
+            ring.SqRingBytes = ring.CqRingBytes;
+        }
+        ring.CqRingBytes = ring.SqRingBytes;
+    }
+
+    ring.SqRing = MapRing(ring, ring.SqRingBytes, IORING_OFF_SQ_RING);
+    ring.CqRing = singleMap ? ring.SqRing : MapRing(ring, ring.CqRingBytes, IORING_OFF_CQ_RING);
+    ring.Sqes = static_cast<io_uring_sqe*>(MapRing(ring, ring.SqesBytes, IORING_OFF_SQES));
+    if (!ring.SqRing || !ring.CqRing || !ring.Sqes)
+    {
+        const int error = errno;
+        IoRingDestroy(ring);
+        errno = error;
+        return false;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(ring.SqRing);
+    ring.SqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    ring.SqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    ring.SqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    ring.SqMask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    ring.SqEntries = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_entries);
+    ring.LocalTail = ring.SubmittedTail = *ring.SqTail;
+
+    uint8_t* cq = static_cast<uint8_t*>(ring.CqRing);
+    ring.CqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    ring.CqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    ring.CqMask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    ring.Cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    return true;
+}
+
+// Returns a cleared submission entry, or null if the queue is full
+static io_uring_sqe* IoRingGetSqe(IoRing& ring)
+{
+    const unsigned head = __atomic_load_n(ring.SqHead, __ATOMIC_ACQUIRE);
+    if (ring.LocalTail - head >= ring.SqEntries)
+    {
+        return nullptr;
+    }
+
+    const unsigned index = ring.LocalTail & ring.SqMask;
+    ring.SqArray[index] = index;
+    ++ring.LocalTail;
+
+    io_uring_sqe* sqe = ring.Sqes + index;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+// Hands the new entries to the kernel and waits for 'waitCount' completions
+static bool IoRingSubmit(IoRing& ring, unsigned waitCount)
+{
+    __atomic_store_n(ring.SqTail, ring.LocalTail, __ATOMIC_RELEASE);
+
+    for (;;)
+    {
+        const unsigned submitCount = ring.LocalTail - ring.SubmittedTail;
+        if (submitCount == 0 && waitCount == 0)
+        {
+            return true;
+        }
+
+        const int result = (int)syscall(__NR_io_uring_enter, ring.Fd, submitCount, waitCount,
+            waitCount ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        ring.SubmittedTail += (unsigned)result;
+        if (ring.SubmittedTail == ring.LocalTail)
+        {
+            return true;
+        }
+    }
+}
+
+// Returns the oldest completion, or null if there is none yet
+static io_uring_cqe* IoRingPeek(IoRing& ring)
+{
+    const unsigned head = *ring.CqHead;
+    if (head == __atomic_load_n(ring.CqTail, __ATOMIC_ACQUIRE))
+    {
+        return nullptr;
+    }
+    return ring.Cqes + (head & ring.CqMask);
+}
+
+static void IoRingAdvance(IoRing& ring)
+{
+    __atomic_store_n(ring.CqHead, *ring.CqHead + 1, __ATOMIC_RELEASE);
+}
+
+// Opens a shard with O_DIRECT where possible
+static int OpenShardDirect(const std::string& path, bool create, uint64_t bytes, bool direct)
+{
+    const int flags = create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+
+    int fd = -1;
+    if (direct)
+    {
+        fd = open(path.c_str(), flags | O_DIRECT, 0644);
+    }
+    if (fd < 0)
+    {
+        // Some filesystems, tmpfs among them, do not support O_DIRECT
+        fd = open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return -1;
+    }
+
+    if (create && ftruncate(fd, (off_t)bytes) != 0)
+    {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+enum class SlotState
+{
+    Free,
+    Reading,
+    Decoding,
+    Writing
+};
+
+struct RepairSlot
+{
+    SlotState State = SlotState::Free;
+    uint64_t Stripe = 0;
+
+    // Requests still in flight for the current stage
+    int Pending = 0;
+
+    // k source blocks followed by one block per missing shard
+    uint8_t* Blocks = nullptr;
+};
+
+static int RepairAsyncCommand(const std::string& prefix, int stripesInFlight, int workerCount)
+{
+    ShardLayout layout;
+    std::vector<int> present, missing;
+    if (!ReadManifest(prefix, layout) ||
+        !FindShards(prefix, layout, present, missing))
+    {
+        return 1;
+    }
+    if (missing.empty())
+    {
+        return 0;
+    }
+
+    const cm256_encoder_params& params = layout.Params;
+    const int k = params.OriginalCount;
+    const int blockBytes = params.BlockBytes;
+    const int missingCount = (int)missing.size();
+    const int slotBlocks = k + missingCount;
+
+    // A slot is either reading k blocks or writing the missing ones
+    const int requestsPerSlot = k > missingCount ? k : missingCount;
+    if (stripesInFlight > kMaxRingEntries / requestsPerSlot)
+    {
+        stripesInFlight = kMaxRingEntries / requestsPerSlot;
+    }
+    if ((uint64_t)stripesInFlight > layout.StripeCount)
+    {
+        stripesInFlight = (int)layout.StripeCount;
+    }
+    if (stripesInFlight < 1)
+    {
+        stripesInFlight = 1;
+    }
+
+    unsigned ringEntries = 1;
+    while (ringEntries < (unsigned)(stripesInFlight * requestsPerSlot))
+    {
+        ringEntries *= 2;
+    }
+
+    IoRing ring;
+    if (!IoRingCreate(ring, ringEntries))
+    {
+        fprintf(stderr, "repair-async: io_uring unavailable (%s), using mmap repair\n", strerror(errno));
+        return RepairCommand(prefix);
+    }
+
+    // Anonymous mappings are page aligned, as O_DIRECT requires
+    const size_t slotBytes = (size_t)slotBlocks * blockBytes;
+    const size_t poolBytes = slotBytes * stripesInFlight;
+    void* pool = mmap(nullptr, poolBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pool == MAP_FAILED)
+    {
+        fprintf(stderr, "repair-async: %s\n", strerror(errno));
+        IoRingDestroy(ring);
+        return 1;
+    }
+
+    std::vector<RepairSlot> slots(stripesInFlight);
+    std::vector<iovec> buffers(stripesInFlight);
+    for (int i = 0; i < stripesInFlight; ++i)
+    {
+        slots[i].Blocks = static_cast<uint8_t*>(pool) + i * slotBytes;
+        buffers[i].iov_base = slots[i].Blocks;
+        buffers[i].iov_len = slotBytes;
+    }
+
+    // Registration pins the pool, which RLIMIT_MEMLOCK may not allow
+    if (syscall(__NR_io_uring_register, ring.Fd, IORING_REGISTER_BUFFERS,
+        buffers.data(), (unsigned)stripesInFlight) != 0)
+    {
+        fprintf(stderr, "repair-async: cannot register buffers (%s), using mmap repair\n", strerror(errno));
+        munmap(pool, poolBytes);
+        IoRingDestroy(ring);
+        return RepairCommand(prefix);
+    }
+
+    cm256_encoder* encoder = cm256_encoder_create(params);
+    cm256_pool* workers = workerCount > 0 ? cm256_pool_create(workerCount) : nullptr;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    const bool direct = blockBytes % kDirectAlignment == 0;
+    std::vector<int> sourceFds(k, -1), rebuiltFds(missingCount, -1);
+    bool success = encoder != nullptr && (workerCount <= 0 || workers != nullptr);
+    for (int i = 0; i < k && success; ++i)
+    {
+        sourceFds[i] = OpenShardDirect(GetShardPath(prefix, present[i]), false, 0, direct);
+        success = sourceFds[i] >= 0;
+    }
+    for (int i = 0; i < missingCount && success; ++i)
+    {
+        rebuiltFds[i] = OpenShardDirect(GetShardPath(prefix, missing[i]), true, layout.ShardBytes(), direct);
+        success = rebuiltFds[i] >= 0;
+    }
+
+    bool dataMissing = false;
+    for (int index : missing)
+    {
+        if (index < k)
+        {
+            dataMissing = true;
+        }
+    }
+
+    cm256_block blocks[256], originals[256];
+    void* outputs[256];
+
+    // Slots whose reads are done, oldest first
+    std::vector<int> ready;
+    uint64_t nextStripe = 0, doneStripes = 0;
+    unsigned inFlight = 0;
+
+    while ((success && doneStripes < layout.StripeCount) || inFlight > 0)
+    {
+        // Start reading the next stripes into every free slot
+        for (int i = 0; i < stripesInFlight && success && nextStripe < layout.StripeCount; ++i)
+        {
+            RepairSlot& slot = slots[i];
+            if (slot.State != SlotState::Free)
+            {
+                continue;
+            }
+
+            slot.State = SlotState::Reading;
+            slot.Stripe = nextStripe++;
+            slot.Pending = k;
+
+            for (int j = 0; j < k; ++j)
+            {
+                io_uring_sqe* sqe = IoRingGetSqe(ring);
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->fd = sourceFds[j];
+                sqe->addr = (uint64_t)(uintptr_t)(slot.Blocks + (size_t)j * blockBytes);
+                sqe->len = blockBytes;
+                sqe->off = slot.Stripe * blockBytes;
+                sqe->buf_index = (uint16_t)i;
+                sqe->user_data = (uint64_t)i;
+                ++inFlight;
+            }
+        }
+
+        // Decode one stripe per pass, so completions are reaped in between
+        if (success && !ready.empty())
+        {
+            const int slotIndex = ready.front();
+            ready.erase(ready.begin());
+            RepairSlot& slot = slots[slotIndex];
+
+            for (int i = 0; i < k; ++i)
+            {
+                blocks[i].Block = slot.Blocks + (size_t)i * blockBytes;
+                blocks[i].Index = static_cast<unsigned char>(present[i]);
+                if (present[i] < k)
+                {
+                    originals[present[i]] = blocks[i];
+                }
+            }
+            for (int i = 0; i < missingCount; ++i)
+            {
+                const int index = missing[i];
+                if (index < k)
+                {
+                    outputs[index] = slot.Blocks + (size_t)(k + i) * blockBytes;
+                    originals[index].Block = outputs[index];
+                    originals[index].Index = static_cast<unsigned char>(index);
+                }
+            }
+
+            if (dataMissing && cm256_decode_into(params, blocks, outputs, workers) != 0)
+            {
+                fprintf(stderr, "repair-async: decode failed\n");
+                success = false;
+            }
+
+            for (int i = 0; i < missingCount && success; ++i)
+            {
+                uint8_t* block = slot.Blocks + (size_t)(k + i) * blockBytes;
+                if (missing[i] >= k)
+                {
+                    cm256_encoder_encode_block(encoder, originals, missing[i], block);
+                }
+
+                io_uring_sqe* sqe = IoRingGetSqe(ring);
+                sqe->opcode = IORING_OP_WRITE_FIXED;
+                sqe->fd = rebuiltFds[i];
+                sqe->addr = (uint64_t)(uintptr_t)block;
+                sqe->len = blockBytes;
+                sqe->off = slot.Stripe * blockBytes;
+                sqe->buf_index = (uint16_t)slotIndex;
+                sqe->user_data = (uint64_t)slotIndex;
+                ++inFlight;
+            }
+
+            slot.State = SlotState::Writing;
+            slot.Pending = missingCount;
+        }
+
+        // Block only when there is nothing left to decode
+        const bool wait = inFlight > 0 && (ready.empty() || !success);
+        if (!IoRingSubmit(ring, wait ? 1 : 0))
+        {
+            fprintf(stderr, "repair-async: io_uring_enter: %s\n", strerror(errno));
+            success = false;
+            break;
+        }
+
+        io_uring_cqe* cqe;
+        while ((cqe = IoRingPeek(ring)) != nullptr)
+        {
+            RepairSlot& slot = slots[(size_t)cqe->user_data];
+            const int result = cqe->res;
+            IoRingAdvance(ring);
+            --inFlight;
+
+            // Shards are regular files at their full size, so short
+            // transfers do not happen short of an error
+            if (result != blockBytes)
+            {
+                if (success)
+                {
+                    fprintf(stderr, "repair-async: %s of stripe %" PRIu64 " failed: %s\n",
+                        slot.State == SlotState::Reading ? "read" : "write", slot.Stripe,
+                        result < 0 ? strerror(-result) : "short transfer");
+                }
+                success = false;
+            }
+
+            if (--slot.Pending == 0)
+            {
+                if (slot.State == SlotState::Reading)
+                {
+                    slot.State = SlotState::Decoding;
+                    ready.push_back((int)(&slot - slots.data()));
+                }
+                else
+                {
+                    slot.State = SlotState::Free;
+                    ++doneStripes;
+                }
+            }
+        }
+    }
+
+    for (int fd : sourceFds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+    for (int fd : rebuiltFds)
+    {
+        if (fd >= 0 && close(fd) != 0)
+        {
+            success = false;
+        }
+    }
+
+    IoRingDestroy(ring);
+    munmap(pool, poolBytes);
+    cm256_pool_destroy(workers);
+    cm256_encoder_destroy(encoder);
+
+    if (!success)
+    {
+        fprintf(stderr, "repair-async: failed\n");
+        return 1;
+    }
+
+    for (int index : missing)
+    {
+        printf("rebuilt %s\n", GetShardPath(prefix, index).c_str());
+    }
+    PrintThroughput("repaired", layout.ShardBytes() * missing.size(), t0);
+    return 0;
+}
+
+#else // __linux__
+
+static const int kDefaultStripesInFlight = 8;
+
+// Without io_uring the command runs the mmap repair
+static int RepairAsyncCommand(const std::string& prefix, int, int)
+{
+    return RepairCommand(prefix);
+}
+
+#endif // __linux__
+
+
+//-----------------------------------------------------------------------------
+// Entrypoint
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+        "usage:\n"
+        "  cm256_shard encode <input> <prefix> <originalCount> <recoveryCount> [blockBytes]\n"
+        "  cm256_shard repair <prefix>\n"
+        "  cm256_shard repair-async <prefix> [stripesInFlight] [workerThreads]\n"
+        "  cm256_shard join <prefix> <output>\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (cm256_init())
+    {
+        fprintf(stderr, "cm256_init failed\n");
+        return 1;
+    }
+
+    const std::string command = argc >= 2 ? argv[1] : "";
+
+    if (command == "encode" && (argc == 6 || argc == 7))
+    {
+        const int blockBytes = argc == 7 ? atoi(argv[6]) : kDefaultBlockBytes;
+        return EncodeCommand(argv[2], argv[3], atoi(argv[4]), atoi(argv[5]), blockBytes);
+    }
+    if (command == "repair" && argc == 3)
+    {
+        return RepairCommand(argv[2]);
+    }
+    if (command == "repair-async" && argc >= 3 && argc <= 5)
+    {
+        const int stripesInFlight = argc >= 4 ? atoi(argv[3]) : kDefaultStripesInFlight;
+        const int workerCount = argc >= 5 ? atoi(argv[4]) : 0;
+        return RepairAsyncCommand(argv[2], stripesInFlight, workerCount);
+    }
+    if (command == "join" && argc == 4)
+    {
+        return JoinCommand(argv[2], argv[3]);
+    }
+
+    PrintUsage();
+    return 1;
+}
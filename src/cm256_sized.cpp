@@ -0,0 +1,586 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+#include "cm256_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <climits>
+
+
+//-----------------------------------------------------------------------------
+// Variable-Length Blocks
+
+/*
+    Each original is treated as zero past its length.  A byte offset of a
+    recovery block then only depends on the originals that reach it, so the
+    zero tails need not be read or multiplied.
+
+    The sources are sorted longest first and combined in groups of similar
+    length, each split into segments where one of its sources ends.  Short
+    segments cost more in kernel calls than they save in multiplies, so the
+    last partial segment of each source is copied into a zero-padded tail
+    and segments only end on multiples of kSizedSegmentBytes.  Originals of
+    one length skip all of this and are encoded as by cm256_encode().
+
+    The lengths go through the same code as a CM256_SIZED_TRAILER_BYTES
+    little-endian field after the data of each recovery block, so the
+    decoder recovers the length of each erased original along with it.
+*/
+
+// Segments are split on multiples of this, so that they are long enough for
+// the SIMD kernels even when many sources end close together
+static const int kSizedSegmentBytes = 256;
+
+// Sources that are zero past their lengths, sorted longest first.
+// The last partial segment of each source is copied into a zero-padded
+// tail, so each source can be read up to a multiple of kSizedSegmentBytes.
+struct SizedSources
+{
+    const uint8_t* Blocks[256];
+    int Bytes[256];
+
+    // Position of each source in the array it was added from
+    int Column[256];
+
+    // Offset of the tail of each source and the end of the tail
+    int TailOffset[256];
+    int PaddedBytes[256];
+    const uint8_t* Tails[256];
+
+    int Count;
+
+    // Sort the 'count' sources by length, longest first
+    void Sort(const void* const* blocks, const int* bytes, int count)
+    {
+        int order[256];
+        for (int i = 0; i < count; ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order, order + count, [bytes](int a, int b) {
+            return bytes[a] != bytes[b] ? bytes[a] > bytes[b] : a < b;
+        });
+
+        for (int i = 0; i < count; ++i)
+        {
+            Blocks[i] = static_cast<const uint8_t*>(blocks[order[i]]);
+            Bytes[i] = bytes[order[i]];
+            Column[i] = order[i];
+        }
+        Count = count;
+    }
+
+    // Copy the tails of the sources, before CombineSizedRange() reads them
+    void StageTails()
+    {
+        uint8_t* tails = GetThreadScratch(kScratchSizedTails, Count * kSizedSegmentBytes);
+
+        for (int i = 0; i < Count; ++i)
+        {
+            const int tailBytes = Bytes[i] % kSizedSegmentBytes;
+            TailOffset[i] = Bytes[i] - tailBytes;
+            PaddedBytes[i] = Bytes[i];
+            Tails[i] = nullptr;
+
+            if (tailBytes > 0)
+            {
+                uint8_t* tail = tails + i * kSizedSegmentBytes;
+                memset(tail, 0, kSizedSegmentBytes);
+                memcpy(tail, Blocks[i] + TailOffset[i], tailBytes);
+
+                PaddedBytes[i] = TailOffset[i] + kSizedSegmentBytes;
+                Tails[i] = tail;
+            }
+        }
+    }
+
+    // Returns source s at 'offset', which must be in one piece up to the
+    // next segment boundary
+    const uint8_t* At(int s, int offset) const
+    {
+        return offset >= TailOffset[s]
+            ? Tails[s] + (offset - TailOffset[s])
+            : Blocks[s] + offset;
+    }
+};
+
+// Sources combined per pass over the output, the widest group of the
+// multi-source kernels
+static const int kSizedGroupSources = 8;
+
+// z[] (+)= sum of y_s * x_s[] over one group of sources.
+// With null coefficients every coefficient is one.
+static void CombineSizedGroup(
+    uint8_t* z,
+    const uint8_t* coefficients,
+    const void* const* inBlocks,
+    int count,
+    int bytes,
+    bool set)
+{
+    if (coefficients)
+    {
+        if (set)
+        {
+            gf256_mul_multi_mem(z, coefficients, inBlocks, count, bytes);
+        }
+        else
+        {
+            gf256_muladd_multi_mem(z, coefficients, inBlocks, count, bytes);
+        }
+        return;
+    }
+
+    // Parity of the sources
+    int s = 0;
+    if (set)
+    {
+        if (count == 1)
+        {
+            memcpy(z, inBlocks[0], bytes);
+            return;
+        }
+        gf256_addset_mem(z, inBlocks[0], inBlocks[1], bytes);
+        s = 2;
+    }
+    for (; s < count; ++s)
+    {
+        gf256_add_mem(z, inBlocks[s], bytes);
+    }
+}
+
+// Sets the byte range [begin, end) to the sum of y_s * x_s[] over the
+// sources, reading each source only up to its padded length.  'z' points at
+// byte 'begin' of the output.  With null coefficients every coefficient is one.
+//
+// The sources are taken in groups of similar length, and each group is
+// split into segments where one of its own sources ends.  This keeps the
+// segments long and few, which matters more for short blocks than the
+// multiplies saved by splitting everywhere a source ends.
+static void CombineSizedRange(
+    uint8_t* z,
+    const uint8_t* coefficients,
+    const SizedSources& sources,
+    int begin,
+    int end)
+{
+    // Bytes past the longest source are zero
+    const int longest = sources.Count > 0 ? std::max(begin, std::min(end, sources.PaddedBytes[0])) : begin;
+    if (longest < end)
+    {
+        memset(z + (longest - begin), 0, end - longest);
+    }
+
+    for (int first = 0; first < sources.Count; first += kSizedGroupSources)
+    {
+        const int groupCount = std::min(kSizedGroupSources, sources.Count - first);
+        const int groupEnd = std::min(end, sources.PaddedBytes[first]);
+
+        // The first group sets the output and the others accumulate
+        const bool set = (first == 0);
+
+        int count = groupCount;
+        for (int offset = begin; offset < groupEnd;)
+        {
+            // Drop the sources that end before this segment
+            while (sources.PaddedBytes[first + count - 1] <= offset)
+            {
+                --count;
+            }
+
+            // The segment runs until the shortest remaining source ends, or
+            // until one of the sources switches to its tail
+            int segmentEnd = std::min(groupEnd, sources.PaddedBytes[first + count - 1]);
+            const void* inBlocks[kSizedGroupSources];
+            for (int s = 0; s < count; ++s)
+            {
+                const int tailOffset = sources.TailOffset[first + s];
+                if (tailOffset > offset && tailOffset < segmentEnd)
+                {
+                    segmentEnd = tailOffset;
+                }
+                inBlocks[s] = sources.At(first + s, offset);
+            }
+            const int bytes = segmentEnd - offset;
+
+            CombineSizedGroup(z + (offset - begin), coefficients ? coefficients + first : nullptr,
+                inBlocks, count, bytes, set);
+
+            offset = segmentEnd;
+        }
+    }
+}
+
+// Returns the sum of y_s * value_s in each byte of the length field.
+// With null coefficients every coefficient is one.
+static uint32_t CombineSizedLengths(const uint8_t* coefficients, const uint32_t* values, int count)
+{
+    // Only the low bytes of the values can be non-zero
+    uint32_t any = 0;
+    for (int s = 0; s < count; ++s)
+    {
+        any |= values[s];
+    }
+
+    uint32_t result = 0;
+    for (int b = 0; b < CM256_SIZED_TRAILER_BYTES && (any >> (b * 8)) != 0; ++b)
+    {
+        const int shift = b * 8;
+
+        uint8_t sum = 0;
+        for (int s = 0; s < count; ++s)
+        {
+            const uint8_t value = static_cast<uint8_t>(values[s] >> shift);
+            sum = gf256_add(sum, coefficients ? gf256_mul(coefficients[s], value) : value);
+        }
+        result |= static_cast<uint32_t>(sum) << shift;
+    }
+    return result;
+}
+
+static void WriteSizedTrailer(uint8_t* trailer, uint32_t value)
+{
+    for (int b = 0; b < CM256_SIZED_TRAILER_BYTES; ++b)
+    {
+        trailer[b] = static_cast<uint8_t>(value >> (b * 8));
+    }
+}
+
+static uint32_t ReadSizedTrailer(const uint8_t* trailer)
+{
+    uint32_t value = 0;
+    for (int b = 0; b < CM256_SIZED_TRAILER_BYTES; ++b)
+    {
+        value |= static_cast<uint32_t>(trailer[b]) << (b * 8);
+    }
+    return value;
+}
+
+extern "C" int cm256_encode_sized(
+    cm256_encoder_params params,         // Encoder params
+    const cm256_sized_block* originals,  // Array of original blocks
+    void* recoveryBlocks,                // Output recovery blocks end-to-end
+    int* recoveryBytes)                  // Set to the length of each recovery block
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.BlockBytes > INT_MAX - CM256_SIZED_TRAILER_BYTES)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks || !recoveryBytes)
+    {
+        return -3;
+    }
+
+    const void* blocks[256];
+    int bytes[256];
+    uint32_t lengths[256];
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        if (originals[j].Bytes < 0 || originals[j].Bytes > params.BlockBytes)
+        {
+            return -1;
+        }
+        blocks[j] = originals[j].Block;
+        bytes[j] = originals[j].Bytes;
+    }
+
+    SizedSources sources;
+    sources.Sort(blocks, bytes, params.OriginalCount);
+    for (int s = 0; s < sources.Count; ++s)
+    {
+        lengths[s] = static_cast<uint32_t>(sources.Bytes[s]);
+    }
+
+    // Recovery blocks are as long as the longest original
+    const int dataBytes = sources.Bytes[0];
+    const int stride = cm256_sized_recovery_bytes(params.BlockBytes);
+    uint8_t* recoveryData = static_cast<uint8_t*>(recoveryBlocks);
+
+    // Matrix rows 1..m-1 in the sorted order of the sources.  Row 0 is all
+    // ones, and with one original every row copies it as cm256_encode() does.
+    static const int StackAllocSize = 2048;
+    uint8_t stackMatrix[StackAllocSize];
+    uint8_t* matrix = stackMatrix;
+    const int requiredSpace = (params.RecoveryCount - 1) * params.OriginalCount;
+    if (requiredSpace > StackAllocSize)
+    {
+        matrix = GetThreadScratch(kScratchCoefficients, requiredSpace);
+    }
+
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+    const uint8_t* rows[256];
+    for (int block = 0; block < params.RecoveryCount; ++block)
+    {
+        rows[block] = nullptr;
+        if (block == 0 || params.OriginalCount == 1)
+        {
+            continue;
+        }
+
+        const uint8_t x_i = static_cast<uint8_t>(params.OriginalCount + block);
+        uint8_t* row = matrix + (block - 1) * params.OriginalCount;
+        for (int s = 0; s < sources.Count; ++s)
+        {
+            row[s] = GetMatrixElement(x_i, x_0, static_cast<uint8_t>(sources.Column[s]));
+        }
+        rows[block] = row;
+    }
+
+    // When every original has the same length there is nothing to skip, so
+    // they are encoded as cm256_encode() does
+    const bool sameLength = (sources.Bytes[sources.Count - 1] == dataBytes);
+    cm256_block sameBlocks[256];
+    if (sameLength)
+    {
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            sameBlocks[j].Block = originals[j].Block;
+            sameBlocks[j].Index = static_cast<unsigned char>(j);
+        }
+    }
+    else
+    {
+        sources.StageTails();
+    }
+
+    // Produce each tile of every recovery block while the originals are in cache
+    const int tileBytes = GetEncodeTileBytes(params);
+    for (int offset = 0; offset < dataBytes; offset += tileBytes)
+    {
+        const int end = std::min(dataBytes, offset + tileBytes);
+
+        uint8_t* recoveryBlock = recoveryData + offset;
+        for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += stride)
+        {
+            if (sameLength)
+            {
+                EncodeBlockRange(params, sameBlocks, params.OriginalCount + block,
+                    recoveryBlock, offset, end - offset, nullptr);
+            }
+            else
+            {
+                CombineSizedRange(recoveryBlock, rows[block], sources, offset, end);
+            }
+        }
+    }
+
+    uint8_t* recoveryBlock = recoveryData;
+    for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += stride)
+    {
+        WriteSizedTrailer(recoveryBlock + dataBytes,
+            CombineSizedLengths(rows[block], lengths, sources.Count));
+    }
+
+    *recoveryBytes = cm256_sized_recovery_bytes(dataBytes);
+    return 0;
+}
+
+extern "C" int cm256_decode_sized(
+    cm256_encoder_params params, // Encoder params
+    cm256_sized_block* blocks)   // Array of 'originalCount' blocks as described above
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.BlockBytes > INT_MAX - CM256_SIZED_TRAILER_BYTES)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+
+    cm256_block indexBlocks[256];
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        indexBlocks[ii].Block = blocks[ii].Block;
+        indexBlocks[ii].Index = blocks[ii].Index;
+    }
+
+    CM256Decoder state;
+    if (!state.Initialize(params, indexBlocks))
+    {
+        return -5;
+    }
+
+    const int N = state.RecoveryCount;
+    if (N <= 0)
+    {
+        return 0;
+    }
+
+    // Every received recovery block has the same length
+    cm256_sized_block* recovery[256];
+    for (int i = 0; i < N; ++i)
+    {
+        recovery[i] = blocks + (state.Recovery[i] - indexBlocks);
+    }
+    const int recoveryBytes = recovery[0]->Bytes;
+    const int dataBytes = recoveryBytes - CM256_SIZED_TRAILER_BYTES;
+    if (dataBytes < 0 || dataBytes > params.BlockBytes)
+    {
+        return -1;
+    }
+
+    // Sources are the originals in Original[] order followed by Recovery[]
+    const void* sourceBlocks[256];
+    int sourceBytes[256];
+    for (int j = 0; j < state.OriginalCount; ++j)
+    {
+        const cm256_sized_block& original = blocks[state.Original[j] - indexBlocks];
+        if (original.Bytes < 0 || original.Bytes > params.BlockBytes)
+        {
+            return -1;
+        }
+        sourceBlocks[j] = original.Block;
+        sourceBytes[j] = original.Bytes;
+    }
+    for (int i = 0; i < N; ++i)
+    {
+        if (recovery[i]->Bytes != recoveryBytes)
+        {
+            return -1;
+        }
+        sourceBlocks[state.OriginalCount + i] = recovery[i]->Block;
+        sourceBytes[state.OriginalCount + i] = dataBytes;
+    }
+
+    const int sourceCount = params.OriginalCount;
+    SizedSources sources;
+    sources.Sort(sourceBlocks, sourceBytes, sourceCount);
+    sources.StageTails();
+
+    uint32_t lengths[256];
+    for (int s = 0; s < sourceCount; ++s)
+    {
+        const int column = sources.Column[s];
+        lengths[s] = column < state.OriginalCount
+            ? static_cast<uint32_t>(sourceBytes[column])
+            : ReadSizedTrailer(static_cast<const uint8_t*>(sourceBlocks[column]) + dataBytes);
+    }
+
+    // Allocate coefficients, one row of sources per erased original
+    static const int StackAllocSize = 2048;
+    uint8_t stackCoefficients[StackAllocSize];
+    uint8_t* coefficients = stackCoefficients;
+    const int requiredSpace = N * sourceCount;
+    if (requiredSpace > StackAllocSize)
+    {
+        coefficients = GetThreadScratch(kScratchCoefficients, requiredSpace);
+    }
+
+    // With one original every block is a copy of it, and otherwise each
+    // erased original is one row of the inverse applied to the sources
+    uint8_t* rows[256];
+    uint32_t outputLengths[256];
+    if (params.OriginalCount == 1)
+    {
+        rows[0] = nullptr;
+        outputLengths[0] = CombineSizedLengths(nullptr, lengths, 1);
+    }
+    else
+    {
+        uint8_t P[256], Dx[256];
+        GetPartialDecodeProducts(state, P, Dx);
+
+        uint8_t row[256];
+        for (int t = 0; t < N; ++t)
+        {
+            GetPartialDecodeRow(state, P, Dx, t, row);
+
+            rows[t] = coefficients + t * sourceCount;
+            for (int s = 0; s < sourceCount; ++s)
+            {
+                rows[t][s] = row[sources.Column[s]];
+            }
+
+            outputLengths[t] = CombineSizedLengths(rows[t], lengths, sourceCount);
+        }
+    }
+
+    // A recovered length that does not fit means the blocks do not belong together
+    int outputBytes[256];
+    int longestOutput = 0;
+    for (int t = 0; t < N; ++t)
+    {
+        if (outputLengths[t] > static_cast<uint32_t>(dataBytes))
+        {
+            return -1;
+        }
+        outputBytes[t] = static_cast<int>(outputLengths[t]);
+        longestOutput = std::max(longestOutput, outputBytes[t]);
+    }
+
+    // The recovery blocks are also sources, so each tile of every output is
+    // built in scratch before any of them is overwritten
+    const int tileBytes = GetEncodeTileBytes(params);
+    uint8_t* scratch = GetThreadScratch(kScratchTile, N * tileBytes);
+
+    for (int offset = 0; offset < longestOutput; offset += tileBytes)
+    {
+        for (int t = 0; t < N; ++t)
+        {
+            const int end = std::min(outputBytes[t], offset + tileBytes);
+            if (end > offset)
+            {
+                CombineSizedRange(scratch + t * tileBytes, rows[t], sources, offset, end);
+            }
+        }
+        for (int t = 0; t < N; ++t)
+        {
+            const int end = std::min(outputBytes[t], offset + tileBytes);
+            if (end > offset)
+            {
+                memcpy(static_cast<uint8_t*>(recovery[t]->Block) + offset, scratch + t * tileBytes, end - offset);
+            }
+        }
+    }
+
+    // Recovery blocks now hold the originals
+    for (int t = 0; t < N; ++t)
+    {
+        recovery[t]->Index = state.ErasuresIndices[t];
+        recovery[t]->Bytes = outputBytes[t];
+    }
+
+    return 0;
+}
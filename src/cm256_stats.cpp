@@ -0,0 +1,284 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256_stats.h"
+
+#include <cstring>
+
+#if defined(CM256_ENABLE_STATS)
+    #include <mutex>
+    #include <vector>
+    #include <chrono>
+    #include <algorithm>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Names
+
+static const char* const kPhaseNames[CM256_PHASE_COUNT] = {
+    "encode",
+    "decode",
+    "decode_m1",
+    "coefficients",
+    "ldu",
+    "eliminate_originals",
+    "eliminate_l",
+    "eliminate_d",
+    "eliminate_u",
+};
+
+static const char* const kKernelNames[CM256_KERNEL_COUNT] = {
+    "add",
+    "add2",
+    "addset",
+    "mul",
+    "muladd",
+    "muladd_multi",
+};
+
+// Same names as gf256_kernels_name()
+static const char* const kIsaNames[CM256_ISA_COUNT] = {
+    "Portable",
+    "SSSE3",
+    "AVX2",
+    "AVX512BW",
+    "GFNI",
+    "NEON",
+    "SVE2",
+};
+
+extern "C" const char* cm256_stats_phase_name(int phase)
+{
+    return (phase >= 0 && phase < CM256_PHASE_COUNT) ? kPhaseNames[phase] : "unknown";
+}
+
+extern "C" const char* cm256_stats_kernel_name(int kernel)
+{
+    return (kernel >= 0 && kernel < CM256_KERNEL_COUNT) ? kKernelNames[kernel] : "unknown";
+}
+
+extern "C" const char* cm256_stats_isa_name(int isa)
+{
+    return (isa >= 0 && isa < CM256_ISA_COUNT) ? kIsaNames[isa] : "unknown";
+}
+
+static int GetSelectedIsa()
+{
+    const char* name = gf256_kernels_name();
+    for (int isa = 0; isa < CM256_ISA_COUNT; ++isa)
+    {
+        if (strcmp(name, kIsaNames[isa]) == 0)
+        {
+            return isa;
+        }
+    }
+    return CM256_ISA_PORTABLE;
+}
+
+
+#if defined(CM256_ENABLE_STATS)
+
+//-----------------------------------------------------------------------------
+// Thread Registry
+
+/*
+    Each thread allocates its counters on first use and adds them to the
+    registry.  When the thread exits its counts are folded into Retired, so
+    work done on short-lived threads is not lost.
+
+    A reset does not touch the counters, which only their owner writes.  It
+    records the current totals as a baseline that later reads subtract.
+*/
+
+struct StatsRegistry
+{
+    std::mutex Lock;
+    std::vector<CM256ThreadStats*> Threads;
+
+    // Counts of threads that have exited
+    uint64_t Retired[kStatsCounterCount];
+
+    // Totals at the last reset
+    uint64_t Baseline[kStatsCounterCount];
+
+    // For measuring the tick rate
+    uint64_t StartTicks;
+    std::chrono::steady_clock::time_point StartTime;
+
+    StatsRegistry()
+    {
+        memset(Retired, 0, sizeof(Retired));
+        memset(Baseline, 0, sizeof(Baseline));
+        StartTicks = cm256_stats_ticks();
+        StartTime = std::chrono::steady_clock::now();
+    }
+
+    // Requires Lock
+    void Sum(uint64_t* totals) const
+    {
+        memcpy(totals, Retired, sizeof(Retired));
+        for (const CM256ThreadStats* stats : Threads)
+        {
+            for (int i = 0; i < kStatsCounterCount; ++i)
+            {
+                totals[i] += stats->Counters[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+static StatsRegistry& GetRegistry()
+{
+    static StatsRegistry registry;
+    return registry;
+}
+
+struct ThreadStatsOwner
+{
+    CM256ThreadStats* Stats = nullptr;
+
+    ~ThreadStatsOwner()
+    {
+        if (!Stats)
+        {
+            return;
+        }
+
+        StatsRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> locker(registry.Lock);
+
+        for (int i = 0; i < kStatsCounterCount; ++i)
+        {
+            registry.Retired[i] += Stats->Counters[i].load(std::memory_order_relaxed);
+        }
+        registry.Threads.erase(std::remove(registry.Threads.begin(), registry.Threads.end(), Stats),
+            registry.Threads.end());
+
+        delete Stats;
+    }
+};
+
+static thread_local ThreadStatsOwner ThisThreadStats;
+
+CM256ThreadStats* cm256_thread_stats()
+{
+    CM256ThreadStats* stats = ThisThreadStats.Stats;
+    if (stats)
+    {
+        return stats;
+    }
+
+    stats = new CM256ThreadStats;
+    for (int i = 0; i < kStatsCounterCount; ++i)
+    {
+        stats->Counters[i].store(0, std::memory_order_relaxed);
+    }
+
+    StatsRegistry& registry = GetRegistry();
+    {
+        std::lock_guard<std::mutex> locker(registry.Lock);
+        registry.Threads.push_back(stats);
+    }
+
+    ThisThreadStats.Stats = stats;
+    return stats;
+}
+
+#endif // CM256_ENABLE_STATS
+
+
+//-----------------------------------------------------------------------------
+// API
+
+extern "C" int cm256_get_stats(cm256_stats* stats)
+{
+    if (!stats)
+    {
+        return -3;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->SelectedIsa = GetSelectedIsa();
+
+#if defined(CM256_ENABLE_STATS)
+    stats->Enabled = 1;
+
+    StatsRegistry& registry = GetRegistry();
+    uint64_t totals[kStatsCounterCount];
+    {
+        std::lock_guard<std::mutex> locker(registry.Lock);
+        registry.Sum(totals);
+        for (int i = 0; i < kStatsCounterCount; ++i)
+        {
+            totals[i] -= registry.Baseline[i];
+        }
+    }
+
+    for (int phase = 0; phase < CM256_PHASE_COUNT; ++phase)
+    {
+        const uint64_t* counters = totals + kStatsPhaseBase + phase * 2;
+        stats->Phases[phase].Calls = counters[0];
+        stats->Phases[phase].Ticks = counters[1];
+    }
+    for (int isa = 0; isa < CM256_ISA_COUNT; ++isa)
+    {
+        for (int kernel = 0; kernel < CM256_KERNEL_COUNT; ++kernel)
+        {
+            const uint64_t* counters = totals + kStatsKernelBase + (isa * CM256_KERNEL_COUNT + kernel) * 3;
+            stats->Kernels[isa][kernel].Calls = counters[0];
+            stats->Kernels[isa][kernel].Bytes = counters[1];
+            stats->Kernels[isa][kernel].Ticks = counters[2];
+        }
+    }
+
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+    // The TSC rate is measured against steady_clock since the registry
+    // was created, once enough time has passed for it to be accurate
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - registry.StartTime).count();
+    if (seconds >= 0.001)
+    {
+        stats->TicksPerSecond = (cm256_stats_ticks() - registry.StartTicks) / seconds;
+    }
+#else
+    stats->TicksPerSecond = 1e9;
+#endif
+#endif // CM256_ENABLE_STATS
+
+    return 0;
+}
+
+extern "C" void cm256_reset_stats()
+{
+#if defined(CM256_ENABLE_STATS)
+    StatsRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> locker(registry.Lock);
+    registry.Sum(registry.Baseline);
+#endif // CM256_ENABLE_STATS
+}
@@ -0,0 +1,143 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_STATS_H
+#define CM256_STATS_H
+
+/*
+    Statistics Counters (internal)
+
+    CM256_STATS_PHASE(phase) and CM256_STATS_KERNEL(isa, kernel, bytes)
+    time the rest of the enclosing scope and add it to the counters of the
+    calling thread.  Without CM256_ENABLE_STATS they expand to nothing.
+
+    Each thread owns its counters, so counting never contends.  The owner
+    only does relaxed loads and stores, which compile to plain moves; the
+    atomics are there so that cm256_get_stats() may read them from another
+    thread.
+*/
+
+#include "cm256.h"
+
+#if defined(CM256_ENABLE_STATS)
+
+#include <atomic>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+    #include <x86intrin.h>
+#else
+    #include <chrono>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Counters
+
+// Calls and ticks per phase, then calls, bytes and ticks per kernel and ISA
+static const int kStatsPhaseBase = 0;
+static const int kStatsKernelBase = CM256_PHASE_COUNT * 2;
+static const int kStatsCounterCount = kStatsKernelBase + CM256_ISA_COUNT * CM256_KERNEL_COUNT * 3;
+
+struct CM256ThreadStats
+{
+    std::atomic<uint64_t> Counters[kStatsCounterCount];
+};
+
+/// Returns the counters of the calling thread, registering them on first use
+extern CM256ThreadStats* cm256_thread_stats();
+
+static inline uint64_t cm256_stats_ticks()
+{
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static inline void cm256_stats_add(CM256ThreadStats* stats, int counter, uint64_t value)
+{
+    std::atomic<uint64_t>& c = stats->Counters[counter];
+    c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/// Adds the ticks from construction to destruction to a calls/ticks pair
+/// of counters, plus an optional byte count
+class CM256StatsScope
+{
+public:
+    CM256StatsScope(int counter, uint64_t bytes)
+        : Counter(counter)
+        , Bytes(bytes)
+        , Start(cm256_stats_ticks())
+    {
+    }
+    ~CM256StatsScope()
+    {
+        const uint64_t ticks = cm256_stats_ticks() - Start;
+        CM256ThreadStats* stats = cm256_thread_stats();
+        cm256_stats_add(stats, Counter, 1);
+        if (Counter >= kStatsKernelBase)
+        {
+            cm256_stats_add(stats, Counter + 1, Bytes);
+            cm256_stats_add(stats, Counter + 2, ticks);
+        }
+        else
+        {
+            cm256_stats_add(stats, Counter + 1, ticks);
+        }
+    }
+
+private:
+    const int Counter;
+    const uint64_t Bytes;
+    const uint64_t Start;
+};
+
+#define CM256_STATS_CONCAT2(a, b) a##b
+#define CM256_STATS_CONCAT(a, b) CM256_STATS_CONCAT2(a, b)
+
+#define CM256_STATS_PHASE(phase) \
+    CM256StatsScope CM256_STATS_CONCAT(cm256StatsScope, __LINE__)( \
+        kStatsPhaseBase + (phase) * 2, 0)
+
+#define CM256_STATS_KERNEL(isa, kernel, bytes) \
+    CM256StatsScope CM256_STATS_CONCAT(cm256StatsScope, __LINE__)( \
+        kStatsKernelBase + ((isa) * CM256_KERNEL_COUNT + (kernel)) * 3, (uint64_t)(bytes))
+
+#else // CM256_ENABLE_STATS
+
+#define CM256_STATS_PHASE(phase)
+#define CM256_STATS_KERNEL(isa, kernel, bytes)
+
+#endif // CM256_ENABLE_STATS
+
+#endif // CM256_STATS_H
@@ -0,0 +1,629 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+#include "cm256_codec.h"
+
+#include <new>
+#include <cstring>
+
+
+//-----------------------------------------------------------------------------
+// Streaming Encoder
+
+/*
+    Every recovery block is a sum over the original blocks, so each original
+    can be folded into all of the recovery blocks as soon as it arrives.  The
+    first original pushed sets the accumulators and the rest add to them, so
+    the originals may arrive in any order.
+
+    Each push reads one original and updates every accumulator, so it is
+    tiled over one original block plus the recovery blocks.
+*/
+
+struct cm256_stream_encoder_t
+{
+    cm256_encoder_params Params;
+
+    // RecoveryCount accumulators end-to-end
+    uint8_t* RecoveryData;
+
+    // Number of originals pushed so far
+    int PushedCount;
+
+    // Pushed[j] is set once original j has been pushed
+    bool Pushed[256];
+};
+
+extern "C" cm256_stream_encoder* cm256_stream_encoder_create(cm256_encoder_params params)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return nullptr;
+    }
+
+    cm256_stream_encoder* encoder = new (std::nothrow) cm256_stream_encoder;
+    if (!encoder)
+    {
+        return nullptr;
+    }
+    encoder->Params = params;
+
+    encoder->RecoveryData = new (std::nothrow) uint8_t[params.RecoveryCount * params.BlockBytes];
+    if (!encoder->RecoveryData)
+    {
+        delete encoder;
+        return nullptr;
+    }
+
+    cm256_stream_encoder_reset(encoder);
+    return encoder;
+}
+
+extern "C" void cm256_stream_encoder_destroy(cm256_stream_encoder* encoder)
+{
+    if (encoder)
+    {
+        delete[] encoder->RecoveryData;
+        delete encoder;
+    }
+}
+
+extern "C" void cm256_stream_encoder_reset(cm256_stream_encoder* encoder)
+{
+    encoder->PushedCount = 0;
+    memset(encoder->Pushed, 0, sizeof(encoder->Pushed));
+}
+
+// Fold the byte range [begin, begin + rangeBytes) of an original into the
+// accumulators, where 'data' points to the start of the range
+static void StreamEncodeRange(
+    cm256_stream_encoder* encoder,
+    int originalIndex,
+    const uint8_t* data,
+    int begin,
+    int rangeBytes)
+{
+    const cm256_encoder_params& params = encoder->Params;
+
+    // The first original sets the accumulators
+    const bool first = (encoder->PushedCount == 0);
+
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+    const uint8_t y_j = static_cast<uint8_t>(originalIndex);
+
+    cm256_encoder_params tileParams = params;
+    tileParams.OriginalCount = 1;
+    const int tileBytes = GetEncodeTileBytes(tileParams);
+
+    const int end = begin + rangeBytes;
+
+    // For each tile of the range,
+    for (int offset = begin; offset < end; offset += tileBytes)
+    {
+        int bytes = end - offset;
+        if (bytes > tileBytes)
+        {
+            bytes = tileBytes;
+        }
+
+        const uint8_t* inBlock = data + (offset - begin);
+        uint8_t* recoveryBlock = encoder->RecoveryData + offset;
+
+        for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += params.BlockBytes)
+        {
+            // One original block is just copied, and row 0 is all ones
+            if (params.OriginalCount == 1 || block == 0)
+            {
+                if (first)
+                {
+                    memcpy(recoveryBlock, inBlock, bytes);
+                }
+                else
+                {
+                    gf256_add_mem(recoveryBlock, inBlock, bytes);
+                }
+                continue;
+            }
+
+            const uint8_t x_i = static_cast<uint8_t>(params.OriginalCount + block);
+            const uint8_t y = GetMatrixElement(x_i, x_0, y_j);
+
+            if (first)
+            {
+                gf256_mul_mem(recoveryBlock, inBlock, y, bytes);
+            }
+            else
+            {
+                gf256_muladd_mem(recoveryBlock, y, inBlock, bytes);
+            }
+        }
+    }
+}
+
+extern "C" int cm256_stream_encoder_push(
+    cm256_stream_encoder* encoder, // Encoder from cm256_stream_encoder_create()
+    int originalIndex,             // Return value from cm256_get_original_block_index()
+    const void* originalBlock)     // Original block data
+{
+    if (!encoder || !originalBlock)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = encoder->Params;
+    if (originalIndex < 0 || originalIndex >= params.OriginalCount)
+    {
+        return -1;
+    }
+    if (encoder->Pushed[originalIndex])
+    {
+        return -2;
+    }
+
+    StreamEncodeRange(encoder, originalIndex, static_cast<const uint8_t*>(originalBlock), 0, params.BlockBytes);
+
+    encoder->Pushed[originalIndex] = true;
+    ++encoder->PushedCount;
+    return 0;
+}
+
+// The kernels here take one source at a time, so each segment is folded in
+// where it lies with no gathering
+extern "C" int cm256_stream_encoder_push_sg(
+    cm256_stream_encoder* encoder, // Encoder from cm256_stream_encoder_create()
+    int originalIndex,             // Return value from cm256_get_original_block_index()
+    const cm256_iovec* segments,   // Array of segments of the original block
+    int segmentCount)              // Number of segments
+{
+    if (!encoder)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = encoder->Params;
+
+    cm256_sg_block block;
+    block.Segments = segments;
+    block.SegmentCount = segmentCount;
+    block.Index = 0;
+    const int result = ValidateSgBlock(block, params.BlockBytes);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    if (originalIndex < 0 || originalIndex >= params.OriginalCount)
+    {
+        return -1;
+    }
+    if (encoder->Pushed[originalIndex])
+    {
+        return -2;
+    }
+
+    int offset = 0;
+    for (int s = 0; s < segmentCount; ++s)
+    {
+        if (segments[s].Bytes > 0)
+        {
+            StreamEncodeRange(encoder, originalIndex, static_cast<const uint8_t*>(segments[s].Base),
+                offset, segments[s].Bytes);
+            offset += segments[s].Bytes;
+        }
+    }
+
+    encoder->Pushed[originalIndex] = true;
+    ++encoder->PushedCount;
+    return 0;
+}
+
+extern "C" int cm256_stream_encoder_flush(
+    cm256_stream_encoder* encoder, // Encoder from cm256_stream_encoder_create()
+    void* recoveryBlocks)          // Output recovery blocks end-to-end
+{
+    if (!encoder || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = encoder->Params;
+    if (encoder->PushedCount < params.OriginalCount)
+    {
+        return -4;
+    }
+
+    memcpy(recoveryBlocks, encoder->RecoveryData, params.RecoveryCount * params.BlockBytes);
+
+    cm256_stream_encoder_reset(encoder);
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Streaming Decoder
+
+/*
+    The original data is eliminated from a recovery block with one multiply
+    per original, which does not depend on the other blocks received.  So
+    this is done as blocks arrive: an original is eliminated from the
+    recovery blocks received so far, and a recovery block has the originals
+    received so far eliminated from it.  Once k blocks are in, only the NxN
+    solve for the erased originals is left.
+*/
+
+struct cm256_stream_decoder_t
+{
+    cm256_encoder_params Params;
+
+    // Original blocks received so far
+    cm256_block* Original[256];
+    int OriginalCount;
+
+    // OriginalSg[j] is the scatter-gather block behind Original[j], or null
+    // if it is contiguous.  Those Original[] entries point into SgIndexBlocks,
+    // which only hold their indices for the final solve.
+    const cm256_sg_block* OriginalSg[256];
+    cm256_block SgIndexBlocks[256];
+    int SgOriginalCount;
+
+    // Recovery blocks received so far
+    cm256_block* Recovery[256];
+    int RecoveryCount;
+
+    // Received[i] is set once block index i has been pushed
+    bool Received[256];
+
+    // Set once all of the originals are recovered
+    bool Complete;
+
+    // Storage for the coefficients of the final solve
+    uint8_t* Coefficients;
+
+    // Decoder for the final solve
+    CM256Decoder Decoder;
+};
+
+extern "C" cm256_stream_decoder* cm256_stream_decoder_create(cm256_encoder_params params)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return nullptr;
+    }
+
+    cm256_stream_decoder* decoder = new (std::nothrow) cm256_stream_decoder;
+    if (!decoder)
+    {
+        return nullptr;
+    }
+    decoder->Params = params;
+
+    // Room for the largest solve, done when every recovery block is used
+    int N = params.RecoveryCount;
+    if (N > params.OriginalCount)
+    {
+        N = params.OriginalCount;
+    }
+    decoder->Coefficients = new (std::nothrow) uint8_t[N * N * 2 + N * params.OriginalCount];
+    if (!decoder->Coefficients)
+    {
+        delete decoder;
+        return nullptr;
+    }
+
+    cm256_stream_decoder_reset(decoder);
+    return decoder;
+}
+
+extern "C" void cm256_stream_decoder_destroy(cm256_stream_decoder* decoder)
+{
+    if (decoder)
+    {
+        delete[] decoder->Coefficients;
+        delete decoder;
+    }
+}
+
+extern "C" void cm256_stream_decoder_reset(cm256_stream_decoder* decoder)
+{
+    decoder->OriginalCount = 0;
+    decoder->RecoveryCount = 0;
+    decoder->SgOriginalCount = 0;
+    decoder->Complete = false;
+    memset(decoder->Received, 0, sizeof(decoder->Received));
+}
+
+extern "C" int cm256_stream_decoder_complete(const cm256_stream_decoder* decoder)
+{
+    return decoder->Complete ? 1 : 0;
+}
+
+// Eliminate the byte range [begin, begin + rangeBytes) of a newly received
+// original from the recovery blocks received so far, where 'data' points to
+// the start of the range
+static void StreamEliminateOriginal(
+    cm256_stream_decoder* decoder,
+    uint8_t y_j,
+    const uint8_t* data,
+    int begin,
+    int rangeBytes)
+{
+    const cm256_encoder_params& params = decoder->Params;
+
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+
+    uint8_t coefficients[256];
+    for (int i = 0; i < decoder->RecoveryCount; ++i)
+    {
+        coefficients[i] = GetMatrixElement(decoder->Recovery[i]->Index, x_0, y_j);
+    }
+
+    // Keep each tile of the original in cache while it is added to every row
+    cm256_encoder_params tileParams = params;
+    tileParams.OriginalCount = 1;
+    tileParams.RecoveryCount = decoder->RecoveryCount;
+    const int tileBytes = GetEncodeTileBytes(tileParams);
+
+    const int end = begin + rangeBytes;
+    for (int offset = begin; offset < end; offset += tileBytes)
+    {
+        int bytes = end - offset;
+        if (bytes > tileBytes)
+        {
+            bytes = tileBytes;
+        }
+
+        const uint8_t* inBlock = data + (offset - begin);
+
+        for (int i = 0; i < decoder->RecoveryCount; ++i)
+        {
+            uint8_t* recoveryBlock = static_cast<uint8_t*>(decoder->Recovery[i]->Block) + offset;
+
+            gf256_muladd_mem(recoveryBlock, coefficients[i], inBlock, bytes);
+        }
+    }
+}
+
+// Eliminate the originals received so far from a newly received recovery block
+static void StreamEliminateRecovery(cm256_stream_decoder* decoder, cm256_block* recovery)
+{
+    const cm256_encoder_params& params = decoder->Params;
+
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+    const uint8_t x_i = recovery->Index;
+
+    uint8_t coefficients[256];
+    const void* inBlocks[256];
+    for (int j = 0; j < decoder->OriginalCount; ++j)
+    {
+        coefficients[j] = GetMatrixElement(x_i, x_0, decoder->Original[j]->Index);
+        inBlocks[j] = decoder->Original[j]->Block;
+    }
+
+    if (decoder->SgOriginalCount <= 0)
+    {
+        gf256_muladd_multi_mem(recovery->Block, coefficients, inBlocks, decoder->OriginalCount, params.BlockBytes);
+        return;
+    }
+
+    // Read every original as a scatter-gather block, with the contiguous
+    // ones as a single segment
+    cm256_iovec wholeSegments[256];
+    cm256_sg_block wholeBlocks[256];
+    const cm256_sg_block* originals[256];
+    for (int j = 0; j < decoder->OriginalCount; ++j)
+    {
+        originals[j] = decoder->OriginalSg[j];
+        if (!originals[j])
+        {
+            wholeSegments[j].Base = inBlocks[j];
+            wholeSegments[j].Bytes = params.BlockBytes;
+            wholeBlocks[j].Segments = wholeSegments + j;
+            wholeBlocks[j].SegmentCount = 1;
+            originals[j] = wholeBlocks + j;
+        }
+    }
+
+    SgRuns runs;
+    runs.Reset(originals, decoder->OriginalCount);
+
+    uint8_t* recoveryBlock = static_cast<uint8_t*>(recovery->Block);
+    for (int offset = 0; offset < params.BlockBytes;)
+    {
+        const int bytes = runs.Next(offset, params.BlockBytes - offset, inBlocks);
+        gf256_muladd_multi_mem(recoveryBlock + offset, coefficients, inBlocks, decoder->OriginalCount, bytes);
+        offset += bytes;
+    }
+}
+
+// Solve for the erased originals once k blocks are in
+static void StreamSolve(cm256_stream_decoder* decoder)
+{
+    const cm256_encoder_params& params = decoder->Params;
+
+    CM256Decoder& state = decoder->Decoder;
+    state.Params = params;
+    state.OriginalsEliminated = true;
+    state.Outputs = nullptr;
+    state.Points = nullptr;
+    state.Crcs = nullptr;
+
+    state.OriginalCount = decoder->OriginalCount;
+    for (int j = 0; j < decoder->OriginalCount; ++j)
+    {
+        state.Original[j] = decoder->Original[j];
+    }
+    state.RecoveryCount = decoder->RecoveryCount;
+    for (int i = 0; i < decoder->RecoveryCount; ++i)
+    {
+        state.Recovery[i] = decoder->Recovery[i];
+    }
+
+    // Identify erasures
+    for (int ii = 0, indexCount = 0; ii < params.OriginalCount && indexCount < state.RecoveryCount; ++ii)
+    {
+        if (!decoder->Received[ii])
+        {
+            state.ErasuresIndices[indexCount++] = static_cast<uint8_t>(ii);
+        }
+    }
+
+    state.ComputeCoefficients(decoder->Coefficients);
+    state.Eliminate(nullptr);
+}
+
+// Solve once k blocks are in
+static void StreamCheckComplete(cm256_stream_decoder* decoder)
+{
+    if (decoder->OriginalCount + decoder->RecoveryCount >= decoder->Params.OriginalCount)
+    {
+        if (decoder->RecoveryCount > 0)
+        {
+            StreamSolve(decoder);
+        }
+        decoder->Complete = true;
+    }
+}
+
+extern "C" int cm256_stream_decoder_push(
+    cm256_stream_decoder* decoder, // Decoder from cm256_stream_decoder_create()
+    cm256_block* block)            // Received block as described above
+{
+    if (!decoder || !block || !block->Block)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = decoder->Params;
+    const int index = block->Index;
+    if (index >= params.OriginalCount + params.RecoveryCount)
+    {
+        return -1;
+    }
+    if (decoder->Received[index])
+    {
+        return -2;
+    }
+
+    // Extra blocks beyond the first k are not needed
+    if (decoder->Complete)
+    {
+        return 0;
+    }
+    decoder->Received[index] = true;
+
+    // If there is only one block,
+    if (params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        block->Index = 0;
+        decoder->Complete = true;
+        return 0;
+    }
+
+    if (index < params.OriginalCount)
+    {
+        StreamEliminateOriginal(decoder, block->Index, static_cast<const uint8_t*>(block->Block), 0, params.BlockBytes);
+        decoder->OriginalSg[decoder->OriginalCount] = nullptr;
+        decoder->Original[decoder->OriginalCount++] = block;
+    }
+    else
+    {
+        StreamEliminateRecovery(decoder, block);
+        decoder->Recovery[decoder->RecoveryCount++] = block;
+    }
+
+    StreamCheckComplete(decoder);
+    return 0;
+}
+
+extern "C" int cm256_stream_decoder_push_sg(
+    cm256_stream_decoder* decoder, // Decoder from cm256_stream_decoder_create()
+    const cm256_sg_block* block)   // Received original block
+{
+    if (!decoder || !block)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = decoder->Params;
+    const int result = ValidateSgBlock(*block, params.BlockBytes);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    // Recovery blocks are decoded in place, so they must be contiguous
+    const int index = block->Index;
+    if (index >= params.OriginalCount)
+    {
+        return -1;
+    }
+    if (decoder->Received[index])
+    {
+        return -2;
+    }
+
+    // Extra blocks beyond the first k are not needed
+    if (decoder->Complete)
+    {
+        return 0;
+    }
+    decoder->Received[index] = true;
+
+    // The kernels here take one source at a time, so each segment is
+    // eliminated where it lies
+    int offset = 0;
+    for (int s = 0; s < block->SegmentCount; ++s)
+    {
+        const cm256_iovec& segment = block->Segments[s];
+        if (segment.Bytes > 0)
+        {
+            StreamEliminateOriginal(decoder, block->Index, static_cast<const uint8_t*>(segment.Base), offset, segment.Bytes);
+            offset += segment.Bytes;
+        }
+    }
+
+    // The final solve only reads the index of an original, and large-block
+    // mode may prefetch from its start
+    cm256_block* indexBlock = decoder->SgIndexBlocks + decoder->SgOriginalCount++;
+    indexBlock->Block = const_cast<void*>(block->Segments[0].Base);
+    indexBlock->Index = block->Index;
+
+    decoder->OriginalSg[decoder->OriginalCount] = block;
+    decoder->Original[decoder->OriginalCount++] = indexBlock;
+
+    StreamCheckComplete(decoder);
+    return 0;
+}
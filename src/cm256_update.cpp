@@ -0,0 +1,180 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+#include "cm256_codec.h"
+
+
+//-----------------------------------------------------------------------------
+// Parity Update
+
+/*
+    Recovery row i is sum_j a_ij * O_j, so replacing original j with O_j'
+    adds a_ij * (O_j + O_j') to it.  The change is formed one tile at a time
+    in scratch and multiplied into all of the rows with one fused pass, which
+    loads each register of the change once per group of eight rows instead
+    of once per row.  The old and new data are each read once however many
+    rows there are.
+*/
+
+// Add the change to original 'originalIndex' into each recovery block
+static void UpdateRecovery(
+    const cm256_encoder_params& params,
+    int originalIndex,
+    const uint8_t* oldBlock,
+    const uint8_t* newBlock,
+    void* const* recoveryBlocks,
+    const gf256_mul_tables* tables) // Precomputed rows 1..m-1 of the matrix, or null
+{
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+    const uint8_t y_j = static_cast<uint8_t>(originalIndex);
+
+    // Gather the rows to update and the coefficient of the original in each
+    uint8_t* rows[256];
+    uint8_t coefficients[256];
+    int rowCount = 0;
+
+    for (int block = 0; block < params.RecoveryCount; ++block)
+    {
+        if (!recoveryBlocks[block])
+        {
+            continue;
+        }
+        rows[rowCount] = static_cast<uint8_t*>(recoveryBlocks[block]);
+
+        // One original block is just copied, and row 0 is all ones
+        if (params.OriginalCount == 1 || block == 0)
+        {
+            coefficients[rowCount] = 1;
+        }
+        else if (tables)
+        {
+            coefficients[rowCount] = tables[(block - 1) * params.OriginalCount + originalIndex].Y;
+        }
+        else
+        {
+            const uint8_t x_i = static_cast<uint8_t>(params.OriginalCount + block);
+            coefficients[rowCount] = GetMatrixElement(x_i, x_0, y_j);
+        }
+        ++rowCount;
+    }
+
+    if (rowCount <= 0)
+    {
+        return;
+    }
+
+    cm256_encoder_params tileParams = params;
+    tileParams.OriginalCount = 1;
+    const int tileBytes = GetEncodeTileBytes(tileParams);
+
+    uint8_t* changeTile = nullptr;
+    if (oldBlock)
+    {
+        changeTile = GetThreadScratch(kScratchTile, tileBytes);
+    }
+
+    // For each tile of the original,
+    void* tileRows[256];
+    for (int offset = 0; offset < params.BlockBytes; offset += tileBytes)
+    {
+        int bytes = params.BlockBytes - offset;
+        if (bytes > tileBytes)
+        {
+            bytes = tileBytes;
+        }
+
+        const uint8_t* change = newBlock + offset;
+        if (changeTile)
+        {
+            gf256_addset_mem(changeTile, oldBlock + offset, change, bytes);
+            change = changeTile;
+        }
+
+        for (int row = 0; row < rowCount; ++row)
+        {
+            tileRows[row] = rows[row] + offset;
+        }
+
+        gf256_muladd_spread_mem(tileRows, coefficients, change, rowCount, bytes);
+    }
+}
+
+extern "C" int cm256_update(
+    cm256_encoder_params params, // Encoder parameters
+    int originalIndex,           // Return value from cm256_get_original_block_index()
+    const void* oldBlock,        // Original block data before the write, or null
+    const void* newBlock,        // Original block data after the write, or the change
+    void* const* recoveryBlocks) // Array of 'recoveryCount' recovery blocks to update
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 256)
+    {
+        return -2;
+    }
+    if (!newBlock || !recoveryBlocks)
+    {
+        return -3;
+    }
+    if (originalIndex < 0 || originalIndex >= params.OriginalCount)
+    {
+        return -1;
+    }
+
+    UpdateRecovery(params, originalIndex, static_cast<const uint8_t*>(oldBlock),
+        static_cast<const uint8_t*>(newBlock), recoveryBlocks, nullptr);
+
+    return 0;
+}
+
+extern "C" int cm256_encoder_update(
+    cm256_encoder* encoder,      // Encoder from cm256_encoder_create()
+    int originalIndex,           // Return value from cm256_get_original_block_index()
+    const void* oldBlock,        // Original block data before the write, or null
+    const void* newBlock,        // Original block data after the write, or the change
+    void* const* recoveryBlocks) // Array of 'recoveryCount' recovery blocks to update
+{
+    if (!encoder || !newBlock || !recoveryBlocks)
+    {
+        return -3;
+    }
+    if (originalIndex < 0 || originalIndex >= encoder->Params.OriginalCount)
+    {
+        return -1;
+    }
+
+    UpdateRecovery(encoder->Params, originalIndex, static_cast<const uint8_t*>(oldBlock),
+        static_cast<const uint8_t*>(newBlock), recoveryBlocks, encoder->Tables);
+
+    return 0;
+}
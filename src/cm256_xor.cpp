@@ -0,0 +1,802 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256.h"
+
+#include <mutex>
+#include <memory>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <new>
+#include <cstring>
+
+
+/*
+    XOR Bitmatrix Mode
+
+    Multiplying by a constant c in GF(256) is linear over GF(2), so it is an
+    8x8 bit matrix M(c) whose column b holds the bits of c * 2^b.  Splitting
+    every block into 8 equal packets and treating bit position b of a symbol
+    as packet b, the product c * x becomes: output packet r is the XOR of the
+    input packets b where M(c) has a one in row r, column b.
+
+    Expanding every coefficient of the Cauchy matrix this way turns encoding
+    into a list of packet XORs, with no table lookups or shuffles at all.
+    The same holds for decoding, where each erased original is a combination
+    of the k received blocks with coefficients from the inverse of the
+    Cauchy submatrix for the erasures.
+
+    The number of XORs is then the number of ones in the bit matrix, which
+    is reduced before encoding by smart scheduling (Plank, Schuman and
+    Robison, "Heuristics for Optimizing Matrix-Based Erasure Codes"): each
+    output packet is built either from the inputs directly or from an output
+    packet computed earlier plus the inputs where their rows differ,
+    whichever needs fewer XORs.  Outputs are scheduled cheapest first, and
+    each schedule is built once and kept in the codec.
+
+    Symbols are bit-sliced across the packets, so the recovery data differs
+    from cm256_encode() and the two must not be mixed.
+*/
+
+
+//-----------------------------------------------------------------------------
+// Bit Matrix
+
+// Cauchy matrix element as in cm256.cpp for the given points, with the
+// k = 1 code repeating the original like cm256_encode() does
+static uint8_t GetXorMatrixElement(const cm256_matrix_points& points, int originalCount,
+                                   int recoveryIndex, int originalIndex)
+{
+    if (originalCount == 1)
+    {
+        return 1;
+    }
+
+    const uint8_t x_i = points.X[recoveryIndex];
+    const uint8_t x_0 = points.X[0];
+    const uint8_t y_j = points.Y[originalIndex];
+    return gf256_mul(points.RowScale[recoveryIndex],
+                     gf256_div(gf256_add(y_j, x_0), gf256_add(x_i, y_j)));
+}
+
+// Rows of a GF(2) matrix with one output packet per row and one input
+// packet per column
+struct XorBitMatrix
+{
+    int Rows;
+    int Words;
+    std::vector<uint64_t> Bits;
+
+    XorBitMatrix(int rows, int columns)
+        : Rows(rows)
+        , Words((columns + 63) / 64)
+        , Bits((size_t)rows * Words, 0)
+    {
+    }
+
+    uint64_t* Row(int row)
+    {
+        return &Bits[(size_t)row * Words];
+    }
+    const uint64_t* Row(int row) const
+    {
+        return &Bits[(size_t)row * Words];
+    }
+
+    // Expand coefficient c for output symbol i and input symbol j
+    void SetElement(int i, int j, uint8_t c)
+    {
+        for (int b = 0; b < 8; ++b)
+        {
+            const uint8_t column = gf256_mul(c, static_cast<uint8_t>(1 << b));
+            const int input = j * 8 + b;
+
+            for (int r = 0; r < 8; ++r)
+            {
+                if (column & (1 << r))
+                {
+                    Row(i * 8 + r)[input / 64] |= (uint64_t)1 << (input % 64);
+                }
+            }
+        }
+    }
+};
+
+static int PopCount(uint64_t x)
+{
+    int count = 0;
+    for (; x; x &= x - 1)
+    {
+        ++count;
+    }
+    return count;
+}
+
+
+//-----------------------------------------------------------------------------
+// Schedule
+
+// Output packet Dst = (Base packet, if any) + the listed input packets
+struct XorRow
+{
+    uint16_t Dst;
+    int16_t Base;
+    uint32_t First;
+    uint32_t Count;
+};
+
+struct XorSchedule
+{
+    std::vector<XorRow> Rows;
+    std::vector<uint16_t> Sources;
+
+    // Total packet XORs, for comparing against the ones in the matrix
+    int XorCount;
+};
+
+typedef std::shared_ptr<XorSchedule> XorSchedulePtr;
+
+static XorSchedulePtr BuildXorSchedule(const XorBitMatrix& matrix)
+{
+    XorSchedulePtr schedule = std::make_shared<XorSchedule>();
+    const int rows = matrix.Rows;
+    const int words = matrix.Words;
+
+    // Cost of each pending output: XORs from the inputs, or from an output
+    std::vector<int> cost(rows);
+    std::vector<int> from(rows, -1);
+    std::vector<bool> done(rows, false);
+
+    for (int i = 0; i < rows; ++i)
+    {
+        int ones = 0;
+        for (int w = 0; w < words; ++w)
+        {
+            ones += PopCount(matrix.Row(i)[w]);
+        }
+        cost[i] = ones - 1;
+    }
+
+    schedule->Rows.reserve(rows);
+    schedule->XorCount = 0;
+
+    for (int step = 0; step < rows; ++step)
+    {
+        int best = -1;
+        for (int i = 0; i < rows; ++i)
+        {
+            if (!done[i] && (best < 0 || cost[i] < cost[best]))
+            {
+                best = i;
+            }
+        }
+
+        // Emit the inputs that differ from the base, or all of them
+        const uint64_t* row = matrix.Row(best);
+        const uint64_t* base = from[best] >= 0 ? matrix.Row(from[best]) : nullptr;
+
+        XorRow entry;
+        entry.Dst = static_cast<uint16_t>(best);
+        entry.Base = static_cast<int16_t>(from[best]);
+        entry.First = static_cast<uint32_t>(schedule->Sources.size());
+
+        for (int w = 0; w < words; ++w)
+        {
+            uint64_t bits = base ? (row[w] ^ base[w]) : row[w];
+            for (; bits; bits &= bits - 1)
+            {
+                int bit = 0;
+                while (!(bits & ((uint64_t)1 << bit)))
+                {
+                    ++bit;
+                }
+                schedule->Sources.push_back(static_cast<uint16_t>(w * 64 + bit));
+            }
+        }
+
+        entry.Count = static_cast<uint32_t>(schedule->Sources.size()) - entry.First;
+        schedule->Rows.push_back(entry);
+        schedule->XorCount += cost[best] > 0 ? cost[best] : 0;
+        done[best] = true;
+
+        // Starting from this output costs one XOR per differing input
+        for (int i = 0; i < rows; ++i)
+        {
+            if (done[i])
+            {
+                continue;
+            }
+
+            int distance = 0;
+            const uint64_t* other = matrix.Row(i);
+            for (int w = 0; w < words; ++w)
+            {
+                distance += PopCount(row[w] ^ other[w]);
+            }
+
+            if (distance < cost[i])
+            {
+                cost[i] = distance;
+                from[i] = best;
+            }
+        }
+    }
+
+    return schedule;
+}
+
+// Runs the schedule over `bytes` of each packet: inputs start at
+// in[p] + inOffset and outputs at out[p]
+static void RunXorSchedule(
+    const XorSchedule& schedule,
+    const uint8_t* const* in,
+    int inOffset,
+    uint8_t* const* out,
+    int bytes)
+{
+    for (const XorRow& row : schedule.Rows)
+    {
+        uint8_t* dst = out[row.Dst];
+        const uint16_t* src = &schedule.Sources[0] + row.First;
+        uint32_t count = row.Count;
+
+        if (row.Base >= 0)
+        {
+            if (count == 0)
+            {
+                memcpy(dst, out[row.Base], bytes);
+                continue;
+            }
+            gf256_addset_mem(dst, out[row.Base], in[src[0]] + inOffset, bytes);
+            ++src, --count;
+        }
+        else if (count == 0)
+        {
+            memset(dst, 0, bytes);
+            continue;
+        }
+        else if (count == 1)
+        {
+            memcpy(dst, in[src[0]] + inOffset, bytes);
+            continue;
+        }
+        else
+        {
+            gf256_addset_mem(dst, in[src[0]] + inOffset, in[src[1]] + inOffset, bytes);
+            src += 2, count -= 2;
+        }
+
+        // Fold the remaining inputs in two at a time
+        for (; count >= 2; src += 2, count -= 2)
+        {
+            gf256_add2_mem(dst, in[src[0]] + inOffset, in[src[1]] + inOffset, bytes);
+        }
+        if (count > 0)
+        {
+            gf256_add_mem(dst, in[src[0]] + inOffset, bytes);
+        }
+    }
+}
+
+// Bytes of each packet handled per pass, so that one pass over all of the
+// packets stays in cache
+static int GetXorTileBytes(cm256_encoder_params params)
+{
+    const int packetBytes = params.BlockBytes / 8;
+    int tile = (256 * 1024) / (8 * (params.OriginalCount + params.RecoveryCount));
+    tile &= ~63;
+    if (tile < 256)
+    {
+        tile = 256;
+    }
+    return tile < packetBytes ? tile : packetBytes;
+}
+
+
+//-----------------------------------------------------------------------------
+// Decode Schedule Cache
+
+// Identifies the decode schedule for a set of received block indices
+struct XorDecodeKey
+{
+    uint64_t Present[4];
+
+    bool operator==(const XorDecodeKey& other) const
+    {
+        return 0 == memcmp(Present, other.Present, sizeof(Present));
+    }
+};
+
+struct XorDecodeKeyHash
+{
+    size_t operator()(const XorDecodeKey& key) const
+    {
+        uint64_t h = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            h = h * 0x9E3779B97F4A7C15ULL ^ key.Present[i];
+        }
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+struct cm256_xor_codec_t
+{
+    cm256_encoder_params Params;
+    cm256_matrix_points Points;
+    int TileBytes;
+
+    XorSchedulePtr Encode;
+
+    int DecodeCapacity;
+
+    // Protects the fields below
+    std::mutex Lock;
+
+    // Most recently used first
+    typedef std::list<std::pair<XorDecodeKey, XorSchedulePtr> > EntryList;
+    EntryList Entries;
+
+    std::unordered_map<XorDecodeKey, EntryList::iterator, XorDecodeKeyHash> Index;
+
+    // Returns the cached schedule and marks it most recently used, or null
+    XorSchedulePtr Find(const XorDecodeKey& key);
+
+    // Adds a schedule, evicting the least recently used one if full.
+    // Returns the schedule that is cached for the key afterwards.
+    XorSchedulePtr Insert(const XorDecodeKey& key, const XorSchedulePtr& schedule);
+};
+
+XorSchedulePtr cm256_xor_codec_t::Find(const XorDecodeKey& key)
+{
+    std::lock_guard<std::mutex> locker(Lock);
+
+    auto found = Index.find(key);
+    if (found == Index.end())
+    {
+        return XorSchedulePtr();
+    }
+
+    Entries.splice(Entries.begin(), Entries, found->second);
+    return found->second->second;
+}
+
+XorSchedulePtr cm256_xor_codec_t::Insert(const XorDecodeKey& key, const XorSchedulePtr& schedule)
+{
+    std::lock_guard<std::mutex> locker(Lock);
+
+    // Another thread may have added the same schedule in the meantime
+    auto found = Index.find(key);
+    if (found != Index.end())
+    {
+        Entries.splice(Entries.begin(), Entries, found->second);
+        return found->second->second;
+    }
+
+    if ((int)Entries.size() >= DecodeCapacity)
+    {
+        Index.erase(Entries.back().first);
+        Entries.pop_back();
+    }
+
+    Entries.emplace_front(key, schedule);
+    Index[key] = Entries.begin();
+    return schedule;
+}
+
+
+//-----------------------------------------------------------------------------
+// Codec
+
+static cm256_xor_codec* CreateXorCodec(cm256_encoder_params params, const cm256_matrix_points* points,
+                                       int decodeCacheCapacity)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.BlockBytes % 8 != 0 ||
+        params.OriginalCount + params.RecoveryCount > 256 ||
+        decodeCacheCapacity <= 0)
+    {
+        return nullptr;
+    }
+
+    cm256_xor_codec* codec = new (std::nothrow) cm256_xor_codec;
+    if (!codec)
+    {
+        return nullptr;
+    }
+
+    codec->Params = params;
+    if (points)
+    {
+        codec->Points = *points;
+    }
+    else
+    {
+        cm256_default_points(params, &codec->Points);
+    }
+    codec->TileBytes = GetXorTileBytes(params);
+    codec->DecodeCapacity = decodeCacheCapacity;
+
+    try
+    {
+        XorBitMatrix matrix(params.RecoveryCount * 8, params.OriginalCount * 8);
+        for (int i = 0; i < params.RecoveryCount; ++i)
+        {
+            for (int j = 0; j < params.OriginalCount; ++j)
+            {
+                matrix.SetElement(i, j, GetXorMatrixElement(codec->Points, params.OriginalCount, i, j));
+            }
+        }
+        codec->Encode = BuildXorSchedule(matrix);
+    }
+    catch (...)
+    {
+        delete codec;
+        return nullptr;
+    }
+
+    return codec;
+}
+
+extern "C" cm256_xor_codec* cm256_xor_codec_create(cm256_encoder_params params, int decodeCacheCapacity)
+{
+    return CreateXorCodec(params, nullptr, decodeCacheCapacity);
+}
+
+extern "C" cm256_xor_codec* cm256_xor_codec_create_with_points(
+    cm256_encoder_params params,       // Encoder parameters
+    const cm256_matrix_points* points, // Points the recovery data is encoded with
+    int decodeCacheCapacity)           // Number of decode schedules to keep
+{
+    if (cm256_points_cost(params, points) < 0)
+    {
+        return nullptr;
+    }
+
+    return CreateXorCodec(params, points, decodeCacheCapacity);
+}
+
+extern "C" void cm256_xor_codec_destroy(cm256_xor_codec* codec)
+{
+    delete codec;
+}
+
+extern "C" int cm256_xor_encode(
+    const cm256_xor_codec* codec, // Codec from cm256_xor_codec_create()
+    cm256_block* originals,       // Array of pointers to original blocks
+    void* recoveryBlocks)         // Output recovery blocks end-to-end
+{
+    if (!codec || !originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = codec->Params;
+    const int packetBytes = params.BlockBytes / 8;
+
+    const uint8_t* in[256 * 8];
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        const uint8_t* block = static_cast<const uint8_t*>(originals[j].Block);
+        if (!block)
+        {
+            return -3;
+        }
+        for (int b = 0; b < 8; ++b)
+        {
+            in[j * 8 + b] = block + b * packetBytes;
+        }
+    }
+
+    uint8_t* recovery = static_cast<uint8_t*>(recoveryBlocks);
+    uint8_t* out[256 * 8];
+    const int outCount = params.RecoveryCount * 8;
+
+    for (int offset = 0; offset < packetBytes; offset += codec->TileBytes)
+    {
+        const int bytes = packetBytes - offset < codec->TileBytes ? packetBytes - offset : codec->TileBytes;
+
+        for (int p = 0; p < outCount; ++p)
+        {
+            out[p] = recovery + (size_t)p * packetBytes + offset;
+        }
+
+        RunXorSchedule(*codec->Encode, in, offset, out, bytes);
+    }
+
+    return 0;
+}
+
+// Builds the schedule that produces the erased originals, in index order,
+// from the received blocks: received originals in index order followed by
+// the received recovery blocks in index order
+static XorSchedulePtr BuildXorDecodeSchedule(
+    cm256_encoder_params params,
+    const cm256_matrix_points& points,
+    const bool* originalPresent,
+    const int* recoveryIndices,
+    int erasureCount)
+{
+    const int k = params.OriginalCount;
+
+    int erasures[256];
+    int receivedOriginals[256];
+    int erasureIndex = 0, receivedCount = 0;
+    for (int j = 0; j < k; ++j)
+    {
+        if (originalPresent[j])
+        {
+            receivedOriginals[receivedCount++] = j;
+        }
+        else
+        {
+            erasures[erasureIndex++] = j;
+        }
+    }
+
+    // Invert C[i][t] = a(recovery i, erasure t) by Gauss-Jordan elimination
+    const int e = erasureCount;
+    std::vector<uint8_t> C((size_t)e * e), inv((size_t)e * e, 0);
+    for (int i = 0; i < e; ++i)
+    {
+        for (int t = 0; t < e; ++t)
+        {
+            C[i * e + t] = GetXorMatrixElement(points, k, recoveryIndices[i], erasures[t]);
+        }
+        inv[i * e + i] = 1;
+    }
+
+    for (int col = 0; col < e; ++col)
+    {
+        // Cauchy submatrices are invertible, so a pivot always exists
+        int pivot = col;
+        while (C[pivot * e + col] == 0)
+        {
+            ++pivot;
+        }
+        if (pivot != col)
+        {
+            for (int c = 0; c < e; ++c)
+            {
+                std::swap(C[pivot * e + c], C[col * e + c]);
+                std::swap(inv[pivot * e + c], inv[col * e + c]);
+            }
+        }
+
+        const uint8_t scale = gf256_inv(C[col * e + col]);
+        gf256_mul_mem(&C[col * e], &C[col * e], scale, e);
+        gf256_mul_mem(&inv[col * e], &inv[col * e], scale, e);
+
+        for (int row = 0; row < e; ++row)
+        {
+            const uint8_t factor = C[row * e + col];
+            if (row != col && factor != 0)
+            {
+                gf256_muladd_mem(&C[row * e], factor, &C[col * e], e);
+                gf256_muladd_mem(&inv[row * e], factor, &inv[col * e], e);
+            }
+        }
+    }
+
+    // Erasure t = sum_i inv[t][i] * (recovery i - sum_j a(i, j) * original j)
+    XorBitMatrix matrix(e * 8, k * 8);
+    for (int t = 0; t < e; ++t)
+    {
+        const uint8_t* invRow = &inv[t * e];
+
+        for (int s = 0; s < receivedCount; ++s)
+        {
+            uint8_t c = 0;
+            for (int i = 0; i < e; ++i)
+            {
+                c ^= gf256_mul(invRow[i], GetXorMatrixElement(points, k, recoveryIndices[i], receivedOriginals[s]));
+            }
+            matrix.SetElement(t, s, c);
+        }
+        for (int i = 0; i < e; ++i)
+        {
+            matrix.SetElement(t, receivedCount + i, invRow[i]);
+        }
+    }
+
+    return BuildXorSchedule(matrix);
+}
+
+extern "C" int cm256_xor_decode(
+    cm256_xor_codec* codec, // Codec from cm256_xor_codec_create()
+    cm256_block* blocks)    // Array of 'originalCount' blocks as described above
+{
+    if (!codec || !blocks)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = codec->Params;
+    const int k = params.OriginalCount;
+    const int packetBytes = params.BlockBytes / 8;
+
+    // Sort the blocks by index
+    const uint8_t* original[256] = {};
+    cm256_block* recovery[256] = {};
+    for (int i = 0; i < k; ++i)
+    {
+        const int index = blocks[i].Index;
+        if (!blocks[i].Block)
+        {
+            return -3;
+        }
+        if (index >= k + params.RecoveryCount)
+        {
+            return -5;
+        }
+
+        if (index < k)
+        {
+            if (original[index])
+            {
+                return -5;
+            }
+            original[index] = static_cast<const uint8_t*>(blocks[i].Block);
+        }
+        else
+        {
+            if (recovery[index - k])
+            {
+                return -5;
+            }
+            recovery[index - k] = &blocks[i];
+        }
+    }
+
+    XorDecodeKey key;
+    memset(key.Present, 0, sizeof(key.Present));
+
+    bool originalPresent[256];
+    int recoveryIndices[256];
+    cm256_block* recoveryBlocks[256];
+    int erasureCount = 0;
+
+    for (int j = 0; j < k; ++j)
+    {
+        originalPresent[j] = original[j] != nullptr;
+        if (originalPresent[j])
+        {
+            key.Present[j / 64] |= (uint64_t)1 << (j % 64);
+        }
+    }
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        if (recovery[i])
+        {
+            const int index = k + i;
+            key.Present[index / 64] |= (uint64_t)1 << (index % 64);
+            recoveryIndices[erasureCount] = i;
+            recoveryBlocks[erasureCount++] = recovery[i];
+        }
+    }
+
+    // Nothing to do if all of the originals arrived
+    if (erasureCount == 0)
+    {
+        return 0;
+    }
+
+    XorSchedulePtr schedule = codec->Find(key);
+    if (!schedule)
+    {
+        // Build the schedule outside the lock, since it is the slow part
+        try
+        {
+            schedule = BuildXorDecodeSchedule(params, codec->Points, originalPresent, recoveryIndices, erasureCount);
+        }
+        catch (...)
+        {
+            return -4;
+        }
+
+        schedule = codec->Insert(key, schedule);
+    }
+
+    // Input packets in the order the schedule expects
+    const uint8_t* in[256 * 8];
+    int source = 0;
+    for (int j = 0; j < k; ++j)
+    {
+        if (original[j])
+        {
+            for (int b = 0; b < 8; ++b)
+            {
+                in[source * 8 + b] = original[j] + b * packetBytes;
+            }
+            ++source;
+        }
+    }
+    for (int i = 0; i < erasureCount; ++i)
+    {
+        const uint8_t* block = static_cast<const uint8_t*>(recoveryBlocks[i]->Block);
+        for (int b = 0; b < 8; ++b)
+        {
+            in[source * 8 + b] = block + b * packetBytes;
+        }
+        ++source;
+    }
+
+    // The recovery blocks are still being read within a tile, so each tile
+    // is decoded into scratch and then written over them
+    const int tileBytes = codec->TileBytes;
+    const int outCount = erasureCount * 8;
+    uint8_t* scratch = new (std::nothrow) uint8_t[(size_t)outCount * tileBytes];
+    if (!scratch)
+    {
+        return -4;
+    }
+    uint8_t* out[256 * 8];
+    for (int p = 0; p < outCount; ++p)
+    {
+        out[p] = scratch + (size_t)p * tileBytes;
+    }
+
+    for (int offset = 0; offset < packetBytes; offset += tileBytes)
+    {
+        const int bytes = packetBytes - offset < tileBytes ? packetBytes - offset : tileBytes;
+
+        RunXorSchedule(*schedule, in, offset, out, bytes);
+
+        for (int t = 0; t < erasureCount; ++t)
+        {
+            uint8_t* block = static_cast<uint8_t*>(recoveryBlocks[t]->Block);
+            for (int b = 0; b < 8; ++b)
+            {
+                memcpy(block + b * packetBytes + offset, out[t * 8 + b], bytes);
+            }
+        }
+    }
+
+    delete[] scratch;
+
+    // Label the recovered originals in index order
+    int next = 0;
+    for (int j = 0; j < k; ++j)
+    {
+        if (!originalPresent[j])
+        {
+            recoveryBlocks[next++]->Index = static_cast<unsigned char>(j);
+        }
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_xor_encode_cost(const cm256_xor_codec* codec)
+{
+    return codec ? codec->Encode->XorCount : -3;
+}
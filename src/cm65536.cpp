@@ -0,0 +1,465 @@
+/*
+	Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice,
+	  this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice,
+	  this list of conditions and the following disclaimer in the documentation
+	  and/or other materials provided with the distribution.
+	* Neither the name of CM256 nor the names of its contributors may be
+	  used to endorse or promote products derived from this software without
+	  specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "cm65536.h"
+
+#include <vector>
+
+/*
+    GF(65536) Cauchy Code
+
+    This is the cm256 code with 16-bit symbols: the same matrix form, with
+    the same first row of ones, and the same LDU decomposition for decoding.
+    See cm256.cpp for the details.  a_ij = (y_j + x_0) div (x_i + y_j),
+    where x_i = originalCount + i and y_j = j.
+*/
+
+extern "C" int cm65536_init_(int version)
+{
+    if (version != CM65536_VERSION)
+    {
+        // User's header does not match library version
+        return -10;
+    }
+
+    // Return error code from GF(65536) init if required
+    return gf65536_init();
+}
+
+// This function generates each matrix element based on x_i, x_0, y_j
+// Note that for x_i == x_0, this will return 1, so it is better to unroll out the first row.
+static GF256_FORCE_INLINE uint16_t GetMatrixElement(uint16_t x_i, uint16_t x_0, uint16_t y_j)
+{
+    return gf65536_div(gf65536_add(y_j, x_0), gf65536_add(x_i, y_j));
+}
+
+static bool ValidateParams(const cm65536_encoder_params& params)
+{
+    return params.OriginalCount > 0 &&
+           params.RecoveryCount > 0 &&
+           params.BlockBytes > 0 &&
+           (params.BlockBytes % 2) == 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Encoding
+
+extern "C" void cm65536_encode_block(
+    cm65536_encoder_params params, // Encoder parameters
+    cm65536_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,        // Return value from cm65536_get_recovery_block_index()
+    void* recoveryBlock)           // Output recovery block
+{
+    // If only one block of input data,
+    if (params.OriginalCount == 1)
+    {
+        // No meaningful operation here, degenerate to outputting the same data each time.
+
+        memcpy(recoveryBlock, originals[0].Block, params.BlockBytes);
+        return;
+    }
+    // else OriginalCount >= 2:
+
+    // Unroll first row of recovery matrix:
+    // The matrix we generate for the first row is all ones,
+    // so it is merely a parity of the original data.
+    if (recoveryBlockIndex == params.OriginalCount)
+    {
+        gf65536_addset_mem(recoveryBlock, originals[0].Block, originals[1].Block, params.BlockBytes);
+        for (int j = 2; j < params.OriginalCount; ++j)
+        {
+            gf65536_add_mem(recoveryBlock, originals[j].Block, params.BlockBytes);
+        }
+        return;
+    }
+
+    // Start the x_0 values arbitrarily from the original count.
+    const uint16_t x_0 = static_cast<uint16_t>(params.OriginalCount);
+    const uint16_t x_i = static_cast<uint16_t>(recoveryBlockIndex);
+
+    // The first column sets the block and the rest add to it
+    gf65536_mul_mem(recoveryBlock, originals[0].Block, GetMatrixElement(x_i, x_0, 0), params.BlockBytes);
+
+    for (int j = 1; j < params.OriginalCount; ++j)
+    {
+        const uint16_t y_j = static_cast<uint16_t>(j);
+
+        gf65536_muladd_mem(recoveryBlock, GetMatrixElement(x_i, x_0, y_j), originals[j].Block, params.BlockBytes);
+    }
+}
+
+extern "C" int cm65536_encode(
+    cm65536_encoder_params params, // Encoder parameters
+    cm65536_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)          // Output recovery blocks end-to-end
+{
+    if (!ValidateParams(params))
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 65536)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    uint8_t* recoveryBlock = static_cast<uint8_t*>(recoveryBlocks);
+
+    for (int block = 0; block < params.RecoveryCount; ++block, recoveryBlock += params.BlockBytes)
+    {
+        cm65536_encode_block(params, originals, (params.OriginalCount + block), recoveryBlock);
+    }
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Decoding
+
+struct CM65536Decoder
+{
+    // Encode parameters
+    cm65536_encoder_params Params;
+
+    // Recovery blocks
+    std::vector<cm65536_block*> Recovery;
+
+    // Original blocks
+    std::vector<cm65536_block*> Original;
+
+    // Row indices that were erased
+    std::vector<uint16_t> ErasuresIndices;
+
+    // Initialize the decoder
+    bool Initialize(cm65536_encoder_params& params, cm65536_block* blocks);
+
+    // Decode m=1 case
+    void DecodeM1();
+
+    // Decode for m>1 case
+    void Decode();
+
+    // Generate the LU decomposition of the matrix
+    void GenerateLDUDecomposition(uint16_t* matrix_L, uint16_t* diag_D, uint16_t* matrix_U);
+};
+
+bool CM65536Decoder::Initialize(cm65536_encoder_params& params, cm65536_block* blocks)
+{
+    Params = params;
+
+    const int blockCount = params.OriginalCount + params.RecoveryCount;
+    std::vector<bool> received(params.OriginalCount, false);
+
+    // For each input block,
+    for (int ii = 0; ii < params.OriginalCount; ++ii)
+    {
+        cm65536_block* block = blocks + ii;
+        const int row = block->Index;
+
+        if (row >= blockCount)
+        {
+            return false;
+        }
+
+        // If it is an original block,
+        if (row < params.OriginalCount)
+        {
+            if (received[row])
+            {
+                // Error out if two row indices repeat
+                return false;
+            }
+            received[row] = true;
+
+            Original.push_back(block);
+        }
+        else
+        {
+            Recovery.push_back(block);
+        }
+    }
+
+    // Identify erasures
+    for (int ii = 0; ii < params.OriginalCount && ErasuresIndices.size() < Recovery.size(); ++ii)
+    {
+        if (!received[ii])
+        {
+            ErasuresIndices.push_back(static_cast<uint16_t>(ii));
+        }
+    }
+
+    return true;
+}
+
+void CM65536Decoder::DecodeM1()
+{
+    // XOR all other blocks into the recovery block
+    void* outBlock = Recovery[0]->Block;
+
+    for (size_t ii = 0; ii < Original.size(); ++ii)
+    {
+        gf65536_add_mem(outBlock, Original[ii]->Block, Params.BlockBytes);
+    }
+
+    // Recover the index it corresponds to
+    Recovery[0]->Index = ErasuresIndices[0];
+}
+
+// Generate the LU decomposition of the matrix
+void CM65536Decoder::GenerateLDUDecomposition(uint16_t* matrix_L, uint16_t* diag_D, uint16_t* matrix_U)
+{
+    // Schur-type-direct-Cauchy algorithm 2.5 from
+    // "Pivoting and Backward Stability of Fast Algorithms for Solving Cauchy Linear Equations"
+    // T. Boros, T. Kailath, V. Olshevsky
+    // This is the same as the GF(256) version in cm256.cpp.
+
+    // Matrix size NxN
+    const int N = static_cast<int>(Recovery.size());
+
+    // Generators
+    std::vector<uint16_t> g(N, 1), b(N, 1);
+
+    // Temporary buffer for rotated row of U matrix
+    std::vector<uint16_t> rotated_row_U(N);
+    uint16_t* last_U = matrix_U + ((N - 1) * N) / 2 - 1;
+    int firstOffset_U = 0;
+
+    // Start the x_0 values arbitrarily from the original count.
+    const uint16_t x_0 = static_cast<uint16_t>(Params.OriginalCount);
+
+    for (int k = 0; k < N - 1; ++k)
+    {
+        const uint16_t x_k = Recovery[k]->Index;
+        const uint16_t y_k = ErasuresIndices[k];
+
+        // D_kk = (x_k + y_k)
+        // L_kk = g[k] / (x_k + y_k)
+        // U_kk = b[k] * (x_0 + y_k) / (x_k + y_k)
+        const uint16_t D_kk = gf65536_add(x_k, y_k);
+        const uint16_t L_kk = gf65536_div(g[k], D_kk);
+        const uint16_t U_kk = gf65536_mul(gf65536_div(b[k], D_kk), gf65536_add(x_0, y_k));
+
+        // diag_D[k] = D_kk * L_kk * U_kk
+        diag_D[k] = gf65536_mul(D_kk, gf65536_mul(L_kk, U_kk));
+
+        // Computing the k-th row of L and U
+        uint16_t* row_U = &rotated_row_U[0];
+        for (int j = k + 1; j < N; ++j)
+        {
+            const uint16_t x_j = Recovery[j]->Index;
+            const uint16_t y_j = ErasuresIndices[j];
+
+            // L_jk = g[j] / (x_j + y_k)
+            // U_kj = b[j] / (x_k + y_j)
+            // Then L_jk /= L_kk and U_kj /= U_kk
+            *matrix_L++ = gf65536_div(gf65536_div(g[j], gf65536_add(x_j, y_k)), L_kk);
+            *row_U++ = gf65536_div(gf65536_div(b[j], gf65536_add(x_k, y_j)), U_kk);
+
+            // g[j] = g[j] * (x_j + x_k) / (x_j + y_k)
+            // b[j] = b[j] * (y_j + y_k) / (y_j + x_k)
+            g[j] = gf65536_mul(g[j], gf65536_div(gf65536_add(x_j, x_k), gf65536_add(x_j, y_k)));
+            b[j] = gf65536_mul(b[j], gf65536_div(gf65536_add(y_j, y_k), gf65536_add(y_j, x_k)));
+        }
+
+        // Copy U matrix row into place in memory.
+        uint16_t* output_U = last_U + firstOffset_U;
+        row_U = &rotated_row_U[0];
+        for (int j = k + 1; j < N; ++j)
+        {
+            *output_U = *row_U++;
+            output_U -= j;
+        }
+        firstOffset_U -= k + 2;
+    }
+
+    // Multiply diagonal matrix into U
+    uint16_t* row_U = matrix_U;
+    for (int j = N - 1; j > 0; --j)
+    {
+        const uint16_t y_j = ErasuresIndices[j];
+        const uint16_t scale = gf65536_add(x_0, y_j);
+
+        for (int i = 0; i < j; ++i)
+        {
+            row_U[i] = gf65536_mul(row_U[i], scale);
+        }
+        row_U += j;
+    }
+
+    const uint16_t x_n = Recovery[N - 1]->Index;
+    const uint16_t y_n = ErasuresIndices[N - 1];
+
+    // D_nn = 1 / (x_n + y_n)
+    // L_nn = g[N-1]
+    // U_nn = b[N-1] * (x_0 + y_n)
+    const uint16_t L_nn = g[N - 1];
+    const uint16_t U_nn = gf65536_mul(b[N - 1], gf65536_add(x_0, y_n));
+
+    // diag_D[N-1] = L_nn * D_nn * U_nn
+    diag_D[N - 1] = gf65536_div(gf65536_mul(L_nn, U_nn), gf65536_add(x_n, y_n));
+}
+
+void CM65536Decoder::Decode()
+{
+    // Matrix size is NxN, where N is the number of recovery blocks used.
+    const int N = static_cast<int>(Recovery.size());
+
+    // Start the x_0 values arbitrarily from the original count.
+    const uint16_t x_0 = static_cast<uint16_t>(Params.OriginalCount);
+
+    // Eliminate original data from the the recovery rows
+    for (size_t originalIndex = 0; originalIndex < Original.size(); ++originalIndex)
+    {
+        const void* inBlock = Original[originalIndex]->Block;
+        const uint16_t y_j = Original[originalIndex]->Index;
+
+        for (int recoveryIndex = 0; recoveryIndex < N; ++recoveryIndex)
+        {
+            void* outBlock = Recovery[recoveryIndex]->Block;
+            const uint16_t x_i = Recovery[recoveryIndex]->Index;
+
+            gf65536_muladd_mem(outBlock, GetMatrixElement(x_i, x_0, y_j), inBlock, Params.BlockBytes);
+        }
+    }
+
+    /*
+        Compute matrix decomposition:
+
+            G = L * D * U
+
+        L is lower-triangular, diagonal is all ones.
+        D is a diagonal matrix.
+        U is upper-triangular, diagonal is all ones.
+    */
+    std::vector<uint16_t> matrix((N - 1) * N + N);
+    uint16_t* matrix_U = &matrix[0];
+    uint16_t* diag_D = matrix_U + (N - 1) * N / 2;
+    uint16_t* matrix_L = diag_D + N;
+    GenerateLDUDecomposition(matrix_L, diag_D, matrix_U);
+
+    /*
+        Eliminate lower left triangle.
+    */
+    // For each column,
+    for (int j = 0; j < N - 1; ++j)
+    {
+        const void* block_j = Recovery[j]->Block;
+
+        // For each row,
+        for (int i = j + 1; i < N; ++i)
+        {
+            void* block_i = Recovery[i]->Block;
+            const uint16_t c_ij = *matrix_L++; // Matrix elements are stored column-first, top-down.
+
+            gf65536_muladd_mem(block_i, c_ij, block_j, Params.BlockBytes);
+        }
+    }
+
+    /*
+        Eliminate diagonal.
+    */
+    for (int i = 0; i < N; ++i)
+    {
+        void* block = Recovery[i]->Block;
+
+        Recovery[i]->Index = ErasuresIndices[i];
+
+        gf65536_div_mem(block, block, diag_D[i], Params.BlockBytes);
+    }
+
+    /*
+        Eliminate upper right triangle.
+    */
+    for (int j = N - 1; j >= 1; --j)
+    {
+        const void* block_j = Recovery[j]->Block;
+
+        for (int i = j - 1; i >= 0; --i)
+        {
+            void* block_i = Recovery[i]->Block;
+            const uint16_t c_ij = *matrix_U++; // Matrix elements are stored column-first, bottom-up.
+
+            gf65536_muladd_mem(block_i, c_ij, block_j, Params.BlockBytes);
+        }
+    }
+}
+
+extern "C" int cm65536_decode(
+    cm65536_encoder_params params, // Encoder parameters
+    cm65536_block* blocks)         // Array of 'originalCount' blocks as described above
+{
+    if (!ValidateParams(params))
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > 65536)
+    {
+        return -2;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+
+    // If there is only one block,
+    if (params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        blocks[0].Index = 0;
+        return 0;
+    }
+
+    CM65536Decoder state;
+    if (!state.Initialize(params, blocks))
+    {
+        return -5;
+    }
+
+    // If nothing is erased,
+    if (state.Recovery.empty())
+    {
+        return 0;
+    }
+
+    // If m=1,
+    if (params.RecoveryCount == 1)
+    {
+        state.DecodeM1();
+        return 0;
+    }
+
+    // Decode for m>1
+    state.Decode();
+    return 0;
+}
@@ -1,1568 +1,1380 @@
-/** \file
-    \brief GF(256) Main C API Source
-    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
-
-    Redistribution and use in source and binary forms, with or without
-    modification, are permitted provided that the following conditions are met:
-
-    * Redistributions of source code must retain the above copyright notice,
-      this list of conditions and the following disclaimer.
-    * Redistributions in binary form must reproduce the above copyright notice,
-      this list of conditions and the following disclaimer in the documentation
-      and/or other materials provided with the distribution.
-    * Neither the name of GF256 nor the names of its contributors may be
-      used to endorse or promote products derived from this software without
-      specific prior written permission.
-
-    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
-    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
-    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
-    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
-    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
-    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
-    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
-    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
-    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
-    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
-    POSSIBILITY OF SUCH DAMAGE.
-*/
-
-#include "gf256.h"
-
-#ifdef LINUX_ARM
-#include <unistd.h>
-#include <fcntl.h>
-#include <elf.h>
-#include <linux/auxvec.h>
-#endif
-
-//------------------------------------------------------------------------------
-// Detect host byte order.
-// This check works with GCC and LLVM; assume little-endian byte order when
-// using any other compiler.
-// The result is verified during initialization.
-//
-#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) \
-    && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-#define GF256_IS_BIG_ENDIAN
-#endif
-
-//------------------------------------------------------------------------------
-// Workaround for ARMv7 that doesn't provide vqtbl1_*
-// This comes from linux-raid (https://www.spinics.net/lists/raid/msg58403.html)
-//
-#ifdef GF256_TRY_NEON
-#if __ARM_ARCH <= 7 && !defined(__aarch64__)
-static GF256_FORCE_INLINE uint8x16_t vqtbl1q_u8(uint8x16_t a, uint8x16_t b)
-{
-    union {
-        uint8x16_t    val;
-        uint8x8x2_t    pair;
-    } __a = { a };
-
-    return vcombine_u8(vtbl2_u8(__a.pair, vget_low_u8(b)),
-                       vtbl2_u8(__a.pair, vget_high_u8(b)));
-}
-#endif
-#endif
-
-//------------------------------------------------------------------------------
-// Self-Test
-//
-// This is executed during initialization to make sure the library is working
-
-static const unsigned kTestBufferBytes = 32 + 16 + 8 + 4 + 2 + 1;
-static const unsigned kTestBufferAllocated = 64;
-struct SelfTestBuffersT
-{
-    GF256_ALIGNED uint8_t A[kTestBufferAllocated];
-    GF256_ALIGNED uint8_t B[kTestBufferAllocated];
-    GF256_ALIGNED uint8_t C[kTestBufferAllocated];
-};
-static GF256_ALIGNED SelfTestBuffersT m_SelfTestBuffers;
-
-static bool gf256_self_test()
-{
-    if ((uintptr_t)m_SelfTestBuffers.A % GF256_ALIGN_BYTES != 0)
-        return false;
-    if ((uintptr_t)m_SelfTestBuffers.A % GF256_ALIGN_BYTES != 0)
-        return false;
-    if ((uintptr_t)m_SelfTestBuffers.B % GF256_ALIGN_BYTES != 0)
-        return false;
-    if ((uintptr_t)m_SelfTestBuffers.C % GF256_ALIGN_BYTES != 0)
-        return false;
-
-    // Check multiplication/division
-    for (unsigned i = 0; i < 256; ++i)
-    {
-        for (unsigned j = 0; j < 256; ++j)
-        {
-            uint8_t prod = gf256_mul((uint8_t)i, (uint8_t)j);
-            if (i != 0 && j != 0)
-            {
-                uint8_t div1 = gf256_div(prod, (uint8_t)i);
-                if (div1 != j)
-                    return false;
-                uint8_t div2 = gf256_div(prod, (uint8_t)j);
-                if (div2 != i)
-                    return false;
-            }
-            else if (prod != 0)
-                return false;
-            if (j == 1 && prod != i)
-                return false;
-        }
-    }
-
-    // Check for overruns
-    m_SelfTestBuffers.A[kTestBufferBytes] = 0x5a;
-    m_SelfTestBuffers.B[kTestBufferBytes] = 0x5a;
-    m_SelfTestBuffers.C[kTestBufferBytes] = 0x5a;
-
-    // Test gf256_add_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-    {
-        m_SelfTestBuffers.A[i] = 0x1f;
-        m_SelfTestBuffers.B[i] = 0xf7;
-    }
-    gf256_add_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != (0x1f ^ 0xf7))
-            return false;
-
-    // Test gf256_add2_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-    {
-        m_SelfTestBuffers.A[i] = 0x1f;
-        m_SelfTestBuffers.B[i] = 0xf7;
-        m_SelfTestBuffers.C[i] = 0x71;
-    }
-    gf256_add2_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, m_SelfTestBuffers.C, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != (0x1f ^ 0xf7 ^ 0x71))
-            return false;
-
-    // Test gf256_addset_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-    {
-        m_SelfTestBuffers.A[i] = 0x55;
-        m_SelfTestBuffers.B[i] = 0xaa;
-        m_SelfTestBuffers.C[i] = 0x6c;
-    }
-    gf256_addset_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, m_SelfTestBuffers.C, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != (0xaa ^ 0x6c))
-            return false;
-
-    // Test gf256_muladd_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-    {
-        m_SelfTestBuffers.A[i] = 0xff;
-        m_SelfTestBuffers.B[i] = 0xaa;
-    }
-    const uint8_t expectedMulAdd = gf256_mul(0xaa, 0x6c);
-    gf256_muladd_mem(m_SelfTestBuffers.A, 0x6c, m_SelfTestBuffers.B, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != (expectedMulAdd ^ 0xff))
-            return false;
-
-    // Test gf256_mul_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-    {
-        m_SelfTestBuffers.A[i] = 0xff;
-        m_SelfTestBuffers.B[i] = 0x55;
-    }
-    const uint8_t expectedMul = gf256_mul(0xa2, 0x55);
-    gf256_mul_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, 0xa2, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != expectedMul)
-            return false;
-
-    if (m_SelfTestBuffers.A[kTestBufferBytes] != 0x5a)
-        return false;
-    if (m_SelfTestBuffers.B[kTestBufferBytes] != 0x5a)
-        return false;
-    if (m_SelfTestBuffers.C[kTestBufferBytes] != 0x5a)
-        return false;
-
-    return true;
-}
-
-
-//------------------------------------------------------------------------------
-// Runtime CPU Architecture Check
-//
-// Feature checks stolen shamelessly from
-// https://github.com/jedisct1/libsodium/blob/master/src/libsodium/sodium/runtime.c
-
-#if defined(HAVE_ANDROID_GETCPUFEATURES)
-#include <cpu-features.h>
-#endif
-
-#if defined(GF256_TRY_NEON)
-# if defined(IOS) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
-// Requires iPhone 5S or newer
-static const bool CpuHasNeon = true;
-static const bool CpuHasNeon64 = true;
-# else // ANDROID or LINUX_ARM
-#  if defined(__aarch64__)
-static bool CpuHasNeon = true;      // if AARCH64, then we have NEON for sure...
-static bool CpuHasNeon64 = true;    // And we have ASIMD
-#  else
-static bool CpuHasNeon = false;     // if not, then we have to check at runtime.
-static bool CpuHasNeon64 = false;   // And we don't have ASIMD
-#  endif
-# endif
-#endif
-
-#if !defined(GF256_TARGET_MOBILE)
-
-#ifdef _MSC_VER
-    #include <intrin.h> // __cpuid
-    #pragma warning(disable: 4752) // found Intel(R) Advanced Vector Extensions; consider using /arch:AVX
-#endif
-
-#ifdef GF256_TRY_AVX2
-static bool CpuHasAVX2 = false;
-#endif
-static bool CpuHasSSSE3 = false;
-
-#define CPUID_EBX_AVX2    0x00000020
-#define CPUID_ECX_SSSE3   0x00000200
-
-static void _cpuid(unsigned int cpu_info[4U], const unsigned int cpu_info_type)
-{
-#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86))
-    __cpuid((int *) cpu_info, cpu_info_type);
-#else //if defined(HAVE_CPUID)
-    cpu_info[0] = cpu_info[1] = cpu_info[2] = cpu_info[3] = 0;
-# ifdef __i386__
-    __asm__ __volatile__ ("pushfl; pushfl; "
-                          "popl %0; "
-                          "movl %0, %1; xorl %2, %0; "
-                          "pushl %0; "
-                          "popfl; pushfl; popl %0; popfl" :
-                          "=&r" (cpu_info[0]), "=&r" (cpu_info[1]) :
-                          "i" (0x200000));
-    if (((cpu_info[0] ^ cpu_info[1]) & 0x200000) == 0) {
-        return; /* LCOV_EXCL_LINE */
-    }
-# endif
-# ifdef __i386__
-    __asm__ __volatile__ ("xchgl %%ebx, %k1; cpuid; xchgl %%ebx, %k1" :
-                          "=a" (cpu_info[0]), "=&r" (cpu_info[1]),
-                          "=c" (cpu_info[2]), "=d" (cpu_info[3]) :
-                          "0" (cpu_info_type), "2" (0U));
-# elif defined(__x86_64__)
-    __asm__ __volatile__ ("xchgq %%rbx, %q1; cpuid; xchgq %%rbx, %q1" :
-                          "=a" (cpu_info[0]), "=&r" (cpu_info[1]),
-                          "=c" (cpu_info[2]), "=d" (cpu_info[3]) :
-                          "0" (cpu_info_type), "2" (0U));
-# else
-    __asm__ __volatile__ ("cpuid" :
-                          "=a" (cpu_info[0]), "=b" (cpu_info[1]),
-                          "=c" (cpu_info[2]), "=d" (cpu_info[3]) :
-                          "0" (cpu_info_type), "2" (0U));
-# endif
-#endif
-}
-
-#else
-#if defined(LINUX_ARM)
-static void checkLinuxARMNeonCapabilities( bool& cpuHasNeon )
-{
-    auto cpufile = open("/proc/self/auxv", O_RDONLY);
-    Elf32_auxv_t auxv;
-    if (cpufile >= 0)
-    {
-        const auto size_auxv_t = sizeof(Elf32_auxv_t);
-        while (read(cpufile, &auxv, size_auxv_t) == size_auxv_t)
-        {
-            if (auxv.a_type == AT_HWCAP)
-            {
-                cpuHasNeon = (auxv.a_un.a_val & 4096) != 0;
-                break;
-            }
-        }
-        close(cpufile);
-    }
-    else
-    {
-        cpuHasNeon = false;
-    }
-}
-#endif
-#endif // defined(GF256_TARGET_MOBILE)
-
-static void gf256_architecture_init()
-{
-#if defined(GF256_TRY_NEON)
-
-    // Check for NEON support on Android platform
-#if defined(HAVE_ANDROID_GETCPUFEATURES)
-    AndroidCpuFamily family = android_getCpuFamily();
-    if (family == ANDROID_CPU_FAMILY_ARM)
-    {
-        if (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON)
-            CpuHasNeon = true;
-    }
-    else if (family == ANDROID_CPU_FAMILY_ARM64)
-    {
-        CpuHasNeon = true;
-        if (android_getCpuFeatures() & ANDROID_CPU_ARM64_FEATURE_ASIMD)
-            CpuHasNeon64 = true;
-    }
-#endif
-
-#if defined(LINUX_ARM)
-    // Check for NEON support on other ARM/Linux platforms
-    checkLinuxARMNeonCapabilities(CpuHasNeon);
-#endif
-
-#endif //GF256_TRY_NEON
-
-#if !defined(GF256_TARGET_MOBILE)
-    unsigned int cpu_info[4];
-
-    _cpuid(cpu_info, 1);
-    CpuHasSSSE3 = ((cpu_info[2] & CPUID_ECX_SSSE3) != 0);
-
-#if defined(GF256_TRY_AVX2)
-    _cpuid(cpu_info, 7);
-    CpuHasAVX2 = ((cpu_info[1] & CPUID_EBX_AVX2) != 0);
-#endif // GF256_TRY_AVX2
-
-    // When AVX2 and SSSE3 are unavailable, Siamese takes 4x longer to decode
-    // and 2.6x longer to encode.  Encoding requires a lot more simple XOR ops
-    // so it is still pretty fast.  Decoding is usually really quick because
-    // average loss rates are low, but when needed it requires a lot more
-    // GF multiplies requiring table lookups which is slower.
-
-#endif // GF256_TARGET_MOBILE
-}
-
-
-//------------------------------------------------------------------------------
-// Context Object
-
-// Context object for GF(2^^8) math
-GF256_ALIGNED gf256_ctx GF256Ctx;
-static bool Initialized = false;
-
-
-//------------------------------------------------------------------------------
-// Generator Polynomial
-
-// There are only 16 irreducible polynomials for GF(2^^8)
-static const int GF256_GEN_POLY_COUNT = 16;
-static const uint8_t GF256_GEN_POLY[GF256_GEN_POLY_COUNT] = {
-    0x8e, 0x95, 0x96, 0xa6, 0xaf, 0xb1, 0xb2, 0xb4,
-    0xb8, 0xc3, 0xc6, 0xd4, 0xe1, 0xe7, 0xf3, 0xfa
-};
-
-static const int kDefaultPolynomialIndex = 3;
-
-// Select which polynomial to use
-static void gf256_poly_init(int polynomialIndex)
-{
-    if (polynomialIndex < 0 || polynomialIndex >= GF256_GEN_POLY_COUNT)
-        polynomialIndex = kDefaultPolynomialIndex;
-
-    GF256Ctx.Polynomial = (GF256_GEN_POLY[polynomialIndex] << 1) | 1;
-}
-
-
-//------------------------------------------------------------------------------
-// Exponential and Log Tables
-
-// Construct EXP and LOG tables from polynomial
-static void gf256_explog_init()
-{
-    unsigned poly = GF256Ctx.Polynomial;
-    uint8_t* exptab = GF256Ctx.GF256_EXP_TABLE;
-    uint16_t* logtab = GF256Ctx.GF256_LOG_TABLE;
-
-    logtab[0] = 512;
-    exptab[0] = 1;
-    for (unsigned jj = 1; jj < 255; ++jj)
-    {
-        unsigned next = (unsigned)exptab[jj - 1] * 2;
-        if (next >= 256)
-            next ^= poly;
-
-        exptab[jj] = static_cast<uint8_t>( next );
-        logtab[exptab[jj]] = static_cast<uint16_t>( jj );
-    }
-    exptab[255] = exptab[0];
-    logtab[exptab[255]] = 255;
-    for (unsigned jj = 256; jj < 2 * 255; ++jj)
-        exptab[jj] = exptab[jj % 255];
-    exptab[2 * 255] = 1;
-    for (unsigned jj = 2 * 255 + 1; jj < 4 * 255; ++jj)
-        exptab[jj] = 0;
-}
-
-
-//------------------------------------------------------------------------------
-// Multiply and Divide Tables
-
-// Initialize MUL and DIV tables using LOG and EXP tables
-static void gf256_muldiv_init()
-{
-    // Allocate table memory 65KB x 2
-    uint8_t* m = GF256Ctx.GF256_MUL_TABLE;
-    uint8_t* d = GF256Ctx.GF256_DIV_TABLE;
-
-    // Unroll y = 0 subtable
-    for (int x = 0; x < 256; ++x)
-        m[x] = d[x] = 0;
-
-    // For each other y value:
-    for (int y = 1; y < 256; ++y)
-    {
-        // Calculate log(y) for mult and 255 - log(y) for div
-        const uint8_t log_y = static_cast<uint8_t>(GF256Ctx.GF256_LOG_TABLE[y]);
-        const uint8_t log_yn = 255 - log_y;
-
-        // Next subtable
-        m += 256, d += 256;
-
-        // Unroll x = 0
-        m[0] = 0, d[0] = 0;
-
-        // Calculate x * y, x / y
-        for (int x = 1; x < 256; ++x)
-        {
-            uint16_t log_x = GF256Ctx.GF256_LOG_TABLE[x];
-
-            m[x] = GF256Ctx.GF256_EXP_TABLE[log_x + log_y];
-            d[x] = GF256Ctx.GF256_EXP_TABLE[log_x + log_yn];
-        }
-    }
-}
-
-
-//------------------------------------------------------------------------------
-// Inverse Table
-
-// Initialize INV table using DIV table
-static void gf256_inv_init()
-{
-    for (int x = 0; x < 256; ++x)
-        GF256Ctx.GF256_INV_TABLE[x] = gf256_div(1, static_cast<uint8_t>(x));
-}
-
-
-//------------------------------------------------------------------------------
-// Square Table
-
-// Initialize SQR table using MUL table
-static void gf256_sqr_init()
-{
-    for (int x = 0; x < 256; ++x)
-        GF256Ctx.GF256_SQR_TABLE[x] = gf256_mul(static_cast<uint8_t>(x), static_cast<uint8_t>(x));
-}
-
-
-//------------------------------------------------------------------------------
-// Multiply and Add Memory Tables
-
-/*
-    Fast algorithm to compute m[1..8] = a[1..8] * b in GF(256)
-    using SSE3 SIMD instruction set:
-
-    Consider z = x * y in GF(256).
-    This operation can be performed bit-by-bit.  Usefully, the partial product
-    of each bit is combined linearly with the rest.  This means that the 8-bit
-    number x can be split into its high and low 4 bits, and partial products
-    can be formed from each half.  Then the halves can be linearly combined:
-
-        z = x[0..3] * y + x[4..7] * y
-
-    The multiplication of each half can be done efficiently via table lookups,
-    and the addition in GF(256) is XOR.  There must be two tables that map 16
-    input elements for the low or high 4 bits of x to the two partial products.
-    Each value for y has a different set of two tables:
-
-        z = TABLE_LO_y(x[0..3]) xor TABLE_HI_y(x[4..7])
-
-    This means that we need 16 * 2 * 256 = 8192 bytes for precomputed tables.
-
-    Computing z[] = x[] * y can be performed 16 bytes at a time by using the
-    128-bit register operations supported by modern processors.
-
-    This is efficiently realized in SSE3 using the _mm_shuffle_epi8() function
-    provided by Visual Studio 2010 or newer in <tmmintrin.h>.  This function
-    uses the low bits to do a table lookup on each byte.  Unfortunately the
-    high bit of each mask byte has the special feature that it clears the
-    output byte when it is set, so we need to make sure it's cleared by masking
-    off the high bit of each byte before using it:
-
-        clr_mask = _mm_set1_epi8(0x0f) = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-
-    For the low half of the partial product, clear the high bit of each byte
-    and perform the table lookup:
-
-        p_lo = _mm_and_si128(x, clr_mask)
-        p_lo = _mm_shuffle_epi8(p_lo, TABLE_LO_y)
-
-    For the high half of the partial product, shift the high 4 bits of each
-    byte into the low 4 bits and clear the high bit of each byte, and then
-    perform the table lookup:
-
-        p_hi = _mm_srli_epi64(x, 4)
-        p_hi = _mm_and_si128(p_hi, clr_mask)
-        p_hi = _mm_shuffle_epi8(p_hi, TABLE_HI_y)
-
-    Finally add the two partial products to form the product, recalling that
-    addition is XOR in a Galois field:
-
-        result = _mm_xor_si128(p_lo, p_hi)
-
-    This crunches 16 bytes of x at a time, and the result can be stored in z.
-*/
-
-/*
-    Intrinsic reference:
-
-    SSE3, VS2010+, tmmintrin.h:
-
-    GF256_M128 _mm_shuffle_epi8(GF256_M128 a, GF256_M128 mask);
-        Emits the Supplemental Streaming SIMD Extensions 3 (SSSE3) instruction pshufb. This instruction shuffles 16-byte parameters from a 128-bit parameter.
-
-        Pseudo-code for PSHUFB (with 128 bit operands):
-
-            for i = 0 to 15 {
-                 if (SRC[(i * 8)+7] = 1 ) then
-                      DEST[(i*8)+7..(i*8)+0] <- 0;
-                  else
-                      index[3..0] <- SRC[(i*8)+3 .. (i*8)+0];
-                      DEST[(i*8)+7..(i*8)+0] <- DEST[(index*8+7)..(index*8+0)];
-                 endif
-            }
-
-    SSE2, VS2008+, emmintrin.h:
-
-    GF256_M128 _mm_slli_epi64 (GF256_M128 a, int count);
-        Shifts the 2 signed or unsigned 64-bit integers in a left by count bits while shifting in zeros.
-    GF256_M128 _mm_srli_epi64 (GF256_M128 a, int count);
-        Shifts the 2 signed or unsigned 64-bit integers in a right by count bits while shifting in zeros.
-    GF256_M128 _mm_set1_epi8 (char b);
-        Sets the 16 signed 8-bit integer values to b.
-    GF256_M128 _mm_and_si128 (GF256_M128 a, GF256_M128 b);
-        Computes the bitwise AND of the 128-bit value in a and the 128-bit value in b.
-    GF256_M128 _mm_xor_si128 ( GF256_M128 a, GF256_M128 b);
-        Computes the bitwise XOR of the 128-bit value in a and the 128-bit value in b.
-*/
-
-// Initialize the multiplication tables using gf256_mul()
-static void gf256_mul_mem_init()
-{
-    // Reuse aligned self test buffers to load table data
-    uint8_t* lo = m_SelfTestBuffers.A;
-    uint8_t* hi = m_SelfTestBuffers.B;
-
-    for (int y = 0; y < 256; ++y)
-    {
-        // TABLE_LO_Y maps 0..15 to 8-bit partial product based on y.
-        for (unsigned char x = 0; x < 16; ++x)
-        {
-            lo[x] = gf256_mul(x, static_cast<uint8_t>( y ));
-            hi[x] = gf256_mul(x << 4, static_cast<uint8_t>( y ));
-        }
-
-#if defined(GF256_TRY_NEON)
-        if (CpuHasNeon)
-        {
-            GF256Ctx.MM128.TABLE_LO_Y[y] = vld1q_u8(lo);
-            GF256Ctx.MM128.TABLE_HI_Y[y] = vld1q_u8(hi);
-        }
-#elif !defined(GF256_TARGET_MOBILE)
-        const GF256_M128 table_lo = _mm_loadu_si128((GF256_M128*)lo);
-        const GF256_M128 table_hi = _mm_loadu_si128((GF256_M128*)hi);
-        _mm_storeu_si128(GF256Ctx.MM128.TABLE_LO_Y + y, table_lo);
-        _mm_storeu_si128(GF256Ctx.MM128.TABLE_HI_Y + y, table_hi);
-# ifdef GF256_TRY_AVX2
-        if (CpuHasAVX2)
-        {
-            const GF256_M256 table_lo2 = _mm256_broadcastsi128_si256(table_lo);
-            const GF256_M256 table_hi2 = _mm256_broadcastsi128_si256(table_hi);
-            _mm256_storeu_si256(GF256Ctx.MM256.TABLE_LO_Y + y, table_lo2);
-            _mm256_storeu_si256(GF256Ctx.MM256.TABLE_HI_Y + y, table_hi2);
-        }
-# endif // GF256_TRY_AVX2
-#endif // GF256_TARGET_MOBILE
-    }
-}
-
-
-//------------------------------------------------------------------------------
-// Initialization
-
-#ifdef GF256_IS_BIG_ENDIAN
-static unsigned char kEndianTestData[4] = { 1, 2, 3, 4 };
-#else
-static unsigned char kEndianTestData[4] = { 4, 3, 2, 1 };
-#endif
-
-union UnionType
-{
-    uint32_t IntValue;
-    char CharArray[4];
-};
-
-static bool IsExpectedEndian()
-{
-    UnionType type;
-    for (unsigned i = 0; i < 4; ++i)
-        type.CharArray[i] = kEndianTestData[i];
-    return 0x01020304 == type.IntValue;
-}
-
-extern "C" int gf256_init_(int version)
-{
-    if (version != GF256_VERSION)
-        return -1; // User's header does not match library version.
-
-    // Avoid multiple initialization
-    if (Initialized)
-        return 0;
-    Initialized = true;
-
-    if (!IsExpectedEndian())
-        return -2; // Unexpected byte order.
-
-    gf256_architecture_init();
-    gf256_poly_init(kDefaultPolynomialIndex);
-    gf256_explog_init();
-    gf256_muldiv_init();
-    gf256_inv_init();
-    gf256_sqr_init();
-    gf256_mul_mem_init();
-
-    if (!gf256_self_test())
-        return -3; // Self-test failed (perhaps untested configuration)
-
-    return 0;
-}
-
-
-//------------------------------------------------------------------------------
-// Operations
-
-extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
-                              const void * GF256_RESTRICT vy, int bytes)
-{
-    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
-    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(vy);
-
-#if defined(GF256_TARGET_MOBILE)
-# if defined(GF256_TRY_NEON)
-    // Handle multiples of 64 bytes
-    if (CpuHasNeon)
-    {
-        while (bytes >= 64)
-        {
-            GF256_M128 x0 = vld1q_u8((uint8_t*) x16);
-            GF256_M128 x1 = vld1q_u8((uint8_t*)(x16 + 1) );
-            GF256_M128 x2 = vld1q_u8((uint8_t*)(x16 + 2) );
-            GF256_M128 x3 = vld1q_u8((uint8_t*)(x16 + 3) );
-            GF256_M128 y0 = vld1q_u8((uint8_t*)y16);
-            GF256_M128 y1 = vld1q_u8((uint8_t*)(y16 + 1));
-            GF256_M128 y2 = vld1q_u8((uint8_t*)(y16 + 2));
-            GF256_M128 y3 = vld1q_u8((uint8_t*)(y16 + 3));
-
-            vst1q_u8((uint8_t*)x16,     veorq_u8(x0, y0));
-            vst1q_u8((uint8_t*)(x16 + 1), veorq_u8(x1, y1));
-            vst1q_u8((uint8_t*)(x16 + 2), veorq_u8(x2, y2));
-            vst1q_u8((uint8_t*)(x16 + 3), veorq_u8(x3, y3));
-
-            bytes -= 64, x16 += 4, y16 += 4;
-        }
-
-        // Handle multiples of 16 bytes
-        while (bytes >= 16)
-        {
-            GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
-            GF256_M128 y0 = vld1q_u8((uint8_t*)y16);
-
-            vst1q_u8((uint8_t*)x16, veorq_u8(x0, y0));
-
-            bytes -= 16, ++x16, ++y16;
-        }
-    }
-    else
-# endif // GF256_TRY_NEON
-    {
-        uint64_t * GF256_RESTRICT x8 = reinterpret_cast<uint64_t *>(x16);
-        const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(y16);
-
-        const unsigned count = (unsigned)bytes / 8;
-        for (unsigned ii = 0; ii < count; ++ii)
-            x8[ii] ^= y8[ii];
-
-        x16 = reinterpret_cast<GF256_M128 *>(x8 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y8 + count);
-
-        bytes -= (count * 8);
-    }
-#else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (CpuHasAVX2)
-    {
-        GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<GF256_M256 *>(x16);
-        const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(y16);
-
-        while (bytes >= 128)
-        {
-            GF256_M256 x0 = _mm256_loadu_si256(x32);
-            GF256_M256 y0 = _mm256_loadu_si256(y32);
-            x0 = _mm256_xor_si256(x0, y0);
-            GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
-            GF256_M256 y1 = _mm256_loadu_si256(y32 + 1);
-            x1 = _mm256_xor_si256(x1, y1);
-            GF256_M256 x2 = _mm256_loadu_si256(x32 + 2);
-            GF256_M256 y2 = _mm256_loadu_si256(y32 + 2);
-            x2 = _mm256_xor_si256(x2, y2);
-            GF256_M256 x3 = _mm256_loadu_si256(x32 + 3);
-            GF256_M256 y3 = _mm256_loadu_si256(y32 + 3);
-            x3 = _mm256_xor_si256(x3, y3);
-
-            _mm256_storeu_si256(x32, x0);
-            _mm256_storeu_si256(x32 + 1, x1);
-            _mm256_storeu_si256(x32 + 2, x2);
-            _mm256_storeu_si256(x32 + 3, x3);
-
-            bytes -= 128, x32 += 4, y32 += 4;
-        }
-
-        // Handle multiples of 32 bytes
-        while (bytes >= 32)
-        {
-            // x[i] = x[i] xor y[i]
-            _mm256_storeu_si256(x32,
-                _mm256_xor_si256(
-                    _mm256_loadu_si256(x32),
-                    _mm256_loadu_si256(y32)));
-
-            bytes -= 32, ++x32, ++y32;
-        }
-
-        x16 = reinterpret_cast<GF256_M128 *>(x32);
-        y16 = reinterpret_cast<const GF256_M128 *>(y32);
-    }
-    else
-# endif // GF256_TRY_AVX2
-    {
-        while (bytes >= 64)
-        {
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 y0 = _mm_loadu_si128(y16);
-            x0 = _mm_xor_si128(x0, y0);
-            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
-            GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
-            x1 = _mm_xor_si128(x1, y1);
-            GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
-            GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
-            x2 = _mm_xor_si128(x2, y2);
-            GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
-            GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
-            x3 = _mm_xor_si128(x3, y3);
-
-            _mm_storeu_si128(x16, x0);
-            _mm_storeu_si128(x16 + 1, x1);
-            _mm_storeu_si128(x16 + 2, x2);
-            _mm_storeu_si128(x16 + 3, x3);
-
-            bytes -= 64, x16 += 4, y16 += 4;
-        }
-    }
-#endif // GF256_TARGET_MOBILE
-
-#if !defined(GF256_TARGET_MOBILE)
-    // Handle multiples of 16 bytes
-    while (bytes >= 16)
-    {
-        // x[i] = x[i] xor y[i]
-        _mm_storeu_si128(x16,
-            _mm_xor_si128(
-                _mm_loadu_si128(x16),
-                _mm_loadu_si128(y16)));
-
-        bytes -= 16, ++x16, ++y16;
-    }
-#endif
-
-    uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(x16);
-    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y16);
-
-    // Handle a block of 8 bytes
-    const int eight = bytes & 8;
-    if (eight)
-    {
-        uint64_t * GF256_RESTRICT x8 = reinterpret_cast<uint64_t *>(x1);
-        const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(y1);
-        *x8 ^= *y8;
-    }
-
-    // Handle a block of 4 bytes
-    const int four = bytes & 4;
-    if (four)
-    {
-        uint32_t * GF256_RESTRICT x4 = reinterpret_cast<uint32_t *>(x1 + eight);
-        const uint32_t * GF256_RESTRICT y4 = reinterpret_cast<const uint32_t *>(y1 + eight);
-        *x4 ^= *y4;
-    }
-
-    // Handle final bytes
-    const int offset = eight + four;
-    switch (bytes & 3)
-    {
-    case 3: x1[offset + 2] ^= y1[offset + 2];
-    case 2: x1[offset + 1] ^= y1[offset + 1];
-    case 1: x1[offset] ^= y1[offset];
-    default:
-        break;
-    }
-}
-
-extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                               const void * GF256_RESTRICT vy, int bytes)
-{
-    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
-    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
-    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
-
-#if defined(GF256_TARGET_MOBILE)
-# if defined(GF256_TRY_NEON)
-    // Handle multiples of 64 bytes
-    if (CpuHasNeon)
-    {
-        // Handle multiples of 16 bytes
-        while (bytes >= 16)
-        {
-            // z[i] = z[i] xor x[i] xor y[i]
-            vst1q_u8((uint8_t*)z16,
-                veorq_u8(
-                    vld1q_u8((uint8_t*)z16),
-                    veorq_u8(
-                        vld1q_u8((uint8_t*)x16),
-                        vld1q_u8((uint8_t*)y16))));
-
-            bytes -= 16, ++x16, ++y16, ++z16;
-        }
-    }
-    else
-# endif // GF256_TRY_NEON
-    {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z16);
-        const uint64_t * GF256_RESTRICT x8 = reinterpret_cast<const uint64_t *>(x16);
-        const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(y16);
-
-        const unsigned count = (unsigned)bytes / 8;
-        for (unsigned ii = 0; ii < count; ++ii)
-            z8[ii] ^= x8[ii] ^ y8[ii];
-
-        z16 = reinterpret_cast<GF256_M128 *>(z8 + count);
-        x16 = reinterpret_cast<const GF256_M128 *>(x8 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y8 + count);
-
-        bytes -= (count * 8);
-    }
-#else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (CpuHasAVX2)
-    {
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z16);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x16);
-        const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(y16);
-
-        const unsigned count = bytes / 32;
-        for (unsigned i = 0; i < count; ++i)
-        {
-            _mm256_storeu_si256(z32 + i,
-                _mm256_xor_si256(
-                    _mm256_loadu_si256(z32 + i),
-                    _mm256_xor_si256(
-                        _mm256_loadu_si256(x32 + i),
-                        _mm256_loadu_si256(y32 + i))));
-        }
-
-        bytes -= count * 32;
-        z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
-    }
-# endif // GF256_TRY_AVX2
-
-    // Handle multiples of 16 bytes
-    while (bytes >= 16)
-    {
-        // z[i] = z[i] xor x[i] xor y[i]
-        _mm_storeu_si128(z16,
-            _mm_xor_si128(
-                _mm_loadu_si128(z16),
-                _mm_xor_si128(
-                    _mm_loadu_si128(x16),
-                    _mm_loadu_si128(y16))));
-
-        bytes -= 16, ++x16, ++y16, ++z16;
-    }
-#endif // GF256_TARGET_MOBILE
-
-    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(z16);
-    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(x16);
-    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y16);
-
-    // Handle a block of 8 bytes
-    const int eight = bytes & 8;
-    if (eight)
-    {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
-        const uint64_t * GF256_RESTRICT x8 = reinterpret_cast<const uint64_t *>(x1);
-        const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(y1);
-        *z8 ^= *x8 ^ *y8;
-    }
-
-    // Handle a block of 4 bytes
-    const int four = bytes & 4;
-    if (four)
-    {
-        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1 + eight);
-        const uint32_t * GF256_RESTRICT x4 = reinterpret_cast<const uint32_t *>(x1 + eight);
-        const uint32_t * GF256_RESTRICT y4 = reinterpret_cast<const uint32_t *>(y1 + eight);
-        *z4 ^= *x4 ^ *y4;
-    }
-
-    // Handle final bytes
-    const int offset = eight + four;
-    switch (bytes & 3)
-    {
-    case 3: z1[offset + 2] ^= x1[offset + 2] ^ y1[offset + 2];
-    case 2: z1[offset + 1] ^= x1[offset + 1] ^ y1[offset + 1];
-    case 1: z1[offset] ^= x1[offset] ^ y1[offset];
-    default:
-        break;
-    }
-}
-
-extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                                 const void * GF256_RESTRICT vy, int bytes)
-{
-    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
-    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
-    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
-
-#if defined(GF256_TARGET_MOBILE)
-# if defined(GF256_TRY_NEON)
-    // Handle multiples of 64 bytes
-    if (CpuHasNeon)
-    {
-        while (bytes >= 64)
-        {
-            GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
-            GF256_M128 x1 = vld1q_u8((uint8_t*)(x16 + 1));
-            GF256_M128 x2 = vld1q_u8((uint8_t*)(x16 + 2));
-            GF256_M128 x3 = vld1q_u8((uint8_t*)(x16 + 3));
-            GF256_M128 y0 = vld1q_u8((uint8_t*)(y16));
-            GF256_M128 y1 = vld1q_u8((uint8_t*)(y16 + 1));
-            GF256_M128 y2 = vld1q_u8((uint8_t*)(y16 + 2));
-            GF256_M128 y3 = vld1q_u8((uint8_t*)(y16 + 3));
-
-            vst1q_u8((uint8_t*)z16,     veorq_u8(x0, y0));
-            vst1q_u8((uint8_t*)(z16 + 1), veorq_u8(x1, y1));
-            vst1q_u8((uint8_t*)(z16 + 2), veorq_u8(x2, y2));
-            vst1q_u8((uint8_t*)(z16 + 3), veorq_u8(x3, y3));
-
-            bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
-        }
-
-        // Handle multiples of 16 bytes
-        while (bytes >= 16)
-        {
-            // z[i] = x[i] xor y[i]
-            vst1q_u8((uint8_t*)z16,
-                     veorq_u8(
-                         vld1q_u8((uint8_t*)x16),
-                         vld1q_u8((uint8_t*)y16)));
-
-            bytes -= 16, ++x16, ++y16, ++z16;
-        }
-    }
-    else
-# endif // GF256_TRY_NEON
-    {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z16);
-        const uint64_t * GF256_RESTRICT x8 = reinterpret_cast<const uint64_t *>(x16);
-        const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(y16);
-
-        const unsigned count = (unsigned)bytes / 8;
-        for (unsigned ii = 0; ii < count; ++ii)
-            z8[ii] = x8[ii] ^ y8[ii];
-
-        x16 = reinterpret_cast<const GF256_M128 *>(x8 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y8 + count);
-        z16 = reinterpret_cast<GF256_M128 *>(z8 + count);
-
-        bytes -= (count * 8);
-    }
-#else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (CpuHasAVX2)
-    {
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z16);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x16);
-        const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(y16);
-
-        const unsigned count = bytes / 32;
-        for (unsigned i = 0; i < count; ++i)
-        {
-            _mm256_storeu_si256(z32 + i,
-                _mm256_xor_si256(
-                    _mm256_loadu_si256(x32 + i),
-                    _mm256_loadu_si256(y32 + i)));
-        }
-
-        bytes -= count * 32;
-        z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
-    }
-    else
-# endif // GF256_TRY_AVX2
-    {
-        // Handle multiples of 64 bytes
-        while (bytes >= 64)
-        {
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
-            GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
-            GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
-            GF256_M128 y0 = _mm_loadu_si128(y16);
-            GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
-            GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
-            GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
-
-            _mm_storeu_si128(z16,     _mm_xor_si128(x0, y0));
-            _mm_storeu_si128(z16 + 1, _mm_xor_si128(x1, y1));
-            _mm_storeu_si128(z16 + 2, _mm_xor_si128(x2, y2));
-            _mm_storeu_si128(z16 + 3, _mm_xor_si128(x3, y3));
-
-            bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
-        }
-    }
-
-    // Handle multiples of 16 bytes
-    while (bytes >= 16)
-    {
-        // z[i] = x[i] xor y[i]
-        _mm_storeu_si128(z16,
-            _mm_xor_si128(
-                _mm_loadu_si128(x16),
-                _mm_loadu_si128(y16)));
-
-        bytes -= 16, ++x16, ++y16, ++z16;
-    }
-#endif // GF256_TARGET_MOBILE
-
-    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(z16);
-    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(x16);
-    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y16);
-
-    // Handle a block of 8 bytes
-    const int eight = bytes & 8;
-    if (eight)
-    {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
-        const uint64_t * GF256_RESTRICT x8 = reinterpret_cast<const uint64_t *>(x1);
-        const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(y1);
-        *z8 = *x8 ^ *y8;
-    }
-
-    // Handle a block of 4 bytes
-    const int four = bytes & 4;
-    if (four)
-    {
-        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1 + eight);
-        const uint32_t * GF256_RESTRICT x4 = reinterpret_cast<const uint32_t *>(x1 + eight);
-        const uint32_t * GF256_RESTRICT y4 = reinterpret_cast<const uint32_t *>(y1 + eight);
-        *z4 = *x4 ^ *y4;
-    }
-
-    // Handle final bytes
-    const int offset = eight + four;
-    switch (bytes & 3)
-    {
-    case 3: z1[offset + 2] = x1[offset + 2] ^ y1[offset + 2];
-    case 2: z1[offset + 1] = x1[offset + 1] ^ y1[offset + 1];
-    case 1: z1[offset] = x1[offset] ^ y1[offset];
-    default:
-        break;
-    }
-}
-
-extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
-{
-    // Use a single if-statement to handle special cases
-    if (y <= 1)
-    {
-        if (y == 0)
-            memset(vz, 0, bytes);
-        else if (vz != vx)
-            memcpy(vz, vx, bytes);
-        return;
-    }
-
-    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
-    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
-
-#if defined(GF256_TARGET_MOBILE)
-#if defined(GF256_TRY_NEON)
-    if (bytes >= 16 && CpuHasNeon)
-    {
-        // Partial product tables; see above
-        const GF256_M128 table_lo_y = vld1q_u8((uint8_t*)(GF256Ctx.MM128.TABLE_LO_Y + y));
-        const GF256_M128 table_hi_y = vld1q_u8((uint8_t*)(GF256Ctx.MM128.TABLE_HI_Y + y));
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M128 clr_mask = vdupq_n_u8(0x0f);
-
-        // Handle multiples of 16 bytes
-        do
-        {
-            // See above comments for details
-            GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
-            GF256_M128 l0 = vandq_u8(x0, clr_mask);
-            x0 = vshrq_n_u8(x0, 4);
-            GF256_M128 h0 = vandq_u8(x0, clr_mask);
-            l0 = vqtbl1q_u8(table_lo_y, l0);
-            h0 = vqtbl1q_u8(table_hi_y, h0);
-            vst1q_u8((uint8_t*)z16, veorq_u8(l0, h0));
-
-            bytes -= 16, ++x16, ++z16;
-        } while (bytes >= 16);
-    }
-#endif
-#else
-# if defined(GF256_TRY_AVX2)
-    if (bytes >= 32 && CpuHasAVX2)
-    {
-        // Partial product tables; see above
-        const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + y);
-        const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
-
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
-
-        // Handle multiples of 32 bytes
-        do
-        {
-            // See above comments for details
-            GF256_M256 x0 = _mm256_loadu_si256(x32);
-            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
-            x0 = _mm256_srli_epi64(x0, 4);
-            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
-            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
-            _mm256_storeu_si256(z32, _mm256_xor_si256(l0, h0));
-
-            bytes -= 32, ++x32, ++z32;
-        } while (bytes >= 32);
-
-        z16 = reinterpret_cast<GF256_M128 *>(z32);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32);
-    }
-# endif // GF256_TRY_AVX2
-    if (bytes >= 16 && CpuHasSSSE3)
-    {
-        // Partial product tables; see above
-        const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y);
-        const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
-
-        // Handle multiples of 16 bytes
-        do
-        {
-            // See above comments for details
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
-            x0 = _mm_srli_epi64(x0, 4);
-            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
-            l0 = _mm_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm_shuffle_epi8(table_hi_y, h0);
-            _mm_storeu_si128(z16, _mm_xor_si128(l0, h0));
-
-            bytes -= 16, ++x16, ++z16;
-        } while (bytes >= 16);
-    }
-#endif
-
-    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t*>(z16);
-    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t*>(x16);
-    const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
-
-    // Handle blocks of 8 bytes
-    while (bytes >= 8)
-    {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
-#ifdef GF256_IS_BIG_ENDIAN
-        uint64_t word = (uint64_t)table[x1[0]] << 56;
-        word |= (uint64_t)table[x1[1]] << 48;
-        word |= (uint64_t)table[x1[2]] << 40;
-        word |= (uint64_t)table[x1[3]] << 32;
-        word |= (uint64_t)table[x1[4]] << 24;
-        word |= (uint64_t)table[x1[5]] << 16;
-        word |= (uint64_t)table[x1[6]] << 8;
-        word |= (uint64_t)table[x1[7]];
-#else
-        uint64_t word = table[x1[0]];
-        word |= (uint64_t)table[x1[1]] << 8;
-        word |= (uint64_t)table[x1[2]] << 16;
-        word |= (uint64_t)table[x1[3]] << 24;
-        word |= (uint64_t)table[x1[4]] << 32;
-        word |= (uint64_t)table[x1[5]] << 40;
-        word |= (uint64_t)table[x1[6]] << 48;
-        word |= (uint64_t)table[x1[7]] << 56;
-#endif
-        *z8 = word;
-
-        bytes -= 8, x1 += 8, z1 += 8;
-    }
-
-    // Handle a block of 4 bytes
-    const int four = bytes & 4;
-    if (four)
-    {
-        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
-#ifdef GF256_IS_BIG_ENDIAN
-        uint32_t word = (uint32_t)table[x1[0]] << 24;
-        word |= (uint32_t)table[x1[1]] << 16;
-        word |= (uint32_t)table[x1[2]] << 8;
-        word |= (uint32_t)table[x1[3]];
-#else
-        uint32_t word = table[x1[0]];
-        word |= (uint32_t)table[x1[1]] << 8;
-        word |= (uint32_t)table[x1[2]] << 16;
-        word |= (uint32_t)table[x1[3]] << 24;
-#endif
-        *z4 = word;
-    }
-
-    // Handle single bytes
-    const int offset = four;
-    switch (bytes & 3)
-    {
-    case 3: z1[offset + 2] = table[x1[offset + 2]];
-    case 2: z1[offset + 1] = table[x1[offset + 1]];
-    case 1: z1[offset] = table[x1[offset]];
-    default:
-        break;
-    }
-}
-
-extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
-                                 const void * GF256_RESTRICT vx, int bytes)
-{
-    // Use a single if-statement to handle special cases
-    if (y <= 1)
-    {
-        if (y == 1)
-            gf256_add_mem(vz, vx, bytes);
-        return;
-    }
-
-    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
-    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
-
-#if defined(GF256_TARGET_MOBILE)
-#if defined(GF256_TRY_NEON)
-    if (bytes >= 16 && CpuHasNeon)
-    {
-        // Partial product tables; see above
-        const GF256_M128 table_lo_y = vld1q_u8((uint8_t*)(GF256Ctx.MM128.TABLE_LO_Y + y));
-        const GF256_M128 table_hi_y = vld1q_u8((uint8_t*)(GF256Ctx.MM128.TABLE_HI_Y + y));
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M128 clr_mask = vdupq_n_u8(0x0f);
-
-        // Handle multiples of 16 bytes
-        do
-        {
-            // See above comments for details
-            GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
-            GF256_M128 l0 = vandq_u8(x0, clr_mask);
-
-            // x0 = vshrq_n_u8(x0, 4);
-            x0 = (GF256_M128)vshrq_n_u64( (uint64x2_t)x0, 4);
-            GF256_M128 h0 = vandq_u8(x0, clr_mask);
-            l0 = vqtbl1q_u8(table_lo_y, l0);
-            h0 = vqtbl1q_u8(table_hi_y, h0);
-            const GF256_M128 p0 = veorq_u8(l0, h0);
-            const GF256_M128 z0 = vld1q_u8((uint8_t*)z16);
-            vst1q_u8((uint8_t*)z16, veorq_u8(p0, z0));
-            bytes -= 16, ++x16, ++z16;
-        } while (bytes >= 16);
-    }
-#endif
-#else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (bytes >= 32 && CpuHasAVX2)
-    {
-        // Partial product tables; see above
-        const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + y);
-        const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
-
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z16);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x16);
-
-        // On my Reed Solomon codec, the encoder unit test runs in 640 usec without and 550 usec with the optimization (86% of the original time)
-        const unsigned count = bytes / 64;
-        for (unsigned i = 0; i < count; ++i)
-        {
-            // See above comments for details
-            GF256_M256 x0 = _mm256_loadu_si256(x32 + i * 2);
-            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
-            x0 = _mm256_srli_epi64(x0, 4);
-            const GF256_M256 z0 = _mm256_loadu_si256(z32 + i * 2);
-            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
-            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
-            const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
-            _mm256_storeu_si256(z32 + i * 2, _mm256_xor_si256(p0, z0));
-
-            GF256_M256 x1 = _mm256_loadu_si256(x32 + i * 2 + 1);
-            GF256_M256 l1 = _mm256_and_si256(x1, clr_mask);
-            x1 = _mm256_srli_epi64(x1, 4);
-            const GF256_M256 z1 = _mm256_loadu_si256(z32 + i * 2 + 1);
-            GF256_M256 h1 = _mm256_and_si256(x1, clr_mask);
-            l1 = _mm256_shuffle_epi8(table_lo_y, l1);
-            h1 = _mm256_shuffle_epi8(table_hi_y, h1);
-            const GF256_M256 p1 = _mm256_xor_si256(l1, h1);
-            _mm256_storeu_si256(z32 + i * 2 + 1, _mm256_xor_si256(p1, z1));
-        }
-        bytes -= count * 64;
-        z32 += count * 2;
-        x32 += count * 2;
-
-        if (bytes >= 32)
-        {
-            GF256_M256 x0 = _mm256_loadu_si256(x32);
-            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
-            x0 = _mm256_srli_epi64(x0, 4);
-            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
-            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
-            const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
-            const GF256_M256 z0 = _mm256_loadu_si256(z32);
-            _mm256_storeu_si256(z32, _mm256_xor_si256(p0, z0));
-
-            bytes -= 32;
-            z32++;
-            x32++;
-        }
-
-        z16 = reinterpret_cast<GF256_M128 *>(z32);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32);
-    }
-# endif // GF256_TRY_AVX2
-    if (bytes >= 16 && CpuHasSSSE3)
-    {
-        // Partial product tables; see above
-        const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y);
-        const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
-
-        // This unroll seems to provide about 7% speed boost when AVX2 is disabled
-        while (bytes >= 32)
-        {
-            bytes -= 32;
-
-            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
-            GF256_M128 l1 = _mm_and_si128(x1, clr_mask);
-            x1 = _mm_srli_epi64(x1, 4);
-            GF256_M128 h1 = _mm_and_si128(x1, clr_mask);
-            l1 = _mm_shuffle_epi8(table_lo_y, l1);
-            h1 = _mm_shuffle_epi8(table_hi_y, h1);
-            const GF256_M128 z1 = _mm_loadu_si128(z16 + 1);
-
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
-            x0 = _mm_srli_epi64(x0, 4);
-            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
-            l0 = _mm_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm_shuffle_epi8(table_hi_y, h0);
-            const GF256_M128 z0 = _mm_loadu_si128(z16);
-
-            const GF256_M128 p1 = _mm_xor_si128(l1, h1);
-            _mm_storeu_si128(z16 + 1, _mm_xor_si128(p1, z1));
-
-            const GF256_M128 p0 = _mm_xor_si128(l0, h0);
-            _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
-
-            x16 += 2, z16 += 2;
-        }
-
-        // Handle multiples of 16 bytes
-        while (bytes >= 16)
-        {
-            // See above comments for details
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
-            x0 = _mm_srli_epi64(x0, 4);
-            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
-            l0 = _mm_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm_shuffle_epi8(table_hi_y, h0);
-            const GF256_M128 p0 = _mm_xor_si128(l0, h0);
-            const GF256_M128 z0 = _mm_loadu_si128(z16);
-            _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
-
-            bytes -= 16, ++x16, ++z16;
-        }
-    }
-#endif // GF256_TARGET_MOBILE
-
-    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t*>(z16);
-    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t*>(x16);
-    const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
-
-    // Handle blocks of 8 bytes
-    while (bytes >= 8)
-    {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
-#ifdef GF256_IS_BIG_ENDIAN
-        uint64_t word = (uint64_t)table[x1[0]] << 56;
-        word |= (uint64_t)table[x1[1]] << 48;
-        word |= (uint64_t)table[x1[2]] << 40;
-        word |= (uint64_t)table[x1[3]] << 32;
-        word |= (uint64_t)table[x1[4]] << 24;
-        word |= (uint64_t)table[x1[5]] << 16;
-        word |= (uint64_t)table[x1[6]] << 8;
-        word |= (uint64_t)table[x1[7]];
-#else
-        uint64_t word = table[x1[0]];
-        word |= (uint64_t)table[x1[1]] << 8;
-        word |= (uint64_t)table[x1[2]] << 16;
-        word |= (uint64_t)table[x1[3]] << 24;
-        word |= (uint64_t)table[x1[4]] << 32;
-        word |= (uint64_t)table[x1[5]] << 40;
-        word |= (uint64_t)table[x1[6]] << 48;
-        word |= (uint64_t)table[x1[7]] << 56;
-#endif
-        *z8 ^= word;
-
-        bytes -= 8, x1 += 8, z1 += 8;
-    }
-
-    // Handle a block of 4 bytes
-    const int four = bytes & 4;
-    if (four)
-    {
-        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
-#ifdef GF256_IS_BIG_ENDIAN
-        uint32_t word = (uint32_t)table[x1[0]] << 24;
-        word |= (uint32_t)table[x1[1]] << 16;
-        word |= (uint32_t)table[x1[2]] << 8;
-        word |= (uint32_t)table[x1[3]];
-#else
-        uint32_t word = table[x1[0]];
-        word |= (uint32_t)table[x1[1]] << 8;
-        word |= (uint32_t)table[x1[2]] << 16;
-        word |= (uint32_t)table[x1[3]] << 24;
-#endif
-        *z4 ^= word;
-    }
-
-    // Handle single bytes
-    const int offset = four;
-    switch (bytes & 3)
-    {
-    case 3: z1[offset + 2] ^= table[x1[offset + 2]];
-    case 2: z1[offset + 1] ^= table[x1[offset + 1]];
-    case 1: z1[offset] ^= table[x1[offset]];
-    default:
-        break;
-    }
-}
-
-extern "C" void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes)
-{
-#if defined(GF256_TARGET_MOBILE)
-    uint64_t * GF256_RESTRICT x16 = reinterpret_cast<uint64_t *>(vx);
-    uint64_t * GF256_RESTRICT y16 = reinterpret_cast<uint64_t *>(vy);
-
-    const unsigned count = (unsigned)bytes / 8;
-    for (unsigned ii = 0; ii < count; ++ii)
-    {
-        const uint64_t temp = x16[ii];
-        x16[ii] = y16[ii];
-        y16[ii] = temp;
-    }
-
-    x16 += count;
-    y16 += count;
-    bytes -= count * 8;
-#else
-    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
-    GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<GF256_M128 *>(vy);
-
-    // Handle blocks of 16 bytes
-    while (bytes >= 16)
-    {
-        GF256_M128 x0 = _mm_loadu_si128(x16);
-        GF256_M128 y0 = _mm_loadu_si128(y16);
-        _mm_storeu_si128(x16, y0);
-        _mm_storeu_si128(y16, x0);
-
-        bytes -= 16, ++x16, ++y16;
-    }
-#endif
-
-    uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(x16);
-    uint8_t * GF256_RESTRICT y1 = reinterpret_cast<uint8_t *>(y16);
-
-    // Handle a block of 8 bytes
-    const int eight = bytes & 8;
-    if (eight)
-    {
-        uint64_t * GF256_RESTRICT x8 = reinterpret_cast<uint64_t *>(x1);
-        uint64_t * GF256_RESTRICT y8 = reinterpret_cast<uint64_t *>(y1);
-
-        uint64_t temp = *x8;
-        *x8 = *y8;
-        *y8 = temp;
-    }
-
-    // Handle a block of 4 bytes
-    const int four = bytes & 4;
-    if (four)
-    {
-        uint32_t * GF256_RESTRICT x4 = reinterpret_cast<uint32_t *>(x1 + eight);
-        uint32_t * GF256_RESTRICT y4 = reinterpret_cast<uint32_t *>(y1 + eight);
-
-        uint32_t temp = *x4;
-        *x4 = *y4;
-        *y4 = temp;
-    }
-
-    // Handle final bytes
-    const int offset = eight + four;
-    uint8_t temp;
-    switch (bytes & 3)
-    {
-    case 3: temp = x1[offset + 2]; x1[offset + 2] = y1[offset + 2]; y1[offset + 2] = temp;
-    case 2: temp = x1[offset + 1]; x1[offset + 1] = y1[offset + 1]; y1[offset + 1] = temp;
-    case 1: temp = x1[offset]; x1[offset] = y1[offset]; y1[offset] = temp;
-    default:
-        break;
-    }
+/** \file
+    \brief GF(256) Main C API Source
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "gf256_kernels.h"
+#include "cm256_stats.h"
+
+#include <mutex>
+
+#ifdef LINUX_ARM
+#include <sys/auxv.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Detect host byte order.
+// This check works with GCC and LLVM; assume little-endian byte order when
+// using any other compiler.
+// The result is verified during initialization.
+//
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) \
+    && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define GF256_IS_BIG_ENDIAN
+#endif
+
+//------------------------------------------------------------------------------
+// Self-Test
+//
+// This is executed during initialization to make sure the library is working.
+// It only runs in builds with GF256_INIT_SELF_TEST or DEBUG defined, such as
+// the unit tests, so that release startup does no work beyond CPU detection.
+
+#if defined(GF256_INIT_SELF_TEST) || defined(DEBUG)
+
+static const unsigned kTestBufferBytes = 32 + 16 + 8 + 4 + 2 + 1;
+static const unsigned kTestBufferAllocated = 64;
+struct SelfTestBuffersT
+{
+    GF256_ALIGNED uint8_t A[kTestBufferAllocated];
+    GF256_ALIGNED uint8_t B[kTestBufferAllocated];
+    GF256_ALIGNED uint8_t C[kTestBufferAllocated];
+};
+static GF256_ALIGNED SelfTestBuffersT m_SelfTestBuffers;
+
+static bool gf256_self_test()
+{
+    if ((uintptr_t)m_SelfTestBuffers.A % GF256_ALIGN_BYTES != 0)
+        return false;
+    if ((uintptr_t)m_SelfTestBuffers.A % GF256_ALIGN_BYTES != 0)
+        return false;
+    if ((uintptr_t)m_SelfTestBuffers.B % GF256_ALIGN_BYTES != 0)
+        return false;
+    if ((uintptr_t)m_SelfTestBuffers.C % GF256_ALIGN_BYTES != 0)
+        return false;
+
+    // The tables were checked by gf256_tablegen.cpp when they were generated,
+    // so this only checks the bulk kernels selected for this CPU
+
+    // Check for overruns
+    m_SelfTestBuffers.A[kTestBufferBytes] = 0x5a;
+    m_SelfTestBuffers.B[kTestBufferBytes] = 0x5a;
+    m_SelfTestBuffers.C[kTestBufferBytes] = 0x5a;
+
+    // Test gf256_add_mem()
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    {
+        m_SelfTestBuffers.A[i] = 0x1f;
+        m_SelfTestBuffers.B[i] = 0xf7;
+    }
+    gf256_add_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != (0x1f ^ 0xf7))
+            return false;
+
+    // Test gf256_add2_mem()
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    {
+        m_SelfTestBuffers.A[i] = 0x1f;
+        m_SelfTestBuffers.B[i] = 0xf7;
+        m_SelfTestBuffers.C[i] = 0x71;
+    }
+    gf256_add2_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, m_SelfTestBuffers.C, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != (0x1f ^ 0xf7 ^ 0x71))
+            return false;
+
+    // Test gf256_addset_mem()
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    {
+        m_SelfTestBuffers.A[i] = 0x55;
+        m_SelfTestBuffers.B[i] = 0xaa;
+        m_SelfTestBuffers.C[i] = 0x6c;
+    }
+    gf256_addset_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, m_SelfTestBuffers.C, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != (0xaa ^ 0x6c))
+            return false;
+
+    // Test gf256_muladd_mem()
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    {
+        m_SelfTestBuffers.A[i] = 0xff;
+        m_SelfTestBuffers.B[i] = 0xaa;
+    }
+    const uint8_t expectedMulAdd = gf256_mul(0xaa, 0x6c);
+    gf256_muladd_mem(m_SelfTestBuffers.A, 0x6c, m_SelfTestBuffers.B, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != (expectedMulAdd ^ 0xff))
+            return false;
+
+    // Test gf256_mul_mem()
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    {
+        m_SelfTestBuffers.A[i] = 0xff;
+        m_SelfTestBuffers.B[i] = 0x55;
+    }
+    const uint8_t expectedMul = gf256_mul(0xa2, 0x55);
+    gf256_mul_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, 0xa2, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != expectedMul)
+            return false;
+
+    // Test gf256_muladd_multi_mem()
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    {
+        m_SelfTestBuffers.A[i] = 0xff;
+        m_SelfTestBuffers.B[i] = 0xaa;
+        m_SelfTestBuffers.C[i] = 0x6c;
+    }
+    const uint8_t multiY[2] = { 0x3b, 0xd7 };
+    const void* multiX[2] = { m_SelfTestBuffers.B, m_SelfTestBuffers.C };
+    const uint8_t expectedMulti = gf256_mul(0xaa, 0x3b) ^ gf256_mul(0x6c, 0xd7);
+    gf256_muladd_multi_mem(m_SelfTestBuffers.A, multiY, multiX, 2, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != (expectedMulti ^ 0xff))
+            return false;
+
+    // Test gf256_mul_multi_mem()
+    gf256_mul_multi_mem(m_SelfTestBuffers.A, multiY, multiX, 2, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != expectedMulti)
+            return false;
+
+    // Test gf256_muladd_multi_tables_mem()
+    gf256_mul_tables multiTables[2];
+    gf256_mul_tables_init(&multiTables[0], multiY[0]);
+    gf256_mul_tables_init(&multiTables[1], multiY[1]);
+    gf256_muladd_multi_tables_mem(m_SelfTestBuffers.A, multiTables, multiX, 2, kTestBufferBytes);
+    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        if (m_SelfTestBuffers.A[i] != 0)
+            return false;
+
+    if (m_SelfTestBuffers.A[kTestBufferBytes] != 0x5a)
+        return false;
+    if (m_SelfTestBuffers.B[kTestBufferBytes] != 0x5a)
+        return false;
+    if (m_SelfTestBuffers.C[kTestBufferBytes] != 0x5a)
+        return false;
+
+    return true;
+}
+
+#endif // GF256_INIT_SELF_TEST || DEBUG
+
+
+//------------------------------------------------------------------------------
+// Runtime CPU Architecture Check
+//
+// Feature checks stolen shamelessly from
+// https://github.com/jedisct1/libsodium/blob/master/src/libsodium/sodium/runtime.c
+
+#if defined(HAVE_ANDROID_GETCPUFEATURES)
+#include <cpu-features.h>
+#endif
+
+#if defined(GF256_TRY_NEON)
+# if defined(IOS) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+// Requires iPhone 5S or newer
+static const bool CpuHasNeon = true;
+static const bool CpuHasNeon64 = true;
+static const bool CpuHasSVE2 = false;
+# else // ANDROID or LINUX_ARM
+#  if defined(__aarch64__)
+static bool CpuHasNeon = true;      // if AARCH64, then we have NEON for sure...
+static bool CpuHasNeon64 = true;    // And we have ASIMD
+static bool CpuHasSVE2 = false;     // SVE2 is optional, so check at runtime.
+#  else
+static bool CpuHasNeon = false;     // if not, then we have to check at runtime.
+static bool CpuHasNeon64 = false;   // And we don't have ASIMD
+static const bool CpuHasSVE2 = false;
+#  endif
+# endif
+#endif
+
+#if !defined(GF256_TARGET_MOBILE)
+
+#ifdef _MSC_VER
+    #include <intrin.h> // __cpuid
+    #pragma warning(disable: 4752) // found Intel(R) Advanced Vector Extensions; consider using /arch:AVX
+#endif
+
+static bool CpuHasGFNI = false;
+static bool CpuHasAVX512BW = false;
+static bool CpuHasAVX2 = false;
+static bool CpuHasSSSE3 = false;
+static bool CpuHasSSE42 = false;
+
+#define CPUID_EBX_AVX2      0x00000020
+#define CPUID_EBX_AVX512F   0x00010000
+#define CPUID_EBX_AVX512BW  0x40000000
+#define CPUID_ECX_GFNI      0x00000100 // Leaf 7
+#define CPUID_ECX_SSSE3     0x00000200
+#define CPUID_ECX_SSE42     0x00100000
+#define CPUID_ECX_OSXSAVE   0x08000000
+#define CPUID_ECX_AVX       0x10000000
+
+// XCR0 state components the OS must save for each register width
+#define XCR0_YMM            0x00000006 // SSE + AVX
+#define XCR0_ZMM            0x000000e6 // SSE + AVX + opmask + ZMM
+
+static void _cpuid(unsigned int cpu_info[4U], const unsigned int cpu_info_type)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86))
+    __cpuid((int *) cpu_info, cpu_info_type);
+#else //if defined(HAVE_CPUID)
+    cpu_info[0] = cpu_info[1] = cpu_info[2] = cpu_info[3] = 0;
+# ifdef __i386__
+    __asm__ __volatile__ ("pushfl; pushfl; "
+                          "popl %0; "
+                          "movl %0, %1; xorl %2, %0; "
+                          "pushl %0; "
+                          "popfl; pushfl; popl %0; popfl" :
+                          "=&r" (cpu_info[0]), "=&r" (cpu_info[1]) :
+                          "i" (0x200000));
+    if (((cpu_info[0] ^ cpu_info[1]) & 0x200000) == 0) {
+        return; /* LCOV_EXCL_LINE */
+    }
+# endif
+# ifdef __i386__
+    __asm__ __volatile__ ("xchgl %%ebx, %k1; cpuid; xchgl %%ebx, %k1" :
+                          "=a" (cpu_info[0]), "=&r" (cpu_info[1]),
+                          "=c" (cpu_info[2]), "=d" (cpu_info[3]) :
+                          "0" (cpu_info_type), "2" (0U));
+# elif defined(__x86_64__)
+    __asm__ __volatile__ ("xchgq %%rbx, %q1; cpuid; xchgq %%rbx, %q1" :
+                          "=a" (cpu_info[0]), "=&r" (cpu_info[1]),
+                          "=c" (cpu_info[2]), "=d" (cpu_info[3]) :
+                          "0" (cpu_info_type), "2" (0U));
+# else
+    __asm__ __volatile__ ("cpuid" :
+                          "=a" (cpu_info[0]), "=b" (cpu_info[1]),
+                          "=c" (cpu_info[2]), "=d" (cpu_info[3]) :
+                          "0" (cpu_info_type), "2" (0U));
+# endif
+#endif
+}
+
+// Read XCR0 to find which register state the OS saves on context switch.
+// Only valid when CPUID reports OSXSAVE.
+static uint64_t _xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0U));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+#else
+#if defined(LINUX_ARM) && defined(GF256_TRY_NEON)
+// Bits from the kernel's asm/hwcap.h, which not every C library exposes
+static const unsigned long kHwcapArmNeon = 1UL << 12;    // 32-bit ARM: HWCAP_NEON
+static const unsigned long kHwcapArm64Asimd = 1UL << 1;  // AArch64: HWCAP_ASIMD
+static const unsigned long kHwcap2Arm64Sve2 = 1UL << 1;  // AArch64: HWCAP2_SVE2
+
+static void checkLinuxARMCapabilities()
+{
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+#if defined(__aarch64__)
+    CpuHasNeon = (hwcap & kHwcapArm64Asimd) != 0;
+    CpuHasNeon64 = CpuHasNeon;
+# if defined(AT_HWCAP2)
+    CpuHasSVE2 = (getauxval(AT_HWCAP2) & kHwcap2Arm64Sve2) != 0;
+# endif
+#else
+    CpuHasNeon = (hwcap & kHwcapArmNeon) != 0;
+#endif
+}
+#endif
+#endif // defined(GF256_TARGET_MOBILE)
+
+static void gf256_architecture_init()
+{
+#if defined(GF256_TRY_NEON)
+
+    // Check for NEON support on Android platform
+#if defined(HAVE_ANDROID_GETCPUFEATURES)
+    AndroidCpuFamily family = android_getCpuFamily();
+    if (family == ANDROID_CPU_FAMILY_ARM)
+    {
+        if (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON)
+            CpuHasNeon = true;
+    }
+    else if (family == ANDROID_CPU_FAMILY_ARM64)
+    {
+        CpuHasNeon = true;
+        if (android_getCpuFeatures() & ANDROID_CPU_ARM64_FEATURE_ASIMD)
+            CpuHasNeon64 = true;
+    }
+#endif
+
+#if defined(LINUX_ARM)
+    // Check for NEON and SVE2 support on other ARM/Linux platforms
+    checkLinuxARMCapabilities();
+#endif
+
+#endif //GF256_TRY_NEON
+
+#if !defined(GF256_TARGET_MOBILE)
+    unsigned int cpu_info[4];
+
+    _cpuid(cpu_info, 1);
+    CpuHasSSSE3 = ((cpu_info[2] & CPUID_ECX_SSSE3) != 0);
+    CpuHasSSE42 = ((cpu_info[2] & CPUID_ECX_SSE42) != 0);
+
+    // The wider registers are only usable if the OS saves them
+    uint64_t xcr0 = 0;
+    if ((cpu_info[2] & (CPUID_ECX_OSXSAVE | CPUID_ECX_AVX)) == (CPUID_ECX_OSXSAVE | CPUID_ECX_AVX))
+        xcr0 = _xgetbv0();
+
+    _cpuid(cpu_info, 0);
+    const unsigned max_leaf = cpu_info[0];
+
+    if (max_leaf >= 7)
+    {
+        _cpuid(cpu_info, 7);
+        CpuHasAVX2 = ((cpu_info[1] & CPUID_EBX_AVX2) != 0) &&
+                     ((xcr0 & XCR0_YMM) == XCR0_YMM);
+        CpuHasAVX512BW = ((cpu_info[1] & (CPUID_EBX_AVX512F | CPUID_EBX_AVX512BW)) == (CPUID_EBX_AVX512F | CPUID_EBX_AVX512BW)) &&
+                         ((xcr0 & XCR0_ZMM) == XCR0_ZMM);
+
+        // The GFNI kernels use the EVEX-encoded 512-bit form
+        CpuHasGFNI = CpuHasAVX512BW && ((cpu_info[2] & CPUID_ECX_GFNI) != 0);
+    }
+
+    // When AVX2 and SSSE3 are unavailable, Siamese takes 4x longer to decode
+    // and 2.6x longer to encode.  Encoding requires a lot more simple XOR ops
+    // so it is still pretty fast.  Decoding is usually really quick because
+    // average loss rates are low, but when needed it requires a lot more
+    // GF multiplies requiring table lookups which is slower.
+
+#endif // GF256_TARGET_MOBILE
+}
+
+
+//------------------------------------------------------------------------------
+// Context Object
+
+/*
+    The math tables are generated by gf256_tablegen.cpp when the library is
+    built, so the context is a constant in read-only data.  Nothing is
+    computed at startup, and processes share the pages of the executable
+    instead of each filling in a private copy.
+*/
+
+// Context object for GF(2^^8) math
+GF256_ALIGNED const gf256_ctx GF256Ctx = {
+#include "gf256_tables.inc"
+};
+
+
+//------------------------------------------------------------------------------
+// Multiply and Add Memory Tables
+
+/*
+    Fast algorithm to compute m[1..8] = a[1..8] * b in GF(256)
+    using SSE3 SIMD instruction set:
+
+    Consider z = x * y in GF(256).
+    This operation can be performed bit-by-bit.  Usefully, the partial product
+    of each bit is combined linearly with the rest.  This means that the 8-bit
+    number x can be split into its high and low 4 bits, and partial products
+    can be formed from each half.  Then the halves can be linearly combined:
+
+        z = x[0..3] * y + x[4..7] * y
+
+    The multiplication of each half can be done efficiently via table lookups,
+    and the addition in GF(256) is XOR.  There must be two tables that map 16
+    input elements for the low or high 4 bits of x to the two partial products.
+    Each value for y has a different set of two tables:
+
+        z = TABLE_LO_y(x[0..3]) xor TABLE_HI_y(x[4..7])
+
+    This means that we need 16 * 2 * 256 = 8192 bytes for precomputed tables.
+
+    Computing z[] = x[] * y can be performed 16 bytes at a time by using the
+    128-bit register operations supported by modern processors.
+
+    This is efficiently realized in SSE3 using the _mm_shuffle_epi8() function
+    provided by Visual Studio 2010 or newer in <tmmintrin.h>.  This function
+    uses the low bits to do a table lookup on each byte.  Unfortunately the
+    high bit of each mask byte has the special feature that it clears the
+    output byte when it is set, so we need to make sure it's cleared by masking
+    off the high bit of each byte before using it:
+
+        clr_mask = _mm_set1_epi8(0x0f) = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+
+    For the low half of the partial product, clear the high bit of each byte
+    and perform the table lookup:
+
+        p_lo = _mm_and_si128(x, clr_mask)
+        p_lo = _mm_shuffle_epi8(p_lo, TABLE_LO_y)
+
+    For the high half of the partial product, shift the high 4 bits of each
+    byte into the low 4 bits and clear the high bit of each byte, and then
+    perform the table lookup:
+
+        p_hi = _mm_srli_epi64(x, 4)
+        p_hi = _mm_and_si128(p_hi, clr_mask)
+        p_hi = _mm_shuffle_epi8(p_hi, TABLE_HI_y)
+
+    Finally add the two partial products to form the product, recalling that
+    addition is XOR in a Galois field:
+
+        result = _mm_xor_si128(p_lo, p_hi)
+
+    This crunches 16 bytes of x at a time, and the result can be stored in z.
+*/
+
+/*
+    Intrinsic reference:
+
+    SSE3, VS2010+, tmmintrin.h:
+
+    GF256_M128 _mm_shuffle_epi8(GF256_M128 a, GF256_M128 mask);
+        Emits the Supplemental Streaming SIMD Extensions 3 (SSSE3) instruction pshufb. This instruction shuffles 16-byte parameters from a 128-bit parameter.
+
+        Pseudo-code for PSHUFB (with 128 bit operands):
+
+            for i = 0 to 15 {
+                 if (SRC[(i * 8)+7] = 1 ) then
+                      DEST[(i*8)+7..(i*8)+0] <- 0;
+                  else
+                      index[3..0] <- SRC[(i*8)+3 .. (i*8)+0];
+                      DEST[(i*8)+7..(i*8)+0] <- DEST[(index*8+7)..(index*8+0)];
+                 endif
+            }
+
+    SSE2, VS2008+, emmintrin.h:
+
+    GF256_M128 _mm_slli_epi64 (GF256_M128 a, int count);
+        Shifts the 2 signed or unsigned 64-bit integers in a left by count bits while shifting in zeros.
+    GF256_M128 _mm_srli_epi64 (GF256_M128 a, int count);
+        Shifts the 2 signed or unsigned 64-bit integers in a right by count bits while shifting in zeros.
+    GF256_M128 _mm_set1_epi8 (char b);
+        Sets the 16 signed 8-bit integer values to b.
+    GF256_M128 _mm_and_si128 (GF256_M128 a, GF256_M128 b);
+        Computes the bitwise AND of the 128-bit value in a and the 128-bit value in b.
+    GF256_M128 _mm_xor_si128 ( GF256_M128 a, GF256_M128 b);
+        Computes the bitwise XOR of the 128-bit value in a and the 128-bit value in b.
+*/
+
+// The tables themselves are written by gf256_tablegen.cpp.  The 256-bit
+// tables repeat the 128-bit table in each lane.
+
+
+//------------------------------------------------------------------------------
+// Kernel Selection
+
+static const gf256_kernels* Kernels = nullptr;
+
+#if defined(CM256_ENABLE_STATS)
+
+// Instruction set of Kernels, for the kernel counters
+static int KernelsIsa = CM256_ISA_PORTABLE;
+
+static void gf256_kernels_update_isa()
+{
+    const gf256_kernels* tables[CM256_ISA_COUNT] = {
+        gf256_kernels_scalar(), gf256_kernels_ssse3(), gf256_kernels_avx2(),
+        gf256_kernels_avx512(), gf256_kernels_gfni(), gf256_kernels_neon(),
+        gf256_kernels_sve2()
+    };
+
+    KernelsIsa = CM256_ISA_PORTABLE;
+    for (int isa = 0; isa < CM256_ISA_COUNT; ++isa)
+        if (tables[isa] == Kernels)
+            KernelsIsa = isa;
+}
+
+#endif // CM256_ENABLE_STATS
+
+// Pick the fastest kernel table that was built and that the CPU supports
+static void gf256_kernels_init()
+{
+    const gf256_kernels* selected = nullptr;
+
+#if defined(GF256_TRY_NEON)
+    if (CpuHasSVE2)
+        selected = gf256_kernels_sve2();
+    if (!selected && CpuHasNeon)
+        selected = gf256_kernels_neon();
+#endif // GF256_TRY_NEON
+
+#if !defined(GF256_TARGET_MOBILE)
+    if (!selected && CpuHasGFNI)
+        selected = gf256_kernels_gfni();
+    if (!selected && CpuHasAVX512BW)
+        selected = gf256_kernels_avx512();
+    if (!selected && CpuHasAVX2)
+        selected = gf256_kernels_avx2();
+    if (!selected && CpuHasSSSE3)
+        selected = gf256_kernels_ssse3();
+#endif // GF256_TARGET_MOBILE
+
+    Kernels = selected ? selected : gf256_kernels_scalar();
+
+#if defined(CM256_ENABLE_STATS)
+    gf256_kernels_update_isa();
+#endif // CM256_ENABLE_STATS
+}
+
+void gf256_set_kernels(const gf256_kernels* kernels)
+{
+    if (!kernels)
+    {
+        gf256_kernels_init();
+        return;
+    }
+
+    Kernels = kernels;
+
+#if defined(CM256_ENABLE_STATS)
+    gf256_kernels_update_isa();
+#endif // CM256_ENABLE_STATS
+}
+
+extern "C" const char* gf256_kernels_name()
+{
+    return Kernels ? Kernels->Name : "None";
+}
+
+// The CPU is queried once, by whichever of gf256_init() and
+// gf256_get_cpu_features() runs first
+static std::once_flag ArchitectureOnce;
+
+gf256_cpu_features gf256_get_cpu_features()
+{
+    std::call_once(ArchitectureOnce, gf256_architecture_init);
+
+    gf256_cpu_features features;
+    memset(&features, 0, sizeof(features));
+
+#if defined(GF256_TRY_NEON)
+    features.Neon = CpuHasNeon;
+    features.SVE2 = CpuHasSVE2;
+#endif // GF256_TRY_NEON
+
+#if !defined(GF256_TARGET_MOBILE)
+    features.SSSE3 = CpuHasSSSE3;
+    features.SSE42 = CpuHasSSE42;
+    features.AVX2 = CpuHasAVX2;
+    features.AVX512BW = CpuHasAVX512BW;
+    features.GFNI = CpuHasGFNI;
+#endif // GF256_TARGET_MOBILE
+
+    return features;
+}
+
+
+//------------------------------------------------------------------------------
+// Initialization
+
+#ifdef GF256_IS_BIG_ENDIAN
+static unsigned char kEndianTestData[4] = { 1, 2, 3, 4 };
+#else
+static unsigned char kEndianTestData[4] = { 4, 3, 2, 1 };
+#endif
+
+union UnionType
+{
+    uint32_t IntValue;
+    char CharArray[4];
+};
+
+static bool IsExpectedEndian()
+{
+    UnionType type;
+    for (unsigned i = 0; i < 4; ++i)
+        type.CharArray[i] = kEndianTestData[i];
+    return 0x01020304 == type.IntValue;
+}
+
+// Result of the one-time initialization
+static int InitResult = 0;
+static std::once_flag InitOnce;
+
+static void gf256_init_once()
+{
+    if (!IsExpectedEndian())
+    {
+        InitResult = -2; // Unexpected byte order.
+        return;
+    }
+
+    std::call_once(ArchitectureOnce, gf256_architecture_init);
+    gf256_kernels_init();
+
+#if defined(GF256_INIT_SELF_TEST) || defined(DEBUG)
+    if (!gf256_self_test())
+        InitResult = -3; // Self-test failed (perhaps untested configuration)
+#endif
+}
+
+extern "C" int gf256_init_(int version)
+{
+    if (version != GF256_VERSION)
+        return -1; // User's header does not match library version.
+
+    // Safe to call from several threads at once, and cheap after the first
+    std::call_once(InitOnce, gf256_init_once);
+
+    return InitResult;
+}
+
+
+//------------------------------------------------------------------------------
+// Portable Kernels
+//
+// These are used when no SIMD kernels are available, and by the SIMD kernels
+// to finish the bytes that do not fill a whole register.
+
+void gf256_add_mem_scalar(void * GF256_RESTRICT vx,
+                          const void * GF256_RESTRICT vy, int bytes)
+{
+    uint64_t * GF256_RESTRICT x8 = reinterpret_cast<uint64_t *>(vx);
+    const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(vy);
+
+    const unsigned count = (unsigned)bytes / 8;
+    for (unsigned ii = 0; ii < count; ++ii)
+        x8[ii] ^= y8[ii];
+
+    uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(x8 + count);
+    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y8 + count);
+
+    // Handle a block of 4 bytes
+    const int four = bytes & 4;
+    if (four)
+    {
+        uint32_t * GF256_RESTRICT x4 = reinterpret_cast<uint32_t *>(x1);
+        const uint32_t * GF256_RESTRICT y4 = reinterpret_cast<const uint32_t *>(y1);
+        *x4 ^= *y4;
+    }
+
+    // Handle final bytes
+    const int offset = four;
+    switch (bytes & 3)
+    {
+    case 3: x1[offset + 2] ^= y1[offset + 2];
+    case 2: x1[offset + 1] ^= y1[offset + 1];
+    case 1: x1[offset] ^= y1[offset];
+    default:
+        break;
+    }
+}
+
+void gf256_add2_mem_scalar(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                           const void * GF256_RESTRICT vy, int bytes)
+{
+    uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(vz);
+    const uint64_t * GF256_RESTRICT x8 = reinterpret_cast<const uint64_t *>(vx);
+    const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(vy);
+
+    const unsigned count = (unsigned)bytes / 8;
+    for (unsigned ii = 0; ii < count; ++ii)
+        z8[ii] ^= x8[ii] ^ y8[ii];
+
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(z8 + count);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(x8 + count);
+    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y8 + count);
+
+    // Handle a block of 4 bytes
+    const int four = bytes & 4;
+    if (four)
+    {
+        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
+        const uint32_t * GF256_RESTRICT x4 = reinterpret_cast<const uint32_t *>(x1);
+        const uint32_t * GF256_RESTRICT y4 = reinterpret_cast<const uint32_t *>(y1);
+        *z4 ^= *x4 ^ *y4;
+    }
+
+    // Handle final bytes
+    const int offset = four;
+    switch (bytes & 3)
+    {
+    case 3: z1[offset + 2] ^= x1[offset + 2] ^ y1[offset + 2];
+    case 2: z1[offset + 1] ^= x1[offset + 1] ^ y1[offset + 1];
+    case 1: z1[offset] ^= x1[offset] ^ y1[offset];
+    default:
+        break;
+    }
+}
+
+void gf256_addset_mem_scalar(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                             const void * GF256_RESTRICT vy, int bytes)
+{
+    uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(vz);
+    const uint64_t * GF256_RESTRICT x8 = reinterpret_cast<const uint64_t *>(vx);
+    const uint64_t * GF256_RESTRICT y8 = reinterpret_cast<const uint64_t *>(vy);
+
+    const unsigned count = (unsigned)bytes / 8;
+    for (unsigned ii = 0; ii < count; ++ii)
+        z8[ii] = x8[ii] ^ y8[ii];
+
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(z8 + count);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(x8 + count);
+    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y8 + count);
+
+    // Handle a block of 4 bytes
+    const int four = bytes & 4;
+    if (four)
+    {
+        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
+        const uint32_t * GF256_RESTRICT x4 = reinterpret_cast<const uint32_t *>(x1);
+        const uint32_t * GF256_RESTRICT y4 = reinterpret_cast<const uint32_t *>(y1);
+        *z4 = *x4 ^ *y4;
+    }
+
+    // Handle final bytes
+    const int offset = four;
+    switch (bytes & 3)
+    {
+    case 3: z1[offset + 2] = x1[offset + 2] ^ y1[offset + 2];
+    case 2: z1[offset + 1] = x1[offset + 1] ^ y1[offset + 1];
+    case 1: z1[offset] = x1[offset] ^ y1[offset];
+    default:
+        break;
+    }
+}
+
+void gf256_mul_mem_scalar(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t*>(vz);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t*>(vx);
+    const gf256_mul_row table = gf256_get_mul_row(y);
+
+    // Handle blocks of 8 bytes
+    while (bytes >= 8)
+    {
+        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
+#ifdef GF256_IS_BIG_ENDIAN
+        uint64_t word = (uint64_t)table[x1[0]] << 56;
+        word |= (uint64_t)table[x1[1]] << 48;
+        word |= (uint64_t)table[x1[2]] << 40;
+        word |= (uint64_t)table[x1[3]] << 32;
+        word |= (uint64_t)table[x1[4]] << 24;
+        word |= (uint64_t)table[x1[5]] << 16;
+        word |= (uint64_t)table[x1[6]] << 8;
+        word |= (uint64_t)table[x1[7]];
+#else
+        uint64_t word = table[x1[0]];
+        word |= (uint64_t)table[x1[1]] << 8;
+        word |= (uint64_t)table[x1[2]] << 16;
+        word |= (uint64_t)table[x1[3]] << 24;
+        word |= (uint64_t)table[x1[4]] << 32;
+        word |= (uint64_t)table[x1[5]] << 40;
+        word |= (uint64_t)table[x1[6]] << 48;
+        word |= (uint64_t)table[x1[7]] << 56;
+#endif
+        *z8 = word;
+
+        bytes -= 8, x1 += 8, z1 += 8;
+    }
+
+    // Handle a block of 4 bytes
+    const int four = bytes & 4;
+    if (four)
+    {
+        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
+#ifdef GF256_IS_BIG_ENDIAN
+        uint32_t word = (uint32_t)table[x1[0]] << 24;
+        word |= (uint32_t)table[x1[1]] << 16;
+        word |= (uint32_t)table[x1[2]] << 8;
+        word |= (uint32_t)table[x1[3]];
+#else
+        uint32_t word = table[x1[0]];
+        word |= (uint32_t)table[x1[1]] << 8;
+        word |= (uint32_t)table[x1[2]] << 16;
+        word |= (uint32_t)table[x1[3]] << 24;
+#endif
+        *z4 = word;
+    }
+
+    // Handle single bytes
+    const int offset = four;
+    switch (bytes & 3)
+    {
+    case 3: z1[offset + 2] = table[x1[offset + 2]];
+    case 2: z1[offset + 1] = table[x1[offset + 1]];
+    case 1: z1[offset] = table[x1[offset]];
+    default:
+        break;
+    }
+}
+
+void gf256_muladd_mem_scalar(void * GF256_RESTRICT vz, uint8_t y,
+                             const void * GF256_RESTRICT vx, int bytes)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t*>(vz);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t*>(vx);
+    const gf256_mul_row table = gf256_get_mul_row(y);
+
+    // Handle blocks of 8 bytes
+    while (bytes >= 8)
+    {
+        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
+#ifdef GF256_IS_BIG_ENDIAN
+        uint64_t word = (uint64_t)table[x1[0]] << 56;
+        word |= (uint64_t)table[x1[1]] << 48;
+        word |= (uint64_t)table[x1[2]] << 40;
+        word |= (uint64_t)table[x1[3]] << 32;
+        word |= (uint64_t)table[x1[4]] << 24;
+        word |= (uint64_t)table[x1[5]] << 16;
+        word |= (uint64_t)table[x1[6]] << 8;
+        word |= (uint64_t)table[x1[7]];
+#else
+        uint64_t word = table[x1[0]];
+        word |= (uint64_t)table[x1[1]] << 8;
+        word |= (uint64_t)table[x1[2]] << 16;
+        word |= (uint64_t)table[x1[3]] << 24;
+        word |= (uint64_t)table[x1[4]] << 32;
+        word |= (uint64_t)table[x1[5]] << 40;
+        word |= (uint64_t)table[x1[6]] << 48;
+        word |= (uint64_t)table[x1[7]] << 56;
+#endif
+        *z8 ^= word;
+
+        bytes -= 8, x1 += 8, z1 += 8;
+    }
+
+    // Handle a block of 4 bytes
+    const int four = bytes & 4;
+    if (four)
+    {
+        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
+#ifdef GF256_IS_BIG_ENDIAN
+        uint32_t word = (uint32_t)table[x1[0]] << 24;
+        word |= (uint32_t)table[x1[1]] << 16;
+        word |= (uint32_t)table[x1[2]] << 8;
+        word |= (uint32_t)table[x1[3]];
+#else
+        uint32_t word = table[x1[0]];
+        word |= (uint32_t)table[x1[1]] << 8;
+        word |= (uint32_t)table[x1[2]] << 16;
+        word |= (uint32_t)table[x1[3]] << 24;
+#endif
+        *z4 ^= word;
+    }
+
+    // Handle single bytes
+    const int offset = four;
+    switch (bytes & 3)
+    {
+    case 3: z1[offset + 2] ^= table[x1[offset + 2]];
+    case 2: z1[offset + 1] ^= table[x1[offset + 1]];
+    case 1: z1[offset] ^= table[x1[offset]];
+    default:
+        break;
+    }
+}
+
+template<typename C>
+static void gf256_muladd_multi_portable(uint8_t * GF256_RESTRICT z, const C * y,
+                                        const uint8_t * const * x, int count, int bytes, bool set)
+{
+    gf256_muladd_multi_scalar(z, y, x, count, 0, bytes, set);
+}
+
+// The portable kernels are bound by the table lookups rather than by loads,
+// so the source is simply re-read from L1 for each destination
+static void gf256_muladd_spread_portable(uint8_t * const * z, const uint8_t * y,
+                                         const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    for (int d = 0; d < count; ++d)
+        gf256_muladd_mem_scalar(z[d], y[d], x, bytes);
+}
+
+static const gf256_kernels kKernelsScalar = {
+    "Portable",
+    gf256_add_mem_scalar,
+    gf256_add2_mem_scalar,
+    gf256_addset_mem_scalar,
+    gf256_mul_mem_scalar,
+    gf256_muladd_mem_scalar,
+    gf256_muladd_multi_portable<uint8_t>,
+    gf256_muladd_multi_portable<gf256_mul_tables>,
+    gf256_muladd_spread_portable
+};
+
+const gf256_kernels* gf256_kernels_scalar()
+{
+    return &kKernelsScalar;
+}
+
+
+//------------------------------------------------------------------------------
+// Operations
+
+extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
+                              const void * GF256_RESTRICT vy, int bytes)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_ADD, bytes);
+    Kernels->AddMem(vx, vy, bytes);
+}
+
+extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_ADD2, bytes);
+    Kernels->Add2Mem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_ADDSET, bytes);
+    Kernels->AddSetMem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_MUL, bytes);
+
+    // Use a single if-statement to handle special cases
+    if (y <= 1)
+    {
+        if (y == 0)
+            memset(vz, 0, bytes);
+        else if (vz != vx)
+            memcpy(vz, vx, bytes);
+        return;
+    }
+
+    Kernels->MulMem(vz, vx, y, bytes);
+}
+
+extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                                 const void * GF256_RESTRICT vx, int bytes)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_MULADD, bytes);
+
+    // Use a single if-statement to handle special cases
+    if (y <= 1)
+    {
+        if (y == 1)
+            Kernels->AddMem(vz, vx, bytes);
+        return;
+    }
+
+    Kernels->MulAddMem(vz, y, vx, bytes);
+}
+
+//------------------------------------------------------------------------------
+// Multi-Source Operations
+
+/*
+    Fused multiply-accumulate over several sources:
+
+        z[] (+)= x_0[] * y_0 + x_1[] * y_1 + ... + x_{N-1}[] * y_{N-1}
+
+    Calling gf256_muladd_mem() once per source reads and writes the whole
+    destination buffer for every source, so the destination traffic costs as
+    much as the source traffic.  Instead each SIMD register of the destination
+    is loaded once, all N partial products are accumulated into it, and it is
+    stored once.
+
+    The partial product tables for each source are hoisted out of the loop.
+    With N = 8 they do not all fit in registers, but the spills land in L1
+    and are much cheaper than the destination round trips they replace.
+*/
+
+static GF256_FORCE_INLINE void gf256_muladd_multi_kernel(uint8_t * GF256_RESTRICT z, const uint8_t * y,
+                                                         const uint8_t * const * x, int count, int bytes, bool set)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_MULADD_MULTI, (uint64_t)bytes * count);
+    Kernels->MulAddMulti(z, y, x, count, bytes, set);
+}
+
+static GF256_FORCE_INLINE void gf256_muladd_multi_kernel(uint8_t * GF256_RESTRICT z, const gf256_mul_tables * tables,
+                                                         const uint8_t * const * x, int count, int bytes, bool set)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_MULADD_MULTI, (uint64_t)bytes * count);
+    Kernels->MulAddMultiTables(z, tables, x, count, bytes, set);
+}
+
+static GF256_FORCE_INLINE void gf256_muladd_single(uint8_t * GF256_RESTRICT z, const uint8_t * y,
+                                                   const uint8_t * x, int bytes, bool set)
+{
+    if (set)
+        gf256_mul_mem(z, x, y[0], bytes);
+    else
+        gf256_muladd_mem(z, y[0], x, bytes);
+}
+
+// Tables may describe a map other than multiplication by Y, so they always go
+// through the kernel
+static GF256_FORCE_INLINE void gf256_muladd_single(uint8_t * GF256_RESTRICT z, const gf256_mul_tables * tables,
+                                                   const uint8_t * x, int bytes, bool set)
+{
+    CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_MULADD_MULTI, bytes);
+    Kernels->MulAddMultiTables(z, tables, &x, 1, bytes, set);
+}
+
+// Accumulate `count` <= kGF256MultiMaxSources sources with non-zero coefficients
+template<typename C>
+static void gf256_muladd_multi_group(uint8_t * GF256_RESTRICT z, const C * y,
+                                     const uint8_t * const * x, int count, int bytes, bool set)
+{
+    // Handle groups of 8, 4 and 2 sources
+    while (count >= 2)
+    {
+        const int n = count >= 8 ? 8 : (count >= 4 ? 4 : 2);
+        gf256_muladd_multi_kernel(z, y, x, n, bytes, set);
+        count -= n, y += n, x += n;
+        set = false;
+    }
+
+    // Handle a single source
+    if (count > 0)
+        gf256_muladd_single(z, y, x[0], bytes, set);
+}
+
+static void gf256_muladd_multi(void * GF256_RESTRICT vz, const uint8_t * y,
+                               const void * const * vx, int count, int bytes, bool set)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+
+    // Gather sources with non-zero coefficients into groups
+    const uint8_t * group_x[kGF256MultiMaxSources];
+    uint8_t group_y[kGF256MultiMaxSources];
+    int group_count = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (y[i] == 0)
+            continue;
+
+        group_x[group_count] = reinterpret_cast<const uint8_t *>(vx[i]);
+        group_y[group_count] = y[i];
+
+        if (++group_count >= kGF256MultiMaxSources)
+        {
+            gf256_muladd_multi_group(z, group_y, group_x, group_count, bytes, set);
+            group_count = 0;
+            set = false;
+        }
+    }
+
+    if (group_count > 0)
+        gf256_muladd_multi_group(z, group_y, group_x, group_count, bytes, set);
+    else if (set)
+        memset(z, 0, bytes);
+}
+
+extern "C" void gf256_muladd_multi_mem(void * GF256_RESTRICT vz, const uint8_t * y,
+                                       const void * const * vx, int count, int bytes)
+{
+    gf256_muladd_multi(vz, y, vx, count, bytes, false);
+}
+
+extern "C" void gf256_mul_multi_mem(void * GF256_RESTRICT vz, const uint8_t * y,
+                                    const void * const * vx, int count, int bytes)
+{
+    gf256_muladd_multi(vz, y, vx, count, bytes, true);
+}
+
+extern "C" void gf256_mul_tables_init(gf256_mul_tables * tables, uint8_t y)
+{
+    memcpy(tables->Lo, GF256Ctx.MM128.TABLE_LO_Y[y], 16);
+    memcpy(tables->Hi, GF256Ctx.MM128.TABLE_HI_Y[y], 16);
+    tables->Affine = GF256Ctx.GF256_AFFINE_TABLE[y];
+    tables->Y = y;
+}
+
+static void gf256_muladd_multi_tables(void * GF256_RESTRICT vz, const gf256_mul_tables * tables,
+                                      const void * const * vx, int count, int bytes, bool set)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+
+    // The tables are already contiguous, so only the sources are gathered
+    const uint8_t * group_x[kGF256MultiMaxSources];
+
+    for (int i = 0; i < count; i += kGF256MultiMaxSources)
+    {
+        const int group_count = count - i < kGF256MultiMaxSources ? count - i : kGF256MultiMaxSources;
+        for (int j = 0; j < group_count; ++j)
+            group_x[j] = reinterpret_cast<const uint8_t *>(vx[i + j]);
+
+        gf256_muladd_multi_group(z, tables + i, group_x, group_count, bytes, set);
+        set = false;
+    }
+
+    if (set)
+        memset(z, 0, bytes);
+}
+
+extern "C" void gf256_muladd_multi_tables_mem(void * GF256_RESTRICT vz, const gf256_mul_tables * tables,
+                                              const void * const * vx, int count, int bytes)
+{
+    gf256_muladd_multi_tables(vz, tables, vx, count, bytes, false);
+}
+
+extern "C" void gf256_mul_multi_tables_mem(void * GF256_RESTRICT vz, const gf256_mul_tables * tables,
+                                           const void * const * vx, int count, int bytes)
+{
+    gf256_muladd_multi_tables(vz, tables, vx, count, bytes, true);
+}
+
+//------------------------------------------------------------------------------
+// Multi-Destination Operations
+
+/*
+    Fused multiply-accumulate of one source into several destinations:
+
+        z_i[] += x[] * y_i, for i = 0 .. N-1
+
+    This is the transpose of the multi-source case, for when one buffer
+    changes and every buffer computed from it has to follow.  Each SIMD
+    register of the source is loaded and split into nibbles once and then
+    multiplied into each destination in turn, rather than being loaded and
+    split again by a separate gf256_muladd_mem() call per destination.
+*/
+
+// Update `count` <= kGF256SpreadMaxDests destinations with non-zero coefficients
+static void gf256_muladd_spread_group(uint8_t * const * z, const uint8_t * y,
+                                      const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    // Handle groups of 8, 4 and 2 destinations
+    while (count >= 2)
+    {
+        const int n = count >= 8 ? 8 : (count >= 4 ? 4 : 2);
+        CM256_STATS_KERNEL(KernelsIsa, CM256_KERNEL_MULADD_MULTI, (uint64_t)bytes * n);
+        Kernels->MulAddSpread(z, y, x, n, bytes);
+        count -= n, y += n, z += n;
+    }
+
+    // Handle a single destination
+    if (count > 0)
+        gf256_muladd_mem(z[0], y[0], x, bytes);
+}
+
+extern "C" void gf256_muladd_spread_mem(void * const * vz, const uint8_t * y,
+                                        const void * GF256_RESTRICT vx, int count, int bytes)
+{
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+
+    // Gather destinations with non-zero coefficients into groups
+    uint8_t * group_z[kGF256SpreadMaxDests];
+    uint8_t group_y[kGF256SpreadMaxDests];
+    int group_count = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (y[i] == 0)
+            continue;
+
+        group_z[group_count] = reinterpret_cast<uint8_t *>(vz[i]);
+        group_y[group_count] = y[i];
+
+        if (++group_count >= kGF256SpreadMaxDests)
+        {
+            gf256_muladd_spread_group(group_z, group_y, x, group_count, bytes);
+            group_count = 0;
+        }
+    }
+
+    if (group_count > 0)
+        gf256_muladd_spread_group(group_z, group_y, x, group_count, bytes);
+}
+
+extern "C" void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes)
+{
+#if defined(GF256_TRY_NEON)
+    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
+    GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<GF256_M128 *>(vy);
+
+    // Handle blocks of 64 bytes
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = vld1q_u8((uint8_t*) x16);
+        GF256_M128 x1 = vld1q_u8((uint8_t*)(x16 + 1));
+        GF256_M128 x2 = vld1q_u8((uint8_t*)(x16 + 2));
+        GF256_M128 x3 = vld1q_u8((uint8_t*)(x16 + 3));
+        GF256_M128 y0 = vld1q_u8((uint8_t*) y16);
+        GF256_M128 y1 = vld1q_u8((uint8_t*)(y16 + 1));
+        GF256_M128 y2 = vld1q_u8((uint8_t*)(y16 + 2));
+        GF256_M128 y3 = vld1q_u8((uint8_t*)(y16 + 3));
+
+        vst1q_u8((uint8_t*) x16,      y0);
+        vst1q_u8((uint8_t*)(x16 + 1), y1);
+        vst1q_u8((uint8_t*)(x16 + 2), y2);
+        vst1q_u8((uint8_t*)(x16 + 3), y3);
+        vst1q_u8((uint8_t*) y16,      x0);
+        vst1q_u8((uint8_t*)(y16 + 1), x1);
+        vst1q_u8((uint8_t*)(y16 + 2), x2);
+        vst1q_u8((uint8_t*)(y16 + 3), x3);
+
+        bytes -= 64, x16 += 4, y16 += 4;
+    }
+
+    // Handle blocks of 16 bytes
+    while (bytes >= 16)
+    {
+        GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
+        GF256_M128 y0 = vld1q_u8((uint8_t*)y16);
+        vst1q_u8((uint8_t*)x16, y0);
+        vst1q_u8((uint8_t*)y16, x0);
+
+        bytes -= 16, ++x16, ++y16;
+    }
+#elif defined(GF256_TARGET_MOBILE)
+    uint64_t * GF256_RESTRICT x16 = reinterpret_cast<uint64_t *>(vx);
+    uint64_t * GF256_RESTRICT y16 = reinterpret_cast<uint64_t *>(vy);
+
+    const unsigned count = (unsigned)bytes / 8;
+    for (unsigned ii = 0; ii < count; ++ii)
+    {
+        const uint64_t temp = x16[ii];
+        x16[ii] = y16[ii];
+        y16[ii] = temp;
+    }
+
+    x16 += count;
+    y16 += count;
+    bytes -= count * 8;
+#else
+    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
+    GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<GF256_M128 *>(vy);
+
+    // Handle blocks of 16 bytes
+    while (bytes >= 16)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 y0 = _mm_loadu_si128(y16);
+        _mm_storeu_si128(x16, y0);
+        _mm_storeu_si128(y16, x0);
+
+        bytes -= 16, ++x16, ++y16;
+    }
+#endif
+
+    uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(x16);
+    uint8_t * GF256_RESTRICT y1 = reinterpret_cast<uint8_t *>(y16);
+
+    // Handle a block of 8 bytes
+    const int eight = bytes & 8;
+    if (eight)
+    {
+        uint64_t * GF256_RESTRICT x8 = reinterpret_cast<uint64_t *>(x1);
+        uint64_t * GF256_RESTRICT y8 = reinterpret_cast<uint64_t *>(y1);
+
+        uint64_t temp = *x8;
+        *x8 = *y8;
+        *y8 = temp;
+    }
+
+    // Handle a block of 4 bytes
+    const int four = bytes & 4;
+    if (four)
+    {
+        uint32_t * GF256_RESTRICT x4 = reinterpret_cast<uint32_t *>(x1 + eight);
+        uint32_t * GF256_RESTRICT y4 = reinterpret_cast<uint32_t *>(y1 + eight);
+
+        uint32_t temp = *x4;
+        *x4 = *y4;
+        *y4 = temp;
+    }
+
+    // Handle final bytes
+    const int offset = eight + four;
+    uint8_t temp;
+    switch (bytes & 3)
+    {
+    case 3: temp = x1[offset + 2]; x1[offset + 2] = y1[offset + 2]; y1[offset + 2] = temp;
+    case 2: temp = x1[offset + 1]; x1[offset + 1] = y1[offset + 1]; y1[offset + 1] = temp;
+    case 1: temp = x1[offset]; x1[offset] = y1[offset]; y1[offset] = temp;
+    default:
+        break;
+    }
+}
+
+extern "C" void gf256_stream_copy_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, int bytes)
+{
+#if defined(GF256_TARGET_MOBILE)
+    // No portable non-temporal store, so this is a plain copy
+    memcpy(vz, vx, bytes);
+#else
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(vx);
+
+    // Non-temporal stores must be aligned, so copy up to the first 16 bytes
+    int head = (int)((16 - (reinterpret_cast<uintptr_t>(z1) & 15)) & 15);
+    if (head > bytes)
+        head = bytes;
+    memcpy(z1, x1, head);
+    bytes -= head, z1 += head, x1 += head;
+
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z1);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x1);
+
+    // Write whole cache lines at a time so the write-combining buffers fill
+    while (bytes >= 64)
+    {
+        const GF256_M128 v0 = _mm_loadu_si128(x16);
+        const GF256_M128 v1 = _mm_loadu_si128(x16 + 1);
+        const GF256_M128 v2 = _mm_loadu_si128(x16 + 2);
+        const GF256_M128 v3 = _mm_loadu_si128(x16 + 3);
+        _mm_stream_si128(z16, v0);
+        _mm_stream_si128(z16 + 1, v1);
+        _mm_stream_si128(z16 + 2, v2);
+        _mm_stream_si128(z16 + 3, v3);
+        bytes -= 64, x16 += 4, z16 += 4;
+    }
+
+    while (bytes >= 16)
+    {
+        _mm_stream_si128(z16, _mm_loadu_si128(x16));
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    memcpy(z16, x16, bytes);
+#endif
+}
+
+extern "C" void gf256_stream_fence()
+{
+#if !defined(GF256_TARGET_MOBILE)
+    _mm_sfence();
+#endif
+}
+
+extern "C" void gf256_prefetch_mem(const void * vx, int bytes)
+{
+    const char * x1 = reinterpret_cast<const char *>(vx);
+
+    for (int offset = 0; offset < bytes; offset += 64)
+    {
+#if !defined(GF256_TARGET_MOBILE)
+        _mm_prefetch(x1 + offset, _MM_HINT_T1);
+#elif defined(__GNUC__)
+        __builtin_prefetch(x1 + offset, 0, 2);
+#endif
+    }
 }
\ No newline at end of file
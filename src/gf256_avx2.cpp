@@ -0,0 +1,542 @@
+/** \file
+    \brief GF(256) AVX2 Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf256_kernels.h"
+
+// Built with -mavx2
+#if defined(GF256_TRY_AVX2) && defined(__AVX2__)
+
+/*
+    AVX2 kernels
+
+    These handle 32 bytes at a time using the _mm256_shuffle_epi8() version of
+    the partial product tables described in gf256.cpp.  A remaining 16 bytes
+    are handled with the 128-bit instructions, and the last few bytes with the
+    portable kernels.
+*/
+
+// Partial product tables for y in both lanes.  The compact context has only
+// the 128-bit tables, which are broadcast into both lanes.
+static GF256_FORCE_INLINE GF256_M256 gf256_table_lo_avx2(uint8_t y)
+{
+#ifdef GF256_COMPACT_CONTEXT
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const GF256_M128*>(GF256Ctx.MM128.TABLE_LO_Y[y])));
+#else
+    return _mm256_loadu_si256(reinterpret_cast<const GF256_M256*>(GF256Ctx.MM256.TABLE_LO_Y[y]));
+#endif
+}
+
+static GF256_FORCE_INLINE GF256_M256 gf256_table_hi_avx2(uint8_t y)
+{
+#ifdef GF256_COMPACT_CONTEXT
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const GF256_M128*>(GF256Ctx.MM128.TABLE_HI_Y[y])));
+#else
+    return _mm256_loadu_si256(reinterpret_cast<const GF256_M256*>(GF256Ctx.MM256.TABLE_HI_Y[y]));
+#endif
+}
+
+static void gf256_add_mem_avx2(void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<GF256_M256 *>(vx);
+    const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(vy);
+
+    while (bytes >= 128)
+    {
+        GF256_M256 x0 = _mm256_loadu_si256(x32);
+        GF256_M256 y0 = _mm256_loadu_si256(y32);
+        x0 = _mm256_xor_si256(x0, y0);
+        GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
+        GF256_M256 y1 = _mm256_loadu_si256(y32 + 1);
+        x1 = _mm256_xor_si256(x1, y1);
+        GF256_M256 x2 = _mm256_loadu_si256(x32 + 2);
+        GF256_M256 y2 = _mm256_loadu_si256(y32 + 2);
+        x2 = _mm256_xor_si256(x2, y2);
+        GF256_M256 x3 = _mm256_loadu_si256(x32 + 3);
+        GF256_M256 y3 = _mm256_loadu_si256(y32 + 3);
+        x3 = _mm256_xor_si256(x3, y3);
+
+        _mm256_storeu_si256(x32, x0);
+        _mm256_storeu_si256(x32 + 1, x1);
+        _mm256_storeu_si256(x32 + 2, x2);
+        _mm256_storeu_si256(x32 + 3, x3);
+
+        bytes -= 128, x32 += 4, y32 += 4;
+    }
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        // x[i] = x[i] xor y[i]
+        _mm256_storeu_si256(x32,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(x32),
+                _mm256_loadu_si256(y32)));
+
+        bytes -= 32, ++x32, ++y32;
+    }
+
+    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(x32);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(y32);
+
+    // Handle 16 bytes
+    if (bytes >= 16)
+    {
+        // x[i] = x[i] xor y[i]
+        _mm_storeu_si128(x16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+
+        bytes -= 16, ++x16, ++y16;
+    }
+
+    gf256_add_mem_scalar(x16, y16, bytes);
+}
+
+static void gf256_add2_mem_avx2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(vy);
+
+    const unsigned count = bytes / 32;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        _mm256_storeu_si256(z32 + i,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(z32 + i),
+                _mm256_xor_si256(
+                    _mm256_loadu_si256(x32 + i),
+                    _mm256_loadu_si256(y32 + i))));
+    }
+
+    bytes -= count * 32;
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
+
+    // Handle 16 bytes
+    if (bytes >= 16)
+    {
+        // z[i] = z[i] xor x[i] xor y[i]
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(z16),
+                _mm_xor_si128(
+                    _mm_loadu_si128(x16),
+                    _mm_loadu_si128(y16))));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    gf256_add2_mem_scalar(z16, x16, y16, bytes);
+}
+
+static void gf256_addset_mem_avx2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(vy);
+
+    const unsigned count = bytes / 32;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        _mm256_storeu_si256(z32 + i,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(x32 + i),
+                _mm256_loadu_si256(y32 + i)));
+    }
+
+    bytes -= count * 32;
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
+
+    // Handle 16 bytes
+    if (bytes >= 16)
+    {
+        // z[i] = x[i] xor y[i]
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    gf256_addset_mem_scalar(z16, x16, y16, bytes);
+}
+
+static void gf256_mul_mem_avx2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+
+    // Partial product tables; see gf256.cpp
+    const GF256_M256 table_lo_y = gf256_table_lo_avx2(y);
+    const GF256_M256 table_hi_y = gf256_table_hi_avx2(y);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        // See gf256.cpp for details
+        GF256_M256 x0 = _mm256_loadu_si256(x32);
+        GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        _mm256_storeu_si256(z32, _mm256_xor_si256(l0, h0));
+
+        bytes -= 32, ++x32, ++z32;
+    }
+
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32);
+
+    // Handle 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        l0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_lo_y), l0);
+        h0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_hi_y), h0);
+        _mm_storeu_si128(z16, _mm_xor_si128(l0, h0));
+
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    gf256_mul_mem_scalar(z16, x16, y, bytes);
+}
+
+static void gf256_muladd_mem_avx2(void * GF256_RESTRICT vz, uint8_t y,
+                                  const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+
+    // Partial product tables; see gf256.cpp
+    const GF256_M256 table_lo_y = gf256_table_lo_avx2(y);
+    const GF256_M256 table_hi_y = gf256_table_hi_avx2(y);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // On my Reed Solomon codec, the encoder unit test runs in 640 usec without and 550 usec with the optimization (86% of the original time)
+    const unsigned count = bytes / 64;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // See gf256.cpp for details
+        GF256_M256 x0 = _mm256_loadu_si256(x32 + i * 2);
+        GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        const GF256_M256 z0 = _mm256_loadu_si256(z32 + i * 2);
+        GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
+        _mm256_storeu_si256(z32 + i * 2, _mm256_xor_si256(p0, z0));
+
+        GF256_M256 x1 = _mm256_loadu_si256(x32 + i * 2 + 1);
+        GF256_M256 l1 = _mm256_and_si256(x1, clr_mask);
+        x1 = _mm256_srli_epi64(x1, 4);
+        const GF256_M256 z1 = _mm256_loadu_si256(z32 + i * 2 + 1);
+        GF256_M256 h1 = _mm256_and_si256(x1, clr_mask);
+        l1 = _mm256_shuffle_epi8(table_lo_y, l1);
+        h1 = _mm256_shuffle_epi8(table_hi_y, h1);
+        const GF256_M256 p1 = _mm256_xor_si256(l1, h1);
+        _mm256_storeu_si256(z32 + i * 2 + 1, _mm256_xor_si256(p1, z1));
+    }
+    bytes -= count * 64;
+    z32 += count * 2;
+    x32 += count * 2;
+
+    if (bytes >= 32)
+    {
+        GF256_M256 x0 = _mm256_loadu_si256(x32);
+        GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
+        const GF256_M256 z0 = _mm256_loadu_si256(z32);
+        _mm256_storeu_si256(z32, _mm256_xor_si256(p0, z0));
+
+        bytes -= 32;
+        z32++;
+        x32++;
+    }
+
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32);
+
+    // Handle 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        l0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_lo_y), l0);
+        h0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_hi_y), h0);
+        const GF256_M128 p0 = _mm_xor_si128(l0, h0);
+        const GF256_M128 z0 = _mm_loadu_si128(z16);
+        _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
+
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    gf256_muladd_mem_scalar(z16, y, x16, bytes);
+}
+
+template<int N, bool Set, typename C>
+static void gf256_muladd_multi_n_avx2(uint8_t * GF256_RESTRICT z, const C * y,
+                                      const uint8_t * const * x, int bytes)
+{
+    int offset = 0;
+
+    // Partial product tables; see gf256.cpp
+    GF256_M256 table_lo_y[N], table_hi_y[N];
+    for (int s = 0; s < N; ++s)
+    {
+        table_lo_y[s] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(gf256_table_lo(y, s))));
+        table_hi_y[s] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(gf256_table_hi(y, s))));
+    }
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // Handle multiples of 64 bytes with two independent accumulators
+    while (bytes - offset >= 64)
+    {
+        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z + offset);
+        GF256_M256 z0 = Set ? _mm256_setzero_si256() : _mm256_loadu_si256(z32);
+        GF256_M256 z1 = Set ? _mm256_setzero_si256() : _mm256_loadu_si256(z32 + 1);
+
+        for (int s = 0; s < N; ++s)
+        {
+            // See gf256.cpp for details
+            const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x[s] + offset);
+            GF256_M256 x0 = _mm256_loadu_si256(x32);
+            GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
+            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+            GF256_M256 l1 = _mm256_and_si256(x1, clr_mask);
+            x0 = _mm256_srli_epi64(x0, 4);
+            x1 = _mm256_srli_epi64(x1, 4);
+            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+            GF256_M256 h1 = _mm256_and_si256(x1, clr_mask);
+            l0 = _mm256_shuffle_epi8(table_lo_y[s], l0);
+            l1 = _mm256_shuffle_epi8(table_lo_y[s], l1);
+            h0 = _mm256_shuffle_epi8(table_hi_y[s], h0);
+            h1 = _mm256_shuffle_epi8(table_hi_y[s], h1);
+            z0 = _mm256_xor_si256(z0, _mm256_xor_si256(l0, h0));
+            z1 = _mm256_xor_si256(z1, _mm256_xor_si256(l1, h1));
+        }
+
+        _mm256_storeu_si256(z32, z0);
+        _mm256_storeu_si256(z32 + 1, z1);
+        offset += 64;
+    }
+
+    // Handle multiples of 32 bytes
+    while (bytes - offset >= 32)
+    {
+        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z + offset);
+        GF256_M256 z0 = Set ? _mm256_setzero_si256() : _mm256_loadu_si256(z32);
+
+        for (int s = 0; s < N; ++s)
+        {
+            // See gf256.cpp for details
+            GF256_M256 x0 = _mm256_loadu_si256(reinterpret_cast<const GF256_M256 *>(x[s] + offset));
+            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+            x0 = _mm256_srli_epi64(x0, 4);
+            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+            l0 = _mm256_shuffle_epi8(table_lo_y[s], l0);
+            h0 = _mm256_shuffle_epi8(table_hi_y[s], h0);
+            z0 = _mm256_xor_si256(z0, _mm256_xor_si256(l0, h0));
+        }
+
+        _mm256_storeu_si256(z32, z0);
+        offset += 32;
+    }
+
+    // Handle 16 bytes
+    if (bytes - offset >= 16)
+    {
+        GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z + offset);
+        GF256_M128 z0 = Set ? _mm_setzero_si128() : _mm_loadu_si128(z16);
+
+        for (int s = 0; s < N; ++s)
+        {
+            GF256_M128 x0 = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(x[s] + offset));
+            GF256_M128 l0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+            x0 = _mm_srli_epi64(x0, 4);
+            GF256_M128 h0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+            l0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_lo_y[s]), l0);
+            h0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_hi_y[s]), h0);
+            z0 = _mm_xor_si128(z0, _mm_xor_si128(l0, h0));
+        }
+
+        _mm_storeu_si128(z16, z0);
+        offset += 16;
+    }
+
+    gf256_muladd_multi_scalar(z, y, x, N, offset, bytes, Set);
+}
+
+template<typename C>
+static void gf256_muladd_multi_avx2(uint8_t * GF256_RESTRICT z, const C * y,
+                                    const uint8_t * const * x, int count, int bytes, bool set)
+{
+    switch (count)
+    {
+    case 8:
+        if (set) gf256_muladd_multi_n_avx2<8, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx2<8, false>(z, y, x, bytes);
+        break;
+    case 4:
+        if (set) gf256_muladd_multi_n_avx2<4, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx2<4, false>(z, y, x, bytes);
+        break;
+    case 1:
+        if (set) gf256_muladd_multi_n_avx2<1, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx2<1, false>(z, y, x, bytes);
+        break;
+    default:
+        if (set) gf256_muladd_multi_n_avx2<2, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx2<2, false>(z, y, x, bytes);
+        break;
+    }
+}
+
+template<int N>
+static void gf256_muladd_spread_n_avx2(uint8_t * const * z, const uint8_t * y,
+                                       const uint8_t * GF256_RESTRICT x, int bytes)
+{
+    int offset = 0;
+
+    // Partial product tables; see gf256.cpp
+    GF256_M256 table_lo_y[N], table_hi_y[N];
+    for (int d = 0; d < N; ++d)
+    {
+        table_lo_y[d] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(GF256Ctx.MM128.TABLE_LO_Y[y[d]])));
+        table_hi_y[d] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(GF256Ctx.MM128.TABLE_HI_Y[y[d]])));
+    }
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // Handle multiples of 32 bytes, splitting the source once for all destinations
+    while (bytes - offset >= 32)
+    {
+        GF256_M256 x0 = _mm256_loadu_si256(reinterpret_cast<const GF256_M256 *>(x + offset));
+        const GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        const GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+
+        for (int d = 0; d < N; ++d)
+        {
+            GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z[d] + offset);
+            const GF256_M256 p0 = _mm256_xor_si256(_mm256_shuffle_epi8(table_lo_y[d], l0),
+                                                   _mm256_shuffle_epi8(table_hi_y[d], h0));
+            _mm256_storeu_si256(z32, _mm256_xor_si256(_mm256_loadu_si256(z32), p0));
+        }
+
+        offset += 32;
+    }
+
+    // Handle 16 bytes
+    if (bytes - offset >= 16)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(x + offset));
+        const GF256_M128 l0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        x0 = _mm_srli_epi64(x0, 4);
+        const GF256_M128 h0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+
+        for (int d = 0; d < N; ++d)
+        {
+            GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z[d] + offset);
+            const GF256_M128 p0 = _mm_xor_si128(_mm_shuffle_epi8(_mm256_castsi256_si128(table_lo_y[d]), l0),
+                                                _mm_shuffle_epi8(_mm256_castsi256_si128(table_hi_y[d]), h0));
+            _mm_storeu_si128(z16, _mm_xor_si128(_mm_loadu_si128(z16), p0));
+        }
+
+        offset += 16;
+    }
+
+    gf256_muladd_spread_scalar(z, y, x, N, offset, bytes);
+}
+
+static void gf256_muladd_spread_avx2(uint8_t * const * z, const uint8_t * y,
+                                     const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    switch (count)
+    {
+    case 8: gf256_muladd_spread_n_avx2<8>(z, y, x, bytes); break;
+    case 4: gf256_muladd_spread_n_avx2<4>(z, y, x, bytes); break;
+    case 1: gf256_muladd_spread_n_avx2<1>(z, y, x, bytes); break;
+    default: gf256_muladd_spread_n_avx2<2>(z, y, x, bytes); break;
+    }
+}
+
+static const gf256_kernels kKernelsAVX2 = {
+    "AVX2",
+    gf256_add_mem_avx2,
+    gf256_add2_mem_avx2,
+    gf256_addset_mem_avx2,
+    gf256_mul_mem_avx2,
+    gf256_muladd_mem_avx2,
+    gf256_muladd_multi_avx2<uint8_t>,
+    gf256_muladd_multi_avx2<gf256_mul_tables>,
+    gf256_muladd_spread_avx2
+};
+
+const gf256_kernels* gf256_kernels_avx2()
+{
+    return &kKernelsAVX2;
+}
+
+#else // __AVX2__
+
+const gf256_kernels* gf256_kernels_avx2()
+{
+    return nullptr;
+}
+
+#endif // __AVX2__
@@ -0,0 +1,321 @@
+/** \file
+    \brief GF(256) AVX-512BW Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf256_kernels.h"
+
+// Built with -mavx512f -mavx512bw
+#if defined(GF256_TRY_AVX2) && defined(__AVX512F__) && defined(__AVX512BW__)
+
+/*
+    AVX-512BW kernels
+
+    These handle 64 bytes at a time.  The 16-byte partial product tables from
+    gf256.cpp are broadcast into all four lanes, since _mm512_shuffle_epi8()
+    also shuffles within 128-bit lanes.  The last partial register is handled
+    with byte-masked loads and stores, so no portable tail is needed.
+
+    The XOR kernels are shared with the GFNI kernel table.
+*/
+
+static GF256_FORCE_INLINE __mmask64 gf256_tail_mask(int bytes)
+{
+    return bytes >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << bytes) - 1);
+}
+
+static GF256_FORCE_INLINE __m512i gf256_mul_512(__m512i x, __m512i table_lo_y,
+                                                __m512i table_hi_y, __m512i clr_mask)
+{
+    // See gf256.cpp for details
+    const __m512i l = _mm512_shuffle_epi8(table_lo_y, _mm512_and_si512(x, clr_mask));
+    const __m512i h = _mm512_shuffle_epi8(table_hi_y, _mm512_and_si512(_mm512_srli_epi64(x, 4), clr_mask));
+    return _mm512_xor_si512(l, h);
+}
+
+void gf256_add_mem_avx512(void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT x = reinterpret_cast<uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y = reinterpret_cast<const uint8_t *>(vy);
+
+    while (bytes >= 128)
+    {
+        const __m512i x0 = _mm512_loadu_si512(x);
+        const __m512i x1 = _mm512_loadu_si512(x + 64);
+        const __m512i y0 = _mm512_loadu_si512(y);
+        const __m512i y1 = _mm512_loadu_si512(y + 64);
+        _mm512_storeu_si512(x, _mm512_xor_si512(x0, y0));
+        _mm512_storeu_si512(x + 64, _mm512_xor_si512(x1, y1));
+        bytes -= 128, x += 128, y += 128;
+    }
+
+    while (bytes > 0)
+    {
+        const __mmask64 mask = gf256_tail_mask(bytes);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        const __m512i y0 = _mm512_maskz_loadu_epi8(mask, y);
+        _mm512_mask_storeu_epi8(x, mask, _mm512_xor_si512(x0, y0));
+        bytes -= 64, x += 64, y += 64;
+    }
+}
+
+void gf256_add2_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y = reinterpret_cast<const uint8_t *>(vy);
+
+    while (bytes > 0)
+    {
+        // z[i] = z[i] xor x[i] xor y[i]
+        const __mmask64 mask = gf256_tail_mask(bytes);
+        const __m512i z0 = _mm512_maskz_loadu_epi8(mask, z);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        const __m512i y0 = _mm512_maskz_loadu_epi8(mask, y);
+        _mm512_mask_storeu_epi8(z, mask, _mm512_ternarylogic_epi32(z0, x0, y0, 0x96));
+        bytes -= 64, x += 64, y += 64, z += 64;
+    }
+}
+
+void gf256_addset_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                    const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y = reinterpret_cast<const uint8_t *>(vy);
+
+    while (bytes > 0)
+    {
+        // z[i] = x[i] xor y[i]
+        const __mmask64 mask = gf256_tail_mask(bytes);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        const __m512i y0 = _mm512_maskz_loadu_epi8(mask, y);
+        _mm512_mask_storeu_epi8(z, mask, _mm512_xor_si512(x0, y0));
+        bytes -= 64, x += 64, y += 64, z += 64;
+    }
+}
+
+static void gf256_mul_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+
+    // Partial product tables; see gf256.cpp
+    const __m512i table_lo_y = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(GF256Ctx.MM128.TABLE_LO_Y[y])));
+    const __m512i table_hi_y = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(GF256Ctx.MM128.TABLE_HI_Y[y])));
+    const __m512i clr_mask = _mm512_set1_epi8(0x0f);
+
+    while (bytes > 0)
+    {
+        const __mmask64 mask = gf256_tail_mask(bytes);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        _mm512_mask_storeu_epi8(z, mask, gf256_mul_512(x0, table_lo_y, table_hi_y, clr_mask));
+        bytes -= 64, x += 64, z += 64;
+    }
+}
+
+static void gf256_muladd_mem_avx512(void * GF256_RESTRICT vz, uint8_t y,
+                                    const void * GF256_RESTRICT vx, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+
+    // Partial product tables; see gf256.cpp
+    const __m512i table_lo_y = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(GF256Ctx.MM128.TABLE_LO_Y[y])));
+    const __m512i table_hi_y = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(GF256Ctx.MM128.TABLE_HI_Y[y])));
+    const __m512i clr_mask = _mm512_set1_epi8(0x0f);
+
+    while (bytes >= 128)
+    {
+        const __m512i x0 = _mm512_loadu_si512(x);
+        const __m512i x1 = _mm512_loadu_si512(x + 64);
+        const __m512i z0 = _mm512_loadu_si512(z);
+        const __m512i z1 = _mm512_loadu_si512(z + 64);
+        const __m512i p0 = gf256_mul_512(x0, table_lo_y, table_hi_y, clr_mask);
+        const __m512i p1 = gf256_mul_512(x1, table_lo_y, table_hi_y, clr_mask);
+        _mm512_storeu_si512(z, _mm512_xor_si512(z0, p0));
+        _mm512_storeu_si512(z + 64, _mm512_xor_si512(z1, p1));
+        bytes -= 128, x += 128, z += 128;
+    }
+
+    while (bytes > 0)
+    {
+        const __mmask64 mask = gf256_tail_mask(bytes);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        const __m512i z0 = _mm512_maskz_loadu_epi8(mask, z);
+        const __m512i p0 = gf256_mul_512(x0, table_lo_y, table_hi_y, clr_mask);
+        _mm512_mask_storeu_epi8(z, mask, _mm512_xor_si512(z0, p0));
+        bytes -= 64, x += 64, z += 64;
+    }
+}
+
+template<int N, bool Set, typename C>
+static void gf256_muladd_multi_n_avx512(uint8_t * GF256_RESTRICT z, const C * y,
+                                        const uint8_t * const * x, int bytes)
+{
+    int offset = 0;
+
+    // Partial product tables; see gf256.cpp
+    __m512i table_lo_y[N], table_hi_y[N];
+    for (int s = 0; s < N; ++s)
+    {
+        table_lo_y[s] = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(gf256_table_lo(y, s))));
+        table_hi_y[s] = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(gf256_table_hi(y, s))));
+    }
+    const __m512i clr_mask = _mm512_set1_epi8(0x0f);
+
+    // Handle multiples of 128 bytes with two independent accumulators
+    while (bytes - offset >= 128)
+    {
+        __m512i z0 = Set ? _mm512_setzero_si512() : _mm512_loadu_si512(z + offset);
+        __m512i z1 = Set ? _mm512_setzero_si512() : _mm512_loadu_si512(z + offset + 64);
+
+        for (int s = 0; s < N; ++s)
+        {
+            const __m512i x0 = _mm512_loadu_si512(x[s] + offset);
+            const __m512i x1 = _mm512_loadu_si512(x[s] + offset + 64);
+            z0 = _mm512_xor_si512(z0, gf256_mul_512(x0, table_lo_y[s], table_hi_y[s], clr_mask));
+            z1 = _mm512_xor_si512(z1, gf256_mul_512(x1, table_lo_y[s], table_hi_y[s], clr_mask));
+        }
+
+        _mm512_storeu_si512(z + offset, z0);
+        _mm512_storeu_si512(z + offset + 64, z1);
+        offset += 128;
+    }
+
+    while (offset < bytes)
+    {
+        const __mmask64 mask = gf256_tail_mask(bytes - offset);
+        __m512i z0 = Set ? _mm512_setzero_si512() : _mm512_maskz_loadu_epi8(mask, z + offset);
+
+        for (int s = 0; s < N; ++s)
+        {
+            const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x[s] + offset);
+            z0 = _mm512_xor_si512(z0, gf256_mul_512(x0, table_lo_y[s], table_hi_y[s], clr_mask));
+        }
+
+        _mm512_mask_storeu_epi8(z + offset, mask, z0);
+        offset += 64;
+    }
+}
+
+template<typename C>
+static void gf256_muladd_multi_avx512(uint8_t * GF256_RESTRICT z, const C * y,
+                                      const uint8_t * const * x, int count, int bytes, bool set)
+{
+    switch (count)
+    {
+    case 8:
+        if (set) gf256_muladd_multi_n_avx512<8, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx512<8, false>(z, y, x, bytes);
+        break;
+    case 4:
+        if (set) gf256_muladd_multi_n_avx512<4, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx512<4, false>(z, y, x, bytes);
+        break;
+    case 1:
+        if (set) gf256_muladd_multi_n_avx512<1, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx512<1, false>(z, y, x, bytes);
+        break;
+    default:
+        if (set) gf256_muladd_multi_n_avx512<2, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_avx512<2, false>(z, y, x, bytes);
+        break;
+    }
+}
+
+template<int N>
+static void gf256_muladd_spread_n_avx512(uint8_t * const * z, const uint8_t * y,
+                                         const uint8_t * GF256_RESTRICT x, int bytes)
+{
+    // Partial product tables; see gf256.cpp
+    __m512i table_lo_y[N], table_hi_y[N];
+    for (int d = 0; d < N; ++d)
+    {
+        table_lo_y[d] = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(GF256Ctx.MM128.TABLE_LO_Y[y[d]])));
+        table_hi_y[d] = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(GF256Ctx.MM128.TABLE_HI_Y[y[d]])));
+    }
+    const __m512i clr_mask = _mm512_set1_epi8(0x0f);
+
+    // Split each register of the source once for all destinations
+    for (int offset = 0; offset < bytes; offset += 64)
+    {
+        const __mmask64 mask = gf256_tail_mask(bytes - offset);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x + offset);
+        const __m512i l0 = _mm512_and_si512(x0, clr_mask);
+        const __m512i h0 = _mm512_and_si512(_mm512_srli_epi64(x0, 4), clr_mask);
+
+        for (int d = 0; d < N; ++d)
+        {
+            const __m512i z0 = _mm512_maskz_loadu_epi8(mask, z[d] + offset);
+            const __m512i p0 = _mm512_ternarylogic_epi32(z0, _mm512_shuffle_epi8(table_lo_y[d], l0),
+                                                         _mm512_shuffle_epi8(table_hi_y[d], h0), 0x96);
+            _mm512_mask_storeu_epi8(z[d] + offset, mask, p0);
+        }
+    }
+}
+
+static void gf256_muladd_spread_avx512(uint8_t * const * z, const uint8_t * y,
+                                       const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    switch (count)
+    {
+    case 8: gf256_muladd_spread_n_avx512<8>(z, y, x, bytes); break;
+    case 4: gf256_muladd_spread_n_avx512<4>(z, y, x, bytes); break;
+    case 1: gf256_muladd_spread_n_avx512<1>(z, y, x, bytes); break;
+    default: gf256_muladd_spread_n_avx512<2>(z, y, x, bytes); break;
+    }
+}
+
+static const gf256_kernels kKernelsAVX512 = {
+    "AVX512BW",
+    gf256_add_mem_avx512,
+    gf256_add2_mem_avx512,
+    gf256_addset_mem_avx512,
+    gf256_mul_mem_avx512,
+    gf256_muladd_mem_avx512,
+    gf256_muladd_multi_avx512<uint8_t>,
+    gf256_muladd_multi_avx512<gf256_mul_tables>,
+    gf256_muladd_spread_avx512
+};
+
+const gf256_kernels* gf256_kernels_avx512()
+{
+    return &kKernelsAVX512;
+}
+
+#else // __AVX512BW__
+
+const gf256_kernels* gf256_kernels_avx512()
+{
+    return nullptr;
+}
+
+#endif // __AVX512BW__
@@ -0,0 +1,255 @@
+/** \file
+    \brief GF(256) GFNI Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf256_kernels.h"
+
+// Built with -mavx512f -mavx512bw -mgfni
+#if defined(GF256_TRY_AVX2) && defined(__AVX512F__) && defined(__AVX512BW__) && defined(__GFNI__)
+
+/*
+    GFNI kernels
+
+    Multiplying by a constant y in GF(256) is a linear map over GF(2), so it
+    is an 8x8 bit matrix applied to each byte.  GF2P8AFFINEQB applies such a
+    matrix to all 64 bytes of a register in one instruction, which replaces
+    the two table lookups, shift and masks of the PSHUFB kernels.
+
+    The instruction takes any bit matrix, so it works for the polynomial of
+    GF256Ctx and not just the AES polynomial that GF2P8MULB is fixed to.
+    GF256_AFFINE_TABLE holds the matrix for each y.
+
+    The last partial register is handled with byte-masked loads and stores.
+*/
+
+static GF256_FORCE_INLINE __mmask64 gf256_tail_mask_gfni(int bytes)
+{
+    return bytes >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << bytes) - 1);
+}
+
+static GF256_FORCE_INLINE __m512i gf256_affine_matrix(uint8_t y)
+{
+    return _mm512_set1_epi64((long long)GF256Ctx.GF256_AFFINE_TABLE[y]);
+}
+
+static void gf256_mul_matrix_gfni(uint8_t * GF256_RESTRICT z, const uint8_t * GF256_RESTRICT x,
+                                  const __m512i matrix, int bytes)
+{
+    while (bytes >= 128)
+    {
+        const __m512i x0 = _mm512_loadu_si512(x);
+        const __m512i x1 = _mm512_loadu_si512(x + 64);
+        _mm512_storeu_si512(z, _mm512_gf2p8affine_epi64_epi8(x0, matrix, 0));
+        _mm512_storeu_si512(z + 64, _mm512_gf2p8affine_epi64_epi8(x1, matrix, 0));
+        bytes -= 128, x += 128, z += 128;
+    }
+
+    while (bytes > 0)
+    {
+        const __mmask64 mask = gf256_tail_mask_gfni(bytes);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        _mm512_mask_storeu_epi8(z, mask, _mm512_gf2p8affine_epi64_epi8(x0, matrix, 0));
+        bytes -= 64, x += 64, z += 64;
+    }
+}
+
+static void gf256_muladd_matrix_gfni(uint8_t * GF256_RESTRICT z, const uint8_t * GF256_RESTRICT x,
+                                     const __m512i matrix, int bytes)
+{
+    while (bytes >= 128)
+    {
+        const __m512i x0 = _mm512_loadu_si512(x);
+        const __m512i x1 = _mm512_loadu_si512(x + 64);
+        const __m512i z0 = _mm512_loadu_si512(z);
+        const __m512i z1 = _mm512_loadu_si512(z + 64);
+        _mm512_storeu_si512(z, _mm512_xor_si512(z0, _mm512_gf2p8affine_epi64_epi8(x0, matrix, 0)));
+        _mm512_storeu_si512(z + 64, _mm512_xor_si512(z1, _mm512_gf2p8affine_epi64_epi8(x1, matrix, 0)));
+        bytes -= 128, x += 128, z += 128;
+    }
+
+    while (bytes > 0)
+    {
+        const __mmask64 mask = gf256_tail_mask_gfni(bytes);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x);
+        const __m512i z0 = _mm512_maskz_loadu_epi8(mask, z);
+        _mm512_mask_storeu_epi8(z, mask, _mm512_xor_si512(z0, _mm512_gf2p8affine_epi64_epi8(x0, matrix, 0)));
+        bytes -= 64, x += 64, z += 64;
+    }
+}
+
+static void gf256_mul_mem_gfni(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    gf256_mul_matrix_gfni(reinterpret_cast<uint8_t *>(vz), reinterpret_cast<const uint8_t *>(vx),
+                          gf256_affine_matrix(y), bytes);
+}
+
+static void gf256_muladd_mem_gfni(void * GF256_RESTRICT vz, uint8_t y,
+                                  const void * GF256_RESTRICT vx, int bytes)
+{
+    gf256_muladd_matrix_gfni(reinterpret_cast<uint8_t *>(vz), reinterpret_cast<const uint8_t *>(vx),
+                             gf256_affine_matrix(y), bytes);
+}
+
+template<int N, bool Set, typename C>
+static void gf256_muladd_multi_n_gfni(uint8_t * GF256_RESTRICT z, const C * y,
+                                      const uint8_t * const * x, int bytes)
+{
+    static_assert(N % 2 == 0, "Sources are accumulated in pairs");
+
+    int offset = 0;
+
+    __m512i matrix[N];
+    for (int s = 0; s < N; ++s)
+        matrix[s] = _mm512_set1_epi64((long long)gf256_table_affine(y, s));
+
+    // Handle multiples of 128 bytes with two independent accumulators
+    while (bytes - offset >= 128)
+    {
+        __m512i z0 = Set ? _mm512_setzero_si512() : _mm512_loadu_si512(z + offset);
+        __m512i z1 = Set ? _mm512_setzero_si512() : _mm512_loadu_si512(z + offset + 64);
+
+        // Fold two products into each accumulator with one three-way XOR
+        for (int s = 0; s < N; s += 2)
+        {
+            const __m512i a0 = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x[s] + offset), matrix[s], 0);
+            const __m512i b0 = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x[s + 1] + offset), matrix[s + 1], 0);
+            const __m512i a1 = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x[s] + offset + 64), matrix[s], 0);
+            const __m512i b1 = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x[s + 1] + offset + 64), matrix[s + 1], 0);
+            z0 = _mm512_ternarylogic_epi32(z0, a0, b0, 0x96);
+            z1 = _mm512_ternarylogic_epi32(z1, a1, b1, 0x96);
+        }
+
+        _mm512_storeu_si512(z + offset, z0);
+        _mm512_storeu_si512(z + offset + 64, z1);
+        offset += 128;
+    }
+
+    while (offset < bytes)
+    {
+        const __mmask64 mask = gf256_tail_mask_gfni(bytes - offset);
+        __m512i z0 = Set ? _mm512_setzero_si512() : _mm512_maskz_loadu_epi8(mask, z + offset);
+
+        for (int s = 0; s < N; s += 2)
+        {
+            const __m512i a0 = _mm512_gf2p8affine_epi64_epi8(_mm512_maskz_loadu_epi8(mask, x[s] + offset), matrix[s], 0);
+            const __m512i b0 = _mm512_gf2p8affine_epi64_epi8(_mm512_maskz_loadu_epi8(mask, x[s + 1] + offset), matrix[s + 1], 0);
+            z0 = _mm512_ternarylogic_epi32(z0, a0, b0, 0x96);
+        }
+
+        _mm512_mask_storeu_epi8(z + offset, mask, z0);
+        offset += 64;
+    }
+}
+
+template<typename C>
+static void gf256_muladd_multi_gfni(uint8_t * GF256_RESTRICT z, const C * y,
+                                    const uint8_t * const * x, int count, int bytes, bool set)
+{
+    switch (count)
+    {
+    case 8:
+        if (set) gf256_muladd_multi_n_gfni<8, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_gfni<8, false>(z, y, x, bytes);
+        break;
+    case 4:
+        if (set) gf256_muladd_multi_n_gfni<4, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_gfni<4, false>(z, y, x, bytes);
+        break;
+    case 1:
+        // Pairs do not apply to a single source
+        if (set) gf256_mul_matrix_gfni(z, x[0], _mm512_set1_epi64((long long)gf256_table_affine(y, 0)), bytes);
+        else gf256_muladd_matrix_gfni(z, x[0], _mm512_set1_epi64((long long)gf256_table_affine(y, 0)), bytes);
+        break;
+    default:
+        if (set) gf256_muladd_multi_n_gfni<2, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_gfni<2, false>(z, y, x, bytes);
+        break;
+    }
+}
+
+template<int N>
+static void gf256_muladd_spread_n_gfni(uint8_t * const * z, const uint8_t * y,
+                                       const uint8_t * GF256_RESTRICT x, int bytes)
+{
+    __m512i matrix[N];
+    for (int d = 0; d < N; ++d)
+        matrix[d] = gf256_affine_matrix(y[d]);
+
+    // Load each register of the source once for all destinations
+    for (int offset = 0; offset < bytes; offset += 64)
+    {
+        const __mmask64 mask = gf256_tail_mask_gfni(bytes - offset);
+        const __m512i x0 = _mm512_maskz_loadu_epi8(mask, x + offset);
+
+        for (int d = 0; d < N; ++d)
+        {
+            const __m512i z0 = _mm512_maskz_loadu_epi8(mask, z[d] + offset);
+            _mm512_mask_storeu_epi8(z[d] + offset, mask,
+                _mm512_xor_si512(z0, _mm512_gf2p8affine_epi64_epi8(x0, matrix[d], 0)));
+        }
+    }
+}
+
+static void gf256_muladd_spread_gfni(uint8_t * const * z, const uint8_t * y,
+                                     const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    switch (count)
+    {
+    case 8: gf256_muladd_spread_n_gfni<8>(z, y, x, bytes); break;
+    case 4: gf256_muladd_spread_n_gfni<4>(z, y, x, bytes); break;
+    case 1: gf256_muladd_spread_n_gfni<1>(z, y, x, bytes); break;
+    default: gf256_muladd_spread_n_gfni<2>(z, y, x, bytes); break;
+    }
+}
+
+static const gf256_kernels kKernelsGFNI = {
+    "GFNI",
+    gf256_add_mem_avx512,
+    gf256_add2_mem_avx512,
+    gf256_addset_mem_avx512,
+    gf256_mul_mem_gfni,
+    gf256_muladd_mem_gfni,
+    gf256_muladd_multi_gfni<uint8_t>,
+    gf256_muladd_multi_gfni<gf256_mul_tables>,
+    gf256_muladd_spread_gfni
+};
+
+const gf256_kernels* gf256_kernels_gfni()
+{
+    return &kKernelsGFNI;
+}
+
+#else // __GFNI__
+
+const gf256_kernels* gf256_kernels_gfni()
+{
+    return nullptr;
+}
+
+#endif // __GFNI__
@@ -0,0 +1,303 @@
+/** \file
+    \brief GF(256) Bulk Memory Kernels (internal)
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CAT_GF256_KERNELS_H
+#define CAT_GF256_KERNELS_H
+
+/** \page GF256Kernels GF(256) Kernel Dispatch
+
+    Each SIMD instruction set has its own translation unit, compiled with the
+    compiler flags for that instruction set.  The rest of the library is
+    compiled for the baseline target, so one binary runs on any host.
+
+    At gf256_init() time the CPU is queried and the fastest available kernel
+    table is selected.  The public bulk memory functions in gf256.h forward to
+    the selected table.
+
+    The SIMD kernels only handle whole registers.  They finish the last few
+    bytes with the portable kernels declared below.
+*/
+
+#include "gf256.h"
+
+
+//------------------------------------------------------------------------------
+// Kernel Table
+
+/// Maximum number of sources accumulated per pass by MulAddMulti
+static const int kGF256MultiMaxSources = 8;
+
+/// Maximum number of destinations updated per pass by MulAddSpread
+static const int kGF256SpreadMaxDests = 8;
+
+/// Bulk memory kernels built for one instruction set
+struct gf256_kernels
+{
+    /// Name of the instruction set, for diagnostics
+    const char* Name;
+
+    /// x[] += y[]
+    void (*AddMem)(void * GF256_RESTRICT vx, const void * GF256_RESTRICT vy, int bytes);
+
+    /// z[] += x[] + y[]
+    void (*Add2Mem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                    const void * GF256_RESTRICT vy, int bytes);
+
+    /// z[] = x[] + y[]
+    void (*AddSetMem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                      const void * GF256_RESTRICT vy, int bytes);
+
+    /// z[] = x[] * y, where y >= 2
+    void (*MulMem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes);
+
+    /// z[] += x[] * y, where y >= 2
+    void (*MulAddMem)(void * GF256_RESTRICT vz, uint8_t y, const void * GF256_RESTRICT vx, int bytes);
+
+    /// z[] (+)= sum x_i[] * y_i for count = 1, 2, 4 or 8 non-zero coefficients.
+    /// The destination is overwritten when set is true and accumulated otherwise.
+    void (*MulAddMulti)(uint8_t * GF256_RESTRICT z, const uint8_t * y,
+                        const uint8_t * const * x, int count, int bytes, bool set);
+
+    /// Same as MulAddMulti, with the coefficients given as precomputed tables
+    void (*MulAddMultiTables)(uint8_t * GF256_RESTRICT z, const gf256_mul_tables * tables,
+                              const uint8_t * const * x, int count, int bytes, bool set);
+
+    /// z_i[] += x[] * y_i for count = 1, 2, 4 or 8 non-zero coefficients.
+    /// The source is read once for all of the destinations.
+    void (*MulAddSpread)(uint8_t * const * z, const uint8_t * y,
+                         const uint8_t * GF256_RESTRICT x, int count, int bytes);
+};
+
+/// Returns the portable kernel table, which is always available
+extern const gf256_kernels* gf256_kernels_scalar();
+
+/// Returns the kernel table for the instruction set, or nullptr if the
+/// kernels were not built for this target
+extern const gf256_kernels* gf256_kernels_ssse3();
+extern const gf256_kernels* gf256_kernels_avx2();
+extern const gf256_kernels* gf256_kernels_avx512();
+extern const gf256_kernels* gf256_kernels_gfni();
+extern const gf256_kernels* gf256_kernels_neon();
+extern const gf256_kernels* gf256_kernels_sve2();
+
+/// Instruction sets the CPU supports, for other modules that select their
+/// own kernels.  The CPU is queried on first use, so this may be called
+/// before gf256_init().
+struct gf256_cpu_features
+{
+    bool SSSE3;
+    bool SSE42; // For the CRC32C instruction
+    bool AVX2;
+    bool AVX512BW;
+    bool GFNI;
+    bool Neon;
+    bool SVE2;
+};
+
+extern gf256_cpu_features gf256_get_cpu_features();
+
+/// Replaces the kernel table selected by gf256_init(), so that benchmarks
+/// can time the whole library on each instruction set.  Passing nullptr
+/// restores the default selection.  The table must be supported by the CPU.
+/// Not thread-safe: call it while no other thread is using the library.
+extern void gf256_set_kernels(const gf256_kernels* kernels);
+
+
+//------------------------------------------------------------------------------
+// Portable Kernels
+
+extern void gf256_add_mem_scalar(void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes);
+
+extern void gf256_add2_mem_scalar(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const void * GF256_RESTRICT vy, int bytes);
+
+extern void gf256_addset_mem_scalar(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                    const void * GF256_RESTRICT vy, int bytes);
+
+extern void gf256_mul_mem_scalar(void * GF256_RESTRICT vz,
+                                 const void * GF256_RESTRICT vx, uint8_t y, int bytes);
+
+extern void gf256_muladd_mem_scalar(void * GF256_RESTRICT vz, uint8_t y,
+                                    const void * GF256_RESTRICT vx, int bytes);
+
+
+//------------------------------------------------------------------------------
+// Product Rows
+//
+// The portable kernels multiply by a constant through a row of products,
+// indexed by the other factor.  The full context has the row in its multiply
+// table.  The compact context has no multiply table, so its row combines the
+// two nibble tables of the coefficient, which stay in L1.
+
+#ifdef GF256_COMPACT_CONTEXT
+
+struct gf256_mul_row
+{
+    const uint8_t * Lo;
+    const uint8_t * Hi;
+
+    GF256_FORCE_INLINE uint8_t operator[](uint8_t x) const
+    {
+        return Lo[x & 15] ^ Hi[x >> 4];
+    }
+};
+
+static GF256_FORCE_INLINE gf256_mul_row gf256_get_mul_row(uint8_t y)
+{
+    gf256_mul_row row;
+    row.Lo = GF256Ctx.MM128.TABLE_LO_Y[y];
+    row.Hi = GF256Ctx.MM128.TABLE_HI_Y[y];
+    return row;
+}
+
+#else // GF256_COMPACT_CONTEXT
+
+typedef const uint8_t * gf256_mul_row;
+
+static GF256_FORCE_INLINE gf256_mul_row gf256_get_mul_row(uint8_t y)
+{
+    return GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
+}
+
+#endif // GF256_COMPACT_CONTEXT
+
+
+//------------------------------------------------------------------------------
+// Coefficient Access
+//
+// The multi-source kernels are templates over the coefficient array type, so
+// the same code takes either coefficients (uint8_t) or precomputed tables
+// (gf256_mul_tables).  These return the tables for source s of either.
+
+static GF256_FORCE_INLINE const uint8_t * gf256_table_lo(const uint8_t * y, int s)
+{
+    return GF256Ctx.MM128.TABLE_LO_Y[y[s]];
+}
+static GF256_FORCE_INLINE const uint8_t * gf256_table_lo(const gf256_mul_tables * tables, int s)
+{
+    return tables[s].Lo;
+}
+
+static GF256_FORCE_INLINE const uint8_t * gf256_table_hi(const uint8_t * y, int s)
+{
+    return GF256Ctx.MM128.TABLE_HI_Y[y[s]];
+}
+static GF256_FORCE_INLINE const uint8_t * gf256_table_hi(const gf256_mul_tables * tables, int s)
+{
+    return tables[s].Hi;
+}
+
+static GF256_FORCE_INLINE uint64_t gf256_table_affine(const uint8_t * y, int s)
+{
+    return GF256Ctx.GF256_AFFINE_TABLE[y[s]];
+}
+static GF256_FORCE_INLINE uint64_t gf256_table_affine(const gf256_mul_tables * tables, int s)
+{
+    return tables[s].Affine;
+}
+
+// The tables path never reads the coefficient itself, only Lo/Hi/Affine, so
+// any GF(2)-linear map on bytes can be applied through it.  The FFT codec
+// uses this for multiplies in its own field.
+static GF256_FORCE_INLINE gf256_mul_row gf256_table_row(const uint8_t * y, int s)
+{
+    return gf256_get_mul_row(y[s]);
+}
+static GF256_FORCE_INLINE uint8_t gf256_table_product(const gf256_mul_row & row, uint8_t x)
+{
+    return row[x];
+}
+
+static GF256_FORCE_INLINE const gf256_mul_tables * gf256_table_row(const gf256_mul_tables * tables, int s)
+{
+    return tables + s;
+}
+static GF256_FORCE_INLINE uint8_t gf256_table_product(const gf256_mul_tables * row, uint8_t x)
+{
+    return row->Lo[x & 15] ^ row->Hi[x >> 4];
+}
+
+/// Handles bytes [offset, bytes) of a MulAddMulti call
+template<typename C>
+static inline void gf256_muladd_multi_scalar(uint8_t * GF256_RESTRICT z, const C * y,
+                                             const uint8_t * const * x, int count,
+                                             int offset, int bytes, bool set)
+{
+    decltype(gf256_table_row(y, 0)) rows[kGF256MultiMaxSources];
+    for (int s = 0; s < count; ++s)
+        rows[s] = gf256_table_row(y, s);
+
+    for (; offset < bytes; ++offset)
+    {
+        uint8_t sum = set ? 0 : z[offset];
+        for (int s = 0; s < count; ++s)
+            sum ^= gf256_table_product(rows[s], x[s][offset]);
+        z[offset] = sum;
+    }
+}
+
+/// Handles bytes [offset, bytes) of a MulAddSpread call
+static inline void gf256_muladd_spread_scalar(uint8_t * const * z, const uint8_t * y,
+                                              const uint8_t * GF256_RESTRICT x, int count,
+                                              int offset, int bytes)
+{
+    gf256_mul_row rows[kGF256SpreadMaxDests];
+    for (int d = 0; d < count; ++d)
+        rows[d] = gf256_get_mul_row(y[d]);
+
+    for (; offset < bytes; ++offset)
+    {
+        const uint8_t value = x[offset];
+        for (int d = 0; d < count; ++d)
+            z[d][offset] ^= rows[d][value];
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Shared AVX-512 Kernels
+//
+// The GFNI kernels only replace the multiplies, so they reuse these from
+// gf256_avx512.cpp.
+
+#if defined(GF256_TRY_AVX2) && defined(__AVX512F__) && defined(__AVX512BW__)
+
+extern void gf256_add_mem_avx512(void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes);
+
+extern void gf256_add2_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const void * GF256_RESTRICT vy, int bytes);
+
+extern void gf256_addset_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                    const void * GF256_RESTRICT vy, int bytes);
+
+#endif // __AVX512BW__
+
+#endif // CAT_GF256_KERNELS_H
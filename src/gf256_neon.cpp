@@ -0,0 +1,447 @@
+/** \file
+    \brief GF(256) NEON Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf256_kernels.h"
+
+#if defined(GF256_TRY_NEON)
+
+//------------------------------------------------------------------------------
+// Workaround for ARMv7 that doesn't provide vqtbl1_*
+// This comes from linux-raid (https://www.spinics.net/lists/raid/msg58403.html)
+//
+#if __ARM_ARCH <= 7 && !defined(__aarch64__)
+static GF256_FORCE_INLINE uint8x16_t vqtbl1q_u8(uint8x16_t a, uint8x16_t b)
+{
+    union {
+        uint8x16_t    val;
+        uint8x8x2_t    pair;
+    } __a = { a };
+
+    return vcombine_u8(vtbl2_u8(__a.pair, vget_low_u8(b)),
+                       vtbl2_u8(__a.pair, vget_high_u8(b)));
+}
+#endif
+
+/*
+    NEON kernels
+
+    These use vqtbl1q_u8() in place of the _mm_shuffle_epi8() partial product
+    lookups described in gf256.cpp, and fall back to the portable kernels for
+    the last few bytes.
+
+    The main loops handle 64 bytes at a time in four independent registers.
+    Cortex-A and Neoverse cores have more than one SIMD pipe, and a single
+    16-byte chain keeps each multiply waiting on the load and lookups before
+    it.  With four chains in flight the loop is bound by the loads instead.
+*/
+
+/// Returns x * y, where table_lo_y and table_hi_y are the partial product
+/// tables for y; see gf256.cpp
+static GF256_FORCE_INLINE GF256_M128 gf256_product_neon(GF256_M128 x,
+    GF256_M128 table_lo_y, GF256_M128 table_hi_y, GF256_M128 clr_mask)
+{
+    const GF256_M128 l = vqtbl1q_u8(table_lo_y, vandq_u8(x, clr_mask));
+    const GF256_M128 h = vqtbl1q_u8(table_hi_y, vshrq_n_u8(x, 4));
+    return veorq_u8(l, h);
+}
+
+static void gf256_add_mem_neon(void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = vld1q_u8((uint8_t*) x16);
+        GF256_M128 x1 = vld1q_u8((uint8_t*)(x16 + 1) );
+        GF256_M128 x2 = vld1q_u8((uint8_t*)(x16 + 2) );
+        GF256_M128 x3 = vld1q_u8((uint8_t*)(x16 + 3) );
+        GF256_M128 y0 = vld1q_u8((uint8_t*)y16);
+        GF256_M128 y1 = vld1q_u8((uint8_t*)(y16 + 1));
+        GF256_M128 y2 = vld1q_u8((uint8_t*)(y16 + 2));
+        GF256_M128 y3 = vld1q_u8((uint8_t*)(y16 + 3));
+
+        vst1q_u8((uint8_t*)x16,     veorq_u8(x0, y0));
+        vst1q_u8((uint8_t*)(x16 + 1), veorq_u8(x1, y1));
+        vst1q_u8((uint8_t*)(x16 + 2), veorq_u8(x2, y2));
+        vst1q_u8((uint8_t*)(x16 + 3), veorq_u8(x3, y3));
+
+        bytes -= 64, x16 += 4, y16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
+        GF256_M128 y0 = vld1q_u8((uint8_t*)y16);
+
+        vst1q_u8((uint8_t*)x16, veorq_u8(x0, y0));
+
+        bytes -= 16, ++x16, ++y16;
+    }
+
+    gf256_add_mem_scalar(x16, y16, bytes);
+}
+
+static void gf256_add2_mem_neon(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        // z[i] = z[i] xor x[i] xor y[i]
+        GF256_M128 z0 = veorq_u8(vld1q_u8((uint8_t*) x16),      vld1q_u8((uint8_t*) y16));
+        GF256_M128 z1 = veorq_u8(vld1q_u8((uint8_t*)(x16 + 1)), vld1q_u8((uint8_t*)(y16 + 1)));
+        GF256_M128 z2 = veorq_u8(vld1q_u8((uint8_t*)(x16 + 2)), vld1q_u8((uint8_t*)(y16 + 2)));
+        GF256_M128 z3 = veorq_u8(vld1q_u8((uint8_t*)(x16 + 3)), vld1q_u8((uint8_t*)(y16 + 3)));
+
+        vst1q_u8((uint8_t*) z16,      veorq_u8(z0, vld1q_u8((uint8_t*) z16)));
+        vst1q_u8((uint8_t*)(z16 + 1), veorq_u8(z1, vld1q_u8((uint8_t*)(z16 + 1))));
+        vst1q_u8((uint8_t*)(z16 + 2), veorq_u8(z2, vld1q_u8((uint8_t*)(z16 + 2))));
+        vst1q_u8((uint8_t*)(z16 + 3), veorq_u8(z3, vld1q_u8((uint8_t*)(z16 + 3))));
+
+        bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // z[i] = z[i] xor x[i] xor y[i]
+        vst1q_u8((uint8_t*)z16,
+            veorq_u8(
+                vld1q_u8((uint8_t*)z16),
+                veorq_u8(
+                    vld1q_u8((uint8_t*)x16),
+                    vld1q_u8((uint8_t*)y16))));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    gf256_add2_mem_scalar(z16, x16, y16, bytes);
+}
+
+static void gf256_addset_mem_neon(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        // z[i] = x[i] xor y[i]
+        GF256_M128 z0 = veorq_u8(vld1q_u8((uint8_t*) x16),      vld1q_u8((uint8_t*) y16));
+        GF256_M128 z1 = veorq_u8(vld1q_u8((uint8_t*)(x16 + 1)), vld1q_u8((uint8_t*)(y16 + 1)));
+        GF256_M128 z2 = veorq_u8(vld1q_u8((uint8_t*)(x16 + 2)), vld1q_u8((uint8_t*)(y16 + 2)));
+        GF256_M128 z3 = veorq_u8(vld1q_u8((uint8_t*)(x16 + 3)), vld1q_u8((uint8_t*)(y16 + 3)));
+
+        vst1q_u8((uint8_t*) z16,      z0);
+        vst1q_u8((uint8_t*)(z16 + 1), z1);
+        vst1q_u8((uint8_t*)(z16 + 2), z2);
+        vst1q_u8((uint8_t*)(z16 + 3), z3);
+
+        bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // z[i] = x[i] xor y[i]
+        vst1q_u8((uint8_t*)z16,
+            veorq_u8(
+                vld1q_u8((uint8_t*)x16),
+                vld1q_u8((uint8_t*)y16)));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    gf256_addset_mem_scalar(z16, x16, y16, bytes);
+}
+
+static void gf256_mul_mem_neon(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+
+    // Partial product tables; see gf256.cpp
+    const GF256_M128 table_lo_y = vld1q_u8(GF256Ctx.MM128.TABLE_LO_Y[y]);
+    const GF256_M128 table_hi_y = vld1q_u8(GF256Ctx.MM128.TABLE_HI_Y[y]);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = vdupq_n_u8(0x0f);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = vld1q_u8((uint8_t*) x16);
+        GF256_M128 x1 = vld1q_u8((uint8_t*)(x16 + 1));
+        GF256_M128 x2 = vld1q_u8((uint8_t*)(x16 + 2));
+        GF256_M128 x3 = vld1q_u8((uint8_t*)(x16 + 3));
+
+        vst1q_u8((uint8_t*) z16,      gf256_product_neon(x0, table_lo_y, table_hi_y, clr_mask));
+        vst1q_u8((uint8_t*)(z16 + 1), gf256_product_neon(x1, table_lo_y, table_hi_y, clr_mask));
+        vst1q_u8((uint8_t*)(z16 + 2), gf256_product_neon(x2, table_lo_y, table_hi_y, clr_mask));
+        vst1q_u8((uint8_t*)(z16 + 3), gf256_product_neon(x3, table_lo_y, table_hi_y, clr_mask));
+
+        bytes -= 64, x16 += 4, z16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        GF256_M128 x0 = vld1q_u8((uint8_t*)x16);
+        vst1q_u8((uint8_t*)z16, gf256_product_neon(x0, table_lo_y, table_hi_y, clr_mask));
+
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    gf256_mul_mem_scalar(z16, x16, y, bytes);
+}
+
+static void gf256_muladd_mem_neon(void * GF256_RESTRICT vz, uint8_t y,
+                                  const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+
+    // Partial product tables; see gf256.cpp
+    const GF256_M128 table_lo_y = vld1q_u8(GF256Ctx.MM128.TABLE_LO_Y[y]);
+    const GF256_M128 table_hi_y = vld1q_u8(GF256Ctx.MM128.TABLE_HI_Y[y]);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = vdupq_n_u8(0x0f);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        GF256_M128 p0 = gf256_product_neon(vld1q_u8((uint8_t*) x16),      table_lo_y, table_hi_y, clr_mask);
+        GF256_M128 p1 = gf256_product_neon(vld1q_u8((uint8_t*)(x16 + 1)), table_lo_y, table_hi_y, clr_mask);
+        GF256_M128 p2 = gf256_product_neon(vld1q_u8((uint8_t*)(x16 + 2)), table_lo_y, table_hi_y, clr_mask);
+        GF256_M128 p3 = gf256_product_neon(vld1q_u8((uint8_t*)(x16 + 3)), table_lo_y, table_hi_y, clr_mask);
+
+        vst1q_u8((uint8_t*) z16,      veorq_u8(p0, vld1q_u8((uint8_t*) z16)));
+        vst1q_u8((uint8_t*)(z16 + 1), veorq_u8(p1, vld1q_u8((uint8_t*)(z16 + 1))));
+        vst1q_u8((uint8_t*)(z16 + 2), veorq_u8(p2, vld1q_u8((uint8_t*)(z16 + 2))));
+        vst1q_u8((uint8_t*)(z16 + 3), veorq_u8(p3, vld1q_u8((uint8_t*)(z16 + 3))));
+
+        bytes -= 64, x16 += 4, z16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        const GF256_M128 p0 = gf256_product_neon(vld1q_u8((uint8_t*)x16), table_lo_y, table_hi_y, clr_mask);
+        const GF256_M128 z0 = vld1q_u8((uint8_t*)z16);
+        vst1q_u8((uint8_t*)z16, veorq_u8(p0, z0));
+
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    gf256_muladd_mem_scalar(z16, y, x16, bytes);
+}
+
+template<int N, bool Set, typename C>
+static void gf256_muladd_multi_n_neon(uint8_t * GF256_RESTRICT z, const C * y,
+                                      const uint8_t * const * x, int bytes)
+{
+    int offset = 0;
+
+    // Partial product tables; see gf256.cpp
+    GF256_M128 table_lo_y[N], table_hi_y[N];
+    for (int s = 0; s < N; ++s)
+    {
+        table_lo_y[s] = vld1q_u8(gf256_table_lo(y, s));
+        table_hi_y[s] = vld1q_u8(gf256_table_hi(y, s));
+    }
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = vdupq_n_u8(0x0f);
+
+    // Handle multiples of 64 bytes
+    while (bytes - offset >= 64)
+    {
+        GF256_M128 z0 = Set ? vdupq_n_u8(0) : vld1q_u8(z + offset);
+        GF256_M128 z1 = Set ? vdupq_n_u8(0) : vld1q_u8(z + offset + 16);
+        GF256_M128 z2 = Set ? vdupq_n_u8(0) : vld1q_u8(z + offset + 32);
+        GF256_M128 z3 = Set ? vdupq_n_u8(0) : vld1q_u8(z + offset + 48);
+
+        for (int s = 0; s < N; ++s)
+        {
+            const uint8_t * xs = x[s] + offset;
+            z0 = veorq_u8(z0, gf256_product_neon(vld1q_u8(xs),      table_lo_y[s], table_hi_y[s], clr_mask));
+            z1 = veorq_u8(z1, gf256_product_neon(vld1q_u8(xs + 16), table_lo_y[s], table_hi_y[s], clr_mask));
+            z2 = veorq_u8(z2, gf256_product_neon(vld1q_u8(xs + 32), table_lo_y[s], table_hi_y[s], clr_mask));
+            z3 = veorq_u8(z3, gf256_product_neon(vld1q_u8(xs + 48), table_lo_y[s], table_hi_y[s], clr_mask));
+        }
+
+        vst1q_u8(z + offset,      z0);
+        vst1q_u8(z + offset + 16, z1);
+        vst1q_u8(z + offset + 32, z2);
+        vst1q_u8(z + offset + 48, z3);
+        offset += 64;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes - offset >= 16)
+    {
+        GF256_M128 z0 = Set ? vdupq_n_u8(0) : vld1q_u8(z + offset);
+
+        for (int s = 0; s < N; ++s)
+        {
+            const GF256_M128 x0 = vld1q_u8(x[s] + offset);
+            z0 = veorq_u8(z0, gf256_product_neon(x0, table_lo_y[s], table_hi_y[s], clr_mask));
+        }
+
+        vst1q_u8(z + offset, z0);
+        offset += 16;
+    }
+
+    gf256_muladd_multi_scalar(z, y, x, N, offset, bytes, Set);
+}
+
+template<typename C>
+static void gf256_muladd_multi_neon(uint8_t * GF256_RESTRICT z, const C * y,
+                                    const uint8_t * const * x, int count, int bytes, bool set)
+{
+    switch (count)
+    {
+    case 8:
+        if (set) gf256_muladd_multi_n_neon<8, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_neon<8, false>(z, y, x, bytes);
+        break;
+    case 4:
+        if (set) gf256_muladd_multi_n_neon<4, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_neon<4, false>(z, y, x, bytes);
+        break;
+    case 1:
+        if (set) gf256_muladd_multi_n_neon<1, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_neon<1, false>(z, y, x, bytes);
+        break;
+    default:
+        if (set) gf256_muladd_multi_n_neon<2, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_neon<2, false>(z, y, x, bytes);
+        break;
+    }
+}
+
+template<int N>
+static void gf256_muladd_spread_n_neon(uint8_t * const * z, const uint8_t * y,
+                                       const uint8_t * GF256_RESTRICT x, int bytes)
+{
+    int offset = 0;
+
+    // Partial product tables; see gf256.cpp
+    GF256_M128 table_lo_y[N], table_hi_y[N];
+    for (int d = 0; d < N; ++d)
+    {
+        table_lo_y[d] = vld1q_u8(GF256Ctx.MM128.TABLE_LO_Y[y[d]]);
+        table_hi_y[d] = vld1q_u8(GF256Ctx.MM128.TABLE_HI_Y[y[d]]);
+    }
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = vdupq_n_u8(0x0f);
+
+    // Handle multiples of 32 bytes, loading the source once for all destinations
+    while (bytes - offset >= 32)
+    {
+        const GF256_M128 x0 = vld1q_u8(x + offset);
+        const GF256_M128 x1 = vld1q_u8(x + offset + 16);
+
+        for (int d = 0; d < N; ++d)
+        {
+            uint8_t * zd = z[d] + offset;
+            vst1q_u8(zd,      veorq_u8(vld1q_u8(zd),      gf256_product_neon(x0, table_lo_y[d], table_hi_y[d], clr_mask)));
+            vst1q_u8(zd + 16, veorq_u8(vld1q_u8(zd + 16), gf256_product_neon(x1, table_lo_y[d], table_hi_y[d], clr_mask)));
+        }
+
+        offset += 32;
+    }
+
+    // Handle 16 bytes
+    if (bytes - offset >= 16)
+    {
+        const GF256_M128 x0 = vld1q_u8(x + offset);
+
+        for (int d = 0; d < N; ++d)
+        {
+            uint8_t * zd = z[d] + offset;
+            vst1q_u8(zd, veorq_u8(vld1q_u8(zd), gf256_product_neon(x0, table_lo_y[d], table_hi_y[d], clr_mask)));
+        }
+
+        offset += 16;
+    }
+
+    gf256_muladd_spread_scalar(z, y, x, N, offset, bytes);
+}
+
+static void gf256_muladd_spread_neon(uint8_t * const * z, const uint8_t * y,
+                                     const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    switch (count)
+    {
+    case 8: gf256_muladd_spread_n_neon<8>(z, y, x, bytes); break;
+    case 4: gf256_muladd_spread_n_neon<4>(z, y, x, bytes); break;
+    case 1: gf256_muladd_spread_n_neon<1>(z, y, x, bytes); break;
+    default: gf256_muladd_spread_n_neon<2>(z, y, x, bytes); break;
+    }
+}
+
+static const gf256_kernels kKernelsNEON = {
+    "NEON",
+    gf256_add_mem_neon,
+    gf256_add2_mem_neon,
+    gf256_addset_mem_neon,
+    gf256_mul_mem_neon,
+    gf256_muladd_mem_neon,
+    gf256_muladd_multi_neon<uint8_t>,
+    gf256_muladd_multi_neon<gf256_mul_tables>,
+    gf256_muladd_spread_neon
+};
+
+const gf256_kernels* gf256_kernels_neon()
+{
+    return &kKernelsNEON;
+}
+
+#else // GF256_TRY_NEON
+
+const gf256_kernels* gf256_kernels_neon()
+{
+    return nullptr;
+}
+
+#endif // GF256_TRY_NEON
@@ -0,0 +1,434 @@
+/** \file
+    \brief GF(256) SSSE3 Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf256_kernels.h"
+
+// Built with -mssse3.  MSVC does not define __SSSE3__ but always allows
+// the intrinsics on x86.
+#if !defined(GF256_TARGET_MOBILE) && (defined(__SSSE3__) || defined(_MSC_VER))
+
+/*
+    SSSE3 kernels
+
+    These handle 16 bytes at a time using the _mm_shuffle_epi8() partial
+    product tables described in gf256.cpp, and fall back to the portable
+    kernels for the last few bytes.
+*/
+
+static void gf256_add_mem_ssse3(void * GF256_RESTRICT vx,
+                                const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(vy);
+
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 y0 = _mm_loadu_si128(y16);
+        x0 = _mm_xor_si128(x0, y0);
+        GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+        GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
+        x1 = _mm_xor_si128(x1, y1);
+        GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
+        GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
+        x2 = _mm_xor_si128(x2, y2);
+        GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
+        GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
+        x3 = _mm_xor_si128(x3, y3);
+
+        _mm_storeu_si128(x16, x0);
+        _mm_storeu_si128(x16 + 1, x1);
+        _mm_storeu_si128(x16 + 2, x2);
+        _mm_storeu_si128(x16 + 3, x3);
+
+        bytes -= 64, x16 += 4, y16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // x[i] = x[i] xor y[i]
+        _mm_storeu_si128(x16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+
+        bytes -= 16, ++x16, ++y16;
+    }
+
+    gf256_add_mem_scalar(x16, y16, bytes);
+}
+
+static void gf256_add2_mem_ssse3(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // z[i] = z[i] xor x[i] xor y[i]
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(z16),
+                _mm_xor_si128(
+                    _mm_loadu_si128(x16),
+                    _mm_loadu_si128(y16))));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    gf256_add2_mem_scalar(z16, x16, y16, bytes);
+}
+
+static void gf256_addset_mem_ssse3(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                   const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+        GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
+        GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
+        GF256_M128 y0 = _mm_loadu_si128(y16);
+        GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
+        GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
+        GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
+
+        _mm_storeu_si128(z16,     _mm_xor_si128(x0, y0));
+        _mm_storeu_si128(z16 + 1, _mm_xor_si128(x1, y1));
+        _mm_storeu_si128(z16 + 2, _mm_xor_si128(x2, y2));
+        _mm_storeu_si128(z16 + 3, _mm_xor_si128(x3, y3));
+
+        bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // z[i] = x[i] xor y[i]
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    gf256_addset_mem_scalar(z16, x16, y16, bytes);
+}
+
+static void gf256_mul_mem_ssse3(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+
+    if (bytes >= 16)
+    {
+        // Partial product tables; see gf256.cpp
+        const GF256_M128 table_lo_y = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(GF256Ctx.MM128.TABLE_LO_Y[y]));
+        const GF256_M128 table_hi_y = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(GF256Ctx.MM128.TABLE_HI_Y[y]));
+
+        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+        // Handle multiples of 16 bytes
+        do
+        {
+            // See gf256.cpp for details
+            GF256_M128 x0 = _mm_loadu_si128(x16);
+            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+            x0 = _mm_srli_epi64(x0, 4);
+            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+            l0 = _mm_shuffle_epi8(table_lo_y, l0);
+            h0 = _mm_shuffle_epi8(table_hi_y, h0);
+            _mm_storeu_si128(z16, _mm_xor_si128(l0, h0));
+
+            bytes -= 16, ++x16, ++z16;
+        } while (bytes >= 16);
+    }
+
+    gf256_mul_mem_scalar(z16, x16, y, bytes);
+}
+
+static void gf256_muladd_mem_ssse3(void * GF256_RESTRICT vz, uint8_t y,
+                                   const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+
+    if (bytes >= 16)
+    {
+        // Partial product tables; see gf256.cpp
+        const GF256_M128 table_lo_y = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(GF256Ctx.MM128.TABLE_LO_Y[y]));
+        const GF256_M128 table_hi_y = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(GF256Ctx.MM128.TABLE_HI_Y[y]));
+
+        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+        // This unroll seems to provide about 7% speed boost when AVX2 is disabled
+        while (bytes >= 32)
+        {
+            bytes -= 32;
+
+            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+            GF256_M128 l1 = _mm_and_si128(x1, clr_mask);
+            x1 = _mm_srli_epi64(x1, 4);
+            GF256_M128 h1 = _mm_and_si128(x1, clr_mask);
+            l1 = _mm_shuffle_epi8(table_lo_y, l1);
+            h1 = _mm_shuffle_epi8(table_hi_y, h1);
+            const GF256_M128 z1 = _mm_loadu_si128(z16 + 1);
+
+            GF256_M128 x0 = _mm_loadu_si128(x16);
+            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+            x0 = _mm_srli_epi64(x0, 4);
+            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+            l0 = _mm_shuffle_epi8(table_lo_y, l0);
+            h0 = _mm_shuffle_epi8(table_hi_y, h0);
+            const GF256_M128 z0 = _mm_loadu_si128(z16);
+
+            const GF256_M128 p1 = _mm_xor_si128(l1, h1);
+            _mm_storeu_si128(z16 + 1, _mm_xor_si128(p1, z1));
+
+            const GF256_M128 p0 = _mm_xor_si128(l0, h0);
+            _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
+
+            x16 += 2, z16 += 2;
+        }
+
+        // Handle multiples of 16 bytes
+        while (bytes >= 16)
+        {
+            // See gf256.cpp for details
+            GF256_M128 x0 = _mm_loadu_si128(x16);
+            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+            x0 = _mm_srli_epi64(x0, 4);
+            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+            l0 = _mm_shuffle_epi8(table_lo_y, l0);
+            h0 = _mm_shuffle_epi8(table_hi_y, h0);
+            const GF256_M128 p0 = _mm_xor_si128(l0, h0);
+            const GF256_M128 z0 = _mm_loadu_si128(z16);
+            _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
+
+            bytes -= 16, ++x16, ++z16;
+        }
+    }
+
+    gf256_muladd_mem_scalar(z16, y, x16, bytes);
+}
+
+template<int N, bool Set, typename C>
+static void gf256_muladd_multi_n_ssse3(uint8_t * GF256_RESTRICT z, const C * y,
+                                       const uint8_t * const * x, int bytes)
+{
+    int offset = 0;
+
+    if (bytes >= 16)
+    {
+        // Partial product tables; see gf256.cpp
+        GF256_M128 table_lo_y[N], table_hi_y[N];
+        for (int s = 0; s < N; ++s)
+        {
+            table_lo_y[s] = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(gf256_table_lo(y, s)));
+            table_hi_y[s] = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(gf256_table_hi(y, s)));
+        }
+
+        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+        // Handle multiples of 32 bytes with two independent accumulators
+        while (bytes - offset >= 32)
+        {
+            GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z + offset);
+            GF256_M128 z0 = Set ? _mm_setzero_si128() : _mm_loadu_si128(z16);
+            GF256_M128 z1 = Set ? _mm_setzero_si128() : _mm_loadu_si128(z16 + 1);
+
+            for (int s = 0; s < N; ++s)
+            {
+                // See gf256.cpp for details
+                const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x[s] + offset);
+                GF256_M128 x0 = _mm_loadu_si128(x16);
+                GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+                GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+                GF256_M128 l1 = _mm_and_si128(x1, clr_mask);
+                x0 = _mm_srli_epi64(x0, 4);
+                x1 = _mm_srli_epi64(x1, 4);
+                GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+                GF256_M128 h1 = _mm_and_si128(x1, clr_mask);
+                l0 = _mm_shuffle_epi8(table_lo_y[s], l0);
+                l1 = _mm_shuffle_epi8(table_lo_y[s], l1);
+                h0 = _mm_shuffle_epi8(table_hi_y[s], h0);
+                h1 = _mm_shuffle_epi8(table_hi_y[s], h1);
+                z0 = _mm_xor_si128(z0, _mm_xor_si128(l0, h0));
+                z1 = _mm_xor_si128(z1, _mm_xor_si128(l1, h1));
+            }
+
+            _mm_storeu_si128(z16, z0);
+            _mm_storeu_si128(z16 + 1, z1);
+            offset += 32;
+        }
+
+        // Handle multiples of 16 bytes
+        while (bytes - offset >= 16)
+        {
+            GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z + offset);
+            GF256_M128 z0 = Set ? _mm_setzero_si128() : _mm_loadu_si128(z16);
+
+            for (int s = 0; s < N; ++s)
+            {
+                // See gf256.cpp for details
+                GF256_M128 x0 = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(x[s] + offset));
+                GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+                x0 = _mm_srli_epi64(x0, 4);
+                GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+                l0 = _mm_shuffle_epi8(table_lo_y[s], l0);
+                h0 = _mm_shuffle_epi8(table_hi_y[s], h0);
+                z0 = _mm_xor_si128(z0, _mm_xor_si128(l0, h0));
+            }
+
+            _mm_storeu_si128(z16, z0);
+            offset += 16;
+        }
+    }
+
+    gf256_muladd_multi_scalar(z, y, x, N, offset, bytes, Set);
+}
+
+template<typename C>
+static void gf256_muladd_multi_ssse3(uint8_t * GF256_RESTRICT z, const C * y,
+                                     const uint8_t * const * x, int count, int bytes, bool set)
+{
+    switch (count)
+    {
+    case 8:
+        if (set) gf256_muladd_multi_n_ssse3<8, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_ssse3<8, false>(z, y, x, bytes);
+        break;
+    case 4:
+        if (set) gf256_muladd_multi_n_ssse3<4, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_ssse3<4, false>(z, y, x, bytes);
+        break;
+    case 1:
+        if (set) gf256_muladd_multi_n_ssse3<1, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_ssse3<1, false>(z, y, x, bytes);
+        break;
+    default:
+        if (set) gf256_muladd_multi_n_ssse3<2, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_ssse3<2, false>(z, y, x, bytes);
+        break;
+    }
+}
+
+template<int N>
+static void gf256_muladd_spread_n_ssse3(uint8_t * const * z, const uint8_t * y,
+                                        const uint8_t * GF256_RESTRICT x, int bytes)
+{
+    int offset = 0;
+
+    if (bytes >= 16)
+    {
+        // Partial product tables; see gf256.cpp
+        GF256_M128 table_lo_y[N], table_hi_y[N];
+        for (int d = 0; d < N; ++d)
+        {
+            table_lo_y[d] = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(GF256Ctx.MM128.TABLE_LO_Y[y[d]]));
+            table_hi_y[d] = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(GF256Ctx.MM128.TABLE_HI_Y[y[d]]));
+        }
+
+        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+        // Handle multiples of 16 bytes, splitting the source once for all destinations
+        while (bytes - offset >= 16)
+        {
+            GF256_M128 x0 = _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(x + offset));
+            const GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+            x0 = _mm_srli_epi64(x0, 4);
+            const GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+
+            for (int d = 0; d < N; ++d)
+            {
+                GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z[d] + offset);
+                const GF256_M128 p0 = _mm_xor_si128(_mm_shuffle_epi8(table_lo_y[d], l0),
+                                                    _mm_shuffle_epi8(table_hi_y[d], h0));
+                _mm_storeu_si128(z16, _mm_xor_si128(_mm_loadu_si128(z16), p0));
+            }
+
+            offset += 16;
+        }
+    }
+
+    gf256_muladd_spread_scalar(z, y, x, N, offset, bytes);
+}
+
+static void gf256_muladd_spread_ssse3(uint8_t * const * z, const uint8_t * y,
+                                      const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    switch (count)
+    {
+    case 8: gf256_muladd_spread_n_ssse3<8>(z, y, x, bytes); break;
+    case 4: gf256_muladd_spread_n_ssse3<4>(z, y, x, bytes); break;
+    case 1: gf256_muladd_spread_n_ssse3<1>(z, y, x, bytes); break;
+    default: gf256_muladd_spread_n_ssse3<2>(z, y, x, bytes); break;
+    }
+}
+
+static const gf256_kernels kKernelsSSSE3 = {
+    "SSSE3",
+    gf256_add_mem_ssse3,
+    gf256_add2_mem_ssse3,
+    gf256_addset_mem_ssse3,
+    gf256_mul_mem_ssse3,
+    gf256_muladd_mem_ssse3,
+    gf256_muladd_multi_ssse3<uint8_t>,
+    gf256_muladd_multi_ssse3<gf256_mul_tables>,
+    gf256_muladd_spread_ssse3
+};
+
+const gf256_kernels* gf256_kernels_ssse3()
+{
+    return &kKernelsSSSE3;
+}
+
+#else // __SSSE3__
+
+const gf256_kernels* gf256_kernels_ssse3()
+{
+    return nullptr;
+}
+
+#endif // __SSSE3__
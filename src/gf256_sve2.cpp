@@ -0,0 +1,382 @@
+/** \file
+    \brief GF(256) SVE2 Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf256_kernels.h"
+
+// Built with -march=armv8-a+sve2
+#if defined(GF256_TRY_NEON) && defined(__ARM_FEATURE_SVE2)
+
+#include <arm_sve.h>
+
+/*
+    SVE2 kernels
+
+    These are vector-length agnostic: the same code runs 128-bit vectors on
+    Neoverse N2/V2 and wider vectors on other cores, with svcntb() bytes per
+    register.  The 16-byte partial product tables from gf256.cpp are
+    replicated into every 128-bit segment with svld1rq_u8(), so that TBL
+    indices 0..15 find the table whatever the vector length is.
+
+    The main loops handle four whole registers at a time in independent
+    accumulators.  The last partial registers are handled with a WHILELT
+    predicate, so no portable tail is needed.  Sums of three terms use the
+    SVE2 EOR3 instruction.
+
+    SVE types have no size known at compile time, so they cannot be held in
+    arrays.  The multi-source kernels reload the tables for each source from
+    L1 instead, once per four registers of data.
+*/
+
+static GF256_FORCE_INLINE svuint8_t gf256_mul_sve2(svbool_t pg, svuint8_t x,
+                                                   svuint8_t table_lo_y, svuint8_t table_hi_y)
+{
+    // See gf256.cpp for details
+    const svuint8_t l = svtbl_u8(table_lo_y, svand_n_u8_x(pg, x, 0x0f));
+    const svuint8_t h = svtbl_u8(table_hi_y, svlsr_n_u8_x(pg, x, 4));
+    return sveor_u8_x(pg, l, h);
+}
+
+static GF256_FORCE_INLINE svuint8_t gf256_muladd_sve2(svbool_t pg, svuint8_t z, svuint8_t x,
+                                                      svuint8_t table_lo_y, svuint8_t table_hi_y)
+{
+    const svuint8_t l = svtbl_u8(table_lo_y, svand_n_u8_x(pg, x, 0x0f));
+    const svuint8_t h = svtbl_u8(table_hi_y, svlsr_n_u8_x(pg, x, 4));
+    return sveor3_u8(z, l, h);
+}
+
+static void gf256_add_mem_sve2(void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT x = reinterpret_cast<uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y = reinterpret_cast<const uint8_t *>(vy);
+
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+    int offset = 0;
+
+    while (bytes - offset >= 4 * vl)
+    {
+        const svuint8_t x0 = svld1_u8(all, x + offset);
+        const svuint8_t x1 = svld1_u8(all, x + offset + vl);
+        const svuint8_t x2 = svld1_u8(all, x + offset + 2 * vl);
+        const svuint8_t x3 = svld1_u8(all, x + offset + 3 * vl);
+        const svuint8_t y0 = svld1_u8(all, y + offset);
+        const svuint8_t y1 = svld1_u8(all, y + offset + vl);
+        const svuint8_t y2 = svld1_u8(all, y + offset + 2 * vl);
+        const svuint8_t y3 = svld1_u8(all, y + offset + 3 * vl);
+
+        svst1_u8(all, x + offset,          sveor_u8_x(all, x0, y0));
+        svst1_u8(all, x + offset + vl,     sveor_u8_x(all, x1, y1));
+        svst1_u8(all, x + offset + 2 * vl, sveor_u8_x(all, x2, y2));
+        svst1_u8(all, x + offset + 3 * vl, sveor_u8_x(all, x3, y3));
+        offset += 4 * vl;
+    }
+
+    for (; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        const svuint8_t x0 = svld1_u8(pg, x + offset);
+        const svuint8_t y0 = svld1_u8(pg, y + offset);
+        svst1_u8(pg, x + offset, sveor_u8_x(pg, x0, y0));
+    }
+}
+
+static void gf256_add2_mem_sve2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y = reinterpret_cast<const uint8_t *>(vy);
+
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+    int offset = 0;
+
+    // z[i] = z[i] xor x[i] xor y[i]
+    while (bytes - offset >= 4 * vl)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            const int i = offset + r * vl;
+            svst1_u8(all, z + i, sveor3_u8(svld1_u8(all, z + i), svld1_u8(all, x + i), svld1_u8(all, y + i)));
+        }
+        offset += 4 * vl;
+    }
+
+    for (; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        svst1_u8(pg, z + offset, sveor3_u8(svld1_u8(pg, z + offset), svld1_u8(pg, x + offset), svld1_u8(pg, y + offset)));
+    }
+}
+
+static void gf256_addset_mem_sve2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y = reinterpret_cast<const uint8_t *>(vy);
+
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+    int offset = 0;
+
+    // z[i] = x[i] xor y[i]
+    while (bytes - offset >= 4 * vl)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            const int i = offset + r * vl;
+            svst1_u8(all, z + i, sveor_u8_x(all, svld1_u8(all, x + i), svld1_u8(all, y + i)));
+        }
+        offset += 4 * vl;
+    }
+
+    for (; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        svst1_u8(pg, z + offset, sveor_u8_x(pg, svld1_u8(pg, x + offset), svld1_u8(pg, y + offset)));
+    }
+}
+
+static void gf256_mul_mem_sve2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+
+    // Partial product tables; see gf256.cpp
+    const svuint8_t table_lo_y = svld1rq_u8(all, GF256Ctx.MM128.TABLE_LO_Y[y]);
+    const svuint8_t table_hi_y = svld1rq_u8(all, GF256Ctx.MM128.TABLE_HI_Y[y]);
+
+    int offset = 0;
+
+    while (bytes - offset >= 4 * vl)
+    {
+        const svuint8_t x0 = svld1_u8(all, x + offset);
+        const svuint8_t x1 = svld1_u8(all, x + offset + vl);
+        const svuint8_t x2 = svld1_u8(all, x + offset + 2 * vl);
+        const svuint8_t x3 = svld1_u8(all, x + offset + 3 * vl);
+
+        svst1_u8(all, z + offset,          gf256_mul_sve2(all, x0, table_lo_y, table_hi_y));
+        svst1_u8(all, z + offset + vl,     gf256_mul_sve2(all, x1, table_lo_y, table_hi_y));
+        svst1_u8(all, z + offset + 2 * vl, gf256_mul_sve2(all, x2, table_lo_y, table_hi_y));
+        svst1_u8(all, z + offset + 3 * vl, gf256_mul_sve2(all, x3, table_lo_y, table_hi_y));
+        offset += 4 * vl;
+    }
+
+    for (; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        const svuint8_t x0 = svld1_u8(pg, x + offset);
+        svst1_u8(pg, z + offset, gf256_mul_sve2(pg, x0, table_lo_y, table_hi_y));
+    }
+}
+
+static void gf256_muladd_mem_sve2(void * GF256_RESTRICT vz, uint8_t y,
+                                  const void * GF256_RESTRICT vx, int bytes)
+{
+    uint8_t * GF256_RESTRICT z = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x = reinterpret_cast<const uint8_t *>(vx);
+
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+
+    // Partial product tables; see gf256.cpp
+    const svuint8_t table_lo_y = svld1rq_u8(all, GF256Ctx.MM128.TABLE_LO_Y[y]);
+    const svuint8_t table_hi_y = svld1rq_u8(all, GF256Ctx.MM128.TABLE_HI_Y[y]);
+
+    int offset = 0;
+
+    while (bytes - offset >= 4 * vl)
+    {
+        const svuint8_t x0 = svld1_u8(all, x + offset);
+        const svuint8_t x1 = svld1_u8(all, x + offset + vl);
+        const svuint8_t x2 = svld1_u8(all, x + offset + 2 * vl);
+        const svuint8_t x3 = svld1_u8(all, x + offset + 3 * vl);
+        const svuint8_t z0 = svld1_u8(all, z + offset);
+        const svuint8_t z1 = svld1_u8(all, z + offset + vl);
+        const svuint8_t z2 = svld1_u8(all, z + offset + 2 * vl);
+        const svuint8_t z3 = svld1_u8(all, z + offset + 3 * vl);
+
+        svst1_u8(all, z + offset,          gf256_muladd_sve2(all, z0, x0, table_lo_y, table_hi_y));
+        svst1_u8(all, z + offset + vl,     gf256_muladd_sve2(all, z1, x1, table_lo_y, table_hi_y));
+        svst1_u8(all, z + offset + 2 * vl, gf256_muladd_sve2(all, z2, x2, table_lo_y, table_hi_y));
+        svst1_u8(all, z + offset + 3 * vl, gf256_muladd_sve2(all, z3, x3, table_lo_y, table_hi_y));
+        offset += 4 * vl;
+    }
+
+    for (; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        const svuint8_t x0 = svld1_u8(pg, x + offset);
+        const svuint8_t z0 = svld1_u8(pg, z + offset);
+        svst1_u8(pg, z + offset, gf256_muladd_sve2(pg, z0, x0, table_lo_y, table_hi_y));
+    }
+}
+
+template<int N, bool Set, typename C>
+static void gf256_muladd_multi_n_sve2(uint8_t * GF256_RESTRICT z, const C * y,
+                                      const uint8_t * const * x, int bytes)
+{
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+    int offset = 0;
+
+    // Handle four whole registers at a time with independent accumulators
+    while (bytes - offset >= 4 * vl)
+    {
+        svuint8_t z0 = Set ? svdup_n_u8(0) : svld1_u8(all, z + offset);
+        svuint8_t z1 = Set ? svdup_n_u8(0) : svld1_u8(all, z + offset + vl);
+        svuint8_t z2 = Set ? svdup_n_u8(0) : svld1_u8(all, z + offset + 2 * vl);
+        svuint8_t z3 = Set ? svdup_n_u8(0) : svld1_u8(all, z + offset + 3 * vl);
+
+        for (int s = 0; s < N; ++s)
+        {
+            const svuint8_t table_lo_y = svld1rq_u8(all, gf256_table_lo(y, s));
+            const svuint8_t table_hi_y = svld1rq_u8(all, gf256_table_hi(y, s));
+            const uint8_t * xs = x[s] + offset;
+
+            z0 = gf256_muladd_sve2(all, z0, svld1_u8(all, xs),          table_lo_y, table_hi_y);
+            z1 = gf256_muladd_sve2(all, z1, svld1_u8(all, xs + vl),     table_lo_y, table_hi_y);
+            z2 = gf256_muladd_sve2(all, z2, svld1_u8(all, xs + 2 * vl), table_lo_y, table_hi_y);
+            z3 = gf256_muladd_sve2(all, z3, svld1_u8(all, xs + 3 * vl), table_lo_y, table_hi_y);
+        }
+
+        svst1_u8(all, z + offset,          z0);
+        svst1_u8(all, z + offset + vl,     z1);
+        svst1_u8(all, z + offset + 2 * vl, z2);
+        svst1_u8(all, z + offset + 3 * vl, z3);
+        offset += 4 * vl;
+    }
+
+    for (; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        svuint8_t z0 = Set ? svdup_n_u8(0) : svld1_u8(pg, z + offset);
+
+        for (int s = 0; s < N; ++s)
+        {
+            const svuint8_t table_lo_y = svld1rq_u8(all, gf256_table_lo(y, s));
+            const svuint8_t table_hi_y = svld1rq_u8(all, gf256_table_hi(y, s));
+            z0 = gf256_muladd_sve2(pg, z0, svld1_u8(pg, x[s] + offset), table_lo_y, table_hi_y);
+        }
+
+        svst1_u8(pg, z + offset, z0);
+    }
+}
+
+template<typename C>
+static void gf256_muladd_multi_sve2(uint8_t * GF256_RESTRICT z, const C * y,
+                                    const uint8_t * const * x, int count, int bytes, bool set)
+{
+    switch (count)
+    {
+    case 8:
+        if (set) gf256_muladd_multi_n_sve2<8, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_sve2<8, false>(z, y, x, bytes);
+        break;
+    case 4:
+        if (set) gf256_muladd_multi_n_sve2<4, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_sve2<4, false>(z, y, x, bytes);
+        break;
+    case 1:
+        if (set) gf256_muladd_multi_n_sve2<1, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_sve2<1, false>(z, y, x, bytes);
+        break;
+    default:
+        if (set) gf256_muladd_multi_n_sve2<2, true>(z, y, x, bytes);
+        else gf256_muladd_multi_n_sve2<2, false>(z, y, x, bytes);
+        break;
+    }
+}
+
+template<int N>
+static void gf256_muladd_spread_n_sve2(uint8_t * const * z, const uint8_t * y,
+                                       const uint8_t * GF256_RESTRICT x, int bytes)
+{
+    const int vl = (int)svcntb();
+    const svbool_t all = svptrue_b8();
+
+    // Load each register of the source once for all destinations
+    for (int offset = 0; offset < bytes; offset += vl)
+    {
+        const svbool_t pg = svwhilelt_b8_s32(offset, bytes);
+        const svuint8_t x0 = svld1_u8(pg, x + offset);
+
+        for (int d = 0; d < N; ++d)
+        {
+            const svuint8_t table_lo_y = svld1rq_u8(all, GF256Ctx.MM128.TABLE_LO_Y[y[d]]);
+            const svuint8_t table_hi_y = svld1rq_u8(all, GF256Ctx.MM128.TABLE_HI_Y[y[d]]);
+            const svuint8_t z0 = svld1_u8(pg, z[d] + offset);
+            svst1_u8(pg, z[d] + offset, gf256_muladd_sve2(pg, z0, x0, table_lo_y, table_hi_y));
+        }
+    }
+}
+
+static void gf256_muladd_spread_sve2(uint8_t * const * z, const uint8_t * y,
+                                     const uint8_t * GF256_RESTRICT x, int count, int bytes)
+{
+    switch (count)
+    {
+    case 8: gf256_muladd_spread_n_sve2<8>(z, y, x, bytes); break;
+    case 4: gf256_muladd_spread_n_sve2<4>(z, y, x, bytes); break;
+    case 1: gf256_muladd_spread_n_sve2<1>(z, y, x, bytes); break;
+    default: gf256_muladd_spread_n_sve2<2>(z, y, x, bytes); break;
+    }
+}
+
+static const gf256_kernels kKernelsSVE2 = {
+    "SVE2",
+    gf256_add_mem_sve2,
+    gf256_add2_mem_sve2,
+    gf256_addset_mem_sve2,
+    gf256_mul_mem_sve2,
+    gf256_muladd_mem_sve2,
+    gf256_muladd_multi_sve2<uint8_t>,
+    gf256_muladd_multi_sve2<gf256_mul_tables>,
+    gf256_muladd_spread_sve2
+};
+
+const gf256_kernels* gf256_kernels_sve2()
+{
+    return &kKernelsSVE2;
+}
+
+#else // __ARM_FEATURE_SVE2
+
+const gf256_kernels* gf256_kernels_sve2()
+{
+    return nullptr;
+}
+
+#endif // __ARM_FEATURE_SVE2
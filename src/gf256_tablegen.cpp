@@ -0,0 +1,302 @@
+/** \file
+    \brief GF(256) Table Generator
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Build-time generator for the GF(256) tables
+
+        gf256_tablegen <output.inc>
+
+    Writes the aggregate initializer of gf256_ctx, member by member, so that
+    gf256.cpp can define GF256Ctx as a constant.  The tables then live in
+    read-only data: there is nothing to compute at startup, and every process
+    maps the same clean pages from the executable instead of building its own
+    dirty copy.
+
+    This program is built for the host and does not include gf256.h, so it
+    does not depend on the instruction sets of the target.  The members are
+    written in the declaration order of gf256_ctx, and the members the struct
+    leaves out for GF256_TRY_AVX2 or GF256_COMPACT_CONTEXT are wrapped in the
+    same conditions.
+
+    The tables are checked here before they are written, which replaces the
+    table checks gf256_init() used to run on every startup.
+*/
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+
+//------------------------------------------------------------------------------
+// Tables
+
+// There are only 16 irreducible polynomials for GF(2^^8)
+static const int GF256_GEN_POLY_COUNT = 16;
+static const uint8_t GF256_GEN_POLY[GF256_GEN_POLY_COUNT] = {
+    0x8e, 0x95, 0x96, 0xa6, 0xaf, 0xb1, 0xb2, 0xb4,
+    0xb8, 0xc3, 0xc6, 0xd4, 0xe1, 0xe7, 0xf3, 0xfa
+};
+
+static const int kDefaultPolynomialIndex = 3;
+
+struct Tables
+{
+    uint8_t LO[256][16];
+    uint8_t HI[256][16];
+    uint8_t MUL[256 * 256];
+    uint8_t DIV[256 * 256];
+    uint8_t INV[256];
+    uint8_t SQR[256];
+    uint64_t AFFINE[256];
+    uint16_t LOG[256];
+    uint8_t EXP[512 * 2 + 1];
+    unsigned Polynomial;
+};
+
+static Tables T;
+
+static uint8_t Mul(uint8_t x, uint8_t y)
+{
+    return T.MUL[((unsigned)y << 8) + x];
+}
+
+static uint8_t Div(uint8_t x, uint8_t y)
+{
+    return T.DIV[((unsigned)y << 8) + x];
+}
+
+static void GenerateTables()
+{
+    T.Polynomial = (GF256_GEN_POLY[kDefaultPolynomialIndex] << 1) | 1;
+
+    // EXP and LOG tables from the polynomial
+    T.LOG[0] = 512;
+    T.EXP[0] = 1;
+    for (unsigned jj = 1; jj < 255; ++jj)
+    {
+        unsigned next = (unsigned)T.EXP[jj - 1] * 2;
+        if (next >= 256)
+            next ^= T.Polynomial;
+
+        T.EXP[jj] = static_cast<uint8_t>( next );
+        T.LOG[T.EXP[jj]] = static_cast<uint16_t>( jj );
+    }
+    T.EXP[255] = T.EXP[0];
+    T.LOG[T.EXP[255]] = 255;
+    for (unsigned jj = 256; jj < 2 * 255; ++jj)
+        T.EXP[jj] = T.EXP[jj % 255];
+    T.EXP[2 * 255] = 1;
+    for (unsigned jj = 2 * 255 + 1; jj < 4 * 255; ++jj)
+        T.EXP[jj] = 0;
+
+    // MUL and DIV tables from the LOG and EXP tables
+    for (int y = 1; y < 256; ++y)
+    {
+        const uint8_t log_y = static_cast<uint8_t>(T.LOG[y]);
+        const uint8_t log_yn = 255 - log_y;
+
+        for (int x = 1; x < 256; ++x)
+        {
+            const uint16_t log_x = T.LOG[x];
+            T.MUL[(y << 8) + x] = T.EXP[log_x + log_y];
+            T.DIV[(y << 8) + x] = T.EXP[log_x + log_yn];
+        }
+    }
+
+    for (int x = 0; x < 256; ++x)
+    {
+        T.INV[x] = Div(1, static_cast<uint8_t>(x));
+        T.SQR[x] = Mul(static_cast<uint8_t>(x), static_cast<uint8_t>(x));
+    }
+
+    for (int y = 0; y < 256; ++y)
+    {
+        // TABLE_LO_Y maps 0..15 to 8-bit partial product based on y.
+        for (unsigned x = 0; x < 16; ++x)
+        {
+            T.LO[y][x] = Mul(static_cast<uint8_t>(x), static_cast<uint8_t>(y));
+            T.HI[y][x] = Mul(static_cast<uint8_t>(x << 4), static_cast<uint8_t>(y));
+        }
+
+        // Column j of the affine matrix is y * 2^j, so row i collects bit i of each
+        uint64_t matrix = 0;
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            const uint8_t column = Mul(static_cast<uint8_t>(y), static_cast<uint8_t>(1 << j));
+            for (unsigned i = 0; i < 8; ++i)
+                if (column & (1 << i))
+                    matrix |= (uint64_t)1 << ((7 - i) * 8 + j);
+        }
+        T.AFFINE[y] = matrix;
+    }
+}
+
+static bool CheckTables()
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        for (unsigned j = 0; j < 256; ++j)
+        {
+            const uint8_t prod = Mul((uint8_t)i, (uint8_t)j);
+            if (i != 0 && j != 0)
+            {
+                if (Div(prod, (uint8_t)i) != j || Div(prod, (uint8_t)j) != i)
+                    return false;
+            }
+            else if (prod != 0)
+                return false;
+            if (j == 1 && prod != i)
+                return false;
+
+            // The compact context computes both from the log/exp tables
+            if (T.EXP[T.LOG[i] + T.LOG[j]] != prod)
+                return false;
+            const unsigned log_jn = 255 - (uint8_t)T.LOG[j];
+            if ((T.EXP[T.LOG[i] + log_jn] & (uint8_t)-(j != 0)) != Div((uint8_t)i, (uint8_t)j))
+                return false;
+        }
+
+        // The nibble tables must add up to the product
+        for (unsigned x = 0; x < 256; ++x)
+            if ((T.LO[i][x & 15] ^ T.HI[i][x >> 4]) != Mul((uint8_t)x, (uint8_t)i))
+                return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Output
+
+static void WriteBytes(FILE* file, const uint8_t* data, int count)
+{
+    fprintf(file, "    {");
+    for (int i = 0; i < count; ++i)
+    {
+        if (i % 16 == 0)
+            fprintf(file, "\n        ");
+        fprintf(file, "%u,", data[i]);
+    }
+    fprintf(file, "\n    },\n");
+}
+
+// Rows of a nibble table, repeated 'lanes' times to fill each register
+static void WriteNibbleTable(FILE* file, const uint8_t table[256][16], int lanes)
+{
+    fprintf(file, "    {\n");
+    for (int y = 0; y < 256; ++y)
+    {
+        fprintf(file, "        {");
+        for (int lane = 0; lane < lanes; ++lane)
+            for (int x = 0; x < 16; ++x)
+                fprintf(file, "%u,", table[y][x]);
+        fprintf(file, "},\n");
+    }
+    fprintf(file, "    },\n");
+}
+
+static void WriteTables(FILE* file)
+{
+    fprintf(file, "// Generated by gf256_tablegen.cpp: the initializer of gf256_ctx.\n");
+    fprintf(file, "// Polynomial 0x%x\n\n", T.Polynomial);
+
+    fprintf(file, "// MM128\n{\n");
+    WriteNibbleTable(file, T.LO, 1);
+    WriteNibbleTable(file, T.HI, 1);
+    fprintf(file, "},\n");
+
+    fprintf(file, "#if defined(GF256_TRY_AVX2) && !defined(GF256_COMPACT_CONTEXT)\n// MM256\n{\n");
+    WriteNibbleTable(file, T.LO, 2);
+    WriteNibbleTable(file, T.HI, 2);
+    fprintf(file, "},\n#endif // GF256_TRY_AVX2\n");
+
+    fprintf(file, "#ifndef GF256_COMPACT_CONTEXT\n");
+    fprintf(file, "// GF256_MUL_TABLE\n");
+    WriteBytes(file, T.MUL, 256 * 256);
+    fprintf(file, "// GF256_DIV_TABLE\n");
+    WriteBytes(file, T.DIV, 256 * 256);
+    fprintf(file, "#endif // GF256_COMPACT_CONTEXT\n");
+    fprintf(file, "// GF256_INV_TABLE\n");
+    WriteBytes(file, T.INV, 256);
+    fprintf(file, "// GF256_SQR_TABLE\n");
+    WriteBytes(file, T.SQR, 256);
+
+    fprintf(file, "// GF256_AFFINE_TABLE\n    {");
+    for (int y = 0; y < 256; ++y)
+    {
+        if (y % 4 == 0)
+            fprintf(file, "\n        ");
+        fprintf(file, "0x%016llxULL,", (unsigned long long)T.AFFINE[y]);
+    }
+    fprintf(file, "\n    },\n");
+
+    fprintf(file, "// GF256_LOG_TABLE\n    {");
+    for (int x = 0; x < 256; ++x)
+    {
+        if (x % 16 == 0)
+            fprintf(file, "\n        ");
+        fprintf(file, "%u,", T.LOG[x]);
+    }
+    fprintf(file, "\n    },\n");
+
+    fprintf(file, "// GF256_EXP_TABLE\n");
+    WriteBytes(file, T.EXP, 512 * 2 + 1);
+
+    fprintf(file, "// Polynomial\n    0x%x\n", T.Polynomial);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: gf256_tablegen <output.inc>\n");
+        return 1;
+    }
+
+    GenerateTables();
+    if (!CheckTables())
+    {
+        fprintf(stderr, "gf256_tablegen: table self-test failed\n");
+        return 2;
+    }
+
+    FILE* file = fopen(argv[1], "w");
+    if (!file)
+    {
+        fprintf(stderr, "gf256_tablegen: cannot write %s\n", argv[1]);
+        return 1;
+    }
+    WriteTables(file);
+    if (fclose(file) != 0)
+    {
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}
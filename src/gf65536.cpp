@@ -0,0 +1,274 @@
+/** \file
+    \brief GF(2^^16) Math Module
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf65536_kernels.h"
+#include "gf256_kernels.h"
+
+
+//------------------------------------------------------------------------------
+// Context Object
+
+// Primitive polynomial x^16 + x^5 + x^3 + x^2 + 1
+static const unsigned kPolynomial = 0x1002D;
+
+// Context object for GF(2^^16) math
+gf65536_ctx GF65536Ctx;
+static bool Initialized = false;
+
+// Returns false if the polynomial is not primitive
+static bool gf65536_explog_init()
+{
+    unsigned x = 1;
+    for (unsigned i = 0; i < 65535; ++i)
+    {
+        if (x == 1 && i != 0)
+            return false;
+
+        GF65536Ctx.Exp[i] = (uint16_t)x;
+        GF65536Ctx.Exp[i + 65535] = (uint16_t)x;
+        GF65536Ctx.Log[x] = (uint16_t)i;
+
+        x <<= 1;
+        if (x & 0x10000)
+            x ^= kPolynomial;
+    }
+
+    // Pad the end so that Exp[] covers every sum of two logs
+    GF65536Ctx.Exp[65535 * 2] = GF65536Ctx.Exp[0];
+    GF65536Ctx.Exp[65535 * 2 + 1] = GF65536Ctx.Exp[1];
+    GF65536Ctx.Log[0] = 0;
+
+    return true;
+}
+
+void gf65536_mul_tables_init(gf65536_mul_tables * tables, uint16_t y)
+{
+    // y * 2^i for each bit i of the other operand
+    unsigned basis[16];
+    unsigned product = y;
+    for (int i = 0; i < 16; ++i)
+    {
+        basis[i] = product;
+        product <<= 1;
+        if (product & 0x10000)
+            product ^= kPolynomial;
+    }
+
+    for (int n = 0; n < 4; ++n)
+    {
+        unsigned table[16];
+        table[0] = 0;
+        for (unsigned v = 1; v < 16; ++v)
+        {
+            // Add the basis element for the lowest set bit to the entry without it
+            unsigned bit = 0;
+            while (!(v & (1u << bit)))
+                ++bit;
+            table[v] = table[v & (v - 1)] ^ basis[n * 4 + bit];
+        }
+
+        for (int v = 0; v < 16; ++v)
+        {
+            tables->Lo[n][v] = (uint8_t)table[v];
+            tables->Hi[n][v] = (uint8_t)(table[v] >> 8);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Portable Kernels
+
+static void gf65536_mul_mem_scalar(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                   const gf65536_mul_tables * tables, int bytes)
+{
+    gf65536_muladd_scalar(reinterpret_cast<uint8_t *>(vz), tables,
+        reinterpret_cast<const uint8_t *>(vx), 0, bytes / 2, true);
+}
+
+static void gf65536_muladd_mem_scalar(void * GF256_RESTRICT vz, const gf65536_mul_tables * tables,
+                                      const void * GF256_RESTRICT vx, int bytes)
+{
+    gf65536_muladd_scalar(reinterpret_cast<uint8_t *>(vz), tables,
+        reinterpret_cast<const uint8_t *>(vx), 0, bytes / 2, false);
+}
+
+static const gf65536_kernels kKernelsScalar = {
+    "Portable",
+    gf65536_mul_mem_scalar,
+    gf65536_muladd_mem_scalar
+};
+
+
+//------------------------------------------------------------------------------
+// Kernel Selection
+
+static const gf65536_kernels* Kernels = nullptr;
+
+// Pick the fastest kernel table that was built and that the CPU supports
+static void gf65536_kernels_init()
+{
+    const gf65536_kernels* selected = nullptr;
+    const gf256_cpu_features cpu = gf256_get_cpu_features();
+
+    if (cpu.AVX2)
+        selected = gf65536_kernels_avx2();
+    if (!selected && cpu.SSSE3)
+        selected = gf65536_kernels_ssse3();
+
+    Kernels = selected ? selected : &kKernelsScalar;
+}
+
+extern "C" const char* gf65536_kernels_name()
+{
+    return Kernels ? Kernels->Name : "None";
+}
+
+
+//------------------------------------------------------------------------------
+// Self-Test
+
+static bool gf65536_self_test()
+{
+    // Multiplication and division by log/exp must agree with the tables
+    static const int kBytes = 2 * 61;
+    uint8_t x[kBytes], z[kBytes], expected[kBytes];
+
+    unsigned seed = 1;
+    for (int i = 0; i < kBytes; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        x[i] = (uint8_t)(seed >> 16);
+    }
+
+    for (unsigned y = 0; y < 65536; y += 4093)
+    {
+        for (int i = 0; i < kBytes; i += 2)
+        {
+            const uint16_t word = (uint16_t)(x[i] | (x[i + 1] << 8));
+            const uint16_t product = gf65536_mul(word, (uint16_t)y);
+            if (y != 0 && gf65536_div(product, (uint16_t)y) != word)
+                return false;
+
+            expected[i] = (uint8_t)product;
+            expected[i + 1] = (uint8_t)(product >> 8);
+        }
+
+        gf65536_mul_mem(z, x, (uint16_t)y, kBytes);
+        if (0 != memcmp(z, expected, kBytes))
+            return false;
+
+        // z = 0 + x * y
+        memset(z, 0, kBytes);
+        gf65536_muladd_mem(z, (uint16_t)y, x, kBytes);
+        if (0 != memcmp(z, expected, kBytes))
+            return false;
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Initialization
+
+extern "C" int gf65536_init_(int version)
+{
+    if (version != GF65536_VERSION)
+        return -1; // User's header does not match library version.
+
+    // Avoid multiple initialization
+    if (Initialized)
+        return 0;
+    Initialized = true;
+
+    // Shares the CPU detection and the XOR kernels
+    const int result = gf256_init();
+    if (result != 0)
+        return result;
+
+    if (!gf65536_explog_init())
+        return -4; // Polynomial is not primitive
+
+    gf65536_kernels_init();
+
+    if (!gf65536_self_test())
+        return -3; // Self-test failed (perhaps untested configuration)
+
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Operations
+
+extern "C" void gf65536_add_mem(void * GF256_RESTRICT vx,
+                                const void * GF256_RESTRICT vy, int bytes)
+{
+    gf256_add_mem(vx, vy, bytes);
+}
+
+extern "C" void gf65536_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                   const void * GF256_RESTRICT vy, int bytes)
+{
+    gf256_addset_mem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf65536_muladd_mem(void * GF256_RESTRICT vz, uint16_t y,
+                                   const void * GF256_RESTRICT vx, int bytes)
+{
+    if (y <= 1)
+    {
+        if (y == 1)
+            gf256_add_mem(vz, vx, bytes);
+        return;
+    }
+
+    gf65536_mul_tables tables;
+    gf65536_mul_tables_init(&tables, y);
+    Kernels->MulAddMem(vz, &tables, vx, bytes);
+}
+
+extern "C" void gf65536_mul_mem(void * GF256_RESTRICT vz,
+                                const void * GF256_RESTRICT vx, uint16_t y, int bytes)
+{
+    if (y <= 1)
+    {
+        if (y == 0)
+            memset(vz, 0, bytes);
+        else if (vz != vx)
+            memcpy(vz, vx, bytes);
+        return;
+    }
+
+    gf65536_mul_tables tables;
+    gf65536_mul_tables_init(&tables, y);
+    Kernels->MulMem(vz, vx, &tables, bytes);
+}
@@ -0,0 +1,137 @@
+/** \file
+    \brief GF(2^^16) AVX2 Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf65536_kernels.h"
+
+// Built with -mavx2
+#if defined(GF256_TRY_AVX2) && defined(__AVX2__)
+
+/*
+    AVX2 kernels
+
+    Same as the SSSE3 kernels with 32 words (64 bytes) at a time.  The byte
+    packing and unpacking instructions work within each 128-bit lane, so
+    splitting and interleaving the words needs no cross-lane permutes.
+*/
+
+template<bool Set>
+static void gf65536_muladd_mem_avx2_t(void * GF256_RESTRICT vz, const gf65536_mul_tables * tables,
+                                      const void * GF256_RESTRICT vx, int bytes)
+{
+#define GF65536_AVX2_TABLE(t) _mm256_broadcastsi128_si256(_mm_loadu_si128((const GF256_M128 *)(t)))
+    const GF256_M256 tableLo0 = GF65536_AVX2_TABLE(tables->Lo[0]);
+    const GF256_M256 tableLo1 = GF65536_AVX2_TABLE(tables->Lo[1]);
+    const GF256_M256 tableLo2 = GF65536_AVX2_TABLE(tables->Lo[2]);
+    const GF256_M256 tableLo3 = GF65536_AVX2_TABLE(tables->Lo[3]);
+    const GF256_M256 tableHi0 = GF65536_AVX2_TABLE(tables->Hi[0]);
+    const GF256_M256 tableHi1 = GF65536_AVX2_TABLE(tables->Hi[1]);
+    const GF256_M256 tableHi2 = GF65536_AVX2_TABLE(tables->Hi[2]);
+    const GF256_M256 tableHi3 = GF65536_AVX2_TABLE(tables->Hi[3]);
+#undef GF65536_AVX2_TABLE
+
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+    const GF256_M256 byte_mask = _mm256_set1_epi16(0x00ff);
+
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+
+    int words = bytes / 2;
+    while (words >= 32)
+    {
+        const GF256_M256 x0 = _mm256_loadu_si256(x32);
+        const GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
+
+        // Split into the low and high bytes of the words, per lane
+        const GF256_M256 lo = _mm256_packus_epi16(_mm256_and_si256(x0, byte_mask), _mm256_and_si256(x1, byte_mask));
+        const GF256_M256 hi = _mm256_packus_epi16(_mm256_srli_epi16(x0, 8), _mm256_srli_epi16(x1, 8));
+
+        const GF256_M256 n0 = _mm256_and_si256(lo, clr_mask);
+        const GF256_M256 n1 = _mm256_and_si256(_mm256_srli_epi64(lo, 4), clr_mask);
+        const GF256_M256 n2 = _mm256_and_si256(hi, clr_mask);
+        const GF256_M256 n3 = _mm256_and_si256(_mm256_srli_epi64(hi, 4), clr_mask);
+
+        GF256_M256 productLo = _mm256_xor_si256(
+            _mm256_xor_si256(_mm256_shuffle_epi8(tableLo0, n0), _mm256_shuffle_epi8(tableLo1, n1)),
+            _mm256_xor_si256(_mm256_shuffle_epi8(tableLo2, n2), _mm256_shuffle_epi8(tableLo3, n3)));
+        GF256_M256 productHi = _mm256_xor_si256(
+            _mm256_xor_si256(_mm256_shuffle_epi8(tableHi0, n0), _mm256_shuffle_epi8(tableHi1, n1)),
+            _mm256_xor_si256(_mm256_shuffle_epi8(tableHi2, n2), _mm256_shuffle_epi8(tableHi3, n3)));
+
+        // Interleave back into words
+        GF256_M256 z0 = _mm256_unpacklo_epi8(productLo, productHi);
+        GF256_M256 z1 = _mm256_unpackhi_epi8(productLo, productHi);
+
+        if (!Set)
+        {
+            z0 = _mm256_xor_si256(z0, _mm256_loadu_si256(z32));
+            z1 = _mm256_xor_si256(z1, _mm256_loadu_si256(z32 + 1));
+        }
+
+        _mm256_storeu_si256(z32, z0);
+        _mm256_storeu_si256(z32 + 1, z1);
+
+        words -= 32, z32 += 2, x32 += 2;
+    }
+
+    gf65536_muladd_scalar(reinterpret_cast<uint8_t *>(z32), tables,
+        reinterpret_cast<const uint8_t *>(x32), 0, words, Set);
+}
+
+static void gf65536_mul_mem_avx2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const gf65536_mul_tables * tables, int bytes)
+{
+    gf65536_muladd_mem_avx2_t<true>(vz, tables, vx, bytes);
+}
+
+static void gf65536_muladd_mem_avx2(void * GF256_RESTRICT vz, const gf65536_mul_tables * tables,
+                                    const void * GF256_RESTRICT vx, int bytes)
+{
+    gf65536_muladd_mem_avx2_t<false>(vz, tables, vx, bytes);
+}
+
+static const gf65536_kernels kKernelsAVX2 = {
+    "AVX2",
+    gf65536_mul_mem_avx2,
+    gf65536_muladd_mem_avx2
+};
+
+const gf65536_kernels* gf65536_kernels_avx2()
+{
+    return &kKernelsAVX2;
+}
+
+#else // __AVX2__
+
+const gf65536_kernels* gf65536_kernels_avx2()
+{
+    return nullptr;
+}
+
+#endif // __AVX2__
@@ -0,0 +1,112 @@
+/** \file
+    \brief GF(2^^16) Bulk Memory Kernels (internal)
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef CAT_GF65536_KERNELS_H
+#define CAT_GF65536_KERNELS_H
+
+/** \page GF65536Kernels GF(65536) Kernel Dispatch
+
+    As with GF(256), each SIMD instruction set has its own translation unit
+    and the fastest one the CPU supports is picked by gf65536_init().
+
+    The kernels take the multiply tables for the constant rather than the
+    constant itself, so a caller reusing one constant builds them once.
+*/
+
+#include "gf65536.h"
+
+
+//------------------------------------------------------------------------------
+// Multiply Tables
+
+/// Tables for multiplying by one constant y.
+/// Lo[n][v] and Hi[n][v] are the low and high bytes of y * (v << 4n).
+struct gf65536_mul_tables
+{
+    GF256_ALIGNED uint8_t Lo[4][16];
+    GF256_ALIGNED uint8_t Hi[4][16];
+};
+
+/// Fill in the tables for y
+extern void gf65536_mul_tables_init(gf65536_mul_tables * tables, uint16_t y);
+
+
+//------------------------------------------------------------------------------
+// Kernel Table
+
+struct gf65536_kernels
+{
+    /// Name of the instruction set, for diagnostics
+    const char* Name;
+
+    /// z[] = x[] * y
+    void (*MulMem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                   const gf65536_mul_tables * tables, int bytes);
+
+    /// z[] += x[] * y
+    void (*MulAddMem)(void * GF256_RESTRICT vz, const gf65536_mul_tables * tables,
+                      const void * GF256_RESTRICT vx, int bytes);
+};
+
+/// Returns the kernel table for the instruction set, or nullptr if the
+/// kernels were not built for this target
+extern const gf65536_kernels* gf65536_kernels_ssse3();
+extern const gf65536_kernels* gf65536_kernels_avx2();
+
+
+//------------------------------------------------------------------------------
+// Portable Kernel
+
+/// Handles the 16-bit words [offset, words) of a MulMem or MulAddMem call
+static inline void gf65536_muladd_scalar(uint8_t * GF256_RESTRICT z, const gf65536_mul_tables * tables,
+                                         const uint8_t * GF256_RESTRICT x, int offset, int words, bool set)
+{
+    for (; offset < words; ++offset)
+    {
+        const unsigned lo = x[offset * 2];
+        const unsigned hi = x[offset * 2 + 1];
+
+        uint8_t productLo = tables->Lo[0][lo & 15] ^ tables->Lo[1][lo >> 4] ^
+                            tables->Lo[2][hi & 15] ^ tables->Lo[3][hi >> 4];
+        uint8_t productHi = tables->Hi[0][lo & 15] ^ tables->Hi[1][lo >> 4] ^
+                            tables->Hi[2][hi & 15] ^ tables->Hi[3][hi >> 4];
+
+        if (!set)
+        {
+            productLo ^= z[offset * 2];
+            productHi ^= z[offset * 2 + 1];
+        }
+
+        z[offset * 2] = productLo;
+        z[offset * 2 + 1] = productHi;
+    }
+}
+
+#endif // CAT_GF65536_KERNELS_H
@@ -0,0 +1,136 @@
+/** \file
+    \brief GF(2^^16) SSSE3 Kernels
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of GF256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "gf65536_kernels.h"
+
+// Built with -mssse3.  MSVC does not define __SSSE3__ but always allows
+// the intrinsics on x86.
+#if !defined(GF256_TARGET_MOBILE) && (defined(__SSSE3__) || defined(_MSC_VER))
+
+/*
+    SSSE3 kernels
+
+    These handle 16 words (32 bytes) at a time.  The low and high bytes of
+    the words are split into separate registers, each nibble is looked up
+    with _mm_shuffle_epi8(), and the product bytes are interleaved again.
+*/
+
+template<bool Set>
+static void gf65536_muladd_mem_ssse3_t(void * GF256_RESTRICT vz, const gf65536_mul_tables * tables,
+                                       const void * GF256_RESTRICT vx, int bytes)
+{
+    const GF256_M128 tableLo0 = _mm_loadu_si128((const GF256_M128 *)tables->Lo[0]);
+    const GF256_M128 tableLo1 = _mm_loadu_si128((const GF256_M128 *)tables->Lo[1]);
+    const GF256_M128 tableLo2 = _mm_loadu_si128((const GF256_M128 *)tables->Lo[2]);
+    const GF256_M128 tableLo3 = _mm_loadu_si128((const GF256_M128 *)tables->Lo[3]);
+    const GF256_M128 tableHi0 = _mm_loadu_si128((const GF256_M128 *)tables->Hi[0]);
+    const GF256_M128 tableHi1 = _mm_loadu_si128((const GF256_M128 *)tables->Hi[1]);
+    const GF256_M128 tableHi2 = _mm_loadu_si128((const GF256_M128 *)tables->Hi[2]);
+    const GF256_M128 tableHi3 = _mm_loadu_si128((const GF256_M128 *)tables->Hi[3]);
+
+    const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+    const GF256_M128 byte_mask = _mm_set1_epi16(0x00ff);
+
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+
+    int words = bytes / 2;
+    while (words >= 16)
+    {
+        const GF256_M128 x0 = _mm_loadu_si128(x16);
+        const GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+
+        // Split into the low and high bytes of the 16 words
+        const GF256_M128 lo = _mm_packus_epi16(_mm_and_si128(x0, byte_mask), _mm_and_si128(x1, byte_mask));
+        const GF256_M128 hi = _mm_packus_epi16(_mm_srli_epi16(x0, 8), _mm_srli_epi16(x1, 8));
+
+        const GF256_M128 n0 = _mm_and_si128(lo, clr_mask);
+        const GF256_M128 n1 = _mm_and_si128(_mm_srli_epi64(lo, 4), clr_mask);
+        const GF256_M128 n2 = _mm_and_si128(hi, clr_mask);
+        const GF256_M128 n3 = _mm_and_si128(_mm_srli_epi64(hi, 4), clr_mask);
+
+        GF256_M128 productLo = _mm_xor_si128(
+            _mm_xor_si128(_mm_shuffle_epi8(tableLo0, n0), _mm_shuffle_epi8(tableLo1, n1)),
+            _mm_xor_si128(_mm_shuffle_epi8(tableLo2, n2), _mm_shuffle_epi8(tableLo3, n3)));
+        GF256_M128 productHi = _mm_xor_si128(
+            _mm_xor_si128(_mm_shuffle_epi8(tableHi0, n0), _mm_shuffle_epi8(tableHi1, n1)),
+            _mm_xor_si128(_mm_shuffle_epi8(tableHi2, n2), _mm_shuffle_epi8(tableHi3, n3)));
+
+        // Interleave back into words
+        GF256_M128 z0 = _mm_unpacklo_epi8(productLo, productHi);
+        GF256_M128 z1 = _mm_unpackhi_epi8(productLo, productHi);
+
+        if (!Set)
+        {
+            z0 = _mm_xor_si128(z0, _mm_loadu_si128(z16));
+            z1 = _mm_xor_si128(z1, _mm_loadu_si128(z16 + 1));
+        }
+
+        _mm_storeu_si128(z16, z0);
+        _mm_storeu_si128(z16 + 1, z1);
+
+        words -= 16, z16 += 2, x16 += 2;
+    }
+
+    gf65536_muladd_scalar(reinterpret_cast<uint8_t *>(z16), tables,
+        reinterpret_cast<const uint8_t *>(x16), 0, words, Set);
+}
+
+static void gf65536_mul_mem_ssse3(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                  const gf65536_mul_tables * tables, int bytes)
+{
+    gf65536_muladd_mem_ssse3_t<true>(vz, tables, vx, bytes);
+}
+
+static void gf65536_muladd_mem_ssse3(void * GF256_RESTRICT vz, const gf65536_mul_tables * tables,
+                                     const void * GF256_RESTRICT vx, int bytes)
+{
+    gf65536_muladd_mem_ssse3_t<false>(vz, tables, vx, bytes);
+}
+
+static const gf65536_kernels kKernelsSSSE3 = {
+    "SSSE3",
+    gf65536_mul_mem_ssse3,
+    gf65536_muladd_mem_ssse3
+};
+
+const gf65536_kernels* gf65536_kernels_ssse3()
+{
+    return &kKernelsSSSE3;
+}
+
+#else // __SSSE3__
+
+const gf65536_kernels* gf65536_kernels_ssse3()
+{
+    return nullptr;
+}
+
+#endif // __SSSE3__
@@ -39,6 +39,10 @@ using namespace std;
 // #endif
 
 #include "cm256.h"
+#include "cm65536.h"
+#include "gf256_kernels.h"
+#include "cm256_pool.h"
+#include "cm256_crc32c.h"
 
 // #ifdef _WIN32
 // #define WIN32_LEAN_AND_MEAN
@@ -47,6 +51,9 @@ using namespace std;
 
 #include <chrono>
 #include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 
 void initializeBlocks(cm256_block originals[256], int blockCount, int blockBytes)
 {
@@ -219,6 +226,2069 @@ bool CheckMemSwap()
     return true;
 }
 
+// Replaces the first 'lost' originals with the first recovery blocks, as if
+// those originals were erased on the way to the decoder
+static void loseOriginals(cm256_encoder_params params, cm256_block* blocks, uint8_t* recoveryData, int lost)
+{
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+    for (int i = 0; i < lost; ++i)
+    {
+        blocks[i].Block = recoveryData + params.BlockBytes * i;
+        blocks[i].Index = cm256_get_recovery_block_index(params, i);
+    }
+}
+
+// Checks the tiled cm256_encode() against cm256_encode_block() one block at
+// a time, with blocks that span several tiles and end in a partial one, and
+// decodes the result
+bool EncodeTilingTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    static const int Counts[][2] = { { 1, 1 }, { 2, 1 }, { 2, 2 }, { 20, 10 }, { 100, 30 }, { 200, 56 } };
+    static const int Sizes[] = { 1, 63, 1296, 100003 };
+
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            cm256_encoder_params params;
+            params.BlockBytes = blockBytes;
+            params.OriginalCount = counts[0];
+            params.RecoveryCount = counts[1];
+
+            std::vector<uint8_t> orig_data(params.OriginalCount * blockBytes);
+            std::vector<uint8_t> recoveryData(params.RecoveryCount * blockBytes);
+            std::vector<uint8_t> expected(params.RecoveryCount * blockBytes);
+
+            cm256_block blocks[256];
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                blocks[i].Block = &orig_data[i * blockBytes];
+            }
+            initializeBlocks(blocks, params.OriginalCount, blockBytes);
+
+            for (int i = 0; i < params.RecoveryCount; ++i)
+            {
+                cm256_encode_block(params, blocks, cm256_get_recovery_block_index(params, i), &expected[i * blockBytes]);
+            }
+            if (cm256_encode(params, blocks, &recoveryData[0]) ||
+                0 != memcmp(&recoveryData[0], &expected[0], expected.size()))
+            {
+                cout << "Tiled encode mismatch: " << blockBytes << " bytes k = " << params.OriginalCount
+                     << " m = " << params.RecoveryCount << endl;
+                return false;
+            }
+
+            loseOriginals(params, blocks, &recoveryData[0], std::min(params.OriginalCount, params.RecoveryCount));
+            if (cm256_decode(params, blocks) || !validateSolution(blocks, params.OriginalCount, blockBytes))
+            {
+                cout << "Tiled decode failed: " << blockBytes << " bytes k = " << params.OriginalCount
+                     << " m = " << params.RecoveryCount << endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Simple PRNG for filling test buffers
+static uint32_t nextRandom(uint32_t& state)
+{
+    state = state * 1103515245 + 12345;
+    return state >> 8;
+}
+
+// Checks the fused multi-source kernels against gf256_mul() one byte at a
+// time, over source counts that fall into each of the 8/4/2/1 groups and
+// lengths with tails, and with zero and one coefficients mixed in
+bool MulAddMultiTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    static const int MaxSources = 20;
+    static const int Sizes[] = { 0, 1, 15, 16, 33, 64, 100, 1000, 4097 };
+
+    uint32_t seed = 1;
+    for (int count = 1; count <= MaxSources; ++count)
+    {
+        for (int bytes : Sizes)
+        {
+            std::vector<uint8_t> sources(count * bytes + 1);
+            for (auto& x : sources)
+            {
+                x = (uint8_t)nextRandom(seed);
+            }
+
+            uint8_t y[MaxSources];
+            gf256_mul_tables tables[MaxSources];
+            const void* x[MaxSources];
+            for (int i = 0; i < count; ++i)
+            {
+                const uint32_t r = nextRandom(seed);
+                y[i] = (r % 8 == 0) ? (uint8_t)(r % 16 == 0) : (uint8_t)(r >> 4);
+                gf256_mul_tables_init(tables + i, y[i]);
+                x[i] = &sources[i * bytes];
+            }
+
+            std::vector<uint8_t> initial(bytes + 1), expected(bytes + 1);
+            for (int b = 0; b < bytes; ++b)
+            {
+                initial[b] = (uint8_t)nextRandom(seed);
+                uint8_t sum = 0;
+                for (int i = 0; i < count; ++i)
+                {
+                    sum ^= gf256_mul(sources[i * bytes + b], y[i]);
+                }
+                expected[b] = sum;
+            }
+
+            for (int kernel = 0; kernel < 4; ++kernel)
+            {
+                const bool accumulate = (kernel % 2 == 0);
+                std::vector<uint8_t> z = accumulate ? initial : std::vector<uint8_t>(bytes + 1, 0x5a);
+                switch (kernel)
+                {
+                case 0: gf256_muladd_multi_mem(&z[0], y, x, count, bytes); break;
+                case 1: gf256_mul_multi_mem(&z[0], y, x, count, bytes); break;
+                case 2: gf256_muladd_multi_tables_mem(&z[0], tables, x, count, bytes); break;
+                default: gf256_mul_multi_tables_mem(&z[0], tables, x, count, bytes); break;
+                }
+
+                for (int b = 0; b < bytes; ++b)
+                {
+                    if (z[b] != (uint8_t)(expected[b] ^ (accumulate ? initial[b] : 0)))
+                    {
+                        cout << "Multi-source kernel " << kernel << " mismatch: count = " << count
+                             << " bytes = " << bytes << endl;
+                        return false;
+                    }
+                }
+                if (z[bytes] != (accumulate ? initial[bytes] : 0x5a))
+                {
+                    cout << "Multi-source kernel " << kernel << " wrote past the end: count = " << count
+                         << " bytes = " << bytes << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Runs one kernel call on a table and on the portable table from the same
+// initial output, and compares the two including the guard byte past the end
+template<typename Call>
+static bool checkKernel(const char* kernelName, const gf256_kernels* kernels, int bytes,
+                        const std::vector<uint8_t>& initial, Call call)
+{
+    std::vector<uint8_t> z = initial, expected = initial;
+    call(kernels, &z[0]);
+    call(gf256_kernels_scalar(), &expected[0]);
+    if (z != expected)
+    {
+        cout << kernels->Name << " " << kernelName << " differs from the portable kernel: bytes = " << bytes << endl;
+        return false;
+    }
+    return true;
+}
+
+// Checks every kernel of each table the CPU supports against the portable
+// table, at each alignment and over lengths that end in every tail size,
+// then runs a whole encode and decode on each table
+bool KernelTableTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    const gf256_cpu_features features = gf256_get_cpu_features();
+    const gf256_kernels* candidates[] = {
+        features.SSSE3 ? gf256_kernels_ssse3() : nullptr,
+        features.AVX2 ? gf256_kernels_avx2() : nullptr,
+        features.AVX512BW ? gf256_kernels_avx512() : nullptr,
+        features.GFNI ? gf256_kernels_gfni() : nullptr,
+        features.Neon ? gf256_kernels_neon() : nullptr,
+        features.SVE2 ? gf256_kernels_sve2() : nullptr,
+    };
+
+    static const int MaxBytes = 600;
+    static const int Counts[] = { 1, 2, 4, 8 };
+
+    uint32_t seed = 3;
+    std::vector<uint8_t> data(9 * (MaxBytes + 64));
+    for (auto& x : data)
+    {
+        x = (uint8_t)nextRandom(seed);
+    }
+
+    for (const gf256_kernels* kernels : candidates)
+    {
+        // Null when the kernels were not built for this target
+        if (!kernels)
+        {
+            continue;
+        }
+
+        for (int bytes = 0; bytes <= MaxBytes; bytes += (bytes < 300 ? 1 : 37))
+        {
+            const int align = bytes % 4;
+            const uint8_t* x = &data[align];
+            const uint8_t* w = &data[MaxBytes + 64 + align];
+            const uint8_t y = (uint8_t)(2 + nextRandom(seed) % 254);
+
+            const std::vector<uint8_t> initial(data.end() - (bytes + 1), data.end());
+
+            bool ok = true;
+            ok &= checkKernel("AddMem", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->AddMem(z, x, bytes);
+            });
+            ok &= checkKernel("Add2Mem", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->Add2Mem(z, x, w, bytes);
+            });
+            ok &= checkKernel("AddSetMem", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->AddSetMem(z, x, w, bytes);
+            });
+            ok &= checkKernel("MulMem", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->MulMem(z, x, y, bytes);
+            });
+            ok &= checkKernel("MulAddMem", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->MulAddMem(z, y, x, bytes);
+            });
+
+            for (int count : Counts)
+            {
+                uint8_t coefficients[8];
+                gf256_mul_tables tables[8];
+                const uint8_t* sources[8];
+                for (int i = 0; i < count; ++i)
+                {
+                    coefficients[i] = (uint8_t)(1 + nextRandom(seed) % 255);
+                    gf256_mul_tables_init(tables + i, coefficients[i]);
+                    sources[i] = &data[i * (MaxBytes + 64) + (align + i) % 4];
+                }
+
+                for (int set = 0; set < 2; ++set)
+                {
+                    ok &= checkKernel("MulAddMulti", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                        k->MulAddMulti(z, coefficients, sources, count, bytes, set != 0);
+                    });
+                    ok &= checkKernel("MulAddMultiTables", kernels, bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                        k->MulAddMultiTables(z, tables, sources, count, bytes, set != 0);
+                    });
+                }
+
+                // One source into `count` destinations, each followed by a guard byte
+                std::vector<uint8_t> destinations;
+                for (int i = 0; i < count; ++i)
+                {
+                    destinations.insert(destinations.end(), data.begin() + i * 37, data.begin() + i * 37 + bytes + 1);
+                }
+                ok &= checkKernel("MulAddSpread", kernels, bytes, destinations, [&](const gf256_kernels* k, uint8_t* z) {
+                    uint8_t* rows[8];
+                    for (int i = 0; i < count; ++i)
+                    {
+                        rows[i] = z + i * (bytes + 1);
+                    }
+                    k->MulAddSpread(rows, coefficients, x, count, bytes);
+                });
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        gf256_set_kernels(kernels);
+        const bool codec = EncodeTilingTest();
+        gf256_set_kernels(nullptr);
+        if (!codec)
+        {
+            cout << kernels->Name << " kernels failed the codec check" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The GFNI kernels multiply with a bit matrix built for each coefficient, so
+// check them against the portable kernels for every coefficient value
+bool GFNICoefficientTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    const gf256_kernels* kernels = gf256_get_cpu_features().GFNI ? gf256_kernels_gfni() : nullptr;
+    if (!kernels)
+    {
+        return true;
+    }
+
+    static const int Bytes = 64 * 3 + 13;
+
+    uint32_t seed = 5;
+    std::vector<uint8_t> x(Bytes);
+    for (auto& b : x)
+    {
+        b = (uint8_t)nextRandom(seed);
+    }
+    const std::vector<uint8_t> initial(x.rbegin(), x.rend());
+    const uint8_t* sources[1] = { &x[0] };
+
+    for (int y = 1; y < 256; ++y)
+    {
+        const uint8_t coefficient = (uint8_t)y;
+        gf256_mul_tables tables;
+        gf256_mul_tables_init(&tables, coefficient);
+
+        bool ok = true;
+        if (y >= 2)
+        {
+            ok &= checkKernel("MulMem", kernels, Bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->MulMem(z, &x[0], coefficient, Bytes);
+            });
+            ok &= checkKernel("MulAddMem", kernels, Bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+                k->MulAddMem(z, coefficient, &x[0], Bytes);
+            });
+        }
+        ok &= checkKernel("MulAddMulti", kernels, Bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+            k->MulAddMulti(z, &coefficient, sources, 1, Bytes, false);
+        });
+        ok &= checkKernel("MulAddMultiTables", kernels, Bytes, initial, [&](const gf256_kernels* k, uint8_t* z) {
+            k->MulAddMultiTables(z, &tables, sources, 1, Bytes, false);
+        });
+        if (!ok)
+        {
+            cout << "GFNI mismatch for coefficient " << y << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Fills the originals of a test stripe in 'orig_data', points blocks[] at
+// them and sizes 'recoveryData' for the recovery blocks
+static void setupStripe(cm256_encoder_params params, std::vector<uint8_t>& orig_data,
+                        std::vector<uint8_t>& recoveryData, cm256_block* blocks)
+{
+    orig_data.assign(params.OriginalCount * params.BlockBytes, 0);
+    recoveryData.assign(params.RecoveryCount * params.BlockBytes, 0);
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &orig_data[i * params.BlockBytes];
+    }
+    initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+}
+
+struct NestedEncodeTask
+{
+    cm256_pool* Pool;
+    cm256_encoder_params Params;
+    cm256_block* Originals;
+    uint8_t* RecoveryData;
+    int Result;
+
+    static void Run(void* context, int task)
+    {
+        NestedEncodeTask* self = static_cast<NestedEncodeTask*>(context);
+        if (task == 0)
+        {
+            self->Result = cm256_encode_mt(self->Params, self->Originals, self->RecoveryData, self->Pool);
+        }
+    }
+};
+
+// Checks cm256_encode_mt() against cm256_encode() for blocks that are split
+// into stripes and blocks that are not, with and without a pool, and from a
+// task already running on the pool
+bool EncodeMTTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    static const int Sizes[] = { 1000, CM256_MT_MIN_STRIPE_BYTES * 3 + 17 };
+
+    for (int blockBytes : Sizes)
+    {
+        cm256_encoder_params params;
+        params.BlockBytes = blockBytes;
+        params.OriginalCount = 30;
+        params.RecoveryCount = 10;
+
+        std::vector<uint8_t> orig_data, recoveryData, expected(params.RecoveryCount * blockBytes);
+        cm256_block blocks[256];
+        setupStripe(params, orig_data, recoveryData, blocks);
+
+        if (cm256_encode(params, blocks, &expected[0]))
+        {
+            return false;
+        }
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            std::fill(recoveryData.begin(), recoveryData.end(), 0);
+
+            int result;
+            if (pass < 2)
+            {
+                result = cm256_encode_mt(params, blocks, &recoveryData[0], pass == 0 ? nullptr : pool);
+            }
+            else
+            {
+                NestedEncodeTask task = { pool, params, blocks, &recoveryData[0], -1 };
+                cm256_pool_run(pool, &NestedEncodeTask::Run, &task, 4);
+                result = task.Result;
+            }
+
+            if (result || recoveryData != expected)
+            {
+                cout << "cm256_encode_mt mismatch: " << blockBytes << " bytes, pass " << pass << endl;
+                return false;
+            }
+        }
+
+        loseOriginals(params, blocks, &recoveryData[0], params.RecoveryCount);
+        if (cm256_decode(params, blocks) || !validateSolution(blocks, params.OriginalCount, blockBytes))
+        {
+            cout << "cm256_encode_mt decode failed: " << blockBytes << " bytes" << endl;
+            return false;
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return true;
+}
+
+// Decodes with cm256_decode_mt() for the m=1 and m>1 paths, on blocks that
+// are split into stripes and blocks that are not, and with no pool
+bool DecodeMTTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    static const int Counts[][3] = { { 30, 1, 1 }, { 30, 10, 1 }, { 30, 10, 10 }, { 10, 30, 10 } };
+    static const int Sizes[] = { 1000, CM256_MT_MIN_STRIPE_BYTES * 3 + 17 };
+
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            for (int withPool = 0; withPool < 2; ++withPool)
+            {
+                cm256_encoder_params params;
+                params.BlockBytes = blockBytes;
+                params.OriginalCount = counts[0];
+                params.RecoveryCount = counts[1];
+
+                std::vector<uint8_t> orig_data, recoveryData;
+                cm256_block blocks[256];
+                setupStripe(params, orig_data, recoveryData, blocks);
+
+                if (cm256_encode(params, blocks, &recoveryData[0]))
+                {
+                    return false;
+                }
+
+                loseOriginals(params, blocks, &recoveryData[0], counts[2]);
+                if (cm256_decode_mt(params, blocks, withPool ? pool : nullptr) ||
+                    !validateSolution(blocks, params.OriginalCount, blockBytes))
+                {
+                    cout << "cm256_decode_mt failed: " << blockBytes << " bytes k = " << params.OriginalCount
+                         << " m = " << params.RecoveryCount << " lost " << counts[2] << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return true;
+}
+
+// Checks that every encode through a cm256_encoder handle matches
+// cm256_encode(), and that its output decodes
+bool EncoderHandleTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    static const int Counts[][2] = { { 1, 3 }, { 5, 1 }, { 30, 10 }, { 200, 56 } };
+    static const int Sizes[] = { 100, CM256_MT_MIN_STRIPE_BYTES * 3 + 17 };
+
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            cm256_encoder_params params;
+            params.BlockBytes = blockBytes;
+            params.OriginalCount = counts[0];
+            params.RecoveryCount = counts[1];
+
+            std::vector<uint8_t> orig_data, recoveryData, expected(params.RecoveryCount * blockBytes);
+            cm256_block blocks[256];
+            setupStripe(params, orig_data, recoveryData, blocks);
+
+            cm256_encoder* encoder = cm256_encoder_create(params);
+            if (!encoder || cm256_encode(params, blocks, &expected[0]))
+            {
+                return false;
+            }
+
+            for (int call = 0; call < 3; ++call)
+            {
+                std::fill(recoveryData.begin(), recoveryData.end(), 0);
+
+                int result = 0;
+                if (call == 0)
+                {
+                    result = cm256_encoder_encode(encoder, blocks, &recoveryData[0]);
+                }
+                else if (call == 1)
+                {
+                    result = cm256_encoder_encode_mt(encoder, blocks, &recoveryData[0], pool);
+                }
+                else
+                {
+                    for (int i = 0; i < params.RecoveryCount; ++i)
+                    {
+                        cm256_encoder_encode_block(encoder, blocks, cm256_get_recovery_block_index(params, i),
+                            &recoveryData[i * blockBytes]);
+                    }
+                }
+
+                if (result || recoveryData != expected)
+                {
+                    cout << "Encoder handle mismatch: " << blockBytes << " bytes k = " << params.OriginalCount
+                         << " m = " << params.RecoveryCount << " call " << call << endl;
+                    return false;
+                }
+            }
+
+            cm256_encoder_destroy(encoder);
+
+            loseOriginals(params, blocks, &recoveryData[0], std::min(params.OriginalCount, params.RecoveryCount));
+            if (cm256_decode(params, blocks) || !validateSolution(blocks, params.OriginalCount, blockBytes))
+            {
+                cout << "Encoder handle decode failed" << endl;
+                return false;
+            }
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return true;
+}
+
+// Decodes several stripes through one plan per loss pattern, with the blocks
+// passed in a different order than the plan was made from, then through a
+// plan cache too small to hold every pattern
+bool DecodePlanTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 1000;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 8;
+
+    static const int LostCounts[] = { 0, 1, 3, 8 };
+    static const int Stripes = 3;
+
+    cm256_plan_cache* cache = cm256_plan_cache_create(2);
+    if (!cache)
+    {
+        return false;
+    }
+
+    for (int usePlan = 1; usePlan >= 0; --usePlan)
+    {
+        for (int stripe = 0; stripe < Stripes; ++stripe)
+        {
+            for (int lost : LostCounts)
+            {
+                std::vector<uint8_t> orig_data, recoveryData;
+                cm256_block blocks[256];
+                setupStripe(params, orig_data, recoveryData, blocks);
+                if (cm256_encode(params, blocks, &recoveryData[0]))
+                {
+                    return false;
+                }
+                loseOriginals(params, blocks, &recoveryData[0], lost);
+
+                int result;
+                if (usePlan)
+                {
+                    unsigned char indices[256];
+                    for (int i = 0; i < params.OriginalCount; ++i)
+                    {
+                        indices[i] = blocks[i].Index;
+                    }
+                    cm256_decode_plan* plan = cm256_decode_plan_create(params, indices);
+                    if (!plan)
+                    {
+                        return false;
+                    }
+
+                    std::reverse(blocks, blocks + params.OriginalCount);
+                    result = cm256_decode_plan_apply(plan, blocks, nullptr);
+
+                    // Blocks that do not match the plan are rejected
+                    if (lost > 0)
+                    {
+                        cm256_block other[256];
+                        for (int i = 0; i < params.OriginalCount; ++i)
+                        {
+                            other[i].Block = &orig_data[i * params.BlockBytes];
+                        }
+                        loseOriginals(params, other, &recoveryData[0], 0);
+                        if (cm256_decode_plan_apply(plan, other, nullptr) == 0)
+                        {
+                            cout << "Decode plan accepted the wrong indices" << endl;
+                            return false;
+                        }
+                    }
+
+                    cm256_decode_plan_destroy(plan);
+                }
+                else
+                {
+                    result = cm256_decode_cached(cache, params, blocks, nullptr);
+                }
+
+                if (result || !validateSolution(blocks, params.OriginalCount, params.BlockBytes))
+                {
+                    cout << (usePlan ? "Decode plan" : "Plan cache") << " failed: lost " << lost << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    cm256_plan_cache_destroy(cache);
+    return true;
+}
+
+// Encodes a batch of stripes with cm256_encode_batch() and the encoder
+// handle, checks them against cm256_encode(), and decodes the batch with a
+// mix of loss patterns so that some stripes share a plan
+bool BatchTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 500;
+    params.OriginalCount = 12;
+    params.RecoveryCount = 4;
+
+    static const int StripeCount = 40;
+
+    for (int withPool = 0; withPool < 2; ++withPool)
+    {
+        std::vector<std::vector<uint8_t>> orig_data(StripeCount), recoveryData(StripeCount);
+        std::vector<std::vector<cm256_block>> blocks(StripeCount, std::vector<cm256_block>(256));
+        std::vector<cm256_encode_stripe> encodeStripes(StripeCount);
+        for (int s = 0; s < StripeCount; ++s)
+        {
+            setupStripe(params, orig_data[s], recoveryData[s], &blocks[s][0]);
+            encodeStripes[s].Originals = &blocks[s][0];
+            encodeStripes[s].RecoveryBlocks = &recoveryData[s][0];
+        }
+
+        cm256_pool* batchPool = withPool ? pool : nullptr;
+
+        // An empty batch does nothing and succeeds
+        cm256_encoder* emptyEncoder = cm256_encoder_create(params);
+        const bool empty = emptyEncoder &&
+            cm256_encode_batch(params, nullptr, 0, batchPool) == 0 &&
+            cm256_encoder_encode_batch(emptyEncoder, nullptr, 0, batchPool) == 0 &&
+            cm256_decode_batch(params, nullptr, 0, batchPool) == 0;
+        cm256_encoder_destroy(emptyEncoder);
+        if (!empty)
+        {
+            cout << "Empty batch failed" << endl;
+            return false;
+        }
+
+        std::vector<uint8_t> expected(params.RecoveryCount * params.BlockBytes);
+        for (int call = 0; call < 2; ++call)
+        {
+            int result;
+            if (call == 0)
+            {
+                result = cm256_encode_batch(params, &encodeStripes[0], StripeCount, batchPool);
+            }
+            else
+            {
+                cm256_encoder* encoder = cm256_encoder_create(params);
+                result = encoder ? cm256_encoder_encode_batch(encoder, &encodeStripes[0], StripeCount, batchPool) : -4;
+                cm256_encoder_destroy(encoder);
+            }
+            if (result)
+            {
+                return false;
+            }
+
+            for (int s = 0; s < StripeCount; ++s)
+            {
+                if (cm256_encode(params, &blocks[s][0], &expected[0]) || recoveryData[s] != expected)
+                {
+                    cout << "Batch encode mismatch: stripe " << s << " call " << call << endl;
+                    return false;
+                }
+            }
+        }
+
+        std::vector<cm256_block*> decodeStripes(StripeCount);
+        for (int s = 0; s < StripeCount; ++s)
+        {
+            loseOriginals(params, &blocks[s][0], &recoveryData[s][0], s % (params.RecoveryCount + 1));
+            decodeStripes[s] = &blocks[s][0];
+        }
+
+        if (cm256_decode_batch(params, &decodeStripes[0], StripeCount, batchPool))
+        {
+            return false;
+        }
+        for (int s = 0; s < StripeCount; ++s)
+        {
+            if (!validateSolution(decodeStripes[s], params.OriginalCount, params.BlockBytes))
+            {
+                cout << "Batch decode failed: stripe " << s << endl;
+                return false;
+            }
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return true;
+}
+
+// Pushes the originals into the streaming encoder in a shuffled order and
+// checks that flush produces the same recovery blocks as cm256_encode().
+// A partial group is discarded by reset first, and the second group checks
+// that flush left the encoder ready for the next one
+bool StreamEncoderTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 1000;
+    params.OriginalCount = 30;
+    params.RecoveryCount = 6;
+
+    cm256_block blocks[256];
+    std::vector<uint8_t> orig_data, recoveryData, expected(params.RecoveryCount * params.BlockBytes);
+    setupStripe(params, orig_data, recoveryData, blocks);
+    if (cm256_encode(params, blocks, &expected[0]))
+    {
+        return false;
+    }
+
+    cm256_stream_encoder* encoder = cm256_stream_encoder_create(params);
+    if (!encoder)
+    {
+        return false;
+    }
+
+    bool success = true;
+    uint32_t state = 7;
+    for (int i = 0; i < params.OriginalCount / 2; ++i)
+    {
+        success &= cm256_stream_encoder_push(encoder, i, blocks[i].Block) == 0;
+    }
+    cm256_stream_encoder_reset(encoder);
+
+    for (int group = 0; group < 2 && success; ++group)
+    {
+        int order[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            order[i] = i;
+        }
+        for (int i = params.OriginalCount - 1; i > 0; --i)
+        {
+            std::swap(order[i], order[nextRandom(state) % (i + 1)]);
+        }
+
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            success &= cm256_stream_encoder_push(encoder, order[i], blocks[order[i]].Block) == 0;
+        }
+        success &= cm256_stream_encoder_flush(encoder, &recoveryData[0]) == 0;
+        if (recoveryData != expected)
+        {
+            cout << "Stream encode mismatch: group " << group << endl;
+            success = false;
+        }
+    }
+
+    cm256_stream_encoder_destroy(encoder);
+    return success;
+}
+
+// Pushes k received blocks into the streaming decoder in a shuffled order
+// for each number of losses, checking that the decode completes on the
+// last one and that a block pushed afterwards is ignored
+bool StreamDecoderTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 1000;
+    params.OriginalCount = 30;
+    params.RecoveryCount = 6;
+
+    cm256_stream_decoder* decoder = cm256_stream_decoder_create(params);
+    if (!decoder)
+    {
+        return false;
+    }
+
+    bool success = true;
+    uint32_t state = 11;
+    for (int lost = 0; lost <= params.RecoveryCount && success; ++lost)
+    {
+        cm256_block blocks[256];
+        std::vector<uint8_t> orig_data, recoveryData;
+        setupStripe(params, orig_data, recoveryData, blocks);
+        if (cm256_encode(params, blocks, &recoveryData[0]))
+        {
+            success = false;
+            break;
+        }
+        const std::vector<uint8_t> lastRecovery(recoveryData.end() - params.BlockBytes, recoveryData.end());
+        loseOriginals(params, blocks, &recoveryData[0], lost);
+
+        for (int i = params.OriginalCount - 1; i > 0; --i)
+        {
+            std::swap(blocks[i], blocks[nextRandom(state) % (i + 1)]);
+        }
+
+        cm256_stream_decoder_reset(decoder);
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            success &= cm256_stream_decoder_complete(decoder) == 0;
+            success &= cm256_stream_decoder_push(decoder, &blocks[i]) == 0;
+        }
+        success &= cm256_stream_decoder_complete(decoder) != 0;
+
+        // Push a copy of the last recovery block once the decode is complete
+        std::vector<uint8_t> extraData = lastRecovery;
+        cm256_block extra;
+        extra.Block = &extraData[0];
+        extra.Index = cm256_get_recovery_block_index(params, params.RecoveryCount - 1);
+        if (lost < params.RecoveryCount)
+        {
+            success &= cm256_stream_decoder_push(decoder, &extra) == 0;
+            success &= extra.Index == cm256_get_recovery_block_index(params, params.RecoveryCount - 1);
+            success &= extraData == lastRecovery;
+        }
+
+        if (!success || !validateSolution(blocks, params.OriginalCount, params.BlockBytes))
+        {
+            cout << "Stream decode failed: lost " << lost << endl;
+            success = false;
+        }
+    }
+
+    cm256_stream_decoder_destroy(decoder);
+    return success;
+}
+
+// Checks a recovered block against the data initializeBlocks() wrote
+static bool checkOriginal(const uint8_t* data, int index, int blockBytes)
+{
+    for (int j = 0; j < blockBytes; ++j)
+    {
+        if (data[j] != (uint8_t)(index + j * 13))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decodes into separate outputs with and without a pool, checking the
+// recovered originals and that the received blocks are not modified
+bool DecodeIntoTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 40000;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 8;
+
+    bool success = true;
+    for (int withPool = 0; withPool < 2 && success; ++withPool)
+    {
+        for (int lost = 0; lost <= params.RecoveryCount && success; ++lost)
+        {
+            cm256_block blocks[256];
+            std::vector<uint8_t> orig_data, recoveryData;
+            setupStripe(params, orig_data, recoveryData, blocks);
+            if (cm256_encode(params, blocks, &recoveryData[0]))
+            {
+                success = false;
+                break;
+            }
+            const std::vector<uint8_t> receivedData = recoveryData;
+            loseOriginals(params, blocks, &recoveryData[0], lost);
+
+            std::vector<uint8_t> outputData(lost * params.BlockBytes + 1);
+            void* outputs[256] = {};
+            for (int i = 0; i < lost; ++i)
+            {
+                outputs[i] = &outputData[i * params.BlockBytes];
+            }
+
+            success &= cm256_decode_into(params, blocks, outputs, withPool ? pool : nullptr) == 0;
+            for (int i = 0; i < lost; ++i)
+            {
+                success &= checkOriginal(&outputData[i * params.BlockBytes], i, params.BlockBytes);
+                success &= blocks[i].Index == cm256_get_recovery_block_index(params, i);
+            }
+            for (int i = lost; i < params.OriginalCount; ++i)
+            {
+                success &= checkOriginal((const uint8_t*)blocks[i].Block, i, params.BlockBytes);
+            }
+            success &= recoveryData == receivedData;
+            if (!success)
+            {
+                cout << "Decode into failed: lost " << lost << " pool " << withPool << endl;
+            }
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return success;
+}
+
+// Recovers a subset of the erased originals with cm256_decode_partial(),
+// checking that only the requested outputs are written
+bool DecodePartialTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 40000;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 8;
+
+    bool success = true;
+    for (int withPool = 0; withPool < 2 && success; ++withPool)
+    {
+        for (int lost = 1; lost <= params.RecoveryCount && success; ++lost)
+        {
+            cm256_block blocks[256];
+            std::vector<uint8_t> orig_data, recoveryData;
+            setupStripe(params, orig_data, recoveryData, blocks);
+            if (cm256_encode(params, blocks, &recoveryData[0]))
+            {
+                success = false;
+                break;
+            }
+            loseOriginals(params, blocks, &recoveryData[0], lost);
+
+            // Request every other erased original, and poison the rest
+            std::vector<uint8_t> outputData(lost * params.BlockBytes, 0xfe);
+            void* outputs[256] = {};
+            for (int i = 0; i < lost; i += 2)
+            {
+                outputs[i] = &outputData[i * params.BlockBytes];
+            }
+
+            success &= cm256_decode_partial(params, blocks, outputs, withPool ? pool : nullptr) == 0;
+            for (int i = 0; i < lost; ++i)
+            {
+                const uint8_t* output = &outputData[i * params.BlockBytes];
+                if (i % 2 == 0)
+                {
+                    success &= checkOriginal(output, i, params.BlockBytes);
+                }
+                else
+                {
+                    success &= std::count(output, output + params.BlockBytes, 0xfe) == params.BlockBytes;
+                }
+            }
+            if (!success)
+            {
+                cout << "Decode partial failed: lost " << lost << " pool " << withPool << endl;
+            }
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return success;
+}
+
+// Encodes a code with more than 256 blocks in GF(65536), erases a spread
+// of originals, and decodes them
+bool CM65536Test()
+{
+    if (cm65536_init())
+    {
+        return false;
+    }
+
+    cm65536_encoder_params params;
+    params.BlockBytes = 250;
+    params.OriginalCount = 300;
+    params.RecoveryCount = 50;
+
+    std::vector<uint8_t> orig_data(params.OriginalCount * params.BlockBytes);
+    std::vector<uint8_t> recoveryData(params.RecoveryCount * params.BlockBytes);
+    for (size_t i = 0; i < orig_data.size(); ++i)
+    {
+        orig_data[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+
+    std::vector<cm65536_block> blocks(params.OriginalCount);
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &orig_data[i * params.BlockBytes];
+        blocks[i].Index = cm65536_get_original_block_index(params, i);
+    }
+    if (cm65536_encode(params, &blocks[0], &recoveryData[0]))
+    {
+        return false;
+    }
+
+    // Erase every sixth original, which uses all of the recovery blocks
+    int lost = 0;
+    for (int i = 0; i < params.OriginalCount; i += 6, ++lost)
+    {
+        blocks[i].Block = &recoveryData[lost * params.BlockBytes];
+        blocks[i].Index = cm65536_get_recovery_block_index(params, lost);
+    }
+    if (cm65536_decode(params, &blocks[0]))
+    {
+        return false;
+    }
+
+    std::vector<bool> seen(params.OriginalCount);
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        const int index = blocks[i].Index;
+        if (index >= params.OriginalCount || seen[index] ||
+            memcmp(blocks[i].Block, &orig_data[index * params.BlockBytes], params.BlockBytes) != 0)
+        {
+            cout << "CM65536 decode failed: block " << i << endl;
+            return false;
+        }
+        seen[index] = true;
+    }
+    return true;
+}
+
+// Round-trips FFT mode for every loss count, over code sizes where it needs
+// padding blocks and block sizes with a partial tail
+bool FFTTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    static const int Counts[][2] = { { 1, 1 }, { 5, 3 }, { 20, 10 }, { 100, 30 }, { 128, 64 }, { 224, 32 } };
+    static const int Sizes[] = { 1, 100, 4100 };
+
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            cm256_encoder_params params;
+            params.BlockBytes = blockBytes;
+            params.OriginalCount = counts[0];
+            params.RecoveryCount = counts[1];
+
+            for (int lost = 0; lost <= params.RecoveryCount && lost <= params.OriginalCount; lost += 1 + lost / 4)
+            {
+                cm256_block blocks[256];
+                std::vector<uint8_t> orig_data, recoveryData;
+                setupStripe(params, orig_data, recoveryData, blocks);
+                if (cm256_fft_encode(params, blocks, &recoveryData[0]))
+                {
+                    return false;
+                }
+
+                loseOriginals(params, blocks, &recoveryData[0], lost);
+                if (cm256_fft_decode(params, blocks) ||
+                    !validateSolution(blocks, params.OriginalCount, params.BlockBytes))
+                {
+                    cout << "FFT round trip failed: k = " << params.OriginalCount << " m = " << params.RecoveryCount
+                         << " bytes = " << blockBytes << " lost = " << lost << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Round-trips XOR bitmatrix mode over more loss patterns than the decode
+// cache holds, so that schedules are evicted and rebuilt
+bool XorCodecTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    static const int Counts[][2] = { { 1, 1 }, { 5, 3 }, { 20, 10 }, { 100, 30 } };
+    static const int Sizes[] = { 8, 1296 };
+
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            cm256_encoder_params params;
+            params.BlockBytes = blockBytes;
+            params.OriginalCount = counts[0];
+            params.RecoveryCount = counts[1];
+
+            cm256_xor_codec* codec = cm256_xor_codec_create(params, 2);
+            if (!codec)
+            {
+                return false;
+            }
+
+            bool success = true;
+            for (int pass = 0; pass < 2 && success; ++pass)
+            {
+                for (int lost = 0; lost <= params.RecoveryCount && lost <= params.OriginalCount; ++lost)
+                {
+                    cm256_block blocks[256];
+                    std::vector<uint8_t> orig_data, recoveryData;
+                    setupStripe(params, orig_data, recoveryData, blocks);
+                    if (cm256_xor_encode(codec, blocks, &recoveryData[0]))
+                    {
+                        success = false;
+                        break;
+                    }
+
+                    loseOriginals(params, blocks, &recoveryData[0], lost);
+                    if (cm256_xor_decode(codec, blocks) ||
+                        !validateSolution(blocks, params.OriginalCount, params.BlockBytes))
+                    {
+                        cout << "XOR round trip failed: k = " << params.OriginalCount << " m = " << params.RecoveryCount
+                             << " bytes = " << blockBytes << " lost = " << lost << endl;
+                        success = false;
+                        break;
+                    }
+                }
+            }
+
+            cm256_xor_codec_destroy(codec);
+            if (!success)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Blocks must split into 8 packets
+    cm256_encoder_params params;
+    params.BlockBytes = 100;
+    params.OriginalCount = 10;
+    params.RecoveryCount = 4;
+    cm256_xor_codec* codec = cm256_xor_codec_create(params, 2);
+    cm256_xor_codec_destroy(codec);
+    return codec == nullptr;
+}
+
+// Checks that the default points reproduce cm256_encode(), that optimizing
+// does not raise the cost, and round-trips data encoded with the optimized
+// points through both the byte codec and XOR bitmatrix mode
+bool MatrixPointsTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 1296;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 6;
+
+    cm256_block blocks[256];
+    std::vector<uint8_t> orig_data, recoveryData, expected(params.RecoveryCount * params.BlockBytes);
+    setupStripe(params, orig_data, recoveryData, blocks);
+    if (cm256_encode(params, blocks, &expected[0]))
+    {
+        return false;
+    }
+
+    cm256_matrix_points defaults, optimized;
+    cm256_default_points(params, &defaults);
+    if (cm256_optimize_points(params, 200, &optimized))
+    {
+        return false;
+    }
+
+    const int defaultCost = cm256_points_cost(params, &defaults);
+    const int optimizedCost = cm256_points_cost(params, &optimized);
+    if (defaultCost < 0 || optimizedCost < 0 || optimizedCost > defaultCost)
+    {
+        cout << "Points cost: default " << defaultCost << " optimized " << optimizedCost << endl;
+        return false;
+    }
+
+    cm256_matrix_points duplicate = defaults;
+    duplicate.Y[1] = duplicate.Y[0];
+    if (cm256_points_cost(params, &duplicate) >= 0)
+    {
+        return false;
+    }
+
+    bool success = true;
+    for (int which = 0; which < 2 && success; ++which)
+    {
+        const cm256_matrix_points* points = which ? &optimized : &defaults;
+
+        cm256_encoder* encoder = cm256_encoder_create_with_points(params, points);
+        cm256_xor_codec* codec = cm256_xor_codec_create_with_points(params, points, 2);
+        if (!encoder || !codec)
+        {
+            cm256_encoder_destroy(encoder);
+            cm256_xor_codec_destroy(codec);
+            return false;
+        }
+
+        for (int lost = 0; lost <= params.RecoveryCount && success; ++lost)
+        {
+            // Byte codec
+            setupStripe(params, orig_data, recoveryData, blocks);
+            success &= cm256_encoder_encode(encoder, blocks, &recoveryData[0]) == 0;
+            if (which == 0)
+            {
+                success &= recoveryData == expected;
+            }
+            loseOriginals(params, blocks, &recoveryData[0], lost);
+            success &= cm256_decode_with_points(params, points, blocks, nullptr) == 0;
+            success &= validateSolution(blocks, params.OriginalCount, params.BlockBytes);
+
+            // XOR bitmatrix mode
+            setupStripe(params, orig_data, recoveryData, blocks);
+            success &= cm256_xor_encode(codec, blocks, &recoveryData[0]) == 0;
+            loseOriginals(params, blocks, &recoveryData[0], lost);
+            success &= cm256_xor_decode(codec, blocks) == 0;
+            success &= validateSolution(blocks, params.OriginalCount, params.BlockBytes);
+
+            if (!success)
+            {
+                cout << "Points round trip failed: " << (which ? "optimized" : "default") << " lost " << lost << endl;
+            }
+        }
+
+        cm256_encoder_destroy(encoder);
+        cm256_xor_codec_destroy(codec);
+    }
+
+    return success;
+}
+
+// Checks that a header built with the other GF(256) context layout is
+// rejected by both init calls
+bool VersionTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    return gf256_init_(GF256_VERSION ^ GF256_VERSION_COMPACT) != 0 &&
+           cm256_init_(CM256_VERSION ^ GF256_VERSION_COMPACT) != 0;
+}
+
+// Takes blocks from an arena, checks their alignment and zero padding, and
+// round-trips them through the aligned encode and decode, comparing the
+// recovery data with cm256_encode()
+bool AlignedArenaTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 1000;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 8;
+
+    const int paddedBytes = cm256_padded_bytes(params.BlockBytes);
+    if (paddedBytes % CM256_BLOCK_ALIGN != 0 || paddedBytes < params.BlockBytes)
+    {
+        return false;
+    }
+
+    cm256_arena* arena = cm256_arena_create(params.BlockBytes, params.OriginalCount);
+    if (!arena)
+    {
+        return false;
+    }
+
+    bool success = true;
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        uint8_t* block = (uint8_t*)cm256_arena_alloc(arena);
+        if (!block || (uintptr_t)block % CM256_BLOCK_ALIGN != 0)
+        {
+            cm256_arena_destroy(arena);
+            return false;
+        }
+        success &= std::count(block + params.BlockBytes, block + paddedBytes, 0) == paddedBytes - params.BlockBytes;
+        blocks[i].Block = block;
+    }
+
+    // All blocks are in use until one is freed
+    success &= cm256_arena_alloc(arena) == nullptr;
+    void* last = blocks[params.OriginalCount - 1].Block;
+    cm256_arena_free(arena, last);
+    blocks[params.OriginalCount - 1].Block = cm256_arena_alloc(arena);
+    success &= blocks[params.OriginalCount - 1].Block != nullptr;
+
+    initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+
+    // Recovery blocks end-to-end at the padded stride
+    std::vector<uint8_t> recoveryStorage(params.RecoveryCount * paddedBytes + CM256_BLOCK_ALIGN);
+    uint8_t* recoveryData = &recoveryStorage[0] + (CM256_BLOCK_ALIGN - (uintptr_t)&recoveryStorage[0] % CM256_BLOCK_ALIGN) % CM256_BLOCK_ALIGN;
+    std::vector<uint8_t> expected(params.RecoveryCount * params.BlockBytes);
+
+    success &= cm256_encode(params, blocks, &expected[0]) == 0;
+    success &= cm256_encode_aligned(params, blocks, recoveryData) == 0;
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        const uint8_t* recovery = recoveryData + i * paddedBytes;
+        success &= memcmp(recovery, &expected[i * params.BlockBytes], params.BlockBytes) == 0;
+        success &= std::count(recovery + params.BlockBytes, recovery + paddedBytes, 0) == paddedBytes - params.BlockBytes;
+    }
+
+    // Misaligned blocks are rejected
+    cm256_block misaligned[256];
+    std::copy(blocks, blocks + params.OriginalCount, misaligned);
+    misaligned[1].Block = (uint8_t*)misaligned[1].Block + 1;
+    success &= cm256_encode_aligned(params, misaligned, recoveryData) == -1;
+
+    // Replace the originals with recovery blocks, as loseOriginals() does
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        blocks[i].Block = recoveryData + i * paddedBytes;
+        blocks[i].Index = cm256_get_recovery_block_index(params, i);
+    }
+    success &= cm256_decode_aligned(params, blocks) == 0;
+    success &= validateSolution(blocks, params.OriginalCount, params.BlockBytes);
+
+    if (!success)
+    {
+        cout << "Aligned arena round trip failed" << endl;
+    }
+
+    cm256_arena_destroy(arena);
+    return success;
+}
+
+// Forces large-block mode on and checks that encode, the multithreaded
+// encode and decode give the same results as the default path
+bool LargeBlockTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    static const int Counts[][2] = { { 2, 1 }, { 20, 10 }, { 100, 30 } };
+    static const int Sizes[] = { 1, 1296, 100003 };
+
+    bool success = true;
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            cm256_encoder_params params;
+            params.BlockBytes = blockBytes;
+            params.OriginalCount = counts[0];
+            params.RecoveryCount = counts[1];
+
+            cm256_block blocks[256];
+            std::vector<uint8_t> orig_data, recoveryData, expected(params.RecoveryCount * params.BlockBytes);
+            setupStripe(params, orig_data, recoveryData, blocks);
+
+            cm256_set_large_block_threshold(-1);
+            success &= cm256_encode(params, blocks, &expected[0]) == 0;
+
+            cm256_set_large_block_threshold(0);
+            success &= cm256_get_large_block_threshold() == 0;
+            for (int withPool = 0; withPool < 2; ++withPool)
+            {
+                std::fill(recoveryData.begin(), recoveryData.end(), 0);
+                success &= (withPool ? cm256_encode_mt(params, blocks, &recoveryData[0], pool)
+                                     : cm256_encode(params, blocks, &recoveryData[0])) == 0;
+                success &= recoveryData == expected;
+            }
+
+            loseOriginals(params, blocks, &recoveryData[0], std::min(params.OriginalCount, params.RecoveryCount));
+            success &= cm256_decode_mt(params, blocks, pool) == 0;
+            success &= validateSolution(blocks, params.OriginalCount, params.BlockBytes);
+
+            if (!success)
+            {
+                cout << "Large-block mode mismatch: k = " << params.OriginalCount << " m = " << params.RecoveryCount
+                     << " bytes = " << blockBytes << endl;
+                break;
+            }
+        }
+    }
+
+    cm256_set_large_block_threshold(-1);
+    cm256_pool_destroy(pool);
+    return success;
+}
+
+// Round-trips originals of different lengths, including empty ones, and
+// checks that the decoder recovers each length along with the data
+bool SizedBlocksTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 1000;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 6;
+
+    const int recoveryStride = cm256_sized_recovery_bytes(params.BlockBytes);
+
+    for (int longest = 0; longest <= params.BlockBytes; longest += params.BlockBytes / 2)
+    {
+        std::vector<uint8_t> orig_data(params.OriginalCount * params.BlockBytes);
+        std::vector<uint8_t> recoveryData(params.RecoveryCount * recoveryStride);
+        cm256_sized_block originals[256];
+        int longestBytes = 0;
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            originals[i].Block = &orig_data[i * params.BlockBytes];
+            originals[i].Bytes = (i == 3) ? longest : (i * 97) % (longest + 1);
+            originals[i].Index = cm256_get_original_block_index(params, i);
+            longestBytes = std::max(longestBytes, originals[i].Bytes);
+
+            uint8_t* data = &orig_data[i * params.BlockBytes];
+            for (int j = 0; j < originals[i].Bytes; ++j)
+            {
+                data[j] = (uint8_t)(i + j * 13);
+            }
+        }
+
+        int recoveryBytes = -1;
+        if (cm256_encode_sized(params, originals, &recoveryData[0], &recoveryBytes) ||
+            recoveryBytes != longestBytes + CM256_SIZED_TRAILER_BYTES)
+        {
+            return false;
+        }
+
+        for (int lost = 0; lost <= params.RecoveryCount; ++lost)
+        {
+            std::vector<uint8_t> received = recoveryData;
+            cm256_sized_block blocks[256];
+            std::copy(originals, originals + params.OriginalCount, blocks);
+            for (int i = 0; i < lost; ++i)
+            {
+                blocks[i].Block = &received[i * recoveryStride];
+                blocks[i].Bytes = recoveryBytes;
+                blocks[i].Index = cm256_get_recovery_block_index(params, i);
+            }
+
+            bool success = cm256_decode_sized(params, blocks) == 0;
+            for (int i = 0; i < params.OriginalCount && success; ++i)
+            {
+                const int index = blocks[i].Index;
+                success = index < params.OriginalCount && blocks[i].Bytes == originals[index].Bytes &&
+                          memcmp(blocks[i].Block, originals[index].Block, blocks[i].Bytes) == 0;
+            }
+            if (!success)
+            {
+                cout << "Sized round trip failed: longest " << longest << " lost " << lost << endl;
+                return false;
+            }
+        }
+    }
+
+    // Lengths past BlockBytes are rejected
+    std::vector<uint8_t> data(params.BlockBytes + 1), recoveryData(params.RecoveryCount * recoveryStride);
+    cm256_sized_block originals[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        originals[i].Block = &data[0];
+        originals[i].Bytes = i == 5 ? params.BlockBytes + 1 : 10;
+        originals[i].Index = cm256_get_original_block_index(params, i);
+    }
+    int recoveryBytes;
+    return cm256_encode_sized(params, originals, &recoveryData[0], &recoveryBytes) == -1;
+}
+
+// Splits each block of a stripe into segments of uneven sizes, including an
+// empty one, as a packet header and payload might be
+struct SgStripe
+{
+    std::vector<cm256_iovec> Segments;
+    cm256_sg_block Blocks[256];
+
+    void Set(cm256_encoder_params params, const cm256_block* blocks)
+    {
+        static const int SegmentCount = 4;
+        Segments.resize(params.OriginalCount * SegmentCount);
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            const uint8_t* data = (const uint8_t*)blocks[i].Block;
+            const int head = std::min(params.BlockBytes, 1 + i % 7);
+            const int middle = (params.BlockBytes - head) / 3;
+
+            cm256_iovec* segments = &Segments[i * SegmentCount];
+            segments[0].Base = data;
+            segments[0].Bytes = head;
+            segments[1].Base = data + head;
+            segments[1].Bytes = 0;
+            segments[2].Base = data + head;
+            segments[2].Bytes = middle;
+            segments[3].Base = data + head + middle;
+            segments[3].Bytes = params.BlockBytes - head - middle;
+
+            Blocks[i].Segments = segments;
+            Blocks[i].SegmentCount = SegmentCount;
+            Blocks[i].Index = blocks[i].Index;
+        }
+    }
+};
+
+// Checks the scatter-gather encodes against cm256_encode() and round-trips
+// them through the scatter-gather decodes and the streaming coders, with
+// and without a pool
+bool ScatterGatherTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_pool* pool = cm256_pool_create(3);
+    if (!pool)
+    {
+        return false;
+    }
+
+    static const int Counts[][2] = { { 1, 1 }, { 20, 6 }, { 100, 30 } };
+    static const int Sizes[] = { 1, 1296, 70001 };
+    static const int StripeCount = 8;
+
+    bool success = true;
+    for (const auto& counts : Counts)
+    {
+        for (int blockBytes : Sizes)
+        {
+            cm256_encoder_params params;
+            params.BlockBytes = blockBytes;
+            params.OriginalCount = counts[0];
+            params.RecoveryCount = counts[1];
+
+            // Empty batches do nothing and succeed, with or without a pool
+            for (cm256_pool* batchPool : { (cm256_pool*)nullptr, pool })
+            {
+                success &= cm256_encode_sg_batch(params, nullptr, 0, batchPool) == 0;
+                success &= cm256_decode_sg_batch(params, nullptr, 0, batchPool) == 0;
+            }
+
+            std::vector<std::vector<uint8_t>> orig_data(StripeCount), recoveryData(StripeCount), expected(StripeCount);
+            std::vector<std::vector<cm256_block>> blocks(StripeCount, std::vector<cm256_block>(256));
+            std::vector<SgStripe> sg(StripeCount);
+            std::vector<cm256_sg_encode_stripe> encodeStripes(StripeCount);
+            for (int s = 0; s < StripeCount; ++s)
+            {
+                setupStripe(params, orig_data[s], recoveryData[s], &blocks[s][0]);
+                loseOriginals(params, &blocks[s][0], nullptr, 0); // Set the indices only
+                expected[s].resize(params.RecoveryCount * params.BlockBytes);
+                success &= cm256_encode(params, &blocks[s][0], &expected[s][0]) == 0;
+                sg[s].Set(params, &blocks[s][0]);
+                encodeStripes[s].Originals = sg[s].Blocks;
+                encodeStripes[s].RecoveryBlocks = &recoveryData[s][0];
+            }
+
+            // Encode
+            for (int withPool = 0; withPool < 2; ++withPool)
+            {
+                cm256_pool* callPool = withPool ? pool : nullptr;
+
+                std::fill(recoveryData[0].begin(), recoveryData[0].end(), 0);
+                success &= cm256_encode_sg(params, sg[0].Blocks, &recoveryData[0][0], callPool) == 0;
+                success &= recoveryData[0] == expected[0];
+
+                for (int s = 0; s < StripeCount; ++s)
+                {
+                    std::fill(recoveryData[s].begin(), recoveryData[s].end(), 0);
+                }
+                success &= cm256_encode_sg_batch(params, &encodeStripes[0], StripeCount, callPool) == 0;
+                for (int s = 0; s < StripeCount; ++s)
+                {
+                    success &= recoveryData[s] == expected[s];
+                }
+            }
+
+            cm256_stream_encoder* encoder = cm256_stream_encoder_create(params);
+            success &= encoder != nullptr;
+            if (encoder)
+            {
+                for (int i = params.OriginalCount - 1; i >= 0; --i)
+                {
+                    success &= cm256_stream_encoder_push_sg(encoder, i, sg[0].Blocks[i].Segments, sg[0].Blocks[i].SegmentCount) == 0;
+                }
+                std::vector<uint8_t> streamed(params.RecoveryCount * params.BlockBytes);
+                success &= cm256_stream_encoder_flush(encoder, &streamed[0]) == 0;
+                success &= streamed == expected[0];
+                cm256_stream_encoder_destroy(encoder);
+            }
+
+            if (!success)
+            {
+                cout << "Scatter-gather encode mismatch: k = " << params.OriginalCount << " m = " << params.RecoveryCount
+                     << " bytes = " << blockBytes << endl;
+                cm256_pool_destroy(pool);
+                return false;
+            }
+
+            // Decode with a different number of erasures in each stripe
+            std::vector<std::vector<uint8_t>> outputData(StripeCount);
+            std::vector<std::vector<void*>> outputs(StripeCount, std::vector<void*>(256));
+            std::vector<cm256_sg_decode_stripe> decodeStripes(StripeCount);
+            std::vector<cm256_iovec> recoverySegments(StripeCount * params.RecoveryCount);
+            std::vector<int> lost(StripeCount);
+            for (int s = 0; s < StripeCount; ++s)
+            {
+                lost[s] = s % (std::min(params.OriginalCount, params.RecoveryCount) + 1);
+                for (int i = 0; i < lost[s]; ++i)
+                {
+                    cm256_iovec& segment = recoverySegments[s * params.RecoveryCount + i];
+                    segment.Base = &recoveryData[s][i * params.BlockBytes];
+                    segment.Bytes = params.BlockBytes;
+                    sg[s].Blocks[i].Segments = &segment;
+                    sg[s].Blocks[i].SegmentCount = 1;
+                    sg[s].Blocks[i].Index = cm256_get_recovery_block_index(params, i);
+                }
+
+                outputData[s].assign(params.OriginalCount * params.BlockBytes, 0);
+                for (int i = 0; i < lost[s]; ++i)
+                {
+                    outputs[s][i] = &outputData[s][i * params.BlockBytes];
+                }
+                decodeStripes[s].Blocks = sg[s].Blocks;
+                decodeStripes[s].Outputs = &outputs[s][0];
+            }
+
+            for (int call = 0; call < 3; ++call)
+            {
+                for (int s = 0; s < StripeCount; ++s)
+                {
+                    std::fill(outputData[s].begin(), outputData[s].end(), 0);
+                }
+
+                if (call == 2)
+                {
+                    success &= cm256_decode_sg_batch(params, &decodeStripes[0], StripeCount, pool) == 0;
+                }
+                else
+                {
+                    for (int s = 0; s < StripeCount; ++s)
+                    {
+                        success &= (call ? cm256_decode_sg_batch(params, &decodeStripes[s], 1, nullptr)
+                                         : cm256_decode_sg(params, sg[s].Blocks, &outputs[s][0], pool)) == 0;
+                    }
+                }
+
+                for (int s = 0; s < StripeCount; ++s)
+                {
+                    for (int i = 0; i < lost[s]; ++i)
+                    {
+                        success &= checkOriginal(&outputData[s][i * params.BlockBytes], i, params.BlockBytes);
+                    }
+                }
+            }
+
+            // The streaming decoder takes scattered originals and whole recovery blocks
+            cm256_stream_decoder* decoder = cm256_stream_decoder_create(params);
+            success &= decoder != nullptr;
+            if (decoder)
+            {
+                const int s = StripeCount - 1;
+                std::vector<uint8_t> received = recoveryData[s];
+                for (int i = 0; i < lost[s]; ++i)
+                {
+                    blocks[s][i].Block = &received[i * params.BlockBytes];
+                    blocks[s][i].Index = cm256_get_recovery_block_index(params, i);
+                    success &= cm256_stream_decoder_push_sg(decoder, &sg[s].Blocks[i]) == -1;
+                    success &= cm256_stream_decoder_push(decoder, &blocks[s][i]) == 0;
+                }
+                for (int i = lost[s]; i < params.OriginalCount; ++i)
+                {
+                    success &= cm256_stream_decoder_push_sg(decoder, &sg[s].Blocks[i]) == 0;
+                }
+                success &= cm256_stream_decoder_complete(decoder) != 0;
+                for (int i = 0; i < lost[s]; ++i)
+                {
+                    success &= blocks[s][i].Index == i || params.OriginalCount == 1;
+                }
+                for (int i = 0; i < lost[s]; ++i)
+                {
+                    success &= checkOriginal((const uint8_t*)blocks[s][i].Block, blocks[s][i].Index, params.BlockBytes);
+                }
+                cm256_stream_decoder_destroy(decoder);
+            }
+
+            if (!success)
+            {
+                cout << "Scatter-gather decode failed: k = " << params.OriginalCount << " m = " << params.RecoveryCount
+                     << " bytes = " << blockBytes << endl;
+                cm256_pool_destroy(pool);
+                return false;
+            }
+        }
+    }
+
+    cm256_pool_destroy(pool);
+    return true;
+}
+
+// Updates one original at a time through each entry point, with and without
+// the old data, and compares the recovery blocks with a fresh encode
+bool UpdateTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    static const int Shapes[][2] = { { 1, 1 }, { 1, 5 }, { 5, 1 }, { 10, 4 }, { 20, 13 }, { 100, 30 } };
+    static const int BlockBytes[] = { 1000, 70001 };
+
+    uint32_t seed = 11;
+
+    for (const auto& shape : Shapes)
+    {
+        for (int blockBytes : BlockBytes)
+        {
+            cm256_encoder_params params;
+            params.OriginalCount = shape[0];
+            params.RecoveryCount = shape[1];
+            params.BlockBytes = blockBytes;
+
+            std::vector<uint8_t> orig_data(params.OriginalCount * params.BlockBytes);
+            for (auto& x : orig_data)
+            {
+                x = (uint8_t)nextRandom(seed);
+            }
+
+            cm256_block blocks[256];
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                blocks[i].Block = &orig_data[i * params.BlockBytes];
+                blocks[i].Index = cm256_get_original_block_index(params, i);
+            }
+
+            std::vector<uint8_t> recoveryData(params.RecoveryCount * params.BlockBytes);
+            cm256_encoder* encoder = cm256_encoder_create(params);
+            if (!encoder || cm256_encode(params, blocks, &recoveryData[0]))
+            {
+                cm256_encoder_destroy(encoder);
+                return false;
+            }
+
+            bool success = true;
+
+            // Rewrite an original for each mode, then check against a fresh encode
+            for (int mode = 0; mode < 4; ++mode)
+            {
+                const int originalIndex = (mode * 7) % params.OriginalCount;
+                uint8_t* original = &orig_data[originalIndex * params.BlockBytes];
+
+                const std::vector<uint8_t> oldBlock(original, original + params.BlockBytes);
+                std::vector<uint8_t> change(params.BlockBytes);
+                for (int j = 0; j < params.BlockBytes; ++j)
+                {
+                    original[j] = (uint8_t)nextRandom(seed);
+                    change[j] = oldBlock[j] ^ original[j];
+                }
+
+                // The change-only modes leave row 1 out, which must not be touched
+                const bool changeOnly = (mode % 2) != 0;
+                const int skipped = (changeOnly && params.RecoveryCount > 1) ? 1 : -1;
+                std::vector<uint8_t> skippedRow;
+                void* recoveryBlocks[256];
+                for (int i = 0; i < params.RecoveryCount; ++i)
+                {
+                    recoveryBlocks[i] = &recoveryData[i * params.BlockBytes];
+                }
+                if (skipped >= 0)
+                {
+                    recoveryBlocks[skipped] = nullptr;
+                    skippedRow.assign(recoveryData.begin() + skipped * params.BlockBytes,
+                                      recoveryData.begin() + (skipped + 1) * params.BlockBytes);
+                }
+
+                const void* oldArg = changeOnly ? nullptr : &oldBlock[0];
+                const void* newArg = changeOnly ? &change[0] : original;
+                const int result = (mode < 2) ? cm256_update(params, originalIndex, oldArg, newArg, recoveryBlocks)
+                                              : cm256_encoder_update(encoder, originalIndex, oldArg, newArg, recoveryBlocks);
+                success &= result == 0;
+
+                std::vector<uint8_t> expected(params.RecoveryCount * params.BlockBytes);
+                success &= cm256_encode(params, blocks, &expected[0]) == 0;
+
+                if (skipped >= 0)
+                {
+                    success &= std::equal(skippedRow.begin(), skippedRow.end(),
+                                          recoveryData.begin() + skipped * params.BlockBytes);
+
+                    // Bring the skipped row up to date for the next mode
+                    std::copy(expected.begin() + skipped * params.BlockBytes,
+                              expected.begin() + (skipped + 1) * params.BlockBytes,
+                              recoveryData.begin() + skipped * params.BlockBytes);
+                }
+                success &= recoveryData == expected;
+
+                if (!success)
+                {
+                    cout << "Update failed: k = " << params.OriginalCount << " m = " << params.RecoveryCount
+                         << " bytes = " << blockBytes << " mode = " << mode << endl;
+                    break;
+                }
+            }
+
+            // Out of range originals are rejected
+            void* recoveryBlocks[256] = { &recoveryData[0] };
+            success &= cm256_update(params, params.OriginalCount, nullptr, &orig_data[0], recoveryBlocks) == -1;
+            success &= cm256_encoder_update(encoder, -1, nullptr, &orig_data[0], recoveryBlocks) == -1;
+
+            cm256_encoder_destroy(encoder);
+            if (!success)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Bit at a time CRC32C register update, to check the table and SSE4.2 kernels
+static uint32_t crc32cReference(uint32_t crc, const uint8_t* data, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc >> 1) ^ (kCrc32cPolynomial & (0U - (crc & 1)));
+        }
+    }
+    return crc;
+}
+
+// Checks cm256_crc32c() on known vectors before anything has called
+// cm256_init(), checks the SSE4.2 kernel where the CPU has it over lengths
+// that reach every lane size, and checks the CRCs from the _crc codecs
+bool CRC32CTest()
+{
+    if (cm256_crc32c(0, "123456789", 9) != 0xE3069283)
+    {
+        cout << "CRC32C of \"123456789\" is wrong" << endl;
+        return false;
+    }
+    const uint8_t zeroes[32] = { 0 };
+    if (cm256_crc32c(0, zeroes, 32) != 0x8A9136AA)
+    {
+        cout << "CRC32C of 32 zero bytes is wrong" << endl;
+        return false;
+    }
+
+    uint32_t seed = 17;
+    std::vector<uint8_t> data(3 * 8192 * 2 + 1000);
+    for (auto& x : data)
+    {
+        x = (uint8_t)nextRandom(seed);
+    }
+
+    static const int Lengths[] = { 0, 1, 7, 8, 9, 767, 768, 769, 1600, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 777, (int)data.size() - 3 };
+    const cm256_crc32c_kernel sse42 = gf256_get_cpu_features().SSE42 ? cm256_crc32c_kernel_sse42() : nullptr;
+    for (int bytes : Lengths)
+    {
+        for (int align = 0; align < 3; ++align)
+        {
+            const uint8_t* x = &data[align];
+            const uint32_t expected = crc32cReference(0xffffffff, x, bytes) ^ 0xffffffff;
+
+            // One call, and the same data split in two
+            const int split = bytes / 3;
+            const uint32_t whole = cm256_crc32c(0, x, bytes);
+            const uint32_t pieces = cm256_crc32c(cm256_crc32c(0, x, split), x + split, bytes - split);
+            const bool kernel = !sse42 || sse42(0xffffffff, x, bytes) == (expected ^ 0xffffffff);
+            if (whole != expected || pieces != expected || !kernel)
+            {
+                cout << "CRC32C differs from the reference: bytes = " << bytes << endl;
+                return false;
+            }
+        }
+    }
+
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 30000;
+    params.OriginalCount = 10;
+    params.RecoveryCount = 4;
+
+    std::vector<uint8_t> orig_data, recoveryData;
+    cm256_block blocks[256];
+    setupStripe(params, orig_data, recoveryData, blocks);
+    loseOriginals(params, blocks, nullptr, 0);
+
+    std::vector<uint32_t> crcs(params.OriginalCount + params.RecoveryCount);
+    if (cm256_encode_crc(params, blocks, &recoveryData[0], &crcs[0]))
+    {
+        return false;
+    }
+
+    bool success = true;
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        success &= crcs[i] == cm256_crc32c(0, &orig_data[i * params.BlockBytes], params.BlockBytes);
+    }
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        success &= crcs[params.OriginalCount + i] == cm256_crc32c(0, &recoveryData[i * params.BlockBytes], params.BlockBytes);
+    }
+
+    for (int lost = 0; lost <= params.RecoveryCount; ++lost)
+    {
+        std::vector<uint8_t> received = recoveryData;
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = &orig_data[i * params.BlockBytes];
+        }
+        loseOriginals(params, blocks, &received[0], lost);
+
+        std::vector<uint32_t> decodeCrcs(params.OriginalCount, 0);
+        success &= cm256_decode_crc(params, blocks, &decodeCrcs[0]) == 0;
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            success &= decodeCrcs[i] == crcs[i];
+        }
+        for (int i = 0; i < lost; ++i)
+        {
+            success &= checkOriginal((const uint8_t*)blocks[i].Block, blocks[i].Index, params.BlockBytes);
+        }
+
+        if (!success)
+        {
+            cout << "CRC32C codec check failed: lost = " << lost << endl;
+            return false;
+        }
+    }
+
+    return success;
+}
+
 bool FinerPerfTimingTest()
 {
 // #ifdef _WIN32
@@ -277,13 +2347,13 @@ bool FinerPerfTimingTest()
         }
         //// Simulate loss of data, substituting a recovery block in its place ////
 
-        const auto start = std::chrono::system_clock::now();
+        const auto start = std::chrono::steady_clock::now();
         if (cm256_decode(params, blocks))
         {
             return false;
         }
-        const auto end = std::chrono::system_clock::now();
-        tsum += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        const auto end = std::chrono::steady_clock::now();
+        tsum += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
 
         for (int i = 0; i < params.RecoveryCount && i < params.OriginalCount; ++i)
         {
@@ -315,6 +2385,9 @@ bool FinerPerfTimingTest()
 }
 
 
+// Times one encode and one decode with the worst case of min(k, m) erasures
+// Times single calls as a quick sanity check.  Use cm256_bench for numbers
+// with warmups, repetitions and percentiles.
 bool BulkPerfTesting()
 {
     if (cm256_init())
@@ -349,13 +2422,13 @@ bool BulkPerfTesting()
                 initializeBlocks(blocks, originalCount, blockBytes);
 
                 {
-                    const auto t0 = std::chrono::system_clock::now();
+                    const auto t0 = std::chrono::steady_clock::now();
                     if (cm256_encode(params, blocks, recoveryData))
                     {
                         cout << "Encoder error" << endl;
                         return false;
                     }
-                    const auto t1 = std::chrono::system_clock::now();
+                    const auto t1 = std::chrono::steady_clock::now();
                     
                     const int dt_usec = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
 
@@ -379,7 +2452,7 @@ bool BulkPerfTesting()
                 }
 
                 {
-                    const auto t0 = std::chrono::system_clock::now();
+                    const auto t0 = std::chrono::steady_clock::now();
 
                     if (cm256_decode(params, blocks))
                     {
@@ -387,7 +2460,7 @@ bool BulkPerfTesting()
                         return false;
                     }
 
-                    const auto t1 = std::chrono::system_clock::now();
+                    const auto t1 = std::chrono::steady_clock::now();
                     const int dt_usec = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
 
                     const double opusec = dt_usec;
@@ -411,6 +2484,11 @@ bool BulkPerfTesting()
 
 int main()
 {
+    // Runs first so that the CRC is checked before anything initializes
+    if (!CRC32CTest())
+    {
+        exit(29);
+    }
 
     if (!ExampleFileUsage())
     {
@@ -422,6 +2500,121 @@ int main()
         exit(4);
     }
 
+    if (!EncodeTilingTest())
+    {
+        exit(6);
+    }
+
+    if (!MulAddMultiTest())
+    {
+        exit(7);
+    }
+
+    if (!KernelTableTest())
+    {
+        exit(8);
+    }
+
+    if (!GFNICoefficientTest())
+    {
+        exit(9);
+    }
+
+    if (!EncodeMTTest())
+    {
+        exit(10);
+    }
+
+    if (!DecodeMTTest())
+    {
+        exit(11);
+    }
+
+    if (!EncoderHandleTest())
+    {
+        exit(12);
+    }
+
+    if (!DecodePlanTest())
+    {
+        exit(13);
+    }
+
+    if (!BatchTest())
+    {
+        exit(14);
+    }
+
+    if (!StreamEncoderTest())
+    {
+        exit(15);
+    }
+
+    if (!StreamDecoderTest())
+    {
+        exit(16);
+    }
+
+    if (!DecodeIntoTest())
+    {
+        exit(17);
+    }
+
+    if (!DecodePartialTest())
+    {
+        exit(18);
+    }
+
+    if (!CM65536Test())
+    {
+        exit(19);
+    }
+
+    if (!FFTTest())
+    {
+        exit(20);
+    }
+
+    if (!XorCodecTest())
+    {
+        exit(21);
+    }
+
+    if (!MatrixPointsTest())
+    {
+        exit(22);
+    }
+
+    if (!VersionTest())
+    {
+        exit(23);
+    }
+
+    if (!AlignedArenaTest())
+    {
+        exit(24);
+    }
+
+    if (!LargeBlockTest())
+    {
+        exit(25);
+    }
+
+    if (!SizedBlocksTest())
+    {
+        exit(26);
+    }
+
+    if (!ScatterGatherTest())
+    {
+        exit(27);
+    }
+
+    if (!UpdateTest())
+    {
+        exit(28);
+    }
+
     if (!FinerPerfTimingTest())
     {
         exit(2);